@@ -15,6 +15,23 @@
 
 extern uint8_t const PFCommandRunningDefaultMaxAttemptsCount;
 
+/**
+ Requests are scheduled in separate lanes, each with its own limit of requests running at the same time,
+ so that a burst of requests in one lane doesn't hold back requests in the others.
+ */
+typedef NS_ENUM(NSUInteger, PFCommandRunningLane) {
+    /** Requests a user is likely waiting for. */
+    PFCommandRunningLaneInteractive = 0,
+    /** Requests nobody is waiting for right away. */
+    PFCommandRunningLaneBackground,
+    /** File uploads and downloads. */
+    PFCommandRunningLaneFileTransfer,
+    /** Commands replayed from the eventually queue. */
+    PFCommandRunningLaneEventuallyQueue,
+};
+
+extern NSUInteger const PFCommandRunningLanesCount;
+
 ///--------------------------------------
 #pragma mark - Headers
 ///--------------------------------------
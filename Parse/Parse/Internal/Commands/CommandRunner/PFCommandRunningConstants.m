@@ -10,6 +10,7 @@
 #import "PFCommandRunningConstants.h"
 
 uint8_t const PFCommandRunningDefaultMaxAttemptsCount = 5;
+NSUInteger const PFCommandRunningLanesCount = PFCommandRunningLaneEventuallyQueue + 1;
 
 NSString *const PFCommandHeaderNameApplicationId = @"X-Parse-Application-Id";
 NSString *const PFCommandHeaderNameClientKey = @"X-Parse-Client-Key";
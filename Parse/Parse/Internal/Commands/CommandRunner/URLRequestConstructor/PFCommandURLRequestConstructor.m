@@ -51,7 +51,8 @@
                                                         path:command.httpPath
                                                        query:nil];
         NSDictionary *headers = task.result;
-        NSURLSessionConfiguration *configuration = Parse._currentManager.configuration.URLSessionConfiguration;
+        ParseClientConfiguration *clientConfiguration = Parse._currentManager.configuration;
+        NSURLSessionConfiguration *configuration = clientConfiguration.URLSessionConfiguration;
         if (configuration && [configuration.HTTPAdditionalHeaders count]) {
             NSMutableDictionary *sessionConfigurationHeaders = [configuration.HTTPAdditionalHeaders mutableCopy];
             [sessionConfigurationHeaders addEntriesFromDictionary:headers];
@@ -82,10 +83,14 @@
             PFPreconditionReturnFailedTask(requestParameters, error);
         }
 
-        return [PFHTTPURLRequestConstructor urlRequestWithURL:url
-                                                   httpMethod:requestMethod
-                                                  httpHeaders:headers
-                                                   parameters:requestParameters];
+        NSMutableURLRequest *request = [PFHTTPURLRequestConstructor urlRequestWithURL:url
+                                                                           httpMethod:requestMethod
+                                                                          httpHeaders:headers
+                                                                           parameters:requestParameters];
+        if (clientConfiguration.networkCompressionEnabled) {
+            [PFHTTPURLRequestConstructor compressBodyOfURLRequest:request];
+        }
+        return request;
     }];
 }
 
@@ -10,6 +10,18 @@
 #import "PFURLSessionCommandRunner.h"
 #import "PFURLSessionCommandRunner_Private.h"
 
+#if __has_include(<Bolts/BFCancellationTokenRegistration.h>)
+#import <Bolts/BFCancellationTokenRegistration.h>
+#else
+#import "BFCancellationTokenRegistration.h"
+#endif
+
+#if __has_include(<Bolts/BFCancellationTokenSource.h>)
+#import <Bolts/BFCancellationTokenSource.h>
+#else
+#import "BFCancellationTokenSource.h"
+#endif
+
 #if __has_include(<Bolts/BFTaskCompletionSource.h>)
 #import <Bolts/BFTaskCompletionSource.h>
 #else
@@ -35,7 +47,39 @@
 #import "PFURLSession.h"
 #import "Parse_Private.h"
 
-@interface PFURLSessionCommandRunner () <PFURLSessionDelegate>
+/**
+ A read-only command that is being run on behalf of one or more callers.
+ */
+@interface PFURLSessionCommandRunnerFlight : NSObject
+
+@property (nonatomic, strong, readonly) BFTaskCompletionSource<PFCommandResult *> *taskCompletionSource;
+@property (nonatomic, strong, readonly) BFCancellationTokenSource *cancellationTokenSource;
+
+/**
+ The number of callers that are waiting for the command and didn't cancel yet.
+ */
+@property (nonatomic, assign) NSUInteger callersCount;
+
+@end
+
+@implementation PFURLSessionCommandRunnerFlight
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) return nil;
+
+    _taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    _cancellationTokenSource = [BFCancellationTokenSource cancellationTokenSource];
+
+    return self;
+}
+
+@end
+
+@interface PFURLSessionCommandRunner () <PFURLSessionDelegate> {
+    dispatch_queue_t _flightsAccessQueue;
+    NSMutableDictionary<NSString *, PFURLSessionCommandRunnerFlight *> *_flights;
+}
 
 @property (nonatomic, strong) NSNotificationCenter *notificationCenter;
 @property (nonatomic, assign) NSUInteger retryAttempts;
@@ -101,6 +145,9 @@
     _session = session;
     _notificationCenter = notificationCenter;
 
+    _flightsAccessQueue = dispatch_queue_create("com.parse.commandRunner.flights", DISPATCH_QUEUE_SERIAL);
+    _flights = [NSMutableDictionary dictionary];
+
     return self;
 }
 
@@ -151,6 +198,23 @@
 - (BFTask<PFCommandResult *> *)runCommandAsync:(PFRESTCommand *)command
                                    withOptions:(PFCommandRunningOptions)options
                              cancellationToken:(BFCancellationToken *)cancellationToken {
+    if (cancellationToken.cancellationRequested) {
+        return [BFTask cancelledTask];
+    }
+
+    NSString *flightKey = [self _flightKeyForCommand:command options:options];
+    if (flightKey) {
+        return [self _runCommandAsync:command
+                          withOptions:options
+                    cancellationToken:cancellationToken
+                            flightKey:flightKey];
+    }
+    return [self _runCommandAsync:command withOptions:options cancellationToken:cancellationToken];
+}
+
+- (BFTask<PFCommandResult *> *)_runCommandAsync:(PFRESTCommand *)command
+                                    withOptions:(PFCommandRunningOptions)options
+                              cancellationToken:(BFCancellationToken *)cancellationToken {
     return [self _performCommandRunningBlock:^id {
         NSError *error;
         BOOL success = [command resolveLocalIds:&error];
@@ -161,6 +225,103 @@
     } withOptions:options cancellationToken:cancellationToken];
 }
 
+///--------------------------------------
+#pragma mark - Single Flight
+///--------------------------------------
+
+/**
+ Identical read-only commands that run at the same time share a single request.
+ Commands that carry state the key doesn't cover are always sent on their own.
+ */
+- (nullable NSString *)_flightKeyForCommand:(PFRESTCommand *)command options:(PFCommandRunningOptions)options {
+    NSString *httpMethod = command.httpMethod;
+    if (![httpMethod isEqualToString:PFHTTPRequestMethodGET] && ![httpMethod isEqualToString:PFHTTPRequestMethodHEAD]) {
+        return nil;
+    }
+    if (command.additionalRequestHeaders.count || command.partialResultsBlock) {
+        return nil;
+    }
+    // `cacheKey` covers the method, the path, canonically encoded parameters and the session token.
+    return [NSString stringWithFormat:@"%@.%lu", command.cacheKey, (unsigned long)options];
+}
+
+- (BFTask<PFCommandResult *> *)_runCommandAsync:(PFRESTCommand *)command
+                                    withOptions:(PFCommandRunningOptions)options
+                              cancellationToken:(BFCancellationToken *)cancellationToken
+                                      flightKey:(NSString *)flightKey {
+    __block PFURLSessionCommandRunnerFlight *flight = nil;
+    __block BOOL isNewFlight = NO;
+    dispatch_sync(_flightsAccessQueue, ^{
+        flight = self->_flights[flightKey];
+        if (!flight) {
+            flight = [[PFURLSessionCommandRunnerFlight alloc] init];
+            self->_flights[flightKey] = flight;
+            isNewFlight = YES;
+        }
+        flight.callersCount++;
+    });
+
+    if (isNewFlight) {
+        BFTask *task = [self _runCommandAsync:command
+                                  withOptions:options
+                            cancellationToken:flight.cancellationTokenSource.token];
+        [task continueWithBlock:^id(BFTask *task) {
+            dispatch_sync(self->_flightsAccessQueue, ^{
+                if (self->_flights[flightKey] == flight) {
+                    [self->_flights removeObjectForKey:flightKey];
+                }
+            });
+            if (task.cancelled) {
+                [flight.taskCompletionSource trySetCancelled];
+            } else if (task.error) {
+                [flight.taskCompletionSource trySetError:task.error];
+            } else {
+                [flight.taskCompletionSource trySetResult:task.result];
+            }
+            return nil;
+        }];
+    }
+
+    // Every caller gets its own task, so that cancelling it doesn't affect the others.
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    BFCancellationTokenRegistration *registration = [cancellationToken registerCancellationObserverWithBlock:^{
+        if ([taskCompletionSource trySetCancelled]) {
+            [self _leaveFlight:flight withKey:flightKey];
+        }
+    }];
+    [flight.taskCompletionSource.task continueWithBlock:^id(BFTask *task) {
+        [registration dispose];
+        if (task.cancelled) {
+            [taskCompletionSource trySetCancelled];
+        } else if (task.error) {
+            [taskCompletionSource trySetError:task.error];
+        } else {
+            [taskCompletionSource trySetResult:task.result];
+        }
+        return nil;
+    }];
+    return taskCompletionSource.task;
+}
+
+/**
+ Cancels the request of the flight once the last of its callers cancels.
+ */
+- (void)_leaveFlight:(PFURLSessionCommandRunnerFlight *)flight withKey:(NSString *)flightKey {
+    __block BOOL shouldCancel = NO;
+    dispatch_sync(_flightsAccessQueue, ^{
+        flight.callersCount--;
+        if (flight.callersCount == 0) {
+            if (self->_flights[flightKey] == flight) {
+                [self->_flights removeObjectForKey:flightKey];
+            }
+            shouldCancel = YES;
+        }
+    });
+    if (shouldCancel) {
+        [flight.cancellationTokenSource cancel];
+    }
+}
+
 ///--------------------------------------
 #pragma mark - File Commands
 ///--------------------------------------
@@ -294,19 +455,67 @@
         headers = sessionConfigurationHeaders;
     }
 
+    if (Parse._currentManager.configuration.networkCompressionEnabled &&
+        !headers[PFHTTPRequestHeaderNameAcceptEncoding]) {
+        // NSURLSession decodes these encodings of responses on its own.
+        NSMutableDictionary *compressionHeaders = [headers mutableCopy];
+        compressionHeaders[PFHTTPRequestHeaderNameAcceptEncoding] = @"gzip, deflate";
+        headers = compressionHeaders;
+    }
+
     configuration.HTTPAdditionalHeaders = headers;
 
     return configuration;
 }
 
+///--------------------------------------
+#pragma mark - Compression
+///--------------------------------------
+
++ (nullable NSNumber *)_compressionRatioOfURLRequest:(NSURLRequest *)request {
+    NSNumber *uncompressedLength = [NSURLProtocol propertyForKey:PFHTTPURLRequestUncompressedBodyLengthPropertyKey
+                                                       inRequest:request];
+    NSUInteger length = request.HTTPBody.length;
+    if (!uncompressedLength || length == 0) {
+        return nil;
+    }
+    return @(uncompressedLength.doubleValue / length);
+}
+
++ (nullable NSNumber *)_compressionRatioOfURLResponse:(nullable NSURLResponse *)response data:(nullable NSData *)data {
+    if (![response isKindOfClass:[NSHTTPURLResponse class]] || data.length == 0) {
+        return nil;
+    }
+    NSDictionary *headers = ((NSHTTPURLResponse *)response).allHeaderFields;
+    NSString *contentEncoding = [headers[PFHTTPRequestHeaderNameContentEncoding] lowercaseString];
+    if (![contentEncoding isEqualToString:PFHTTPRequestContentEncodingGZIP] &&
+        ![contentEncoding isEqualToString:PFHTTPRequestContentEncodingDeflate]) {
+        return nil;
+    }
+    // Content-Length is the length of the body on the wire, while the data is already decoded.
+    long long length = [headers[PFHTTPRequestHeaderNameContentLength] longLongValue];
+    if (length <= 0) {
+        return nil;
+    }
+    return @((double)data.length / length);
+}
+
 ///--------------------------------------
 #pragma mark - PFURLSessionDelegate
 ///--------------------------------------
 
 - (void)urlSession:(PFURLSession *)session willPerformURLRequest:(NSURLRequest *)request {
     [[BFExecutor defaultPriorityBackgroundExecutor] execute:^{
-        NSDictionary *userInfo = ([PFSystemLogger sharedLogger].logLevel == PFLogLevelDebug ?
-                                  @{ PFNetworkNotificationURLRequestUserInfoKey : request } : nil);
+        NSMutableDictionary *userInfo = nil;
+        if ([PFSystemLogger sharedLogger].logLevel == PFLogLevelDebug) {
+            userInfo = [NSMutableDictionary dictionaryWithObject:request
+                                                          forKey:PFNetworkNotificationURLRequestUserInfoKey];
+        }
+        NSNumber *compressionRatio = [[self class] _compressionRatioOfURLRequest:request];
+        if (compressionRatio) {
+            userInfo = userInfo ?: [NSMutableDictionary dictionary];
+            userInfo[PFNetworkNotificationURLRequestBodyCompressionRatioUserInfoKey] = compressionRatio;
+        }
         [self.notificationCenter postNotificationName:PFNetworkWillSendURLRequestNotification
                                                object:self
                                              userInfo:userInfo];
@@ -316,7 +525,7 @@
 - (void)urlSession:(PFURLSession *)session
 didPerformURLRequest:(NSURLRequest *)request
    withURLResponse:(nullable NSURLResponse *)response
-    responseString:(nullable NSString *)responseString {
+      responseData:(nullable NSData *)responseData {
     [[BFExecutor defaultPriorityBackgroundExecutor] execute:^{
         NSMutableDictionary *userInfo = nil;
         if ([PFSystemLogger sharedLogger].logLevel == PFLogLevelDebug) {
@@ -325,10 +534,18 @@ didPerformURLRequest:(NSURLRequest *)request
             if (response) {
                 userInfo[PFNetworkNotificationURLResponseUserInfoKey] = response;
             }
+            NSString *responseString = (responseData ?
+                                        [[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding] :
+                                        nil);
             if (responseString) {
                 userInfo[PFNetworkNotificationURLResponseBodyUserInfoKey] = responseString;
             }
         }
+        NSNumber *compressionRatio = [[self class] _compressionRatioOfURLResponse:response data:responseData];
+        if (compressionRatio) {
+            userInfo = userInfo ?: [NSMutableDictionary dictionary];
+            userInfo[PFNetworkNotificationURLResponseBodyCompressionRatioUserInfoKey] = compressionRatio;
+        }
         [self.notificationCenter postNotificationName:PFNetworkDidReceiveURLResponseNotification
                                                object:self
                                              userInfo:userInfo];
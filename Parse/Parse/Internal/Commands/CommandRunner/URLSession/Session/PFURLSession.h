@@ -15,6 +15,7 @@
 
 @class BFTask<__covariant BFGenericType>;
 @class PFRESTCommand;
+@class PFURLSessionScheduler;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -24,7 +25,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)urlSession:(PFURLSession *)session willPerformURLRequest:(NSURLRequest *)request;
 
-- (void)urlSession:(PFURLSession *)session didPerformURLRequest:(NSURLRequest *)request withURLResponse:(nullable NSURLResponse *)response responseString:(nullable NSString *)string;
+- (void)urlSession:(PFURLSession *)session didPerformURLRequest:(NSURLRequest *)request withURLResponse:(nullable NSURLResponse *)response responseData:(nullable NSData *)data;
 
 @end
 
@@ -32,6 +33,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, weak, readonly) id<PFURLSessionDelegate> delegate;
 
+/**
+ Limits the number of requests of each lane that run at the same time.
+ */
+@property (nonatomic, strong, readonly) PFURLSessionScheduler *scheduler;
+
 ///--------------------------------------
 #pragma mark - Init
 ///--------------------------------------
@@ -20,7 +20,9 @@
 #import "PFCommandResult.h"
 #import "PFMacros.h"
 #import "PFAssert.h"
+#import "PFRESTCommand.h"
 #import "PFURLSessionJSONDataTaskDelegate.h"
+#import "PFURLSessionScheduler.h"
 #import "PFURLSessionUploadTaskDelegate.h"
 #import "PFURLSessionFileDownloadTaskDelegate.h"
 
@@ -57,6 +59,7 @@ typedef void (^PFURLSessionTaskCompletionHandler)(NSData *data, NSURLResponse *r
 
     _delegate = delegate;
     _urlSession = session;
+    _scheduler = [[PFURLSessionScheduler alloc] init];
 
     _sessionTaskQueue = dispatch_queue_create("com.parse.urlSession.tasks", DISPATCH_QUEUE_SERIAL);
 
@@ -102,13 +105,15 @@ typedef void (^PFURLSessionTaskCompletionHandler)(NSData *data, NSURLResponse *r
             return [BFTask cancelledTask];
         }
 
-        __block NSURLSessionDataTask *task = nil;
-        dispatch_sync(self->_sessionTaskQueue, ^{
-            task = [self->_urlSession dataTaskWithRequest:request];
-        });
-        PFURLSessionDataTaskDelegate *delegate = [PFURLSessionJSONDataTaskDelegate taskDelegateForDataTask:task
-                                                                                     withCancellationToken:cancellationToken];
-        return [self _performDataTask:task withDelegate:delegate];
+        return [self _performDataTaskInLane:command.lane
+                          cancellationToken:cancellationToken
+                          withDelegateBlock:^PFURLSessionDataTaskDelegate *(NSURLSession *urlSession) {
+            NSURLSessionDataTask *task = [urlSession dataTaskWithRequest:request];
+            PFURLSessionJSONDataTaskDelegate *delegate = [PFURLSessionJSONDataTaskDelegate taskDelegateForDataTask:task
+                                                                                             withCancellationToken:cancellationToken];
+            delegate.partialResultsBlock = command.partialResultsBlock;
+            return delegate;
+        }];
     }];
 }
 
@@ -128,14 +133,15 @@ typedef void (^PFURLSessionTaskCompletionHandler)(NSData *data, NSURLResponse *r
             return [BFTask cancelledTask];
         }
 
-        __block NSURLSessionDataTask *task = nil;
-        dispatch_sync(self->_sessionTaskQueue, ^{
-            task = [self->_urlSession uploadTaskWithRequest:request fromFile:[NSURL fileURLWithPath:sourceFilePath]];
-        });
-        PFURLSessionUploadTaskDelegate *delegate = [PFURLSessionUploadTaskDelegate taskDelegateForDataTask:task
-                                                                                     withCancellationToken:cancellationToken
-                                                                                       uploadProgressBlock:progressBlock];
-        return [self _performDataTask:task withDelegate:delegate];
+        return [self _performDataTaskInLane:PFCommandRunningLaneFileTransfer
+                          cancellationToken:cancellationToken
+                          withDelegateBlock:^PFURLSessionDataTaskDelegate *(NSURLSession *urlSession) {
+            NSURLSessionDataTask *task = [urlSession uploadTaskWithRequest:request
+                                                                  fromFile:[NSURL fileURLWithPath:sourceFilePath]];
+            return [PFURLSessionUploadTaskDelegate taskDelegateForDataTask:task
+                                                     withCancellationToken:cancellationToken
+                                                       uploadProgressBlock:progressBlock];
+        }];
     }];
 }
 
@@ -154,15 +160,34 @@ typedef void (^PFURLSessionTaskCompletionHandler)(NSData *data, NSURLResponse *r
             return [BFTask cancelledTask];
         }
 
-        __block NSURLSessionDataTask *task = nil;
+        return [self _performDataTaskInLane:PFCommandRunningLaneFileTransfer
+                          cancellationToken:cancellationToken
+                          withDelegateBlock:^PFURLSessionDataTaskDelegate *(NSURLSession *urlSession) {
+            NSURLSessionDataTask *task = [urlSession dataTaskWithRequest:request];
+            return [PFURLSessionFileDownloadTaskDelegate taskDelegateForDataTask:task
+                                                           withCancellationToken:cancellationToken
+                                                                  targetFilePath:filePath
+                                                                   progressBlock:progressBlock];
+        }];
+    }];
+}
+
+/**
+ Creates and starts a task once its lane lets it run, so requests that are cancelled while they wait never create one.
+
+ @param block Block that creates the task with the session and returns the delegate for it.
+ */
+- (BFTask *)_performDataTaskInLane:(PFCommandRunningLane)lane
+                 cancellationToken:(BFCancellationToken *)cancellationToken
+                 withDelegateBlock:(PFURLSessionDataTaskDelegate *(^)(NSURLSession *urlSession))block {
+    @weakify(self);
+    return [_scheduler scheduleTaskInLane:lane cancellationToken:cancellationToken withBlock:^BFTask *{
+        @strongify(self);
+        __block PFURLSessionDataTaskDelegate *delegate = nil;
         dispatch_sync(self->_sessionTaskQueue, ^{
-            task = [self->_urlSession dataTaskWithRequest:request];
+            delegate = block(self->_urlSession);
         });
-        PFURLSessionFileDownloadTaskDelegate *delegate = [PFURLSessionFileDownloadTaskDelegate taskDelegateForDataTask:task
-                                                                                                 withCancellationToken:cancellationToken
-                                                                                                        targetFilePath:filePath
-                                                                                                         progressBlock:progressBlock];
-        return [self _performDataTask:task withDelegate:delegate];
+        return [self _performDataTask:delegate.dataTask withDelegate:delegate];
     }];
 }
 
@@ -180,7 +205,7 @@ typedef void (^PFURLSessionTaskCompletionHandler)(NSData *data, NSURLResponse *r
             [self.delegate urlSession:self
                  didPerformURLRequest:dataTask.originalRequest
                       withURLResponse:delegate.response
-                       responseString:delegate.responseString];
+                         responseData:delegate.responseData];
 
             [self _removeDelegateForTaskWithIdentifier:taskIdentifier];
             return task;
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "PFCommandRunningConstants.h"
+
+@class BFCancellationToken;
+@class BFTask<__covariant BFGenericType>;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Limits the number of requests that run at the same time in each lane.
+
+ The limit of a lane adapts to the network: it grows by one for every limit's worth of requests
+ that finish quickly, and halves when requests time out, lose their connection, fail with a temporary server error
+ or take much longer than usual.
+ It never grows above the maximum count of the lane.
+ */
+@interface PFURLSessionScheduler : NSObject
+
+///--------------------------------------
+#pragma mark - Limits
+///--------------------------------------
+
+- (NSUInteger)maxConcurrentTasksCountForLane:(PFCommandRunningLane)lane;
+- (void)setMaxConcurrentTasksCount:(NSUInteger)count forLane:(PFCommandRunningLane)lane;
+
+/**
+ The number of requests that the lane currently lets run at the same time.
+ */
+- (NSUInteger)concurrentTasksLimitForLane:(PFCommandRunningLane)lane;
+
+///--------------------------------------
+#pragma mark - Statistics
+///--------------------------------------
+
+- (NSUInteger)runningTasksCountForLane:(PFCommandRunningLane)lane;
+
+/**
+ The number of requests that wait for the lane to let them run.
+ */
+- (NSUInteger)waitingTasksCountForLane:(PFCommandRunningLane)lane;
+
+/**
+ Smoothed time requests of the lane recently waited for before they started.
+ */
+- (NSTimeInterval)averageWaitTimeForLane:(PFCommandRunningLane)lane;
+
+///--------------------------------------
+#pragma mark - Scheduling
+///--------------------------------------
+
+/**
+ Calls the block once the lane lets another request run.
+ The request counts towards the limit of the lane until the task returned from the block completes.
+
+ @param lane              Lane to schedule the request in.
+ @param cancellationToken Cancels the request if it's still waiting.
+ @param block             Block that starts the request and returns a task that completes with it.
+
+ @return A task that completes with the task returned from the block, or is cancelled if the request never started.
+ */
+- (BFTask *)scheduleTaskInLane:(PFCommandRunningLane)lane
+             cancellationToken:(nullable BFCancellationToken *)cancellationToken
+                     withBlock:(BFTask *(^)(void))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
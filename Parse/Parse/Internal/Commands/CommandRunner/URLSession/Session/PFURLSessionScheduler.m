@@ -0,0 +1,346 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import "PFURLSessionScheduler.h"
+
+#if __has_include(<Bolts/BFCancellationToken.h>)
+#import <Bolts/BFCancellationToken.h>
+#else
+#import "BFCancellationToken.h"
+#endif
+
+#if __has_include(<Bolts/BFCancellationTokenRegistration.h>)
+#import <Bolts/BFCancellationTokenRegistration.h>
+#else
+#import "BFCancellationTokenRegistration.h"
+#endif
+
+#if __has_include(<Bolts/BFTaskCompletionSource.h>)
+#import <Bolts/BFTaskCompletionSource.h>
+#else
+#import "BFTaskCompletionSource.h"
+#endif
+
+#import "BFTask+Private.h"
+
+static NSUInteger const PFURLSessionSchedulerDefaultMaxConcurrentTasksCounts[] = {
+    [PFCommandRunningLaneInteractive] = 8,
+    [PFCommandRunningLaneBackground] = 2,
+    [PFCommandRunningLaneFileTransfer] = 3,
+    [PFCommandRunningLaneEventuallyQueue] = 4,
+};
+
+/**
+ Weight of the latest sample in smoothed wait times and latencies.
+ */
+static double const PFURLSessionSchedulerSmoothingFactor = 0.2;
+
+/**
+ How fast the base latency of a lane follows latencies above it, so that it recovers from a lucky fast request.
+ */
+static double const PFURLSessionSchedulerBaseLatencyDriftFactor = 0.01;
+
+/**
+ Requests that take this many times longer than the base latency of their lane are a sign of congestion.
+ */
+static double const PFURLSessionSchedulerLatencyTolerance = 2.0;
+
+/**
+ Requests faster than this are never a sign of congestion, no matter how fast the base latency is.
+ */
+static NSTimeInterval const PFURLSessionSchedulerMinCongestedLatency = 0.25;
+
+static double const PFURLSessionSchedulerDecreaseFactor = 0.5;
+
+@interface PFURLSessionSchedulerEntry : NSObject
+
+@property (nonatomic, copy, readonly) BFTask *(^block)(void);
+@property (nonatomic, strong, readonly) BFTaskCompletionSource *taskCompletionSource;
+@property (nonatomic, assign, readonly) NSTimeInterval enqueueTime;
+
+@end
+
+@implementation PFURLSessionSchedulerEntry
+
+- (instancetype)initWithBlock:(BFTask *(^)(void))block {
+    self = [super init];
+    if (!self) return nil;
+
+    _block = [block copy];
+    _taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    _enqueueTime = [NSProcessInfo processInfo].systemUptime;
+
+    return self;
+}
+
+@end
+
+@interface PFURLSessionSchedulerLane : NSObject
+
+@property (nonatomic, assign) NSUInteger maxConcurrentTasksCount;
+@property (nonatomic, assign) double concurrentTasksLimit;
+@property (nonatomic, assign) NSUInteger runningTasksCount;
+@property (nonatomic, strong, readonly) NSMutableArray<PFURLSessionSchedulerEntry *> *waitingEntries;
+
+@property (nonatomic, assign) NSTimeInterval averageWaitTime;
+
+/**
+ Whether latencies of requests tell anything about congestion. File transfers take as long as the files are big.
+ */
+@property (nonatomic, assign) BOOL adaptsToLatency;
+@property (nonatomic, assign) NSTimeInterval baseLatency;
+@property (nonatomic, assign) NSTimeInterval lastDecreaseTime;
+
+@end
+
+@implementation PFURLSessionSchedulerLane
+
+- (instancetype)initWithMaxConcurrentTasksCount:(NSUInteger)count {
+    self = [super init];
+    if (!self) return nil;
+
+    _maxConcurrentTasksCount = count;
+    _concurrentTasksLimit = count;
+    _waitingEntries = [NSMutableArray array];
+    _adaptsToLatency = YES;
+
+    return self;
+}
+
+@end
+
+@implementation PFURLSessionScheduler {
+    dispatch_queue_t _stateAccessQueue;
+    NSArray<PFURLSessionSchedulerLane *> *_lanes;
+}
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) return nil;
+
+    _stateAccessQueue = dispatch_queue_create("com.parse.urlSession.scheduler", DISPATCH_QUEUE_SERIAL);
+
+    NSMutableArray *lanes = [NSMutableArray arrayWithCapacity:PFCommandRunningLanesCount];
+    for (NSUInteger lane = 0; lane < PFCommandRunningLanesCount; lane++) {
+        NSUInteger count = PFURLSessionSchedulerDefaultMaxConcurrentTasksCounts[lane];
+        [lanes addObject:[[PFURLSessionSchedulerLane alloc] initWithMaxConcurrentTasksCount:count]];
+    }
+    ((PFURLSessionSchedulerLane *)lanes[PFCommandRunningLaneFileTransfer]).adaptsToLatency = NO;
+    _lanes = [lanes copy];
+
+    return self;
+}
+
+///--------------------------------------
+#pragma mark - Limits
+///--------------------------------------
+
+- (NSUInteger)maxConcurrentTasksCountForLane:(PFCommandRunningLane)lane {
+    __block NSUInteger count = 0;
+    dispatch_sync(_stateAccessQueue, ^{
+        count = self->_lanes[lane].maxConcurrentTasksCount;
+    });
+    return count;
+}
+
+- (void)setMaxConcurrentTasksCount:(NSUInteger)count forLane:(PFCommandRunningLane)lane {
+    NSParameterAssert(count > 0);
+
+    PFURLSessionSchedulerLane *schedulerLane = _lanes[lane];
+    dispatch_sync(_stateAccessQueue, ^{
+        schedulerLane.maxConcurrentTasksCount = count;
+        schedulerLane.concurrentTasksLimit = count;
+    });
+    [self _startWaitingTasksInLane:schedulerLane];
+}
+
+- (NSUInteger)concurrentTasksLimitForLane:(PFCommandRunningLane)lane {
+    __block NSUInteger limit = 0;
+    dispatch_sync(_stateAccessQueue, ^{
+        limit = (NSUInteger)self->_lanes[lane].concurrentTasksLimit;
+    });
+    return limit;
+}
+
+///--------------------------------------
+#pragma mark - Statistics
+///--------------------------------------
+
+- (NSUInteger)runningTasksCountForLane:(PFCommandRunningLane)lane {
+    __block NSUInteger count = 0;
+    dispatch_sync(_stateAccessQueue, ^{
+        count = self->_lanes[lane].runningTasksCount;
+    });
+    return count;
+}
+
+- (NSUInteger)waitingTasksCountForLane:(PFCommandRunningLane)lane {
+    __block NSUInteger count = 0;
+    dispatch_sync(_stateAccessQueue, ^{
+        count = self->_lanes[lane].waitingEntries.count;
+    });
+    return count;
+}
+
+- (NSTimeInterval)averageWaitTimeForLane:(PFCommandRunningLane)lane {
+    __block NSTimeInterval waitTime = 0.0;
+    dispatch_sync(_stateAccessQueue, ^{
+        waitTime = self->_lanes[lane].averageWaitTime;
+    });
+    return waitTime;
+}
+
+///--------------------------------------
+#pragma mark - Scheduling
+///--------------------------------------
+
+- (BFTask *)scheduleTaskInLane:(PFCommandRunningLane)lane
+             cancellationToken:(BFCancellationToken *)cancellationToken
+                     withBlock:(BFTask *(^)(void))block {
+    if (cancellationToken.cancellationRequested) {
+        return [BFTask cancelledTask];
+    }
+
+    PFURLSessionSchedulerLane *schedulerLane = _lanes[lane];
+    PFURLSessionSchedulerEntry *entry = [[PFURLSessionSchedulerEntry alloc] initWithBlock:block];
+    dispatch_sync(_stateAccessQueue, ^{
+        [schedulerLane.waitingEntries addObject:entry];
+    });
+
+    BFCancellationTokenRegistration *registration = [cancellationToken registerCancellationObserverWithBlock:^{
+        __block BOOL wasWaiting = NO;
+        dispatch_sync(self->_stateAccessQueue, ^{
+            NSUInteger index = [schedulerLane.waitingEntries indexOfObjectIdenticalTo:entry];
+            if (index != NSNotFound) {
+                [schedulerLane.waitingEntries removeObjectAtIndex:index];
+                wasWaiting = YES;
+            }
+        });
+        if (wasWaiting) {
+            [entry.taskCompletionSource trySetCancelled];
+        }
+    }];
+    [entry.taskCompletionSource.task continueWithBlock:^id(BFTask *task) {
+        [registration dispose];
+        return nil;
+    }];
+
+    [self _startWaitingTasksInLane:schedulerLane];
+    return entry.taskCompletionSource.task;
+}
+
+- (void)_startWaitingTasksInLane:(PFURLSessionSchedulerLane *)lane {
+    NSMutableArray<PFURLSessionSchedulerEntry *> *entries = [NSMutableArray array];
+    dispatch_sync(_stateAccessQueue, ^{
+        NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+        NSUInteger limit = MAX((NSUInteger)lane.concurrentTasksLimit, 1);
+        while (lane.waitingEntries.count > 0 && lane.runningTasksCount < limit) {
+            PFURLSessionSchedulerEntry *entry = lane.waitingEntries.firstObject;
+            [lane.waitingEntries removeObjectAtIndex:0];
+            lane.runningTasksCount++;
+
+            NSTimeInterval waitTime = now - entry.enqueueTime;
+            lane.averageWaitTime += (waitTime - lane.averageWaitTime) * PFURLSessionSchedulerSmoothingFactor;
+            [entries addObject:entry];
+        }
+    });
+
+    for (PFURLSessionSchedulerEntry *entry in entries) {
+        [self _startEntry:entry inLane:lane];
+    }
+}
+
+- (void)_startEntry:(PFURLSessionSchedulerEntry *)entry inLane:(PFURLSessionSchedulerLane *)lane {
+    NSTimeInterval startTime = [NSProcessInfo processInfo].systemUptime;
+    BFTask *task = entry.block() ?: [BFTask cancelledTask];
+    [task continueWithBlock:^id(BFTask *task) {
+        NSTimeInterval latency = [NSProcessInfo processInfo].systemUptime - startTime;
+        [self _didFinishTask:task inLane:lane withLatency:latency];
+
+        if (task.cancelled) {
+            [entry.taskCompletionSource trySetCancelled];
+        } else if (task.error) {
+            [entry.taskCompletionSource trySetError:task.error];
+        } else {
+            [entry.taskCompletionSource trySetResult:task.result];
+        }
+
+        [self _startWaitingTasksInLane:lane];
+        return nil;
+    }];
+}
+
+///--------------------------------------
+#pragma mark - Adaptive Limits
+///--------------------------------------
+
+- (void)_didFinishTask:(BFTask *)task inLane:(PFURLSessionSchedulerLane *)lane withLatency:(NSTimeInterval)latency {
+    dispatch_sync(_stateAccessQueue, ^{
+        lane.runningTasksCount--;
+        if (task.cancelled) {
+            return;
+        }
+
+        BOOL congested = [[self class] _isCongestionError:task.error];
+        if (!task.error && lane.adaptsToLatency) {
+            if (lane.baseLatency == 0.0 || latency < lane.baseLatency) {
+                lane.baseLatency = latency;
+            } else {
+                lane.baseLatency += (latency - lane.baseLatency) * PFURLSessionSchedulerBaseLatencyDriftFactor;
+            }
+            congested = (latency > PFURLSessionSchedulerMinCongestedLatency &&
+                         latency > lane.baseLatency * PFURLSessionSchedulerLatencyTolerance);
+        }
+
+        if (congested) {
+            // Requests that started before the last decrease ran into the same congestion, don't count them again.
+            NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+            if (now - lane.lastDecreaseTime >= latency) {
+                lane.concurrentTasksLimit = MAX(lane.concurrentTasksLimit * PFURLSessionSchedulerDecreaseFactor, 1.0);
+                lane.lastDecreaseTime = now;
+            }
+        } else if (!task.error) {
+            // Grows by one once every request within the current limit finished without congestion.
+            lane.concurrentTasksLimit = MIN(lane.concurrentTasksLimit + 1.0 / lane.concurrentTasksLimit,
+                                            (double)lane.maxConcurrentTasksCount);
+        }
+    });
+}
+
+/**
+ Only timeouts, lost connections and temporary server errors point to congestion.
+ Errors like a missing connection or an unknown host say nothing about how many requests the network can take.
+ */
++ (BOOL)_isCongestionError:(NSError *)error {
+    if (!error) {
+        return NO;
+    }
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        switch (error.code) {
+            case NSURLErrorTimedOut:
+            case NSURLErrorNetworkConnectionLost:
+            case NSURLErrorCannotConnectToHost:
+                return YES;
+            default:
+                return NO;
+        }
+    }
+    // Connection failures are reported as temporary errors that wrap the original one.
+    NSError *underlyingError = error.userInfo[NSUnderlyingErrorKey];
+    if ([underlyingError isKindOfClass:[NSError class]]) {
+        return [self _isCongestionError:underlyingError];
+    }
+    return [error.userInfo[@"temporary"] boolValue];
+}
+
+@end
@@ -23,6 +23,15 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readonly) BFTask *resultTask;
 
 @property (nonatomic, strong, readonly) NSHTTPURLResponse *response;
+
+/**
+ The response body, unless it was written to a stream by a subclass.
+ */
+@property (nullable, nonatomic, strong, readonly) NSData *responseData;
+
+/**
+ The response body decoded as UTF-8. It is decoded on first access, as most responses never need it.
+ */
 @property (nullable, nonatomic, copy, readonly) NSString *responseString;
 
 - (instancetype)init NS_UNAVAILABLE;
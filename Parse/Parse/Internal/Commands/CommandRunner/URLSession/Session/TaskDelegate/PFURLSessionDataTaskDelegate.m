@@ -21,15 +21,22 @@
 #import "PFAssert.h"
 #import "PFMacros.h"
 
+/**
+ Upper bound for the buffer that is allocated up front from `Content-Length`, so that a bogus header can't make us
+ allocate more than a large response would need anyway.
+ */
+static NSUInteger const PFURLSessionDataTaskDelegateMaxPreallocatedLength = 16 * 1024 * 1024;
+
 @interface PFURLSessionDataTaskDelegate () {
     BFTaskCompletionSource *_taskCompletionSource;
+    NSMutableData *_responseBuffer;
+    NSString *_responseString;
 }
 
 @end
 
 @implementation PFURLSessionDataTaskDelegate
 
-@synthesize dataOutputStream = _dataOutputStream;
 @synthesize downloadedBytes = _downloadedBytes;
 
 ///--------------------------------------
@@ -67,10 +74,16 @@
 }
 
 - (NSOutputStream *)dataOutputStream {
-    if (!_dataOutputStream) {
-        _dataOutputStream = [NSOutputStream outputStreamToMemory];
+    return nil;
+}
+
+- (NSString *)responseString {
+    @synchronized(self) {
+        if (!_responseString && _responseData) {
+            _responseString = [[NSString alloc] initWithData:_responseData encoding:NSUTF8StringEncoding];
+        }
+        return _responseString;
     }
-    return _dataOutputStream;
 }
 
 ///--------------------------------------
@@ -88,6 +101,8 @@
 
 - (void)_taskDidCancel {
     [self _closeDataOutputStream];
+    _responseBuffer = nil;
+    _responseData = nil;
     [_taskCompletionSource trySetCancelled];
 }
 
@@ -95,6 +110,30 @@
     [self.dataTask cancel];
 }
 
+///--------------------------------------
+#pragma mark - Data
+///--------------------------------------
+
+- (void)_appendResponseData:(NSData *)data {
+    _downloadedBytes += data.length;
+    if (!_responseData) {
+        // Most responses arrive in a single chunk, which is used as is.
+        _responseData = data;
+        return;
+    }
+    if (!_responseBuffer) {
+        long long expectedLength = self.response.expectedContentLength;
+        NSUInteger capacity = _responseData.length + data.length;
+        if (expectedLength > (long long)capacity) {
+            capacity = (NSUInteger)MIN(expectedLength, (long long)PFURLSessionDataTaskDelegateMaxPreallocatedLength);
+        }
+        _responseBuffer = [NSMutableData dataWithCapacity:capacity];
+        [_responseBuffer appendData:_responseData];
+        _responseData = _responseBuffer;
+    }
+    [_responseBuffer appendData:data];
+}
+
 ///--------------------------------------
 #pragma mark - Stream
 ///--------------------------------------
@@ -175,7 +214,11 @@ didReceiveResponse:(NSURLResponse *)response
 }
 
 - (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
-    [self _writeDataOutputStreamData:data];
+    if (self.dataOutputStream) {
+        [self _writeDataOutputStreamData:data];
+    } else {
+        [self _appendResponseData:data];
+    }
 }
 
 @end
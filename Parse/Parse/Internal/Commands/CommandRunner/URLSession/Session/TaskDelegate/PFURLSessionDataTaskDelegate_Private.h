@@ -16,16 +16,14 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readonly) dispatch_queue_t dataQueue;
 
 /**
- Defaults to to-memory output stream if not overwritten.
+ Stream that receives the response body. Defaults to `nil`, in which case the body is kept in `responseData`.
  */
-@property (nonatomic, strong, readonly) NSOutputStream *dataOutputStream;
+@property (nullable, nonatomic, strong, readonly) NSOutputStream *dataOutputStream;
 @property (nonatomic, assign, readonly) uint64_t downloadedBytes;
 
 @property (nullable, nonatomic, strong) id result;
 @property (nullable, nonatomic, strong) NSError *error;
 
-@property (nullable, nonatomic, copy, readwrite) NSString *responseString;
-
 - (void)_taskDidFinish NS_REQUIRES_SUPER;
 - (void)_taskDidCancel NS_REQUIRES_SUPER;
 
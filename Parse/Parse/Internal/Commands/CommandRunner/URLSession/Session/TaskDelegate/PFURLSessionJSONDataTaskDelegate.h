@@ -15,6 +15,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface PFURLSessionJSONDataTaskDelegate : PFURLSessionDataTaskDelegate
 
+/**
+ Called on the delegate queue with the elements of the `results` array of a successful response as soon as they are
+ received, before the whole response is. `index` is the position of the first of `results` in the array.
+ Streaming stops quietly at anything unexpected, in which case only the final result has every element.
+ */
+@property (nullable, nonatomic, copy) void (^partialResultsBlock)(NSArray *results, NSUInteger index);
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -25,24 +25,188 @@
 #import "PFMacros.h"
 #import "PFURLSessionDataTaskDelegate_Private.h"
 
-@interface PFURLSessionJSONDataTaskDelegate ()
+/**
+ Finds complete elements of the top-level `results` array in a JSON object that is still being received,
+ without parsing anything else. Only objects are expected in the array.
+ */
+@interface PFJSONResultsScanner : NSObject
+
+/**
+ The number of elements found so far.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Set once the array is over, or something that isn't supported was found.
+ */
+@property (nonatomic, assign, readonly, getter=isFinished) BOOL finished;
+
+/**
+ Scans the bytes received since the last call.
+
+ @param data All of the bytes received so far.
+ @return The elements that were completed by the new bytes.
+ */
+- (NSArray *)elementsByScanningData:(NSData *)data;
+
+@end
+
+@implementation PFJSONResultsScanner {
+    NSUInteger _offset;
+    NSUInteger _depth;
+    BOOL _inString;
+    BOOL _escaped;
+    NSUInteger _stringStart;
+    BOOL _keyIsResults;
+    BOOL _expectsResults;
+    BOOL _inResults;
+    NSUInteger _elementStart;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) return nil;
+
+    _elementStart = NSNotFound;
+
+    return self;
+}
+
+- (NSArray *)elementsByScanningData:(NSData *)data {
+    NSMutableArray *elements = [NSMutableArray array];
+    const char *bytes = data.bytes;
+    NSUInteger length = data.length;
+    for (; _offset < length && !_finished; _offset++) {
+        char c = bytes[_offset];
+        if (_inString) {
+            if (_escaped) {
+                _escaped = NO;
+            } else if (c == '\\') {
+                _escaped = YES;
+            } else if (c == '"') {
+                _inString = NO;
+                if (_depth == 1) {
+                    _keyIsResults = (_offset - _stringStart == 8 && memcmp(&bytes[_stringStart], "\"results", 8) == 0);
+                }
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            continue;
+        }
+
+        if (_inResults && _depth == 2 && _elementStart == NSNotFound && c != ']' && c != ',') {
+            if (c != '{') {
+                _finished = YES;
+                break;
+            }
+            _elementStart = _offset;
+        }
+        if (_depth == 1 && c != ':' && c != '[') {
+            _expectsResults = NO;
+        }
+
+        switch (c) {
+            case '"':
+                _inString = YES;
+                _stringStart = _offset;
+                break;
+            case ':':
+                _expectsResults = (_depth == 1 && _keyIsResults);
+                break;
+            case '{':
+            case '[':
+                if (c == '[' && _depth == 1 && _expectsResults) {
+                    _inResults = YES;
+                }
+                _depth++;
+                break;
+            case '}':
+            case ']':
+                if (_depth == 0) {
+                    _finished = YES;
+                    break;
+                }
+                _depth--;
+                if (_inResults && _depth == 2) {
+                    NSData *elementData = [NSData dataWithBytesNoCopy:(void *)&bytes[_elementStart]
+                                                               length:(_offset + 1 - _elementStart)
+                                                         freeWhenDone:NO];
+                    id element = [NSJSONSerialization JSONObjectWithData:elementData options:0 error:nil];
+                    if (!element) {
+                        _finished = YES;
+                        break;
+                    }
+                    [elements addObject:element];
+                    _elementStart = NSNotFound;
+                } else if (_inResults && _depth == 1) {
+                    _finished = YES;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    _count += elements.count;
+    return elements;
+}
+
+@end
+
+@interface PFURLSessionJSONDataTaskDelegate () {
+    PFJSONResultsScanner *_resultsScanner;
+}
 
 @end
 
 @implementation PFURLSessionJSONDataTaskDelegate
 
+///--------------------------------------
+#pragma mark - Partial Results
+///--------------------------------------
+
+- (void)_scanPartialResults {
+    NSInteger statusCode = self.response.statusCode;
+    if (statusCode < 200 || statusCode >= 400) {
+        return;
+    }
+
+    if (!_resultsScanner) {
+        _resultsScanner = [[PFJSONResultsScanner alloc] init];
+    }
+    if (_resultsScanner.finished) {
+        return;
+    }
+
+    NSUInteger index = _resultsScanner.count;
+    NSArray *results = [_resultsScanner elementsByScanningData:self.responseData];
+    if (results.count > 0) {
+        self.partialResultsBlock(results, index);
+    }
+}
+
+///--------------------------------------
+#pragma mark - NSURLSessionDataDelegate
+///--------------------------------------
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
+    [super URLSession:session dataTask:dataTask didReceiveData:data];
+    if (self.partialResultsBlock && !self.error) {
+        [self _scanPartialResults];
+    }
+}
+
 ///--------------------------------------
 #pragma mark - Private
 ///--------------------------------------
 
 - (void)_taskDidFinish {
-    NSData *data = [self.dataOutputStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    NSData *data = self.responseData;
 
     id result = nil;
 
     NSError *jsonError = nil;
     if (data) {
-        self.responseString = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
         result = [NSJSONSerialization JSONObjectWithData:data
                                                  options:0
                                                    error:&jsonError];
@@ -74,7 +238,7 @@
     if (self.response.statusCode >= 200) {
         if (self.response.statusCode < 400) {
             PFCommandResult *commandResult = [PFCommandResult commandResultWithResult:result
-                                                                         resultString:self.responseString
+                                                                           resultData:data
                                                                          httpResponse:self.response];
             self.result = commandResult;
         } else if ([result isKindOfClass:[NSDictionary class]]) {
@@ -9,6 +9,7 @@
 
 #import <Foundation/Foundation.h>
 
+#import "PFCommandRunningConstants.h"
 #import "PFNetworkCommand.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -25,6 +26,18 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nullable, nonatomic, copy) NSString *localId;
 
+/**
+ Called with the elements of the `results` array of a successful response as soon as they are received,
+ before the whole response is. `index` is the position of the first of `results` in the array.
+ If the command is retried, elements are reported again starting from `0`.
+ */
+@property (nullable, nonatomic, copy) void (^partialResultsBlock)(NSArray *results, NSUInteger index);
+
+/**
+ The lane the request of the command is scheduled in. Default: `PFCommandRunningLaneInteractive`.
+ */
+@property (nonatomic, assign) PFCommandRunningLane lane;
+
 ///--------------------------------------
 #pragma mark - Init
 ///--------------------------------------
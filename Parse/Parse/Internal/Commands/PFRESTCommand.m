@@ -27,7 +27,7 @@ static NSString *const PFRESTCommandSessionTokenEncodingKey = @"sessionToken";
 static NSString *const PFRESTCommandLocalIdEncodingKey = @"localId";
 
 // Increment this when you change the format of cache values.
-static const int PFRESTCommandCacheKeyVersion = 1;
+static const int PFRESTCommandCacheKeyVersion = 2;
 static const int PFRESTCommandCacheKeyParseAPIVersion = 2;
 
 @implementation PFRESTCommand
@@ -85,12 +85,10 @@ static const int PFRESTCommandCacheKeyParseAPIVersion = 2;
         cacheParameters[PFRESTCommandSessionTokenEncodingKey] = self.sessionToken;
     }
 
-    NSString *parametersCacheKey = [PFInternalUtils cacheKeyForObject:cacheParameters];
-
     _cacheKey = [NSString stringWithFormat:@"PFRESTCommand.%i.%@.%@.%ld.%@",
-                 PFRESTCommandCacheKeyVersion, self.httpMethod, PFMD5HashFromString(self.httpPath),
-                 // We use MD5 instead of native hash because it collides too much.
-                 (long)PFRESTCommandCacheKeyParseAPIVersion, PFMD5HashFromString(parametersCacheKey)];
+                 PFRESTCommandCacheKeyVersion, self.httpMethod, PFHash128FromString(self.httpPath),
+                 // We use a 128-bit hash instead of native hash because it collides too much.
+                 (long)PFRESTCommandCacheKeyParseAPIVersion, [PFInternalUtils cacheKeyHashForObject:cacheParameters]];
     return _cacheKey;
 }
 
@@ -20,5 +20,10 @@ static NSString *const PFHTTPRequestMethodPUT = @"PUT";
 
 static NSString *const PFHTTPRequestHeaderNameContentType = @"Content-Type";
 static NSString *const PFHTTPRequestHeaderNameContentLength = @"Content-Length";
+static NSString *const PFHTTPRequestHeaderNameContentEncoding = @"Content-Encoding";
+static NSString *const PFHTTPRequestHeaderNameAcceptEncoding = @"Accept-Encoding";
+
+static NSString *const PFHTTPRequestContentEncodingDeflate = @"deflate";
+static NSString *const PFHTTPRequestContentEncodingGZIP = @"gzip";
 
 #endif
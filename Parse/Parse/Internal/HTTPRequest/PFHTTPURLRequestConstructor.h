@@ -9,6 +9,9 @@
 
 #import <Foundation/Foundation.h>
 
+extern NSUInteger const PFHTTPURLRequestMinimumCompressedBodyLength;
+extern NSString *const PFHTTPURLRequestUncompressedBodyLengthPropertyKey;
+
 @interface PFHTTPURLRequestConstructor : NSObject
 
 + (NSMutableURLRequest *)urlRequestWithURL:(NSURL *)url
@@ -16,4 +19,13 @@
                                httpHeaders:(NSDictionary *)httpHeaders
                                 parameters:(NSDictionary *)parameters;
 
+/**
+ Compresses the body of the request and sets `Content-Encoding: deflate` on it,
+ if the body is at least `PFHTTPURLRequestMinimumCompressedBodyLength` bytes long and gets smaller.
+ The length of the original body is kept in the request with `PFHTTPURLRequestUncompressedBodyLengthPropertyKey`.
+
+ @return `YES` if the body was compressed, otherwise `NO`.
+ */
++ (BOOL)compressBodyOfURLRequest:(NSMutableURLRequest *)request;
+
 @end
@@ -9,12 +9,42 @@
 
 #import "PFHTTPURLRequestConstructor.h"
 
+#import <compression.h>
+
 #import "PFAssert.h"
 #import "PFHTTPRequest.h"
 #import "PFURLConstructor.h"
 
 static NSString *const PFHTTPURLRequestContentTypeJSON = @"application/json; charset=utf-8";
 
+NSUInteger const PFHTTPURLRequestMinimumCompressedBodyLength = 1024;
+NSString *const PFHTTPURLRequestUncompressedBodyLengthPropertyKey = @"PFHTTPURLRequestUncompressedBodyLength";
+
+// `Content-Encoding: deflate` is a zlib stream: a 2-byte header, raw deflate data and an Adler-32 of the original data.
+static const uint8_t PFHTTPURLRequestZlibHeader[] = { 0x78, 0x9C };
+static const NSUInteger PFHTTPURLRequestZlibHeaderLength = sizeof(PFHTTPURLRequestZlibHeader);
+static const NSUInteger PFHTTPURLRequestZlibTrailerLength = sizeof(uint32_t);
+
+static uint32_t PFHTTPURLRequestAdler32(const uint8_t *bytes, NSUInteger length) {
+    static const uint32_t base = 65521;
+    // The largest number of bytes that can be summed up before `b` overflows 32 bits.
+    static const NSUInteger maxBlockLength = 5552;
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (length > 0) {
+        NSUInteger blockLength = MIN(length, maxBlockLength);
+        length -= blockLength;
+        while (blockLength--) {
+            a += *bytes++;
+            b += a;
+        }
+        a %= base;
+        b %= base;
+    }
+    return (b << 16) | a;
+}
+
 @implementation PFHTTPURLRequestConstructor
 
 ///--------------------------------------
@@ -49,4 +79,34 @@ static NSString *const PFHTTPURLRequestContentTypeJSON = @"application/json; cha
     return request;
 }
 
++ (BOOL)compressBodyOfURLRequest:(NSMutableURLRequest *)request {
+    NSData *body = request.HTTPBody;
+    if (body.length < PFHTTPURLRequestMinimumCompressedBodyLength ||
+        [request valueForHTTPHeaderField:PFHTTPRequestHeaderNameContentEncoding]) {
+        return NO;
+    }
+
+    // The encoder fails as soon as it runs out of space, so a compressed body that isn't smaller is never produced.
+    size_t capacity = body.length - PFHTTPURLRequestZlibHeaderLength - PFHTTPURLRequestZlibTrailerLength - 1;
+    NSMutableData *compressedBody = [NSMutableData dataWithLength:(PFHTTPURLRequestZlibHeaderLength + capacity +
+                                                                   PFHTTPURLRequestZlibTrailerLength)];
+    uint8_t *bytes = compressedBody.mutableBytes;
+    size_t length = compression_encode_buffer(bytes + PFHTTPURLRequestZlibHeaderLength, capacity,
+                                              body.bytes, body.length,
+                                              NULL, COMPRESSION_ZLIB);
+    if (length == 0) {
+        return NO;
+    }
+
+    memcpy(bytes, PFHTTPURLRequestZlibHeader, PFHTTPURLRequestZlibHeaderLength);
+    uint32_t checksum = CFSwapInt32HostToBig(PFHTTPURLRequestAdler32(body.bytes, body.length));
+    memcpy(bytes + PFHTTPURLRequestZlibHeaderLength + length, &checksum, PFHTTPURLRequestZlibTrailerLength);
+    compressedBody.length = PFHTTPURLRequestZlibHeaderLength + length + PFHTTPURLRequestZlibTrailerLength;
+
+    [NSURLProtocol setProperty:@(body.length) forKey:PFHTTPURLRequestUncompressedBodyLengthPropertyKey inRequest:request];
+    [request setValue:PFHTTPRequestContentEncodingDeflate forHTTPHeaderField:PFHTTPRequestHeaderNameContentEncoding];
+    request.HTTPBody = compressedBody;
+    return YES;
+}
+
 @end
@@ -9,11 +9,80 @@
 
 #import <Foundation/Foundation.h>
 
+@protocol PFKeyValueCacheCodec;
+
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ Posted by a cache after values were removed, either explicitly or to keep the disk cache within its limits.
+ Lets owners of data derived from the values drop it together with them. Posted on an arbitrary queue.
+ */
+extern NSString *const PFKeyValueCacheDidRemoveValuesNotification;
+
+/**
+ The keys of the removed values in `PFKeyValueCacheDidRemoveValuesNotification`. Missing when all values were removed.
+ */
+extern NSString *const PFKeyValueCacheRemovedKeysUserInfoKey;
+
+typedef NS_ENUM(uint8_t, PFKeyValueCacheStorage) {
+    /**
+     Every value is stored in its own file named after the key, and file modification dates track recent use.
+     */
+    PFKeyValueCacheStorageFiles = 0,
+    /**
+     All values are stored in a single append-only file with an index, and recent use is tracked in memory.
+
+     @see `PFKeyValueCacheLog`
+     */
+    PFKeyValueCacheStorageLog = 1,
+};
+
+/**
+ A snapshot of how values were written to disk since the cache was created.
+ */
+@interface PFKeyValueCacheStatistics : NSObject
+
+@property (nonatomic, assign, readonly) NSUInteger writtenValuesCount;
+@property (nonatomic, assign, readonly) NSUInteger compressedValuesCount;
+
+/**
+ The size of written values as UTF-8.
+ */
+@property (nonatomic, assign, readonly) unsigned long long uncompressedBytes;
+
+/**
+ The size of written values on disk, including the headers of compressed values.
+ */
+@property (nonatomic, assign, readonly) unsigned long long storedBytes;
+
+/**
+ `uncompressedBytes` divided by `storedBytes`, or `1` if nothing was written.
+ */
+@property (nonatomic, assign, readonly) double compressionRatio;
+
+/**
+ The number of stored values that could not be decompressed, and were dropped.
+ */
+@property (nonatomic, assign, readonly) NSUInteger decodingFailuresCount;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
 @interface PFKeyValueCache : NSObject
 
 @property (nonatomic, copy, readonly) NSString *cacheDirectoryPath;
+@property (nonatomic, assign, readonly) PFKeyValueCacheStorage storage;
+
+/**
+ Compresses values that are written to disk, when that makes them smaller. Defaults to `nil`.
+
+ Values that were stored with any built-in codec, or without one, can always be read back.
+ */
+@property (nullable, atomic, strong) id<PFKeyValueCacheCodec> codec;
+
+@property (nonatomic, strong, readonly) PFKeyValueCacheStatistics *statistics;
 
 ///--------------------------------------
 #pragma mark - Init
@@ -23,6 +92,7 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)new NS_UNAVAILABLE;
 
 - (instancetype)initWithCacheDirectoryPath:(NSString *)path;
+- (instancetype)initWithCacheDirectoryPath:(NSString *)path storage:(PFKeyValueCacheStorage)storage;
 
 ///--------------------------------------
 #pragma mark - Setting
@@ -35,8 +105,32 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - Getting
 ///--------------------------------------
 
+/**
+ Returns the value for the key, if it is not older than `age`.
+
+ Values that were set but are not yet written to disk are returned right away,
+ so this never waits for outstanding disk writes.
+ */
 - (nullable NSString *)objectForKey:(NSString *)key maxAge:(NSTimeInterval)age;
 
+/**
+ Returns the value for the key like `objectForKey:maxAge:`.
+
+ @param creationDate Set to the date when the value was stored, if there is a value.
+ */
+- (nullable NSString *)objectForKey:(NSString *)key
+                             maxAge:(NSTimeInterval)age
+                       creationDate:(NSDate *_Nullable *_Nullable)creationDate;
+
+/**
+ Looks up the value for the key like `objectForKey:maxAge:`, without blocking the calling thread.
+
+ @param completion Called on a background queue with the value, or `nil` if there is none.
+ */
+- (void)objectForKey:(NSString *)key
+              maxAge:(NSTimeInterval)age
+          completion:(void (^)(NSString *_Nullable value))completion;
+
 ///--------------------------------------
 #pragma mark - Removing
 ///--------------------------------------
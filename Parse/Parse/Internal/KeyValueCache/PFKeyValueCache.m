@@ -14,14 +14,25 @@
 #import "PFConstants.h"
 #import "PFFileManager.h"
 #import "PFInternalUtils.h"
+#import "PFKeyValueCacheCodec.h"
+#import "PFKeyValueCacheLog.h"
 #import "PFLogging.h"
 
+NSString *const PFKeyValueCacheDidRemoveValuesNotification = @"PFKeyValueCacheDidRemoveValuesNotification";
+NSString *const PFKeyValueCacheRemovedKeysUserInfoKey = @"removedKeys";
+
 static const NSUInteger PFKeyValueCacheDefaultDiskCacheSize = 10 << 20;
 static const NSUInteger PFKeyValueCacheDefaultDiskCacheRecords = 1000;
 static const NSUInteger PFKeyValueCacheDefaultMemoryCacheRecordSize = 1 << 20;
 static const NSTimeInterval PFKeyValueCacheDiskCacheTimeResolution = 1; // HFS+ stores only second level accuracy.
 
-static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
+// Compressed values start with a byte that UTF-8 text never starts with, so both can be stored side by side.
+// Header: magic, codec identifier, uncompressed length (uint32, little endian).
+static const uint8_t PFKeyValueCacheEncodedValueMagic[] = { 0x00, 'P', 'F', 'Z' };
+enum {
+    PFKeyValueCacheEncodedValueMagicLength = sizeof(PFKeyValueCacheEncodedValueMagic),
+    PFKeyValueCacheEncodedValueHeaderLength = PFKeyValueCacheEncodedValueMagicLength + 1 + 4,
+};
 
 @interface PFKeyValueCacheEntry ()
 
@@ -56,13 +67,107 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
 
 @end
 
+///--------------------------------------
+#pragma mark - Disk Cache Entry
+///--------------------------------------
+
+/**
+ A file in the disk cache, linked into the least recently used order.
+ */
+@interface PFKeyValueCacheDiskEntry : NSObject
+
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, assign) NSUInteger size;
+
+// Owned by the index dictionary.
+@property (nullable, nonatomic, unsafe_unretained) PFKeyValueCacheDiskEntry *previous;
+@property (nullable, nonatomic, unsafe_unretained) PFKeyValueCacheDiskEntry *next;
+
+@end
+
+@implementation PFKeyValueCacheDiskEntry
+
+@end
+
+///--------------------------------------
+#pragma mark - Statistics
+///--------------------------------------
+
+@interface PFKeyValueCacheStatistics ()
+
+- (instancetype)initWithWrittenValuesCount:(NSUInteger)writtenValuesCount
+                     compressedValuesCount:(NSUInteger)compressedValuesCount
+                         uncompressedBytes:(unsigned long long)uncompressedBytes
+                               storedBytes:(unsigned long long)storedBytes
+                     decodingFailuresCount:(NSUInteger)decodingFailuresCount NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation PFKeyValueCacheStatistics
+
+- (instancetype)initWithWrittenValuesCount:(NSUInteger)writtenValuesCount
+                     compressedValuesCount:(NSUInteger)compressedValuesCount
+                         uncompressedBytes:(unsigned long long)uncompressedBytes
+                               storedBytes:(unsigned long long)storedBytes
+                     decodingFailuresCount:(NSUInteger)decodingFailuresCount {
+    self = [super init];
+    if (!self) return nil;
+
+    _writtenValuesCount = writtenValuesCount;
+    _compressedValuesCount = compressedValuesCount;
+    _uncompressedBytes = uncompressedBytes;
+    _storedBytes = storedBytes;
+    _decodingFailuresCount = decodingFailuresCount;
+
+    return self;
+}
+
+- (double)compressionRatio {
+    if (_storedBytes == 0) {
+        return 1.0;
+    }
+    return (double)_uncompressedBytes / (double)_storedBytes;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p, values: %lu, compressed: %lu, bytes: %llu -> %llu (%.2fx), failures: %lu>",
+            [self class], self,
+            (unsigned long)_writtenValuesCount, (unsigned long)_compressedValuesCount,
+            _uncompressedBytes, _storedBytes, self.compressionRatio,
+            (unsigned long)_decodingFailuresCount];
+}
+
+@end
+
+
 @implementation PFKeyValueCache {
     NSURL *_cacheDirectoryURL;
     dispatch_queue_t _diskCacheQueue;
 
+    // Values that were set or removed, but not yet written to disk, so reads don't have to wait for the disk queue.
+    // Removals are stored as entries without a value. Only accessed on the pending values queue.
+    dispatch_queue_t _pendingDiskValuesQueue;
+    NSMutableDictionary<NSString *, PFKeyValueCacheEntry *> *_pendingDiskValues;
+    uint64_t _diskWriteGeneration;
+
+    // Only accessed on the disk cache queue.
     NSDate *_lastDiskCacheModDate;
     NSUInteger _lastDiskCacheSize;
-    NSMutableArray *_lastDiskCacheAttributes;
+    NSMutableDictionary<NSString *, PFKeyValueCacheDiskEntry *> *_lastDiskCacheEntries;
+    __unsafe_unretained PFKeyValueCacheDiskEntry *_leastRecentlyUsedDiskCacheEntry;
+    __unsafe_unretained PFKeyValueCacheDiskEntry *_mostRecentlyUsedDiskCacheEntry;
+
+    // Only accessed on the disk cache log queue.
+    dispatch_queue_t _diskCacheLogQueue;
+    PFKeyValueCacheLog *_diskCacheLog;
+
+    // Only accessed on the statistics queue.
+    dispatch_queue_t _statisticsQueue;
+    NSUInteger _writtenValuesCount;
+    NSUInteger _compressedValuesCount;
+    unsigned long long _uncompressedBytes;
+    unsigned long long _storedBytes;
+    NSUInteger _decodingFailuresCount;
 }
 
 ///--------------------------------------
@@ -70,22 +175,39 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
 ///--------------------------------------
 
 - (instancetype)initWithCacheDirectoryPath:(NSString *)path {
+    return [self initWithCacheDirectoryPath:path storage:PFKeyValueCacheStorageFiles];
+}
+
+- (instancetype)initWithCacheDirectoryPath:(NSString *)path storage:(PFKeyValueCacheStorage)storage {
     return [self initWithCacheDirectoryURL:[NSURL fileURLWithPath:path]
                                fileManager:[NSFileManager defaultManager]
-                               memoryCache:[[NSCache alloc] init]];
+                               memoryCache:[[NSCache alloc] init]
+                                   storage:storage];
 }
 
 - (instancetype)initWithCacheDirectoryURL:(NSURL *)url
                               fileManager:(NSFileManager *)fileManager
                               memoryCache:(NSCache *)cache {
+    return [self initWithCacheDirectoryURL:url fileManager:fileManager memoryCache:cache storage:PFKeyValueCacheStorageFiles];
+}
+
+- (instancetype)initWithCacheDirectoryURL:(NSURL *)url
+                              fileManager:(NSFileManager *)fileManager
+                              memoryCache:(NSCache *)cache
+                                  storage:(PFKeyValueCacheStorage)storage {
     self = [super init];
     if (!self) return nil;
 
     _cacheDirectoryURL = url;
     _fileManager = fileManager;
     _memoryCache = cache;
+    _storage = storage;
 
     _diskCacheQueue = dispatch_queue_create("com.parse.keyvaluecache.disk", DISPATCH_QUEUE_SERIAL);
+    _diskCacheLogQueue = dispatch_queue_create("com.parse.keyvaluecache.disk.log", DISPATCH_QUEUE_SERIAL);
+    _pendingDiskValuesQueue = dispatch_queue_create("com.parse.keyvaluecache.disk.pending", DISPATCH_QUEUE_SERIAL);
+    _pendingDiskValues = [NSMutableDictionary dictionary];
+    _statisticsQueue = dispatch_queue_create("com.parse.keyvaluecache.statistics", DISPATCH_QUEUE_SERIAL);
 
     _maxDiskCacheBytes = PFKeyValueCacheDefaultDiskCacheSize;
     _maxDiskCacheRecords = PFKeyValueCacheDefaultDiskCacheRecords;
@@ -94,6 +216,11 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
     return self;
 }
 
+- (void)dealloc {
+    // Persists the index along with the recent use order.
+    [_diskCacheLog close];
+}
+
 ///--------------------------------------
 #pragma mark - Property Accessors
 ///--------------------------------------
@@ -103,6 +230,18 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
     return _cacheDirectoryURL.path;
 }
 
+- (PFKeyValueCacheStatistics *)statistics {
+    __block PFKeyValueCacheStatistics *statistics = nil;
+    dispatch_sync(_statisticsQueue, ^{
+        statistics = [[PFKeyValueCacheStatistics alloc] initWithWrittenValuesCount:self->_writtenValuesCount
+                                                             compressedValuesCount:self->_compressedValuesCount
+                                                                 uncompressedBytes:self->_uncompressedBytes
+                                                                       storedBytes:self->_storedBytes
+                                                             decodingFailuresCount:self->_decodingFailuresCount];
+    });
+    return statistics;
+}
+
 ///--------------------------------------
 #pragma mark - Public
 ///--------------------------------------
@@ -112,23 +251,37 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
 }
 
 - (void)setObject:(NSString *)value forKey:(NSString *)key {
+    PFKeyValueCacheEntry *cacheEntry = [PFKeyValueCacheEntry cacheEntryWithValue:value];
+    [self _setPendingDiskValue:cacheEntry forKey:key];
+
     NSUInteger keyBytes = [key maximumLengthOfBytesUsingEncoding:key.fastestEncoding];
     NSUInteger valueBytes = [value maximumLengthOfBytesUsingEncoding:value.fastestEncoding];
 
     if ((keyBytes + valueBytes) < self.maxMemoryCacheBytesPerRecord) {
-        [self.memoryCache setObject:[PFKeyValueCacheEntry cacheEntryWithValue:value] forKey:key];
+        [self.memoryCache setObject:cacheEntry forKey:key];
     } else {
         [self.memoryCache removeObjectForKey:key];
     }
 
     dispatch_async(_diskCacheQueue, ^{
-        [self _createDiskCacheEntry:value atURL:[self _cacheURLForKey:key]];
-        [self _compactDiskCache];
+        if (self.storage == PFKeyValueCacheStorageLog) {
+            [self _accessDiskCacheLogWithBlock:^(PFKeyValueCacheLog *log) {
+                [log setData:[self _diskDataFromValue:value] forKey:key creationDate:cacheEntry.creationTime];
+                [self _postRemovalOfKeys:[log trimToCount:self.maxDiskCacheRecords size:self.maxDiskCacheBytes]];
+            }];
+        } else {
+            [self _createDiskCacheEntry:value forKey:key];
+            [self _compactDiskCache];
+        }
+        [self _clearPendingDiskValue:cacheEntry forKey:key];
     });
 }
 
 - (NSString *)objectForKey:(NSString *)key maxAge:(NSTimeInterval)maxAge {
-    NSURL *cacheURL = [self _cacheURLForKey:key];
+    return [self objectForKey:key maxAge:maxAge creationDate:NULL];
+}
+
+- (NSString *)objectForKey:(NSString *)key maxAge:(NSTimeInterval)maxAge creationDate:(NSDate **)outCreationDate {
     PFKeyValueCacheEntry *cacheEntry = [self.memoryCache objectForKey:key];
 
     if (cacheEntry) {
@@ -140,46 +293,120 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
         }
 
         dispatch_async(_diskCacheQueue, ^{
-            [self _updateModificationDateAtURL:cacheURL];
+            [self _touchDiskCacheEntryForKey:key];
         });
 
+        if (outCreationDate) {
+            *outCreationDate = cacheEntry.creationTime;
+        }
         return cacheEntry.value;
     }
 
-    // Wait for all outstanding disk operations before continuing, as another thread could be in the process of
-    // Writing a value to disk right now.
-    __block NSString *value = nil;
-    dispatch_sync(_diskCacheQueue, ^{
-        NSDate *modificationDate = [self _modificationDateOfCacheEntryAtURL:cacheURL];
-        if ([[NSDate date] timeIntervalSinceDate:modificationDate] > maxAge) {
+    // Values that are still waiting for the disk queue are served from memory, so reads never wait behind writes.
+    __block PFKeyValueCacheEntry *pendingEntry = nil;
+    __block uint64_t generation = 0;
+    dispatch_sync(_pendingDiskValuesQueue, ^{
+        pendingEntry = self->_pendingDiskValues[key];
+        generation = self->_diskWriteGeneration;
+    });
+    cacheEntry = pendingEntry;
+    if (cacheEntry) {
+        if (!cacheEntry.value) {
+            return nil;
+        }
+        if ([[NSDate date] timeIntervalSinceDate:cacheEntry.creationTime] > maxAge) {
             [self removeObjectForKey:key];
-            return;
+            return nil;
+        }
+        if (outCreationDate) {
+            *outCreationDate = cacheEntry.creationTime;
         }
+        return cacheEntry.value;
+    }
 
-        // Cache misses here (e.g. creationDate and value are both nil) should still be put into the memory cache.
-        value = [self _diskCacheEntryForURL:cacheURL];
-        [self.memoryCache setObject:[PFKeyValueCacheEntry cacheEntryWithValue:value creationTime:modificationDate]
-                             forKey:key];
-    });
+    NSData *data = nil;
+    NSDate *creationDate = nil;
+    if (self.storage == PFKeyValueCacheStorageLog) {
+        data = [self _logDataForKey:key creationDate:&creationDate];
+        if (!data) {
+            return nil;
+        }
+    } else {
+        NSURL *cacheURL = [self _cacheURLForKey:key];
+        creationDate = [self _modificationDateOfCacheEntryAtURL:cacheURL];
+        if (!creationDate) {
+            return nil;
+        }
+        if ([[NSDate date] timeIntervalSinceDate:creationDate] <= maxAge) {
+            data = [self.fileManager contentsAtPath:cacheURL.path];
+        }
+    }
 
+    if ([[NSDate date] timeIntervalSinceDate:creationDate] > maxAge) {
+        [self _removeStaleDiskCacheEntryForKey:key writeGeneration:generation];
+        return nil;
+    }
+
+    NSString *value = (data ? [self _valueFromDiskData:data] : nil);
+    if (data && !value) {
+        [self _removeStaleDiskCacheEntryForKey:key writeGeneration:generation];
+        return nil;
+    }
+
+    // Cache misses here (e.g. the file was removed after its date was read) should still be put into the memory cache.
+    [self _setMemoryCacheEntry:[PFKeyValueCacheEntry cacheEntryWithValue:value creationTime:creationDate]
+                        forKey:key
+               writeGeneration:generation];
+    if (self.storage == PFKeyValueCacheStorageFiles) {
+        // Reading from the log already marks the value as recently used.
+        dispatch_async(_diskCacheQueue, ^{
+            [self _touchDiskCacheEntryForKey:key];
+        });
+    }
+
+    if (outCreationDate && value) {
+        *outCreationDate = creationDate;
+    }
     return value;
 }
 
+- (void)objectForKey:(NSString *)key
+              maxAge:(NSTimeInterval)maxAge
+          completion:(void (^)(NSString *_Nullable value))completion {
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        completion([self objectForKey:key maxAge:maxAge]);
+    });
+}
+
 - (void)removeObjectForKey:(NSString *)key {
+    PFKeyValueCacheEntry *removalEntry = [PFKeyValueCacheEntry cacheEntryWithValue:nil];
+    [self _setPendingDiskValue:removalEntry forKey:key];
     [self.memoryCache removeObjectForKey:key];
+    [self _postRemovalOfKeys:@[ key ]];
 
     dispatch_async(_diskCacheQueue, ^{
-        [self.fileManager removeItemAtURL:[self _cacheURLForKey:key] error:NULL];
+        [self _removeDiskCacheEntryForKey:key];
+        [self _clearPendingDiskValue:removalEntry forKey:key];
     });
 }
 
 - (void)removeAllObjects {
+    dispatch_sync(_pendingDiskValuesQueue, ^{
+        self->_diskWriteGeneration++;
+    });
     [self.memoryCache removeAllObjects];
 
     dispatch_sync(_diskCacheQueue, ^{
+        dispatch_sync(self->_diskCacheLogQueue, ^{
+            [self->_diskCacheLog close];
+            self->_diskCacheLog = nil;
+        });
+        [self _invalidateDiskCache];
+
         // Directory will be automatically recreated the next time 'cacheDir' is accessed.
         [self.fileManager removeItemAtURL:self->_cacheDirectoryURL error:NULL];
     });
+    [self _postRemovalOfKeys:nil];
 }
 
 - (void)waitForOutstandingOperations {
@@ -204,23 +431,204 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
     return [self.fileManager attributesOfItemAtPath:url.path error:NULL][NSFileModificationDate];
 }
 
+/**
+ Must be called on the disk cache queue.
+ */
+- (void)_touchDiskCacheEntryForKey:(NSString *)key {
+    if (self.storage == PFKeyValueCacheStorageLog) {
+        [self _accessDiskCacheLogWithBlock:^(PFKeyValueCacheLog *log) {
+            [log touchKey:key];
+        }];
+        return;
+    }
+
+    [self _updateModificationDateAtURL:[self _cacheURLForKey:key]];
+    PFKeyValueCacheDiskEntry *entry = _lastDiskCacheEntries[key];
+    if (entry && entry != _mostRecentlyUsedDiskCacheEntry) {
+        [self _unlinkDiskCacheEntry:entry];
+        [self _linkDiskCacheEntryAsMostRecentlyUsed:entry];
+    }
+}
+
+/**
+ Must be called on the disk cache queue.
+ */
+- (void)_removeDiskCacheEntryForKey:(NSString *)key {
+    if (self.storage == PFKeyValueCacheStorageLog) {
+        [self _accessDiskCacheLogWithBlock:^(PFKeyValueCacheLog *log) {
+            [log removeStringForKey:key];
+        }];
+        return;
+    }
+
+    BOOL isDirty = [self _isDiskCacheDirty];
+    NSDate *modificationDate = [NSDate date];
+    [self.fileManager removeItemAtURL:[self _cacheURLForKey:key] error:NULL];
+    if (!isDirty) {
+        _lastDiskCacheModDate = modificationDate;
+        [self _removeFromDiskCacheDictionary:key];
+    }
+}
+
+/**
+ Removes an entry that a read found expired or unreadable, unless it was written again since.
+ */
+- (void)_removeStaleDiskCacheEntryForKey:(NSString *)key writeGeneration:(uint64_t)generation {
+    dispatch_async(_diskCacheQueue, ^{
+        if ([self _isDiskWriteGenerationEqualTo:generation]) {
+            [self.memoryCache removeObjectForKey:key];
+            [self _removeDiskCacheEntryForKey:key];
+            [self _postRemovalOfKeys:@[ key ]];
+        }
+    });
+}
+
 ///--------------------------------------
-#pragma mark - Disk Cache
+#pragma mark - Pending Disk Values
 ///--------------------------------------
 
-- (NSString *)_diskCacheEntryForURL:(NSURL *)url {
-    NSData *bytes = [self.fileManager contentsAtPath:url.path];
-    if (!bytes) {
-        return nil;
+- (void)_setPendingDiskValue:(PFKeyValueCacheEntry *)value forKey:(NSString *)key {
+    dispatch_sync(_pendingDiskValuesQueue, ^{
+        self->_pendingDiskValues[key] = value;
+        self->_diskWriteGeneration++;
+    });
+}
+
+- (void)_clearPendingDiskValue:(PFKeyValueCacheEntry *)value forKey:(NSString *)key {
+    dispatch_sync(_pendingDiskValuesQueue, ^{
+        // A newer write for the same key replaces the value, and clears it itself.
+        if (self->_pendingDiskValues[key] == value) {
+            [self->_pendingDiskValues removeObjectForKey:key];
+        }
+    });
+}
+
+- (BOOL)_isDiskWriteGenerationEqualTo:(uint64_t)generation {
+    __block BOOL equal = NO;
+    dispatch_sync(_pendingDiskValuesQueue, ^{
+        equal = (self->_diskWriteGeneration == generation);
+    });
+    return equal;
+}
+
+/**
+ Puts a value read from disk into the memory cache, unless anything was written since the read started.
+ Writers bump the generation before updating the memory cache, so a stale value never replaces a newer one.
+ */
+- (void)_setMemoryCacheEntry:(PFKeyValueCacheEntry *)entry forKey:(NSString *)key writeGeneration:(uint64_t)generation {
+    dispatch_sync(_pendingDiskValuesQueue, ^{
+        if (self->_diskWriteGeneration == generation) {
+            [self.memoryCache setObject:entry forKey:key];
+        }
+    });
+}
+
+///--------------------------------------
+#pragma mark - Disk Cache Log
+///--------------------------------------
+
+/**
+ The log is not thread-safe, so writes from the disk cache queue and reads from any thread take turns here.
+ Reads only wait for the log operation in progress, not for the writes queued behind it.
+ */
+- (void)_accessDiskCacheLogWithBlock:(void (^)(PFKeyValueCacheLog *log))block {
+    dispatch_sync(_diskCacheLogQueue, ^{
+        if (!self->_diskCacheLog && self->_cacheDirectoryURL) {
+            self->_diskCacheLog = [PFKeyValueCacheLog logWithDirectoryURL:self->_cacheDirectoryURL];
+        }
+        block(self->_diskCacheLog);
+    });
+}
+
+- (NSData *)_logDataForKey:(NSString *)key creationDate:(NSDate **)creationDate {
+    __block NSData *data = nil;
+    __block NSDate *date = nil;
+    [self _accessDiskCacheLogWithBlock:^(PFKeyValueCacheLog *log) {
+        NSDate *logCreationDate = nil;
+        data = [log dataForKey:key creationDate:&logCreationDate];
+        date = logCreationDate;
+    }];
+    *creationDate = date;
+    return data;
+}
+
+///--------------------------------------
+#pragma mark - Encoding
+///--------------------------------------
+
+/**
+ Compresses the value with the codec when that makes it smaller, otherwise stores it as plain UTF-8.
+ */
+- (NSData *)_diskDataFromValue:(NSString *)value {
+    NSData *data = [value dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *diskData = data;
+
+    id<PFKeyValueCacheCodec> codec = self.codec;
+    if (codec && data.length <= UINT32_MAX) {
+        NSData *compressedData = [codec compressedDataFromData:data];
+        if (compressedData && compressedData.length + PFKeyValueCacheEncodedValueHeaderLength < data.length) {
+            NSMutableData *encodedData = [NSMutableData dataWithCapacity:PFKeyValueCacheEncodedValueHeaderLength + compressedData.length];
+            [encodedData appendBytes:PFKeyValueCacheEncodedValueMagic length:PFKeyValueCacheEncodedValueMagicLength];
+
+            uint8_t identifier = codec.identifier;
+            [encodedData appendBytes:&identifier length:sizeof(identifier)];
+
+            uint32_t length = CFSwapInt32HostToLittle((uint32_t)data.length);
+            [encodedData appendBytes:&length length:sizeof(length)];
+
+            [encodedData appendData:compressedData];
+            diskData = encodedData;
+        }
     }
 
-    [self _updateModificationDateAtURL:url];
-    return [[NSString alloc] initWithData:bytes encoding:NSUTF8StringEncoding];
+    dispatch_sync(_statisticsQueue, ^{
+        self->_writtenValuesCount++;
+        if (diskData != data) {
+            self->_compressedValuesCount++;
+        }
+        self->_uncompressedBytes += data.length;
+        self->_storedBytes += diskData.length;
+    });
+    return diskData;
 }
 
-- (void)_createDiskCacheEntry:(NSString *)value atURL:(NSURL *)url {
-    NSString *path = url.path;
-    NSData *bytes = [value dataUsingEncoding:NSUTF8StringEncoding];
+- (NSString *)_valueFromDiskData:(NSData *)diskData {
+    const uint8_t *bytes = diskData.bytes;
+    if (diskData.length < PFKeyValueCacheEncodedValueHeaderLength ||
+        memcmp(bytes, PFKeyValueCacheEncodedValueMagic, PFKeyValueCacheEncodedValueMagicLength) != 0) {
+        return [[NSString alloc] initWithData:diskData encoding:NSUTF8StringEncoding];
+    }
+
+    uint8_t identifier = bytes[PFKeyValueCacheEncodedValueMagicLength];
+    uint32_t length = 0;
+    memcpy(&length, bytes + PFKeyValueCacheEncodedValueMagicLength + 1, sizeof(length));
+    length = CFSwapInt32LittleToHost(length);
+
+    id<PFKeyValueCacheCodec> codec = self.codec;
+    if (codec.identifier != identifier) {
+        codec = [PFKeyValueCacheCompressionCodec codecWithIdentifier:identifier];
+    }
+
+    NSRange compressedRange = NSMakeRange(PFKeyValueCacheEncodedValueHeaderLength,
+                                          diskData.length - PFKeyValueCacheEncodedValueHeaderLength);
+    NSData *data = [codec dataFromCompressedData:[diskData subdataWithRange:compressedRange] uncompressedLength:length];
+    NSString *value = (data ? [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] : nil);
+    if (!value) {
+        PFLogWarning(PFLoggingTagCommon, @"Failed to decode cached value with codec %u.", identifier);
+        dispatch_sync(_statisticsQueue, ^{
+            self->_decodingFailuresCount++;
+        });
+    }
+    return value;
+}
+
+///--------------------------------------
+#pragma mark - Disk Cache
+///--------------------------------------
+
+- (void)_createDiskCacheEntry:(NSString *)value forKey:(NSString *)key {
+    NSString *path = [self _cacheURLForKey:key].path;
+    NSData *bytes = [self _diskDataFromValue:value];
     NSDate *creationDate = [NSDate date];
 
     BOOL isDirty = [self _isDiskCacheDirty];
@@ -232,11 +640,7 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
 
     if (!isDirty) {
         _lastDiskCacheModDate = creationDate;
-        _lastDiskCacheSize += bytes.length;
-
-        [self _addToDiskCacheDictionary:path
-                       modificationDate:creationDate
-                                   size:bytes.length];
+        [self _addToDiskCacheDictionary:key size:bytes.length];
     } else {
         [self _invalidateDiskCache];
     }
@@ -262,50 +666,89 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
 - (void)_invalidateDiskCache {
     _lastDiskCacheModDate = nil;
     _lastDiskCacheSize = 0;
-    _lastDiskCacheAttributes = nil;
+    _lastDiskCacheEntries = nil;
+    _leastRecentlyUsedDiskCacheEntry = nil;
+    _mostRecentlyUsedDiskCacheEntry = nil;
 }
 
 - (void)_recreateDiskCache {
-    NSDictionary *cacheDirectoryAttributes = [self.fileManager attributesOfItemAtPath:_cacheDirectoryURL.path error:NULL];
+    [self _invalidateDiskCache];
 
+    NSDictionary *cacheDirectoryAttributes = [self.fileManager attributesOfItemAtPath:_cacheDirectoryURL.path error:NULL];
     _lastDiskCacheModDate = cacheDirectoryAttributes[NSFileModificationDate];
-    _lastDiskCacheSize = 0;
-    _lastDiskCacheAttributes = [[NSMutableArray alloc] init];
+    _lastDiskCacheEntries = [NSMutableDictionary dictionary];
 
     NSDirectoryEnumerator *enumerator = [self.fileManager enumeratorAtPath:_cacheDirectoryURL.path];
+    NSMutableArray<NSArray *> *files = [NSMutableArray array];
     NSString *path = nil;
 
     while ((path = [enumerator nextObject]) != nil) {
         [enumerator skipDescendants];
 
+        // NOTE: Do not use -copy here, as fileAttributes are lazily-loaded, we would run into issues with a lot of
+        // syscalls all at once here.
         NSDictionary *attributes = enumerator.fileAttributes;
-        NSUInteger size = [attributes[NSFileSize] unsignedIntegerValue];
+        [files addObject:@[ path, attributes[NSFileModificationDate] ?: [NSDate distantPast], attributes[NSFileSize] ?: @0 ]];
+    }
 
-        _lastDiskCacheSize += size;
+    // Modification dates are only needed to restore the order, which is kept in memory from now on.
+    [files sortUsingComparator:^NSComparisonResult(NSArray *obj1, NSArray *obj2) {
+        return [obj1[1] compare:obj2[1]];
+    }];
+    for (NSArray *file in files) {
+        [self _addToDiskCacheDictionary:file[0] size:[file[2] unsignedIntegerValue]];
+    }
+}
 
-        // NOTE: Do not use -copy here, as fileAttributes are lazily-loaded, we would run into issues with a lot of
-        // syscalls all at once here.
-        [self _addToDiskCacheDictionary:path
-                       modificationDate:attributes[NSFileModificationDate]
-                                   size:size];
+- (void)_addToDiskCacheDictionary:(NSString *)key size:(NSUInteger)size {
+    if (!_lastDiskCacheEntries) {
+        // Rebuilt from the directory on the next compaction.
+        return;
     }
+    [self _removeFromDiskCacheDictionary:key];
+
+    PFKeyValueCacheDiskEntry *entry = [[PFKeyValueCacheDiskEntry alloc] init];
+    entry.key = key;
+    entry.size = size;
+    _lastDiskCacheEntries[key] = entry;
+    _lastDiskCacheSize += size;
+    [self _linkDiskCacheEntryAsMostRecentlyUsed:entry];
 }
 
-- (void)_addToDiskCacheDictionary:(NSString *)path modificationDate:(NSDate *)modificationDate size:(NSUInteger)size {
-    NSDictionary *entry = @{
-        PFKeyValueCacheDiskCachePathKey: path,
-        NSFileModificationDate: modificationDate,
-        NSFileSize: @(size)
-    };
+- (void)_removeFromDiskCacheDictionary:(NSString *)key {
+    PFKeyValueCacheDiskEntry *entry = _lastDiskCacheEntries[key];
+    if (entry) {
+        [self _unlinkDiskCacheEntry:entry];
+        _lastDiskCacheSize -= entry.size;
+        // The dictionary owns the entry, so this has to come last.
+        [_lastDiskCacheEntries removeObjectForKey:key];
+    }
+}
 
-    NSInteger insertionIndex = [_lastDiskCacheAttributes indexOfObject:entry
-                                                         inSortedRange:NSMakeRange(0, _lastDiskCacheAttributes.count)
-                                                               options:NSBinarySearchingInsertionIndex
-                                                       usingComparator:^NSComparisonResult(id obj1, id obj2) {
-                                                           return [obj1[NSFileModificationDate] compare:obj2[NSFileModificationDate]];
-                                                        }];
+- (void)_linkDiskCacheEntryAsMostRecentlyUsed:(PFKeyValueCacheDiskEntry *)entry {
+    entry.previous = _mostRecentlyUsedDiskCacheEntry;
+    entry.next = nil;
+    if (_mostRecentlyUsedDiskCacheEntry) {
+        _mostRecentlyUsedDiskCacheEntry.next = entry;
+    } else {
+        _leastRecentlyUsedDiskCacheEntry = entry;
+    }
+    _mostRecentlyUsedDiskCacheEntry = entry;
+}
 
-    [_lastDiskCacheAttributes insertObject:entry atIndex:insertionIndex];
+- (void)_unlinkDiskCacheEntry:(PFKeyValueCacheDiskEntry *)entry {
+    if (entry.previous) {
+        entry.previous.next = entry.next;
+    } else {
+        _leastRecentlyUsedDiskCacheEntry = entry.next;
+    }
+    if (entry.next) {
+        entry.next.previous = entry.previous;
+    } else {
+        _mostRecentlyUsedDiskCacheEntry = entry.previous;
+    }
+    entry.previous = nil;
+    entry.next = nil;
 }
 
 - (void)_compactDiskCache {
@@ -313,16 +756,32 @@ static NSString *const PFKeyValueCacheDiskCachePathKey = @"path";
         [self _recreateDiskCache];
     }
 
-    while (_lastDiskCacheAttributes.count > _maxDiskCacheRecords || _lastDiskCacheSize > _maxDiskCacheBytes) {
-        NSDictionary *attributes = _lastDiskCacheAttributes.firstObject;
-        NSString *toRemove = attributes[PFKeyValueCacheDiskCachePathKey];
-        NSNumber *fileSize = attributes[NSFileSize];
-
+    NSMutableArray<NSString *> *removedKeys = [NSMutableArray array];
+    while (_leastRecentlyUsedDiskCacheEntry &&
+           (_lastDiskCacheEntries.count > _maxDiskCacheRecords || _lastDiskCacheSize > _maxDiskCacheBytes)) {
+        NSString *toRemove = _leastRecentlyUsedDiskCacheEntry.key;
         [self.fileManager removeItemAtURL:[self _cacheURLForKey:toRemove] error:NULL];
-        _lastDiskCacheSize -= fileSize.unsignedIntegerValue;
+        [self _removeFromDiskCacheDictionary:toRemove];
+        [removedKeys addObject:toRemove];
+    }
+    [self _postRemovalOfKeys:removedKeys];
+}
+
+///--------------------------------------
+#pragma mark - Notifications
+///--------------------------------------
 
-        [_lastDiskCacheAttributes removeObjectAtIndex:0];
+/**
+ @param keys The removed keys, or `nil` if all values were removed.
+ */
+- (void)_postRemovalOfKeys:(NSArray<NSString *> *)keys {
+    if (keys && keys.count == 0) {
+        return;
     }
+    NSDictionary *userInfo = (keys ? @{ PFKeyValueCacheRemovedKeysUserInfoKey : keys } : nil);
+    [[NSNotificationCenter defaultCenter] postNotificationName:PFKeyValueCacheDidRemoveValuesNotification
+                                                        object:self
+                                                      userInfo:userInfo];
 }
 
 @end
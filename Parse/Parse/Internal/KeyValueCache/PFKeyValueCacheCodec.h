@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Compresses values that `PFKeyValueCache` writes to disk.
+
+ The identifier of the codec is stored with every compressed value, so it must never change for a codec,
+ and must not be reused by a different one.
+ */
+@protocol PFKeyValueCacheCodec <NSObject>
+
+/**
+ Identifies the codec in stored values. Must not be `0`.
+ */
+@property (nonatomic, assign, readonly) uint8_t identifier;
+
+/**
+ @return The compressed data, or `nil` if it would not be smaller than `data`.
+ */
+- (nullable NSData *)compressedDataFromData:(NSData *)data;
+
+/**
+ @return The original data, or `nil` if the data is corrupted or does not decompress to exactly `length` bytes.
+ */
+- (nullable NSData *)dataFromCompressedData:(NSData *)data uncompressedLength:(NSUInteger)length;
+
+@end
+
+typedef NS_ENUM(uint8_t, PFKeyValueCacheCompressionCodecIdentifier) {
+    PFKeyValueCacheCompressionCodecIdentifierZlib = 1,
+    PFKeyValueCacheCompressionCodecIdentifierLZ4 = 2,
+};
+
+/**
+ Codecs backed by the system compression library.
+ */
+@interface PFKeyValueCacheCompressionCodec : NSObject <PFKeyValueCacheCodec>
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+/**
+ Smaller output, at a higher cost per value.
+ */
++ (instancetype)zlibCodec;
+
+/**
+ Faster, with less compression.
+ */
++ (instancetype)lz4Codec;
+
+/**
+ @return The built-in codec with the identifier, or `nil` if there is none.
+ */
++ (nullable instancetype)codecWithIdentifier:(uint8_t)identifier;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import "PFKeyValueCacheCodec.h"
+
+#import <compression.h>
+
+@implementation PFKeyValueCacheCompressionCodec {
+    compression_algorithm _algorithm;
+}
+
+@synthesize identifier = _identifier;
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)initWithIdentifier:(uint8_t)identifier algorithm:(compression_algorithm)algorithm {
+    self = [super init];
+    if (!self) return nil;
+
+    _identifier = identifier;
+    _algorithm = algorithm;
+
+    return self;
+}
+
++ (instancetype)zlibCodec {
+    return [[self alloc] initWithIdentifier:PFKeyValueCacheCompressionCodecIdentifierZlib algorithm:COMPRESSION_ZLIB];
+}
+
++ (instancetype)lz4Codec {
+    return [[self alloc] initWithIdentifier:PFKeyValueCacheCompressionCodecIdentifierLZ4 algorithm:COMPRESSION_LZ4];
+}
+
++ (instancetype)codecWithIdentifier:(uint8_t)identifier {
+    switch (identifier) {
+        case PFKeyValueCacheCompressionCodecIdentifierZlib:
+            return [self zlibCodec];
+        case PFKeyValueCacheCompressionCodecIdentifierLZ4:
+            return [self lz4Codec];
+        default:
+            return nil;
+    }
+}
+
+///--------------------------------------
+#pragma mark - PFKeyValueCacheCodec
+///--------------------------------------
+
+- (NSData *)compressedDataFromData:(NSData *)data {
+    if (data.length == 0) {
+        return nil;
+    }
+
+    // Output that doesn't fit in fewer bytes than the input isn't worth keeping, so the input length is enough room.
+    NSMutableData *compressedData = [NSMutableData dataWithLength:data.length - 1];
+    size_t length = compression_encode_buffer(compressedData.mutableBytes, compressedData.length,
+                                              data.bytes, data.length,
+                                              NULL, _algorithm);
+    if (length == 0) {
+        return nil;
+    }
+    compressedData.length = length;
+    return compressedData;
+}
+
+- (NSData *)dataFromCompressedData:(NSData *)data uncompressedLength:(NSUInteger)length {
+    if (length == 0) {
+        return nil;
+    }
+
+    // One spare byte tells output that is longer than expected apart from output that fills the buffer exactly.
+    NSMutableData *uncompressedData = [NSMutableData dataWithLength:length + 1];
+    size_t decodedLength = compression_decode_buffer(uncompressedData.mutableBytes, uncompressedData.length,
+                                                     data.bytes, data.length,
+                                                     NULL, _algorithm);
+    if (decodedLength != length) {
+        return nil;
+    }
+    uncompressedData.length = length;
+    return uncompressedData;
+}
+
+@end
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Key-value storage in a single append-only data file, with a compact index file next to it.
+
+ Every change is appended to the data file as a checksummed record. The index maps keys to their values in the
+ data file, and is kept in memory along with the least recently used order. It is written to disk after
+ compactions, when enough records were appended since the last write, and when the log is closed.
+ Opening a log loads the index and replays the records appended after it, stopping at the first torn or corrupt
+ record, so a crash at any point loses at most the changes that were never fully written.
+
+ Compaction rewrites live records in least recently used order once most of the data file is dead records.
+
+ This class is not thread-safe; all calls must be serialized by the owner. Several processes can share a log
+ as long as they hold a file lock around their calls and start each of them with `-synchronize`.
+ */
+@interface PFKeyValueCacheLog : NSObject
+
+@property (nonatomic, strong, readonly) NSURL *directoryURL;
+
+/**
+ The number of stored values.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ The total size of stored values in bytes.
+ */
+@property (nonatomic, assign, readonly) NSUInteger size;
+
+/**
+ The keys of stored values, from the least to the most recently used one.
+ */
+@property (nonatomic, copy, readonly) NSArray<NSString *> *keys;
+
+/**
+ Whether the log compacts itself while values are removed. Defaults to `YES`.
+ When it doesn't, the owner is expected to call `-compactIfNeeded` at a convenient time.
+ */
+@property (nonatomic, assign) BOOL automaticallyCompacts;
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+/**
+ Opens the log in the directory, creating the directory and the files if needed.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *)url NS_DESIGNATED_INITIALIZER;
++ (instancetype)logWithDirectoryURL:(NSURL *)url;
+
+///--------------------------------------
+#pragma mark - Accessing Values
+///--------------------------------------
+
+/**
+ Returns the value for the key and marks it as the most recently used one.
+
+ @param key          The key.
+ @param creationDate Set to the date when the value was stored, if the value exists.
+ */
+- (nullable NSData *)dataForKey:(NSString *)key creationDate:(NSDate *_Nullable *_Nullable)creationDate;
+- (nullable NSString *)stringForKey:(NSString *)key creationDate:(NSDate *_Nullable *_Nullable)creationDate;
+
+/**
+ Returns the value for the key, without changing the least recently used order.
+ */
+- (nullable NSData *)peekDataForKey:(NSString *)key;
+
+/**
+ Marks the value for the key as the most recently used one, without reading it.
+ */
+- (void)touchKey:(NSString *)key;
+
+/**
+ @return Whether the value was written.
+ */
+- (BOOL)setData:(NSData *)data forKey:(NSString *)key creationDate:(NSDate *)creationDate;
+- (void)setString:(NSString *)string forKey:(NSString *)key creationDate:(NSDate *)creationDate;
+- (void)removeStringForKey:(NSString *)key;
+
+/**
+ Removes least recently used values until at most `count` values that are at most `size` bytes in total are left.
+
+ @return The keys of the removed values.
+ */
+- (NSArray<NSString *> *)trimToCount:(NSUInteger)count size:(NSUInteger)size;
+
+/**
+ Starts over with an empty data file.
+ */
+- (void)removeAllValues;
+
+- (void)compactIfNeeded;
+
+///--------------------------------------
+#pragma mark - Sharing Between Processes
+///--------------------------------------
+
+/**
+ Catches up with the records that other processes appended to the data file since the last call,
+ or opens the log again if another process replaced the data file.
+
+ Processes that share the log must hold a file lock around this call and the changes that follow it.
+ */
+- (void)synchronize;
+
+///--------------------------------------
+#pragma mark - Closing
+///--------------------------------------
+
+/**
+ Writes the index and closes the data file. The log can't be used afterwards.
+ */
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,816 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import "PFKeyValueCacheLog.h"
+
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+#import "PFLogging.h"
+
+static NSString *const PFKeyValueCacheLogDataFileName = @"cache.log";
+static NSString *const PFKeyValueCacheLogIndexFileName = @"cache.index";
+static NSString *const PFKeyValueCacheLogCompactionFileName = @"cache.log.compacting";
+
+static const uint8_t PFKeyValueCacheLogMagic[] = { 'P', 'F', 'K', 'V', 'L', 'O', 'G' };
+static const uint8_t PFKeyValueCacheLogVersion = 1;
+
+enum {
+    // Random identifier of the data file, which changes on every compaction, so that a stale index is never used.
+    PFKeyValueCacheLogIdentifierLength = 16,
+    // Magic (7), version (1), identifier (16).
+    PFKeyValueCacheLogFileHeaderLength = 24,
+    // Type (1), key length (4), value length (4), creation time (8), checksum (4).
+    PFKeyValueCacheLogRecordHeaderLength = 21,
+    PFKeyValueCacheLogRecordChecksumOffset = 17,
+};
+
+typedef NS_ENUM(uint8_t, PFKeyValueCacheLogRecordType) {
+    PFKeyValueCacheLogRecordTypeSet = 1,
+    PFKeyValueCacheLogRecordTypeRemove = 2,
+};
+
+// Compaction only runs once dead records take at least this much space, and more space than live records.
+static const off_t PFKeyValueCacheLogMinimumCompactionBytes = 256 << 10;
+// Bounds the number of records that are replayed when the log is opened.
+static const off_t PFKeyValueCacheLogIndexWriteIntervalBytes = 1 << 20;
+
+static NSString *const PFKeyValueCacheLogIndexVersionKey = @"version";
+static NSString *const PFKeyValueCacheLogIndexIdentifierKey = @"identifier";
+static NSString *const PFKeyValueCacheLogIndexLengthKey = @"length";
+static NSString *const PFKeyValueCacheLogIndexEntriesKey = @"entries";
+
+///--------------------------------------
+#pragma mark - Records
+///--------------------------------------
+
+static uint32_t PFKeyValueCacheLogChecksum(uint32_t hash, const uint8_t *bytes, NSUInteger length) {
+    // FNV-1a, which is plenty to detect torn writes.
+    for (NSUInteger i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t PFKeyValueCacheLogReadUInt32(const uint8_t *bytes) {
+    uint32_t value = 0;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt32LittleToHost(value);
+}
+
+static void PFKeyValueCacheLogWriteUInt32(uint8_t *bytes, uint32_t value) {
+    value = CFSwapInt32HostToLittle(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+/**
+ @return Whether the checksum in the header of a record matches its header, key and value.
+ */
+static BOOL PFKeyValueCacheLogRecordIsIntact(const uint8_t *record, NSUInteger length) {
+    uint32_t checksum = PFKeyValueCacheLogChecksum(2166136261u, record, PFKeyValueCacheLogRecordChecksumOffset);
+    checksum = PFKeyValueCacheLogChecksum(checksum, record + PFKeyValueCacheLogRecordHeaderLength,
+                                          length - PFKeyValueCacheLogRecordHeaderLength);
+    return (checksum == PFKeyValueCacheLogReadUInt32(record + PFKeyValueCacheLogRecordChecksumOffset));
+}
+
+static NSTimeInterval PFKeyValueCacheLogReadTime(const uint8_t *bytes) {
+    uint64_t bits = 0;
+    memcpy(&bits, bytes, sizeof(bits));
+    bits = CFSwapInt64LittleToHost(bits);
+
+    NSTimeInterval time = 0.0;
+    memcpy(&time, &bits, sizeof(time));
+    return time;
+}
+
+static void PFKeyValueCacheLogWriteTime(uint8_t *bytes, NSTimeInterval time) {
+    uint64_t bits = 0;
+    memcpy(&bits, &time, sizeof(bits));
+    bits = CFSwapInt64HostToLittle(bits);
+    memcpy(bytes, &bits, sizeof(bits));
+}
+
+/**
+ @return Header for a new data file, with a new identifier.
+ */
+static NSData *PFKeyValueCacheLogCreateFileHeader(void) {
+    uint8_t header[PFKeyValueCacheLogFileHeaderLength];
+    memcpy(header, PFKeyValueCacheLogMagic, sizeof(PFKeyValueCacheLogMagic));
+    header[sizeof(PFKeyValueCacheLogMagic)] = PFKeyValueCacheLogVersion;
+    [[NSUUID UUID] getUUIDBytes:header + sizeof(PFKeyValueCacheLogMagic) + 1];
+    return [NSData dataWithBytes:header length:sizeof(header)];
+}
+
+static NSData *PFKeyValueCacheLogIdentifierFromFileHeader(NSData *header) {
+    return [header subdataWithRange:NSMakeRange(sizeof(PFKeyValueCacheLogMagic) + 1, PFKeyValueCacheLogIdentifierLength)];
+}
+
+static BOOL PFKeyValueCacheLogWriteAll(int fileDescriptor, const void *bytes, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t written = pwrite(fileDescriptor, bytes, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        bytes = (const uint8_t *)bytes + written;
+        length -= (size_t)written;
+        offset += written;
+    }
+    return YES;
+}
+
+static BOOL PFKeyValueCacheLogReadAll(int fileDescriptor, void *bytes, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t read = pread(fileDescriptor, bytes, length, offset);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read <= 0) {
+            return NO;
+        }
+        bytes = (uint8_t *)bytes + read;
+        length -= (size_t)read;
+        offset += read;
+    }
+    return YES;
+}
+
+///--------------------------------------
+#pragma mark - Entry
+///--------------------------------------
+
+@interface PFKeyValueCacheLogEntry : NSObject
+
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, assign) off_t offset;
+@property (nonatomic, assign) uint32_t keyLength;
+@property (nonatomic, assign) uint32_t valueLength;
+@property (nonatomic, assign) NSTimeInterval creationTime;
+
+// Entries are owned by the index, and linked from the least to the most recently used.
+@property (nullable, nonatomic, unsafe_unretained) PFKeyValueCacheLogEntry *previous;
+@property (nullable, nonatomic, unsafe_unretained) PFKeyValueCacheLogEntry *next;
+
+@property (nonatomic, assign, readonly) off_t recordLength;
+
+@end
+
+@implementation PFKeyValueCacheLogEntry
+
+- (off_t)recordLength {
+    return PFKeyValueCacheLogRecordHeaderLength + (off_t)_keyLength + (off_t)_valueLength;
+}
+
+@end
+
+///--------------------------------------
+#pragma mark - Log
+///--------------------------------------
+
+@implementation PFKeyValueCacheLog {
+    int _fileDescriptor;
+    NSData *_identifier;
+
+    off_t _dataLength;
+    off_t _deadLength;
+    off_t _indexedLength;
+
+    NSMutableDictionary<NSString *, PFKeyValueCacheLogEntry *> *_entries;
+    __unsafe_unretained PFKeyValueCacheLogEntry *_leastRecentlyUsedEntry;
+    __unsafe_unretained PFKeyValueCacheLogEntry *_mostRecentlyUsedEntry;
+}
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)initWithDirectoryURL:(NSURL *)url {
+    self = [super init];
+    if (!self) return nil;
+
+    _directoryURL = url;
+    _fileDescriptor = -1;
+    _entries = [NSMutableDictionary dictionary];
+    _automaticallyCompacts = YES;
+
+    [[NSFileManager defaultManager] createDirectoryAtURL:url withIntermediateDirectories:YES attributes:nil error:NULL];
+    [self _open];
+
+    return self;
+}
+
++ (instancetype)logWithDirectoryURL:(NSURL *)url {
+    return [[self alloc] initWithDirectoryURL:url];
+}
+
+- (void)dealloc {
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+}
+
+///--------------------------------------
+#pragma mark - Accessors
+///--------------------------------------
+
+- (NSUInteger)count {
+    return _entries.count;
+}
+
+- (NSArray<NSString *> *)keys {
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:_entries.count];
+    for (PFKeyValueCacheLogEntry *entry = _leastRecentlyUsedEntry; entry; entry = entry.next) {
+        [keys addObject:entry.key];
+    }
+    return keys;
+}
+
+///--------------------------------------
+#pragma mark - Accessing Values
+///--------------------------------------
+
+- (NSString *)stringForKey:(NSString *)key creationDate:(NSDate **)creationDate {
+    NSData *data = [self dataForKey:key creationDate:creationDate];
+    return (data ? [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] : nil);
+}
+
+- (NSData *)dataForKey:(NSString *)key creationDate:(NSDate **)creationDate {
+    PFKeyValueCacheLogEntry *entry = _entries[key];
+    NSData *data = [self _valueDataForEntry:entry];
+    if (!data) {
+        return nil;
+    }
+
+    [self _moveEntryToMostRecentlyUsed:entry];
+    if (creationDate) {
+        *creationDate = [NSDate dateWithTimeIntervalSince1970:entry.creationTime];
+    }
+    return data;
+}
+
+- (NSData *)peekDataForKey:(NSString *)key {
+    return [self _valueDataForEntry:_entries[key]];
+}
+
+- (NSData *)_valueDataForEntry:(PFKeyValueCacheLogEntry *)entry {
+    if (!entry || _fileDescriptor < 0) {
+        return nil;
+    }
+
+    // The whole record is read to verify its checksum, the index might have been written before the record itself.
+    NSMutableData *record = [NSMutableData dataWithLength:(NSUInteger)entry.recordLength];
+    if (!PFKeyValueCacheLogReadAll(_fileDescriptor, record.mutableBytes, record.length, entry.offset)) {
+        PFLogError(PFLoggingTagCommon, @"Failed to read cache entry: %s", strerror(errno));
+        return nil;
+    }
+    const uint8_t *bytes = record.bytes;
+    if (bytes[0] != PFKeyValueCacheLogRecordTypeSet ||
+        PFKeyValueCacheLogReadUInt32(bytes + 5) != entry.valueLength ||
+        !PFKeyValueCacheLogRecordIsIntact(bytes, record.length)) {
+        PFLogWarning(PFLoggingTagCommon, @"Discarding corrupt cache entry for key %@.", entry.key);
+        [self _removeEntry:entry];
+        return nil;
+    }
+    return [record subdataWithRange:NSMakeRange(record.length - entry.valueLength, entry.valueLength)];
+}
+
+- (void)touchKey:(NSString *)key {
+    PFKeyValueCacheLogEntry *entry = _entries[key];
+    if (entry) {
+        [self _moveEntryToMostRecentlyUsed:entry];
+    }
+}
+
+- (void)setString:(NSString *)string forKey:(NSString *)key creationDate:(NSDate *)creationDate {
+    [self setData:[string dataUsingEncoding:NSUTF8StringEncoding] forKey:key creationDate:creationDate];
+}
+
+- (BOOL)setData:(NSData *)valueData forKey:(NSString *)key creationDate:(NSDate *)creationDate {
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    NSTimeInterval creationTime = creationDate.timeIntervalSince1970;
+
+    off_t offset = [self _appendRecordWithType:PFKeyValueCacheLogRecordTypeSet
+                                       keyData:keyData
+                                     valueData:valueData
+                                  creationTime:creationTime];
+    if (offset < 0) {
+        return NO;
+    }
+
+    PFKeyValueCacheLogEntry *entry = [[PFKeyValueCacheLogEntry alloc] init];
+    entry.key = key;
+    entry.offset = offset;
+    entry.keyLength = (uint32_t)keyData.length;
+    entry.valueLength = (uint32_t)valueData.length;
+    entry.creationTime = creationTime;
+    [self _insertEntry:entry];
+
+    [self _compactIfNeeded];
+    return YES;
+}
+
+- (void)removeStringForKey:(NSString *)key {
+    PFKeyValueCacheLogEntry *entry = _entries[key];
+    if (entry) {
+        [self _removeEntry:entry];
+        [self _compactIfNeeded];
+    }
+}
+
+- (NSArray<NSString *> *)trimToCount:(NSUInteger)count size:(NSUInteger)size {
+    NSMutableArray<NSString *> *removedKeys = [NSMutableArray array];
+    while (_leastRecentlyUsedEntry && (_entries.count > count || _size > size)) {
+        NSString *key = _leastRecentlyUsedEntry.key;
+        if (![self _removeEntry:_leastRecentlyUsedEntry]) {
+            break;
+        }
+        [removedKeys addObject:key];
+    }
+    if (removedKeys.count > 0) {
+        [self _compactIfNeeded];
+    }
+    return removedKeys;
+}
+
+- (void)removeAllValues {
+    if (_fileDescriptor >= 0) {
+        [self _resetWithFileDescriptor:_fileDescriptor];
+    }
+}
+
+- (void)compactIfNeeded {
+    if ([self _shouldCompact]) {
+        [self _compact];
+    }
+}
+
+///--------------------------------------
+#pragma mark - Sharing Between Processes
+///--------------------------------------
+
+- (void)synchronize {
+    if (_fileDescriptor < 0) {
+        [self _reopen];
+        return;
+    }
+
+    NSString *path = [self _pathForFileName:PFKeyValueCacheLogDataFileName];
+    struct stat fileStat;
+    struct stat pathStat;
+    BOOL replaced = (fstat(_fileDescriptor, &fileStat) != 0 ||
+                     stat(path.fileSystemRepresentation, &pathStat) != 0 ||
+                     fileStat.st_dev != pathStat.st_dev ||
+                     fileStat.st_ino != pathStat.st_ino);
+    if (!replaced) {
+        // Resetting the log rewrites the same file with a new identifier.
+        uint8_t identifier[PFKeyValueCacheLogIdentifierLength];
+        replaced = (fileStat.st_size < _dataLength ||
+                    !PFKeyValueCacheLogReadAll(_fileDescriptor, identifier, sizeof(identifier), sizeof(PFKeyValueCacheLogMagic) + 1) ||
+                    memcmp(identifier, _identifier.bytes, sizeof(identifier)) != 0);
+    }
+    if (replaced) {
+        [self _reopen];
+        return;
+    }
+    if (fileStat.st_size == _dataLength) {
+        return;
+    }
+
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:NULL];
+    if (data.length <= (NSUInteger)_dataLength) {
+        return;
+    }
+    _dataLength = [self _replayRecordsInData:data fromOffset:_dataLength];
+    if (_dataLength < (off_t)data.length) {
+        PFLogWarning(PFLoggingTagCommon, @"Discarding %lld bytes of corrupt cache log records.",
+                     (long long)data.length - (long long)_dataLength);
+        ftruncate(_fileDescriptor, _dataLength);
+    }
+    [self _updateDeadLength];
+}
+
+- (void)_reopen {
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+    [self _removeAllEntries];
+    _identifier = nil;
+    _dataLength = 0;
+    _deadLength = 0;
+    _indexedLength = 0;
+    [self _open];
+}
+
+///--------------------------------------
+#pragma mark - Closing
+///--------------------------------------
+
+- (void)close {
+    if (_fileDescriptor < 0) {
+        return;
+    }
+    // Also persists the least recently used order, which isn't part of the data file.
+    [self _writeIndex];
+    close(_fileDescriptor);
+    _fileDescriptor = -1;
+}
+
+///--------------------------------------
+#pragma mark - Index
+///--------------------------------------
+
+- (void)_insertEntry:(PFKeyValueCacheLogEntry *)entry {
+    PFKeyValueCacheLogEntry *existingEntry = _entries[entry.key];
+    if (existingEntry) {
+        [self _discardEntry:existingEntry];
+    }
+
+    _entries[entry.key] = entry;
+    _size += entry.valueLength;
+    [self _linkEntryAsMostRecentlyUsed:entry];
+}
+
+/**
+ Appends a remove record for the entry, and drops it from the index.
+ */
+- (BOOL)_removeEntry:(PFKeyValueCacheLogEntry *)entry {
+    NSData *keyData = [entry.key dataUsingEncoding:NSUTF8StringEncoding];
+    off_t offset = [self _appendRecordWithType:PFKeyValueCacheLogRecordTypeRemove
+                                       keyData:keyData
+                                     valueData:nil
+                                  creationTime:0.0];
+    if (offset < 0) {
+        return NO;
+    }
+    // Remove records are only needed until the next compaction.
+    _deadLength += _dataLength - offset;
+    [self _discardEntry:entry];
+    return YES;
+}
+
+- (void)_discardEntry:(PFKeyValueCacheLogEntry *)entry {
+    [self _unlinkEntry:entry];
+    _size -= entry.valueLength;
+    _deadLength += entry.recordLength;
+    // The index owns the entry, so this has to come last.
+    [_entries removeObjectForKey:entry.key];
+}
+
+- (void)_moveEntryToMostRecentlyUsed:(PFKeyValueCacheLogEntry *)entry {
+    if (entry != _mostRecentlyUsedEntry) {
+        [self _unlinkEntry:entry];
+        [self _linkEntryAsMostRecentlyUsed:entry];
+    }
+}
+
+- (void)_linkEntryAsMostRecentlyUsed:(PFKeyValueCacheLogEntry *)entry {
+    entry.previous = _mostRecentlyUsedEntry;
+    entry.next = nil;
+    if (_mostRecentlyUsedEntry) {
+        _mostRecentlyUsedEntry.next = entry;
+    } else {
+        _leastRecentlyUsedEntry = entry;
+    }
+    _mostRecentlyUsedEntry = entry;
+}
+
+- (void)_unlinkEntry:(PFKeyValueCacheLogEntry *)entry {
+    if (entry.previous) {
+        entry.previous.next = entry.next;
+    } else {
+        _leastRecentlyUsedEntry = entry.next;
+    }
+    if (entry.next) {
+        entry.next.previous = entry.previous;
+    } else {
+        _mostRecentlyUsedEntry = entry.previous;
+    }
+    entry.previous = nil;
+    entry.next = nil;
+}
+
+- (void)_removeAllEntries {
+    [_entries removeAllObjects];
+    _leastRecentlyUsedEntry = nil;
+    _mostRecentlyUsedEntry = nil;
+    _size = 0;
+}
+
+///--------------------------------------
+#pragma mark - Opening
+///--------------------------------------
+
+- (void)_open {
+    NSString *path = [self _pathForFileName:PFKeyValueCacheLogDataFileName];
+    _fileDescriptor = open(path.fileSystemRepresentation, O_RDWR | O_CREAT, 0644);
+    if (_fileDescriptor < 0) {
+        PFLogError(PFLoggingTagCommon, @"Failed to open cache log: %s", strerror(errno));
+        return;
+    }
+
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:NULL];
+    if (![self _readFileHeaderFromData:data]) {
+        if (![self _resetWithFileDescriptor:_fileDescriptor]) {
+            close(_fileDescriptor);
+            _fileDescriptor = -1;
+        }
+        return;
+    }
+
+    off_t replayOffset = ([self _readIndexForData:data] ? _indexedLength : PFKeyValueCacheLogFileHeaderLength);
+    _dataLength = [self _replayRecordsInData:data fromOffset:replayOffset];
+    if (_dataLength < (off_t)data.length) {
+        // Drop the torn tail, so that new records are appended right after the last valid one.
+        PFLogWarning(PFLoggingTagCommon, @"Discarding %lld bytes of corrupt cache log records.",
+                     (long long)data.length - (long long)_dataLength);
+        ftruncate(_fileDescriptor, _dataLength);
+    }
+
+    [self _updateDeadLength];
+}
+
+- (void)_updateDeadLength {
+    off_t liveLength = 0;
+    for (PFKeyValueCacheLogEntry *entry in _entries.objectEnumerator) {
+        liveLength += entry.recordLength;
+    }
+    _deadLength = _dataLength - PFKeyValueCacheLogFileHeaderLength - liveLength;
+}
+
+- (BOOL)_readFileHeaderFromData:(NSData *)data {
+    if (data.length < PFKeyValueCacheLogFileHeaderLength) {
+        return NO;
+    }
+    const uint8_t *bytes = data.bytes;
+    if (memcmp(bytes, PFKeyValueCacheLogMagic, sizeof(PFKeyValueCacheLogMagic)) != 0 ||
+        bytes[sizeof(PFKeyValueCacheLogMagic)] != PFKeyValueCacheLogVersion) {
+        return NO;
+    }
+    _identifier = PFKeyValueCacheLogIdentifierFromFileHeader(data);
+    return YES;
+}
+
+/**
+ Loads the index if it matches the data file. On success, records up to `_indexedLength` are already applied.
+ */
+- (BOOL)_readIndexForData:(NSData *)data {
+    NSData *indexData = [NSData dataWithContentsOfFile:[self _pathForFileName:PFKeyValueCacheLogIndexFileName]];
+    if (!indexData) {
+        return NO;
+    }
+    NSDictionary *index = [NSPropertyListSerialization propertyListWithData:indexData options:0 format:NULL error:NULL];
+    if (![index isKindOfClass:[NSDictionary class]] ||
+        ![index[PFKeyValueCacheLogIndexVersionKey] isEqual:@(PFKeyValueCacheLogVersion)] ||
+        ![index[PFKeyValueCacheLogIndexIdentifierKey] isEqual:_identifier]) {
+        return NO;
+    }
+
+    off_t length = [index[PFKeyValueCacheLogIndexLengthKey] longLongValue];
+    NSArray *entries = index[PFKeyValueCacheLogIndexEntriesKey];
+    if (length < PFKeyValueCacheLogFileHeaderLength || length > (off_t)data.length || ![entries isKindOfClass:[NSArray class]]) {
+        return NO;
+    }
+
+    for (NSArray *values in entries) {
+        if (![values isKindOfClass:[NSArray class]] || values.count != 4 || ![values[0] isKindOfClass:[NSString class]]) {
+            [self _removeAllEntries];
+            return NO;
+        }
+        PFKeyValueCacheLogEntry *entry = [[PFKeyValueCacheLogEntry alloc] init];
+        entry.key = values[0];
+        entry.offset = [values[1] longLongValue];
+        entry.keyLength = (uint32_t)[entry.key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        entry.valueLength = [values[2] unsignedIntValue];
+        entry.creationTime = [values[3] doubleValue];
+        if (entry.offset < PFKeyValueCacheLogFileHeaderLength || entry.offset + entry.recordLength > length) {
+            [self _removeAllEntries];
+            return NO;
+        }
+        [self _insertEntry:entry];
+    }
+    _indexedLength = length;
+    return YES;
+}
+
+/**
+ @return The offset right after the last valid record.
+ */
+- (off_t)_replayRecordsInData:(NSData *)data fromOffset:(off_t)offset {
+    const uint8_t *bytes = data.bytes;
+    off_t length = (off_t)data.length;
+    while (length - offset >= PFKeyValueCacheLogRecordHeaderLength) {
+        const uint8_t *header = bytes + offset;
+        uint8_t type = header[0];
+        uint32_t keyLength = PFKeyValueCacheLogReadUInt32(header + 1);
+        uint32_t valueLength = PFKeyValueCacheLogReadUInt32(header + 5);
+        off_t recordLength = PFKeyValueCacheLogRecordHeaderLength + (off_t)keyLength + (off_t)valueLength;
+        if ((type != PFKeyValueCacheLogRecordTypeSet && type != PFKeyValueCacheLogRecordTypeRemove) ||
+            recordLength > length - offset) {
+            break;
+        }
+
+        if (!PFKeyValueCacheLogRecordIsIntact(header, (NSUInteger)recordLength)) {
+            break;
+        }
+        NSString *key = [[NSString alloc] initWithBytes:header + PFKeyValueCacheLogRecordHeaderLength
+                                                 length:keyLength
+                                               encoding:NSUTF8StringEncoding];
+        if (!key) {
+            break;
+        }
+
+        if (type == PFKeyValueCacheLogRecordTypeSet) {
+            PFKeyValueCacheLogEntry *entry = [[PFKeyValueCacheLogEntry alloc] init];
+            entry.key = key;
+            entry.offset = offset;
+            entry.keyLength = keyLength;
+            entry.valueLength = valueLength;
+            entry.creationTime = PFKeyValueCacheLogReadTime(header + 9);
+            [self _insertEntry:entry];
+        } else {
+            PFKeyValueCacheLogEntry *entry = _entries[key];
+            if (entry) {
+                [self _unlinkEntry:entry];
+                [_entries removeObjectForKey:key];
+                _size -= entry.valueLength;
+            }
+        }
+        offset += recordLength;
+    }
+    return offset;
+}
+
+/**
+ Starts a new, empty data file, with a new identifier.
+ */
+- (BOOL)_resetWithFileDescriptor:(int)fileDescriptor {
+    NSData *header = PFKeyValueCacheLogCreateFileHeader();
+    if (ftruncate(fileDescriptor, 0) != 0 ||
+        !PFKeyValueCacheLogWriteAll(fileDescriptor, header.bytes, header.length, 0)) {
+        PFLogError(PFLoggingTagCommon, @"Failed to create cache log: %s", strerror(errno));
+        return NO;
+    }
+
+    [self _removeAllEntries];
+    _identifier = PFKeyValueCacheLogIdentifierFromFileHeader(header);
+    _dataLength = PFKeyValueCacheLogFileHeaderLength;
+    _deadLength = 0;
+    _indexedLength = 0;
+    [[NSFileManager defaultManager] removeItemAtPath:[self _pathForFileName:PFKeyValueCacheLogIndexFileName] error:NULL];
+    return YES;
+}
+
+///--------------------------------------
+#pragma mark - Writing
+///--------------------------------------
+
+/**
+ @return Offset of the appended record, or `-1` if it couldn't be written.
+ */
+- (off_t)_appendRecordWithType:(PFKeyValueCacheLogRecordType)type
+                       keyData:(NSData *)keyData
+                     valueData:(nullable NSData *)valueData
+                  creationTime:(NSTimeInterval)creationTime {
+    if (_fileDescriptor < 0) {
+        return -1;
+    }
+
+    NSMutableData *record = [NSMutableData dataWithLength:PFKeyValueCacheLogRecordHeaderLength];
+    uint8_t *header = record.mutableBytes;
+    header[0] = type;
+    PFKeyValueCacheLogWriteUInt32(header + 1, (uint32_t)keyData.length);
+    PFKeyValueCacheLogWriteUInt32(header + 5, (uint32_t)valueData.length);
+    PFKeyValueCacheLogWriteTime(header + 9, creationTime);
+
+    uint32_t checksum = PFKeyValueCacheLogChecksum(2166136261u, header, PFKeyValueCacheLogRecordChecksumOffset);
+    checksum = PFKeyValueCacheLogChecksum(checksum, keyData.bytes, keyData.length);
+    checksum = PFKeyValueCacheLogChecksum(checksum, valueData.bytes, valueData.length);
+    PFKeyValueCacheLogWriteUInt32(header + PFKeyValueCacheLogRecordChecksumOffset, checksum);
+
+    [record appendData:keyData];
+    if (valueData) {
+        [record appendData:valueData];
+    }
+
+    off_t offset = _dataLength;
+    if (!PFKeyValueCacheLogWriteAll(_fileDescriptor, record.bytes, record.length, offset)) {
+        PFLogError(PFLoggingTagCommon, @"Failed to append to cache log: %s", strerror(errno));
+        ftruncate(_fileDescriptor, offset);
+        return -1;
+    }
+    _dataLength += record.length;
+    return offset;
+}
+
+- (void)_compactIfNeeded {
+    if (_automaticallyCompacts && [self _shouldCompact]) {
+        [self _compact];
+    } else if (_dataLength - _indexedLength >= PFKeyValueCacheLogIndexWriteIntervalBytes) {
+        [self _writeIndex];
+    }
+}
+
+- (BOOL)_shouldCompact {
+    off_t recordsLength = _dataLength - PFKeyValueCacheLogFileHeaderLength;
+    return (_fileDescriptor >= 0 &&
+            _deadLength >= PFKeyValueCacheLogMinimumCompactionBytes && _deadLength * 2 > recordsLength);
+}
+
+/**
+ Copies live records into a new data file in least recently used order, so that a full replay restores the order,
+ and atomically replaces the current data file with it.
+ */
+- (void)_compact {
+    NSString *path = [self _pathForFileName:PFKeyValueCacheLogCompactionFileName];
+    int fileDescriptor = open(path.fileSystemRepresentation, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0) {
+        PFLogError(PFLoggingTagCommon, @"Failed to compact cache log: %s", strerror(errno));
+        return;
+    }
+
+    NSMutableArray<NSNumber *> *offsets = [NSMutableArray arrayWithCapacity:_entries.count];
+    NSMutableData *buffer = [NSMutableData data];
+    NSMutableArray<PFKeyValueCacheLogEntry *> *orderedEntries = [NSMutableArray arrayWithCapacity:_entries.count];
+    for (PFKeyValueCacheLogEntry *entry = _leastRecentlyUsedEntry; entry; entry = entry.next) {
+        [orderedEntries addObject:entry];
+    }
+
+    NSData *header = PFKeyValueCacheLogCreateFileHeader();
+    BOOL success = PFKeyValueCacheLogWriteAll(fileDescriptor, header.bytes, header.length, 0);
+    off_t offset = PFKeyValueCacheLogFileHeaderLength;
+    for (PFKeyValueCacheLogEntry *entry in orderedEntries) {
+        if (!success) {
+            break;
+        }
+        buffer.length = (NSUInteger)entry.recordLength;
+        // Records are copied as is, their checksums don't depend on where they are.
+        success = (PFKeyValueCacheLogReadAll(_fileDescriptor, buffer.mutableBytes, buffer.length, entry.offset) &&
+                   PFKeyValueCacheLogWriteAll(fileDescriptor, buffer.bytes, buffer.length, offset));
+        [offsets addObject:@(offset)];
+        offset += entry.recordLength;
+    }
+    success = (success &&
+               fsync(fileDescriptor) == 0 &&
+               rename(path.fileSystemRepresentation, [self _pathForFileName:PFKeyValueCacheLogDataFileName].fileSystemRepresentation) == 0);
+    if (!success) {
+        PFLogError(PFLoggingTagCommon, @"Failed to compact cache log: %s", strerror(errno));
+        close(fileDescriptor);
+        unlink(path.fileSystemRepresentation);
+        return;
+    }
+
+    close(_fileDescriptor);
+    _fileDescriptor = fileDescriptor;
+    _identifier = PFKeyValueCacheLogIdentifierFromFileHeader(header);
+    [orderedEntries enumerateObjectsUsingBlock:^(PFKeyValueCacheLogEntry *entry, NSUInteger i, BOOL *stop) {
+        entry.offset = offsets[i].longLongValue;
+    }];
+    _dataLength = offset;
+    _deadLength = 0;
+    [self _writeIndex];
+}
+
+- (void)_writeIndex {
+    // The records have to be on disk before an index that points to them.
+    if (_fileDescriptor < 0 || fsync(_fileDescriptor) != 0) {
+        PFLogError(PFLoggingTagCommon, @"Failed to sync cache log: %s", strerror(errno));
+        return;
+    }
+
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:_entries.count];
+    for (PFKeyValueCacheLogEntry *entry = _leastRecentlyUsedEntry; entry; entry = entry.next) {
+        [entries addObject:@[ entry.key, @(entry.offset), @(entry.valueLength), @(entry.creationTime) ]];
+    }
+    NSDictionary *index = @{ PFKeyValueCacheLogIndexVersionKey : @(PFKeyValueCacheLogVersion),
+                             PFKeyValueCacheLogIndexIdentifierKey : _identifier,
+                             PFKeyValueCacheLogIndexLengthKey : @(_dataLength),
+                             PFKeyValueCacheLogIndexEntriesKey : entries };
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:index
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0
+                                                               error:NULL];
+    if ([data writeToFile:[self _pathForFileName:PFKeyValueCacheLogIndexFileName] atomically:YES]) {
+        _indexedLength = _dataLength;
+    }
+}
+
+///--------------------------------------
+#pragma mark - Paths
+///--------------------------------------
+
+- (NSString *)_pathForFileName:(NSString *)fileName {
+    return [_directoryURL URLByAppendingPathComponent:fileName].path;
+}
+
+@end
@@ -30,7 +30,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithCacheDirectoryURL:(nullable NSURL *)url
                               fileManager:(nullable NSFileManager *)fileManager
-                              memoryCache:(nullable NSCache *)cache NS_DESIGNATED_INITIALIZER;
+                              memoryCache:(nullable NSCache *)cache;
+- (instancetype)initWithCacheDirectoryURL:(nullable NSURL *)url
+                              fileManager:(nullable NSFileManager *)fileManager
+                              memoryCache:(nullable NSCache *)cache
+                                  storage:(PFKeyValueCacheStorage)storage NS_DESIGNATED_INITIALIZER;
 
 ///--------------------------------------
 #pragma mark - Waiting
@@ -46,19 +50,19 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - Properties
 ///--------------------------------------
 
-@property (atomic, copy, readonly) NSString *value;
+@property (nullable, atomic, copy, readonly) NSString *value;
 @property (atomic, strong, readonly) NSDate *creationTime;
 
 ///--------------------------------------
 #pragma mark - Init
 ///--------------------------------------
 
-+ (instancetype)cacheEntryWithValue:(NSString *)value;
-+ (instancetype)cacheEntryWithValue:(NSString *)value creationTime:(NSDate *)creationTime;
++ (instancetype)cacheEntryWithValue:(nullable NSString *)value;
++ (instancetype)cacheEntryWithValue:(nullable NSString *)value creationTime:(NSDate *)creationTime;
 
 - (instancetype)init NS_UNAVAILABLE;
-- (instancetype)initWithValue:(NSString *)value;
-- (instancetype)initWithValue:(NSString *)value
+- (instancetype)initWithValue:(nullable NSString *)value;
+- (instancetype)initWithValue:(nullable NSString *)value
                  creationTime:(NSDate *)creationTime NS_DESIGNATED_INITIALIZER;
 
 @end
@@ -22,12 +22,56 @@
 
 typedef BFTask<NSNumber *> * (^PFConstraintMatcherBlock)(PFObject *object, PFSQLiteDatabase *database);
 
+/**
+ Synchronous counterpart of `PFConstraintMatcherBlock`.
+
+ @return YES iff the object matches. Returns NO and sets `error` if the object can't be matched.
+ */
+typedef BOOL (^PFConstraintPredicateBlock)(PFObject *object, NSError **error);
+
 typedef NS_OPTIONS(uint8_t, PFOfflineQueryOption) {
     PFOfflineQueryOptionOrder = 1 << 0,
     PFOfflineQueryOptionLimit = 1 << 1,
     PFOfflineQueryOptionSkip = 1 << 2,
 };
 
+/**
+ Collects the objects that match a query, and only keeps the ones that are returned
+ once the order, skip and limit of the query are applied. Objects that can't make the cut are released right away.
+ */
+@interface PFOfflineQueryResultsCollector : NSObject
+
+/**
+ Whether no more objects can be returned, so the remaining objects don't need to be matched.
+ */
+@property (nonatomic, assign, readonly, getter=isSaturated) BOOL saturated;
+
+/**
+ The collected objects, sorted, with skip and limit applied.
+ */
+@property (nonatomic, copy, readonly) NSArray<PFObject *> *results;
+
+/**
+ The number of objects that were added.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ @param comparator The order of the results, or `nil` to keep the order in which objects are added.
+ @param skip       The number of objects to skip.
+ @param limit      The maximum number of results, or `NSNotFound` for no limit.
+ */
+- (instancetype)initWithComparator:(NSComparator)comparator skip:(NSUInteger)skip limit:(NSUInteger)limit;
+
+/**
+ @return A collector that only counts the objects that are added, without keeping them.
+ */
++ (instancetype)countingCollector;
+
+- (void)addObject:(PFObject *)object;
+
+@end
+
 @interface PFOfflineQueryLogic : NSObject
 
 /**
@@ -53,6 +97,13 @@ typedef NS_OPTIONS(uint8_t, PFOfflineQueryOption) {
  */
 - (PFConstraintMatcherBlock)createMatcherForQueryState:(PFQueryState *)queryState user:(PFUser *)user;
 
+/**
+ Returns a PFConstraintPredicateBlock that returns true iff the object matches the given query's constraints,
+ without going through tasks. Returns `nil` if the query has subqueries, which need the database to be matched;
+ `createMatcherForQueryState:user:` must be used instead in that case.
+ */
+- (PFConstraintPredicateBlock)createPredicateForQueryState:(PFQueryState *)queryState user:(PFUser *)user;
+
 /**
  Sort given array with given `PFQuery` constraint.
 
@@ -62,6 +113,12 @@ typedef NS_OPTIONS(uint8_t, PFOfflineQueryOption) {
                          ofQueryState:(PFQueryState *)queryState
                             toResults:(NSArray *)results;
 
+/**
+ @return A collector that applies the given options of the query to objects as they are matched.
+ */
+- (PFOfflineQueryResultsCollector *)resultsCollectorWithOptions:(PFOfflineQueryOption)options
+                                                    ofQueryState:(PFQueryState *)queryState;
+
 /**
  Make sure all of the objects included by the given query get fetched.
  */
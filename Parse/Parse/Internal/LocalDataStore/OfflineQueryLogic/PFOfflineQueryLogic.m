@@ -34,6 +34,11 @@
 typedef BOOL (^PFComparatorDeciderBlock)(id value, id constraint);
 typedef BOOL (^PFSubQueryMatcherBlock)(id object, NSArray *results);
 
+/**
+ Matches an object synchronously. Raises an exception if the object can't be matched.
+ */
+typedef BOOL (^PFConstraintEvaluatorBlock)(PFObject *object);
+
 /**
  A query to be used in $inQuery, $notInQuery, $select and $dontSelect
  */
@@ -81,6 +86,159 @@ typedef BOOL (^PFSubQueryMatcherBlock)(id object, NSArray *results);
 
 @end
 
+@interface PFOfflineQueryResultsCollector () {
+    NSComparator _comparator;
+    NSUInteger _skip;
+    NSUInteger _limit;
+    NSUInteger _capacity;
+    NSUInteger _addedObjectsCount;
+    BOOL _countsOnly;
+    NSMutableArray<PFObject *> *_objects;
+    NSMutableArray<NSNumber *> *_sequenceNumbers;
+}
+
+@end
+
+@implementation PFOfflineQueryResultsCollector
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)initWithComparator:(NSComparator)comparator skip:(NSUInteger)skip limit:(NSUInteger)limit {
+    self = [super init];
+    if (!self) return nil;
+
+    _comparator = [comparator copy];
+    _skip = skip;
+    _limit = limit;
+    _capacity = (limit == NSNotFound ? NSNotFound : skip + limit);
+    _objects = [NSMutableArray array];
+    _sequenceNumbers = [NSMutableArray array];
+
+    return self;
+}
+
++ (instancetype)countingCollector {
+    PFOfflineQueryResultsCollector *collector = [[self alloc] initWithComparator:nil skip:0 limit:NSNotFound];
+    collector->_countsOnly = YES;
+    return collector;
+}
+
+///--------------------------------------
+#pragma mark - Collecting
+///--------------------------------------
+
+- (NSUInteger)count {
+    return _addedObjectsCount;
+}
+
+- (BOOL)isSaturated {
+    // Without an order, only the first objects are returned.
+    return (!_comparator && _capacity != NSNotFound && _objects.count >= _capacity);
+}
+
+- (void)addObject:(PFObject *)object {
+    NSNumber *sequenceNumber = @(_addedObjectsCount++);
+    if (_countsOnly) {
+        return;
+    }
+    if (_capacity == NSNotFound || _objects.count < _capacity) {
+        [_objects addObject:object];
+        [_sequenceNumbers addObject:sequenceNumber];
+        if (_comparator && _capacity != NSNotFound) {
+            [self _siftUpFromIndex:_objects.count - 1];
+        }
+        return;
+    }
+
+    // The heap is full: its root is the last object that makes the cut, so replace it if the new one is before it.
+    // Objects that were added later sort after equal ones, like with a stable sort, so the new one never ties.
+    if (_comparator && _capacity > 0 && _comparator(object, _objects[0]) == NSOrderedAscending) {
+        _objects[0] = object;
+        _sequenceNumbers[0] = sequenceNumber;
+        [self _siftDownFromIndex:0];
+    }
+}
+
+- (NSArray<PFObject *> *)results {
+    NSMutableArray<PFObject *> *results = nil;
+    if (_comparator) {
+        NSMutableArray<NSNumber *> *indexes = [NSMutableArray arrayWithCapacity:_objects.count];
+        for (NSUInteger i = 0; i < _objects.count; i++) {
+            [indexes addObject:@(i)];
+        }
+        [indexes sortUsingComparator:^NSComparisonResult(NSNumber *lhs, NSNumber *rhs) {
+            return [self _compareObjectAtIndex:lhs.unsignedIntegerValue withObjectAtIndex:rhs.unsignedIntegerValue];
+        }];
+        results = [NSMutableArray arrayWithCapacity:_objects.count];
+        for (NSNumber *index in indexes) {
+            [results addObject:_objects[index.unsignedIntegerValue]];
+        }
+    } else {
+        results = [_objects mutableCopy];
+    }
+    if (_skip > 0) {
+        [results removeObjectsInRange:NSMakeRange(0, MIN(_skip, results.count))];
+    }
+    if (_limit != NSNotFound && results.count > _limit) {
+        [results removeObjectsInRange:NSMakeRange(_limit, results.count - _limit)];
+    }
+    return [results copy];
+}
+
+///--------------------------------------
+#pragma mark - Heap
+///--------------------------------------
+
+// `_objects` is a binary heap with the object that sorts last at its root.
+
+- (NSComparisonResult)_compareObjectAtIndex:(NSUInteger)lhs withObjectAtIndex:(NSUInteger)rhs {
+    NSComparisonResult result = _comparator(_objects[lhs], _objects[rhs]);
+    if (result == NSOrderedSame) {
+        result = [_sequenceNumbers[lhs] compare:_sequenceNumbers[rhs]];
+    }
+    return result;
+}
+
+- (void)_exchangeObjectAtIndex:(NSUInteger)lhs withObjectAtIndex:(NSUInteger)rhs {
+    [_objects exchangeObjectAtIndex:lhs withObjectAtIndex:rhs];
+    [_sequenceNumbers exchangeObjectAtIndex:lhs withObjectAtIndex:rhs];
+}
+
+- (void)_siftUpFromIndex:(NSUInteger)index {
+    while (index > 0) {
+        NSUInteger parent = (index - 1) / 2;
+        if ([self _compareObjectAtIndex:index withObjectAtIndex:parent] != NSOrderedDescending) {
+            return;
+        }
+        [self _exchangeObjectAtIndex:index withObjectAtIndex:parent];
+        index = parent;
+    }
+}
+
+- (void)_siftDownFromIndex:(NSUInteger)index {
+    NSUInteger count = _objects.count;
+    while (YES) {
+        NSUInteger largest = index;
+        NSUInteger left = 2 * index + 1;
+        NSUInteger right = left + 1;
+        if (left < count && [self _compareObjectAtIndex:left withObjectAtIndex:largest] == NSOrderedDescending) {
+            largest = left;
+        }
+        if (right < count && [self _compareObjectAtIndex:right withObjectAtIndex:largest] == NSOrderedDescending) {
+            largest = right;
+        }
+        if (largest == index) {
+            return;
+        }
+        [self _exchangeObjectAtIndex:index withObjectAtIndex:largest];
+        index = largest;
+    }
+}
+
+@end
+
 @interface PFOfflineQueryLogic ()
 
 @property (nonatomic, weak) PFOfflineStore *offlineStore;
@@ -627,15 +785,136 @@ greaterThanOrEqualTo:(id)constraint {
     };
 }
 
+/**
+ Returns a PFConstraintEvaluatorBlock that combines the given evaluators with AND.
+ */
+- (PFConstraintEvaluatorBlock)createAndEvaluatorWithEvaluators:(NSArray<PFConstraintEvaluatorBlock> *)evaluators {
+    if (evaluators.count == 0) {
+        return ^BOOL (PFObject *object) {
+            return YES;
+        };
+    }
+    if (evaluators.count == 1) {
+        return evaluators.firstObject;
+    }
+    return ^BOOL (PFObject *object) {
+        for (PFConstraintEvaluatorBlock evaluator in evaluators) {
+            if (!evaluator(object)) {
+                return NO;
+            }
+        }
+        return YES;
+    };
+}
+
+/**
+ Returns PFConstraintEvaluatorBlocks for the constraints of the given queries,
+ or `nil` if any of them needs the database.
+ */
+- (NSArray<PFConstraintEvaluatorBlock> *)createEvaluatorsForQueries:(NSArray *)queries {
+    NSMutableArray<PFConstraintEvaluatorBlock> *evaluators = [NSMutableArray arrayWithCapacity:queries.count];
+    for (PFQuery *query in queries) {
+        PFConstraintEvaluatorBlock evaluator = [self createEvaluatorWithQueryConstraints:query.state.conditions];
+        if (!evaluator) {
+            return nil;
+        }
+        [evaluators addObject:evaluator];
+    }
+    return evaluators;
+}
+
+/**
+ Returns a PFConstraintEvaluatorBlock for the constraints on a single key, or `nil` if they can only be
+ matched with the database, which is the case for $inQuery, $notInQuery, $select and $dontSelect.
+ */
+- (PFConstraintEvaluatorBlock)createEvaluatorForKey:(NSString *)key constraint:(id)queryConstraintValue {
+    if ([key isEqualToString:PFQueryKeyOr]) {
+        NSArray<PFConstraintEvaluatorBlock> *evaluators = [self createEvaluatorsForQueries:queryConstraintValue];
+        if (!evaluators) {
+            return nil;
+        }
+        return ^BOOL (PFObject *object) {
+            for (PFConstraintEvaluatorBlock evaluator in evaluators) {
+                if (evaluator(object)) {
+                    return YES;
+                }
+            }
+            return NO;
+        };
+    } else if ([key isEqualToString:PFQueryKeyAnd]) {
+        NSArray<PFConstraintEvaluatorBlock> *evaluators = [self createEvaluatorsForQueries:queryConstraintValue];
+        if (!evaluators) {
+            return nil;
+        }
+        return [self createAndEvaluatorWithEvaluators:evaluators];
+    } else if ([key isEqualToString:PFQueryKeyRelatedTo]) {
+        return ^BOOL (PFObject *object) {
+            PFObject *parent = queryConstraintValue[PFQueryKeyObject];
+            NSString *relationKey = queryConstraintValue[PFQueryKeyKey];
+            PFRelation *relation = parent[relationKey];
+            return [relation _hasKnownObject:object];
+        };
+    } else if ([queryConstraintValue isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *keyConstraints = (NSDictionary *)queryConstraintValue;
+        for (NSString *operator in keyConstraints) {
+            if ([operator isEqualToString:PFQueryKeyInQuery] ||
+                [operator isEqualToString:PFQueryKeyNotInQuery] ||
+                [operator isEqualToString:PFQueryKeySelect] ||
+                [operator isEqualToString:PFQueryKeyDontSelect]) {
+                return nil;
+            }
+        }
+        // The value is only looked up once for all operators on the key.
+        return ^BOOL (PFObject *object) {
+            id value = [self valueForContainer:object key:key];
+            for (NSString *operator in keyConstraints) {
+                if (![[self class] matchesValue:value
+                                     constraint:keyConstraints[operator]
+                                       operator:operator
+                              allKeyConstraints:keyConstraints]) {
+                    return NO;
+                }
+            }
+            return YES;
+        };
+    }
+
+    // It's not a set of constraints, so it's just a value to compare against.
+    return ^BOOL (PFObject *object) {
+        id objectValue = [self valueForContainer:object key:key];
+        return [[self class] matchesValue:objectValue equalTo:queryConstraintValue];
+    };
+}
+
+/**
+ Returns a PFConstraintEvaluatorBlock that returns true iff the object matches queryConstraints,
+ or `nil` if any of the constraints needs the database.
+ */
+- (PFConstraintEvaluatorBlock)createEvaluatorWithQueryConstraints:(NSDictionary *)queryConstraints {
+    NSMutableArray<PFConstraintEvaluatorBlock> *evaluators = [NSMutableArray arrayWithCapacity:queryConstraints.count];
+    for (NSString *key in queryConstraints) {
+        PFConstraintEvaluatorBlock evaluator = [self createEvaluatorForKey:key constraint:queryConstraints[key]];
+        if (!evaluator) {
+            return nil;
+        }
+        [evaluators addObject:evaluator];
+    }
+    return [self createAndEvaluatorWithEvaluators:evaluators];
+}
+
 /**
  Returns a PFConstraintMatcherBlock that return true iff the object matches queryConstraints. This
  takes in a SQLiteDatabase connection because SQLite is finicky about nesting connections, so we
  want to reuse them whenever possible.
  */
 - (PFConstraintMatcherBlock)createMatcherWithQueryConstraints:(NSDictionary *)queryConstraints user:(PFUser *)user {
+    NSMutableArray *evaluators = [[NSMutableArray alloc] init];
     NSMutableArray *matchers = [[NSMutableArray alloc] init];
     [queryConstraints enumerateKeysAndObjectsUsingBlock:^(id key, id queryConstraintValue, BOOL *stop) {
-        if ([key isEqualToString:PFQueryKeyOr]) {
+        PFConstraintEvaluatorBlock evaluator = [self createEvaluatorForKey:key constraint:queryConstraintValue];
+        if (evaluator) {
+            [evaluators addObject:evaluator];
+        } else if ([key isEqualToString:PFQueryKeyOr]) {
             // A set of queries to be OR-ed together
             PFConstraintMatcherBlock matcher = [self createOrMatcherForQueries:queryConstraintValue user:user];
             [matchers addObject:matcher];
@@ -643,17 +922,8 @@ greaterThanOrEqualTo:(id)constraint {
             // A set of queries to be AND-ed together
             PFConstraintMatcherBlock matcher = [self createAndMatcherForQueries:queryConstraintValue user:user];
             [matchers addObject:matcher];
-        } else if ([key isEqualToString:PFQueryKeyRelatedTo]) {
-            PFConstraintMatcherBlock matcher = ^BFTask *(PFObject *object, PFSQLiteDatabase *database) {
-                PFObject *parent = queryConstraintValue[PFQueryKeyObject];
-                NSString *relationKey = queryConstraintValue[PFQueryKeyKey];
-                PFRelation *relation = parent[relationKey];
-
-                return [BFTask taskWithResult:@([relation _hasKnownObject:object])];
-            };
-            [matchers addObject:matcher];
-        } else if ([queryConstraintValue isKindOfClass:[NSDictionary class]]) {
-            // If it's a set of constraints that should be AND-ed together
+        } else {
+            // A set of constraints with subqueries that should be AND-ed together
             NSDictionary *keyConstraints = (NSDictionary *)queryConstraintValue;
             [keyConstraints enumerateKeysAndObjectsUsingBlock:^(id operator, id keyConstraintValue, BOOL *stop) {
                 PFConstraintMatcherBlock matcher = [self createMatcherWithOperator:operator
@@ -663,19 +933,27 @@ greaterThanOrEqualTo:(id)constraint {
                                                                               user:user];
                 [matchers addObject:matcher];
             }];
-        } else {
-            // It's not a set of constraints, so it's just a value to compare against.
-            PFConstraintMatcherBlock matcher = ^BFTask *(PFObject *object, PFSQLiteDatabase *database) {
-                id objectValue = [self valueForContainer:object key:key];
-                BOOL matches = [[self class] matchesValue:objectValue equalTo:queryConstraintValue];
-                return [BFTask taskWithResult:@(matches)];
-            };
-            [matchers addObject:matcher];
         }
     }];
 
     // Now AND together the constraints for each key
+    PFConstraintEvaluatorBlock evaluator = [self createAndEvaluatorWithEvaluators:evaluators];
     return ^BFTask *(PFObject *object, PFSQLiteDatabase *database) {
+        // Constraints that don't need the database are checked inline, before any of the subqueries.
+        @try {
+            if (!evaluator(object)) {
+                return [BFTask taskWithResult:@NO];
+            }
+        } @catch (NSException *exception) {
+            NSError *error = [PFErrorUtilities errorWithCode:kPFErrorInvalidQuery
+                                                     message:exception.reason
+                                                   shouldLog:NO];
+            return [BFTask taskWithError:error];
+        }
+        if (matchers.count == 0) {
+            return [BFTask taskWithResult:@YES];
+        }
+
         BFTask *task = [BFTask taskWithResult:@YES];
         for (PFConstraintMatcherBlock matcher in matchers) {
             task = [task continueWithSuccessBlock:^id(BFTask *task) {
@@ -829,6 +1107,32 @@ greaterThanOrEqualTo:(id)constraint {
     };
 }
 
+- (PFConstraintPredicateBlock)createPredicateForQueryState:(PFQueryState *)queryState user:(PFUser *)user {
+    PFConstraintEvaluatorBlock evaluator = [self createEvaluatorWithQueryConstraints:queryState.conditions];
+    if (!evaluator) {
+        return nil;
+    }
+    // Capture ignoreACLs before the block since it might be modified between matchings.
+    BOOL shouldIgnoreACLs = queryState.shouldIgnoreACLs;
+
+    return ^BOOL (PFObject *object, NSError **error) {
+        if (!shouldIgnoreACLs && ![[self class] userHasReadAccess:user ofObject:object]) {
+            return NO;
+        }
+        @try {
+            return evaluator(object);
+        } @catch (NSException *exception) {
+            // Promote to error to keep the same behavior as online.
+            if (error) {
+                *error = [PFErrorUtilities errorWithCode:kPFErrorInvalidQuery
+                                                 message:exception.reason
+                                               shouldLog:NO];
+            }
+            return NO;
+        }
+    };
+}
+
 ///--------------------------------------
 #pragma mark - Query Options
 ///--------------------------------------
@@ -841,36 +1145,48 @@ greaterThanOrEqualTo:(id)constraint {
         return results;
     }
 
-    NSMutableArray *mutableResults = [results mutableCopy];
+    PFOfflineQueryResultsCollector *collector = [self resultsCollectorWithOptions:options ofQueryState:queryState];
+    for (PFObject *object in results) {
+        [collector addObject:object];
+    }
+    return collector.results;
+}
+
+- (PFOfflineQueryResultsCollector *)resultsCollectorWithOptions:(PFOfflineQueryOption)options
+                                                    ofQueryState:(PFQueryState *)queryState {
+    NSComparator comparator = nil;
     if (options & PFOfflineQueryOptionOrder) {
-        [self _sortResults:mutableResults ofQueryState:queryState];
+        comparator = [self _comparatorForQueryState:queryState];
     }
-    if (options & PFOfflineQueryOptionSkip) {
-        NSInteger skip = queryState.skip;
-        if (skip > 0) {
-            skip = MIN(skip, results.count);
-            [mutableResults removeObjectsInRange:NSMakeRange(0, skip)];
-        }
+    NSUInteger skip = 0;
+    if ((options & PFOfflineQueryOptionSkip) && queryState.skip > 0) {
+        skip = queryState.skip;
     }
-    if (options & PFOfflineQueryOptionLimit) {
-        NSInteger limit = queryState.limit;
-        if (limit >= 0 && mutableResults.count > limit) {
-            [mutableResults removeObjectsInRange:NSMakeRange(limit, mutableResults.count - limit)];
-        }
+    NSUInteger limit = NSNotFound;
+    if ((options & PFOfflineQueryOptionLimit) && queryState.limit >= 0) {
+        limit = queryState.limit;
     }
-
-    return [mutableResults copy];
+    return [[PFOfflineQueryResultsCollector alloc] initWithComparator:comparator skip:skip limit:limit];
 }
 
-- (void)_sortResults:(NSMutableArray *)results ofQueryState:(PFQueryState *)queryState {
-    NSArray *keys = queryState.sortKeys;
-    [keys enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-        NSString *key = (NSString *)obj;
-        if ([key rangeOfString:@"^-?[A-Za-z][A-Za-z0-9_]*$" options:NSRegularExpressionSearch].location == NSNotFound) {
-            PFConsistencyAssert([@"_created_at" isEqualToString:key] || [@"_updated_at" isEqualToString:key],
-                                @"Invalid key name: %@", key);
+/**
+ @return A comparator for the sort keys of the query, which are parsed once, or `nil` if the query is not ordered.
+ */
+- (NSComparator)_comparatorForQueryState:(PFQueryState *)queryState {
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:queryState.sortKeys.count];
+    NSMutableIndexSet *descendingIndexes = [NSMutableIndexSet indexSet];
+    for (NSString *sortKey in queryState.sortKeys) {
+        if ([sortKey rangeOfString:@"^-?[A-Za-z][A-Za-z0-9_]*$" options:NSRegularExpressionSearch].location == NSNotFound) {
+            PFConsistencyAssert([@"_created_at" isEqualToString:sortKey] || [@"_updated_at" isEqualToString:sortKey],
+                                @"Invalid key name: %@", sortKey);
         }
-    }];
+        NSString *key = sortKey;
+        if ([key hasPrefix:@"-"]) {
+            [descendingIndexes addIndex:keys.count];
+            key = [key substringFromIndex:1];
+        }
+        [keys addObject:key];
+    }
 
     __block NSString *nearSphereKey = nil;
     __block PFGeoPoint *nearSphereValue = nil;
@@ -886,10 +1202,10 @@ greaterThanOrEqualTo:(id)constraint {
 
     // If there's nothing to sort based on, then don't do anything.
     if (keys.count == 0 && nearSphereKey == nil) {
-        return;
+        return nil;
     }
 
-    [results sortUsingComparator:^NSComparisonResult(id lhs, id rhs) {
+    return ^NSComparisonResult(id lhs, id rhs) {
         if (nearSphereKey != nil) {
             PFGeoPoint *lhsPoint = [self valueForContainer:lhs key:nearSphereKey];
             PFGeoPoint *rhsPoint = [self valueForContainer:rhs key:nearSphereKey];
@@ -901,14 +1217,9 @@ greaterThanOrEqualTo:(id)constraint {
             }
         }
 
-        for (int i = 0; i < keys.count; ++i) {
+        NSUInteger count = keys.count;
+        for (NSUInteger i = 0; i < count; ++i) {
             NSString *key = keys[i];
-            BOOL descending = NO;
-            if ([key hasPrefix:@"-"]) {
-                descending = YES;
-                key = [key substringFromIndex:1];
-            }
-
             id lhsValue = [self valueForContainer:lhs key:key];
             id rhsValue = [self valueForContainer:rhs key:key];
 
@@ -924,13 +1235,12 @@ greaterThanOrEqualTo:(id)constraint {
             }
 
             if (result != 0) {
-                return descending ? -result : result;
+                return [descendingIndexes containsIndex:i] ? -result : result;
             }
-
         }
 
         return NSOrderedSame;
-    }];
+    };
 }
 
 - (BFTask *)fetchIncludesAsyncForResults:(NSArray *)results
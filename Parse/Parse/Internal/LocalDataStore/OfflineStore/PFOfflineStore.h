@@ -23,8 +23,22 @@
 
 typedef NS_OPTIONS(uint8_t, PFOfflineStoreOptions) {
     PFOfflineStoreOptionAlwaysFetchFromSQLite = 1 << 0,
+    /**
+     Keeps the database in write-ahead log mode, so that finds and local fetches don't wait for saves and pins.
+     */
+    PFOfflineStoreOptionWriteAheadLogging = 1 << 1,
+    /**
+     Stores objects in the compact `PFBinaryJSONSerialization` format instead of JSON.
+     Objects stored in either format can always be read, and are rewritten in the current format when saved again.
+     */
+    PFOfflineStoreOptionBinaryEncoding = 1 << 2,
 };
 
+/**
+ Called with each page of objects that are enumerated from the store. Set `stop` to `YES` to stop enumerating.
+ */
+typedef void (^PFOfflineStoreEnumerationBlock)(NSArray<PFObject *> *objects, BOOL *stop);
+
 //TODO: (nlutsenko) Bring this header up to standard with @name, method comments, etc...
 @interface PFOfflineStore : NSObject
 
@@ -130,6 +144,26 @@ typedef NS_OPTIONS(uint8_t, PFOfflineStoreOptions) {
                            isCount:(BOOL)isCount
                           database:(PFSQLiteDatabase *)database;
 
+///--------------------------------------
+#pragma mark - Enumerate
+///--------------------------------------
+
+/**
+ Runs a PFQueryState against the store's contents, and hands the objects that match to `block` a page at a time,
+ without loading all of them at once. Objects are enumerated in no particular order, so the query must not be ordered.
+ Skip and limit are applied across pages.
+
+ @param pageSize The maximum number of stored objects that are loaded for each page.
+ @param block    Called serially, off the database connection, with every non-empty page of matching objects.
+
+ @return A task that completes once all objects are enumerated, or `block` stops the enumeration.
+ */
+- (BFTask<PFVoid> *)enumerateObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                                  user:(PFUser *)user
+                                                   pin:(PFPin *)pin
+                                              pageSize:(NSUInteger)pageSize
+                                                 block:(PFOfflineStoreEnumerationBlock)block;
+
 ///--------------------------------------
 #pragma mark - Update Internal State
 ///--------------------------------------
@@ -156,6 +190,17 @@ typedef NS_OPTIONS(uint8_t, PFOfflineStoreOptions) {
 
 - (BFTask<PFVoid> *)unpinObjectAsync:(PFObject *)object;
 
+///--------------------------------------
+#pragma mark - Indexes
+///--------------------------------------
+
+/**
+ Indexes the values of `key` for every object of the class, so that finds with equality, comparison or `$in`
+ constraints on `key` only load the objects that can match. The index is persisted and kept up to date on writes.
+ Does nothing if `key` is already indexed.
+ */
+- (BFTask<PFVoid> *)createIndexAsyncOnKey:(NSString *)key forClassName:(NSString *)className;
+
 ///--------------------------------------
 #pragma mark - Internal Helper Methods
 ///--------------------------------------
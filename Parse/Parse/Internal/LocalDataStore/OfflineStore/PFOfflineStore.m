@@ -17,6 +17,8 @@
 
 #import "BFTask+Private.h"
 #import "PFAssert.h"
+#import "PFBinaryJSONSerialization.h"
+#import "PFDateFormatter.h"
 #import "PFDecoder.h"
 #import "PFEncoder.h"
 #import "PFLogging.h"
@@ -26,6 +28,7 @@
 #import "PFObjectPrivate.h"
 #import "PFOfflineQueryLogic.h"
 #import "PFPin.h"
+#import "PFQueryConstants.h"
 #import "PFQueryPrivate.h"
 #import "PFSQLiteDatabase.h"
 #import "PFSQLiteDatabaseController.h"
@@ -48,6 +51,10 @@ static NSString *const PFOfflineStoreKeyOfUUID = @"uuid";
 static NSString *const PFOfflineStoreTableOfDependencies = @"Dependencies";
 static NSString *const PFOfflineStoreKeyOfKey = @"key";
 
+static NSString *const PFOfflineStoreTableOfIndexedKeys = @"IndexedKeys";
+static NSString *const PFOfflineStoreTableOfIndexedValues = @"IndexedValues";
+static NSString *const PFOfflineStoreKeyOfValue = @"value";
+
 static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 
 @interface PFOfflineStore ()
@@ -104,7 +111,10 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 
     _options = options;
     _fileManager = fileManager;
-    _databaseController = [PFSQLiteDatabaseController controllerWithFileManager:_fileManager];
+    PFSQLiteDatabaseJournalMode journalMode = ((options & PFOfflineStoreOptionWriteAheadLogging) ?
+                                               PFSQLiteDatabaseJournalModeWriteAheadLog :
+                                               PFSQLiteDatabaseJournalModeDelete);
+    _databaseController = [PFSQLiteDatabaseController controllerWithFileManager:_fileManager journalMode:journalMode];
     _lock = [[NSObject alloc] init];
     _classNameAndObjectIdToObjectMap = [NSMapTable strongToWeakObjectsMapTable];
     _fetchedObjects = [NSMapTable weakToStrongObjectsMapTable];
@@ -123,14 +133,8 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 ///--------------------------------------
 
 - (BFTask<PFObject *> *)fetchObjectLocallyAsync:(PFObject *)object {
-    __block BFTask<PFObject *> *fetchTask = nil;
-    return [[self _performDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
-        // We need this to return the result of `fetchObjectLocallyAsync` instead of returning the
-        // result of `[database closeAsync]`
-        fetchTask = [self fetchObjectLocallyAsync:object database:database];
-        return fetchTask;
-    }] continueWithBlock:^id(BFTask *task) {
-        return fetchTask;
+    return [self _performReadOnlyDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
+        return [self fetchObjectLocallyAsync:object database:database];
     }];
 }
 
@@ -160,7 +164,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 
     // If this gets set, then it will contain data from offline store that need to be merged
     // into existing object in memory
-    BFTask *jsonStringTask = [BFTask taskWithResult:nil];
+    BFTask *jsonTask = [BFTask taskWithResult:nil];
     __block NSString *uuid = nil;
 
     if (objectId == nil) {
@@ -177,15 +181,17 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
             // and then an object with a pointer to it was fetched, so we only created the pointer.
             // We need to pull the data out of the database using UUID.
 
-            jsonStringTask = [uuidTask continueWithSuccessBlock:^id(BFTask *task) {
+            jsonTask = [uuidTask continueWithSuccessBlock:^id(BFTask *task) {
                 uuid = task.result;
                 NSString *query = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ?;",
                                    PFOfflineStoreKeyOfJSON, PFOfflineStoreTableOfObjects, PFOfflineStoreKeyOfUUID];
-                return [database executeQueryAsync:query withArgumentsInArray:@[ uuid ] block:^id(PFSQLiteDatabaseResult *_Nonnull result) {
+                return [database executeCachedQueryAsync:query withArgumentsInArray:@[ uuid ] block:^id(PFSQLiteDatabaseResult *_Nonnull result) {
                     if (![result next]) {
-                        PFPreconditionFailure(@"Attempted to find non-existent uuid %@. Please report this issue with stack traces and logs.", uuid);
+                        // The UUID is known before the transaction that creates its row commits,
+                        // and concurrent reads only see committed rows. Handled as a cache miss below.
+                        return nil;
                     }
-                    return [result stringForColumnIndex:0];
+                    return [[self class] _JSONObjectForColumnIndex:0 ofResult:result];
                 }];
             }];
         }
@@ -215,9 +221,9 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                            PFOfflineStoreKeyOfClassName,
                            PFOfflineStoreKeyOfObjectId];
 
-        __block NSString *jsonString = nil;
+        __block id json = nil;
         __block NSString *newUUID = nil;
-        jsonStringTask = [[database executeQueryAsync:query withArgumentsInArray:@[ className, objectId ] block:^id(PFSQLiteDatabaseResult *_Nonnull result) {
+        jsonTask = [[database executeCachedQueryAsync:query withArgumentsInArray:@[ className, objectId ] block:^id(PFSQLiteDatabaseResult *_Nonnull result) {
             if (![result next]) {
                 NSError *error = [PFErrorUtilities errorWithCode:kPFErrorCacheMiss
                                                          message:@"This object is not available in the offline cache."
@@ -225,7 +231,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                 return [BFTask taskWithError:error];
             }
 
-            jsonString = [result stringForColumnIndex:0];
+            json = [[self class] _JSONObjectForColumnIndex:0 ofResult:result];
             newUUID = [result stringForColumnIndex:1];
             return nil;
         }] continueWithSuccessBlock:^id(BFTask *task) {
@@ -236,13 +242,13 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                 [self.objectToUUIDMap setObject:[BFTask taskWithResult:newUUID] forKey:object];
                 [self.UUIDToObjectMap setObject:object forKey:newUUID];
             }
-            return jsonString;
+            return json;
         }];
     }
 
-    return [[jsonStringTask continueWithSuccessBlock:^id(BFTask *task) {
-        NSString *jsonString = task.result;
-        if (jsonString == nil) {
+    return [[jsonTask continueWithSuccessBlock:^id(BFTask *task) {
+        id parsedJson = task.result;
+        if (parsedJson == nil) {
             // This means we tried to fetch from the database that was never actually saved
             // locally. This probably means that its parent object was saved locally and we
             // just created a pointer to this object. This should be considered cache miss.
@@ -253,7 +259,6 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                                                    shouldLog:NO];
             return [BFTask taskWithError:error];
         }
-        id parsedJson = [PFJSONSerialization JSONObjectFromString:jsonString];
         NSMutableDictionary *offlineObjects = [[NSMutableDictionary alloc] init];
         [PFInternalUtils traverseObject:parsedJson usingBlock:^id(id object) {
             // Omit root and PFObject
@@ -357,68 +362,91 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         return [self getOrCreateUUIDAsyncForObject:object database:database];
     }] continueWithSuccessBlock:^id(BFTask *task) {
         NSString *uuid = task.result;
-
-        NSMutableArray<BFTask<PFVoid> *>*tasks = [NSMutableArray array];
-        for (PFObject *object in objectsInTree) {
-            [tasks addObject:[self saveObjectLocallyAsync:object key:uuid database:database]];
-        }
-
-        return [BFTask taskForCompletionOfAllTasks:tasks];
+        return [self _saveObjectsLocallyAsync:objectsInTree key:uuid database:database];
     }];
 }
 
-- (BFTask<PFVoid> *)saveObjectLocallyAsync:(PFObject *)object
-                                       key:(NSString *)key
-                                  database:(PFSQLiteDatabase *)database {
-    if (object.objectId != nil && !object.dataAvailable &&
-        ![object _hasChanges] && ![object _hasOutstandingOperations]) {
+/**
+ Writes the objects and their dependency on `key` to the database. Rows are written a batch at a time,
+ with statements that are prepared once, instead of a few statements per object.
+ */
+- (BFTask<PFVoid> *)_saveObjectsLocallyAsync:(NSArray<PFObject *> *)objects
+                                         key:(NSString *)key
+                                    database:(PFSQLiteDatabase *)database {
+    NSMutableArray<PFObject *> *objectsToSave = [NSMutableArray arrayWithCapacity:objects.count];
+    for (PFObject *object in [NSOrderedSet orderedSetWithArray:objects]) {
+        if (object.objectId != nil && !object.dataAvailable &&
+            ![object _hasChanges] && ![object _hasOutstandingOperations]) {
+            continue;
+        }
+        [objectsToSave addObject:object];
+    }
+    if (objectsToSave.count == 0) {
         return [BFTask taskWithResult:nil];
     }
 
-    __block NSString *uuid = nil;
-    __block id encoded = nil;
-    return [[[[BFTask taskFromExecutor:[BFExecutor defaultExecutor] withBlock:^id {
-        // Make sure we have UUID for the object to be saved.
-        return [self getOrCreateUUIDAsyncForObject:object database:database];
+    __block NSArray<NSString *> *uuids = nil;
+    NSMutableArray *encodedObjects = [NSMutableArray arrayWithCapacity:objectsToSave.count];
+    return [[[[[BFTask taskFromExecutor:[BFExecutor defaultExecutor] withBlock:^id {
+        // Make sure we have UUIDs for the objects to be saved.
+        return [self _getOrCreateUUIDsAsyncForObjects:objectsToSave database:database];
     }] continueWithSuccessBlock:^id(BFTask *task) {
-        uuid = task.result;
-
-        // Encode the object, and wait for the UUIDs in its pointers to get encoded.
-        PFOfflineObjectEncoder *encoder = [PFOfflineObjectEncoder objectEncoderWithOfflineStore:self database:database];
-        // We don't care about operationSetUUIDs here
-        NSArray *operationSetUUIDs = nil;
-        NSError *error;
-        encoded = [object RESTDictionaryWithObjectEncoder:encoder operationSetUUIDs:&operationSetUUIDs error:&error];
-        PFPreconditionReturnFailedTask(encoded, error);
-        return [encoder encodeFinished];
+        uuids = task.result;
+
+        // Encode the objects, and wait for the UUIDs in their pointers to get encoded.
+        NSMutableArray<BFTask *> *tasks = [NSMutableArray arrayWithCapacity:objectsToSave.count];
+        for (PFObject *object in objectsToSave) {
+            PFOfflineObjectEncoder *encoder = [PFOfflineObjectEncoder objectEncoderWithOfflineStore:self database:database];
+            // We don't care about operationSetUUIDs here
+            NSArray *operationSetUUIDs = nil;
+            NSError *error;
+            id encoded = [object RESTDictionaryWithObjectEncoder:encoder operationSetUUIDs:&operationSetUUIDs error:&error];
+            PFPreconditionReturnFailedTask(encoded, error);
+            [encodedObjects addObject:encoded];
+            [tasks addObject:[encoder encodeFinished]];
+        }
+        return [BFTask taskForCompletionOfAllTasks:tasks];
     }] continueWithSuccessBlock:^id(BFTask *task) {
-        // Time to actually save the object
-        NSString *className = object.parseClassName;
-        NSString *objectId = object.objectId;
-        NSString *encodedString = [PFJSONSerialization stringFromJSONObject:encoded];
-        NSString *updateFields = nil;
-        NSArray *queryParams = nil;
+        // Time to actually save the objects
+        NSMutableArray<NSArray *> *argumentsWithObjectId = [NSMutableArray array];
+        NSMutableArray<NSArray *> *argumentsWithoutObjectId = [NSMutableArray array];
+        [objectsToSave enumerateObjectsUsingBlock:^(PFObject *object, NSUInteger i, BOOL *stop) {
+            NSString *className = object.parseClassName;
+            NSString *objectId = object.objectId;
+            id json = [self _JSONColumnValueFromObject:encodedObjects[i]];
+            if (objectId != nil) {
+                [argumentsWithObjectId addObject:@[ className, json, objectId, uuids[i] ]];
+            } else {
+                [argumentsWithoutObjectId addObject:@[ className, json, uuids[i] ]];
+            }
+        }];
 
-        if (objectId != nil) {
-            updateFields = [NSString stringWithFormat:@"%@ = ?, %@ = ?, %@ = ?",
-                            PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON,
-                            PFOfflineStoreKeyOfObjectId];
-            queryParams = @[className, encodedString, objectId, uuid];
-        } else {
-            updateFields = [NSString stringWithFormat:@"%@ = ?, %@ = ?",
-                            PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON];
-            queryParams = @[className, encodedString, uuid];
+        NSMutableArray<BFTask *> *tasks = [NSMutableArray arrayWithCapacity:2];
+        if (argumentsWithObjectId.count > 0) {
+            NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ = ?, %@ = ?, %@ = ? WHERE %@ = ?",
+                             PFOfflineStoreTableOfObjects, PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON,
+                             PFOfflineStoreKeyOfObjectId, PFOfflineStoreKeyOfUUID];
+            [tasks addObject:[database executeCachedSQLAsync:sql withArgumentsArrays:argumentsWithObjectId]];
         }
-
-        NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@ = ?",
-                         PFOfflineStoreTableOfObjects, updateFields,
-                         PFOfflineStoreKeyOfUUID];
-        return [database executeSQLAsync:sql withArgumentsInArray:queryParams];
+        if (argumentsWithoutObjectId.count > 0) {
+            NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ = ?, %@ = ? WHERE %@ = ?",
+                             PFOfflineStoreTableOfObjects, PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON,
+                             PFOfflineStoreKeyOfUUID];
+            [tasks addObject:[database executeCachedSQLAsync:sql withArgumentsArrays:argumentsWithoutObjectId]];
+        }
+        return [BFTask taskForCompletionOfAllTasks:tasks];
     }] continueWithSuccessBlock:^id(BFTask *task) {
-        NSString *sql = [NSString stringWithFormat:@"INSERT OR IGNORE INTO %@(%@, %@) VALUES (?, ?)",
-                         PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfKey,
-                         PFOfflineStoreKeyOfUUID];
-        return [database executeSQLAsync:sql withArgumentsInArray:@[key, uuid]];
+        return [self _updateIndexedValuesAsyncForObjects:objectsToSave uuids:uuids database:database];
+    }] continueWithSuccessBlock:^id(BFTask *task) {
+        NSMutableArray<NSArray *> *rows = [NSMutableArray arrayWithCapacity:uuids.count];
+        for (NSString *uuid in uuids) {
+            [rows addObject:@[ key, uuid ]];
+        }
+        return [[self class] _insertRowsAsync:rows
+                                    intoTable:PFOfflineStoreTableOfDependencies
+                                      columns:@[ PFOfflineStoreKeyOfKey, PFOfflineStoreKeyOfUUID ]
+                             ignoreConflicts:YES
+                                     database:database];
     }];
 }
 
@@ -435,15 +463,8 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 - (BFTask<NSNumber *> *)countAsyncForQueryState:(PFQueryState *)queryState
                                            user:(PFUser *)user
                                             pin:(PFPin *)pin {
-    return [[self findAsyncForQueryState:queryState
-                                    user:user
-                                     pin:pin
-                                 isCount:YES] continueWithSuccessBlock:^id(BFTask *task) {
-        if (!task.cancelled && !task.faulted) {
-            NSArray *result = task.result;
-            return @(result.count);
-        }
-        return task;
+    return [self _performReadOnlyDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
+        return [self _countAsyncForQueryState:queryState user:user pin:pin database:database];
     }];
 }
 
@@ -451,14 +472,8 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                               user:(PFUser *)user
                                pin:(PFPin *)pin
                            isCount:(BOOL)isCount {
-    __block BFTask *resultTask = nil;
-    return [[self _performDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
-        resultTask = [self findAsyncForQueryState:queryState user:user pin:pin isCount:isCount database:database];
-        return resultTask;
-    }] continueWithBlock:^id(BFTask *ignored) {
-        // We need this to return the result of `findQuery` instead of returning the
-        // result of `[database closeAsync]`
-        return resultTask;
+    return [self _performReadOnlyDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
+        return [self findAsyncForQueryState:queryState user:user pin:pin isCount:isCount database:database];
     }];
 }
 
@@ -467,116 +482,471 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                                pin:(PFPin *)pin
                            isCount:(BOOL)isCount
                           database:(PFSQLiteDatabase *)database {
-    __block NSMutableArray<PFObject *> *mutableResults = [NSMutableArray array];
-    BFTask *queryTask = nil;
-    BOOL includeIsDeletingEventually = queryState.shouldIncludeDeletingEventually;
+    // Sort, apply skip and limit as objects are matched, so that only the objects that are returned are kept around.
+    PFOfflineQueryOption queryOptions = 0;
+    if (!isCount) {
+        queryOptions = PFOfflineQueryOptionOrder | PFOfflineQueryOptionSkip | PFOfflineQueryOptionLimit;
+    }
+    PFOfflineQueryResultsCollector *collector = [self.offlineQueryLogic resultsCollectorWithOptions:queryOptions
+                                                                                        ofQueryState:queryState];
+    @weakify(self);
+    return [[self _collectObjectsAsyncForQueryState:queryState
+                                               user:user
+                                                pin:pin
+                                          collector:collector
+                                           database:database] continueWithSuccessBlock:^id(BFTask *_) {
+        @strongify(self);
+        NSArray<PFObject *> *results = collector.results;
 
-    __block NSString *queryString = nil;
-    __block NSArray<NSString *> *queryArguments = nil;
+        // Fetch includes
+        BFTask *fetchIncludesTask = [self.offlineQueryLogic fetchIncludesAsyncForResults:results
+                                                                            ofQueryState:queryState
+                                                                              inDatabase:database];
 
-    if (!pin) {
-        NSString *isDeletingEventuallyQuery = @"";
-        if (!includeIsDeletingEventually) {
-            isDeletingEventuallyQuery = [NSString stringWithFormat:@"AND %@ = 0",
-                                         PFOfflineStoreKeyOfIsDeletingEventually];
-        }
-        queryString = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ? %@;",
-                       PFOfflineStoreKeyOfUUID,
-                       PFOfflineStoreTableOfObjects,
-                       PFOfflineStoreKeyOfClassName,
-                       isDeletingEventuallyQuery];
-        queryArguments = @[ queryState.parseClassName ];
-        queryTask = [BFTask taskWithResult:nil];
-    } else {
-        BFTask *uuidTask = [self.objectToUUIDMap objectForKey:pin];
-        if (!uuidTask) {
+        return [fetchIncludesTask continueWithSuccessBlock:^id(BFTask *_) {
+            return results;
+        }];
+    }];
+}
+
+/**
+ Adds the stored objects that match the query to `collector`.
+ */
+- (BFTask<PFVoid> *)_collectObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                                 user:(PFUser *)user
+                                                  pin:(PFPin *)pin
+                                            collector:(PFOfflineQueryResultsCollector *)collector
+                                             database:(PFSQLiteDatabase *)database {
+    NSString *uuidColumn = [self _uuidColumnForPin:pin];
+    NSMutableArray *arguments = [NSMutableArray array];
+
+    return [[self _uuidsQueryAsyncForQueryState:queryState
+                                            pin:pin
+                                      arguments:arguments] continueWithSuccessBlock:^id(BFTask<NSString *> *task) {
+        NSString *queryString = task.result;
+        if (!queryString) {
             // Pin was never saved locally, therefore there won't be any results.
-            return [BFTask taskWithResult:mutableResults];
+            return nil;
         }
-        queryTask = [uuidTask continueWithSuccessBlock:^id(BFTask *task) {
-            NSString *uuid = task.result;
-            NSString *isDeletingEventuallyQuery = @"";
-            if (!includeIsDeletingEventually) {
-                isDeletingEventuallyQuery = [NSString stringWithFormat:@"AND %@ = 0",
-                                             PFOfflineStoreKeyOfIsDeletingEventually];
+        NSArray *queryArguments = [arguments copy];
+        return [[self _indexedKeysAsyncForClassName:queryState.parseClassName
+                                           database:database] continueWithSuccessBlock:^id(BFTask *task) {
+            NSString *indexedCondition = [self _indexedConditionForQueryState:queryState
+                                                                  indexedKeys:task.result
+                                                                   uuidColumn:uuidColumn
+                                                                    arguments:arguments];
+            BFTask *uuidsTask = nil;
+            if (indexedCondition) {
+                // The condition depends on the constraints, so the statement isn't worth caching.
+                NSString *query = [NSString stringWithFormat:@"%@ AND %@;", queryString, indexedCondition];
+                uuidsTask = [database executeQueryAsync:query
+                                   withArgumentsInArray:arguments
+                                                  block:[[self class] _uuidsQueryBlock]];
+            } else {
+                NSString *query = [queryString stringByAppendingString:@";"];
+                uuidsTask = [database executeCachedQueryAsync:query
+                                         withArgumentsInArray:queryArguments
+                                                        block:[[self class] _uuidsQueryBlock]];
             }
-            queryString = [NSString stringWithFormat:@"SELECT A.%@ FROM %@ A "
-                           @"INNER JOIN %@ B ON A.%@ = B.%@ WHERE %@ = ? AND %@ = ? %@;",
-                           PFOfflineStoreKeyOfUUID, PFOfflineStoreTableOfObjects,
-                           PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfUUID,
-                           PFOfflineStoreKeyOfUUID, PFOfflineStoreKeyOfClassName,
-                           PFOfflineStoreKeyOfKey, isDeletingEventuallyQuery];
-            queryArguments = @[ queryState.parseClassName, uuid ];
-
-            return nil;
+            return [uuidsTask continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
+                return [self _collectObjectsAsyncWithUUIDs:task.result
+                                             forQueryState:queryState
+                                                      user:user
+                                                 collector:collector
+                                                  database:database];
+            }];
         }];
-    }
+    }];
+}
+
+///--------------------------------------
+#pragma mark - Count
+///--------------------------------------
+
+- (BFTask<NSNumber *> *)_countAsyncForQueryState:(PFQueryState *)queryState
+                                            user:(PFUser *)user
+                                             pin:(PFPin *)pin
+                                        database:(PFSQLiteDatabase *)database {
+    NSString *uuidColumn = [self _uuidColumnForPin:pin];
+    NSMutableArray *arguments = [NSMutableArray array];
 
     @weakify(self);
-    return [[queryTask continueWithSuccessBlock:^id(BFTask *task) {
-        return [[database executeQueryAsync:queryString withArgumentsInArray:queryArguments block:^id(PFSQLiteDatabaseResult *result) {
-            NSMutableArray<NSString *> *uuids = [NSMutableArray array];
-            while ([result next]) {
-                NSString *uuid = [result stringForColumnIndex:0];
-                [uuids addObject:uuid];
+    return [[self _uuidsQueryAsyncForQueryState:queryState
+                                            pin:pin
+                                      arguments:arguments] continueWithSuccessBlock:^id(BFTask<NSString *> *task) {
+        @strongify(self);
+        NSString *queryString = task.result;
+        if (!queryString) {
+            // Pin was never saved locally, therefore there won't be any results.
+            return @0;
+        }
+        NSArray *queryArguments = [arguments copy];
+        return [[self _indexedKeysAsyncForClassName:queryState.parseClassName
+                                           database:database] continueWithSuccessBlock:^id(BFTask *task) {
+            // ACLs can only be checked on objects, so the count only comes from SQL if they are ignored.
+            BOOL isExact = NO;
+            NSString *condition = nil;
+            if (queryState.shouldIgnoreACLs) {
+                condition = [self _indexedConstraintsConditionForQueryState:queryState
+                                                                indexedKeys:task.result
+                                                                 uuidColumn:uuidColumn
+                                                                  arguments:arguments
+                                                                    isExact:&isExact];
             }
-            return uuids;
-        }] continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
-            @strongify(self);
-            PFConstraintMatcherBlock matcherBlock = [self.offlineQueryLogic createMatcherForQueryState:queryState user:user];
-
-            BFTask *checkAllTask = [BFTask taskWithResult:nil];
-            NSArray<NSArray<NSString *> *> *uuidBatches = [PFInternalUtils arrayBySplittingArray:task.result
-                                                                 withMaximumComponentsPerSegment:64];
-            for (NSArray <NSString *> *uuids in uuidBatches) {
-                checkAllTask = [[checkAllTask continueWithSuccessBlock:^id(BFTask *_) {
-                    return [self _getObjectPointersAsyncWithUUIDs:uuids fromDatabase:database];
-                }] continueWithSuccessBlock:^id(BFTask<NSArray<PFObject *> *> *task) {
-                    BFTask *checkBatchTask = [BFTask taskWithResult:nil];
-                    for (PFObject *object in task.result) {
-                        checkBatchTask = [[[checkBatchTask continueWithSuccessBlock:^id(BFTask *_) {
-                            return [self fetchObjectLocallyAsync:object database:database];
-                        }] continueWithSuccessBlock:^id(BFTask *_) {
-                            if (!object.dataAvailable) {
-                                return nil;
-                            }
-                            return matcherBlock(object, database);
-                        }] continueWithSuccessBlock:^id(BFTask *task) {
-                            if ([task.result boolValue]) {
-                                [mutableResults addObject:object];
-                            }
-                            return nil;
-                        }];
-                    }
-                    return checkBatchTask;
+            NSArray<NSString *> *changedUUIDs = [self _uuidsOfChangedObjectsWithClassName:queryState.parseClassName];
+            if (!isExact || arguments.count + changedUUIDs.count > PFOfflineStoreMaximumSQLVariablesCount) {
+                PFOfflineQueryResultsCollector *collector = [PFOfflineQueryResultsCollector countingCollector];
+                return [[self _collectObjectsAsyncForQueryState:queryState
+                                                           user:user
+                                                            pin:pin
+                                                      collector:collector
+                                                       database:database] continueWithSuccessBlock:^id(BFTask *_) {
+                    return @(collector.count);
                 }];
             }
-            return checkAllTask;
+            return [self _countAsyncWithQuery:queryString
+                                    arguments:arguments
+                                    condition:condition
+                                   uuidColumn:uuidColumn
+                                 changedUUIDs:changedUUIDs
+                               queryArguments:queryArguments
+                                forQueryState:queryState
+                                         user:user
+                                     database:database];
+        }];
+    }];
+}
+
+/**
+ Counts the objects selected by `query` and `condition` in SQL, without loading them. Objects that were changed in
+ memory since they were written aren't counted in SQL, and are matched instead.
+ */
+- (BFTask<NSNumber *> *)_countAsyncWithQuery:(NSString *)query
+                                   arguments:(NSArray *)arguments
+                                   condition:(NSString *)condition
+                                  uuidColumn:(NSString *)uuidColumn
+                                changedUUIDs:(NSArray<NSString *> *)changedUUIDs
+                              queryArguments:(NSArray *)queryArguments
+                               forQueryState:(PFQueryState *)queryState
+                                        user:(PFUser *)user
+                                    database:(PFSQLiteDatabase *)database {
+    NSMutableString *countQuery = [NSMutableString stringWithFormat:@"SELECT COUNT(*) FROM (%@", query];
+    if (condition) {
+        [countQuery appendFormat:@" AND %@", condition];
+    }
+    NSString *changedUUIDsPlaceholders = nil;
+    if (changedUUIDs.count > 0) {
+        NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:changedUUIDs.count];
+        for (NSUInteger i = 0; i < changedUUIDs.count; i++) {
+            [placeholders addObject:@"?"];
+        }
+        changedUUIDsPlaceholders = [placeholders componentsJoinedByString:@","];
+        [countQuery appendFormat:@" AND %@ NOT IN (%@)", uuidColumn, changedUUIDsPlaceholders];
+    }
+    [countQuery appendString:@");"];
+
+    BFTask *countTask = nil;
+    PFSQLiteDatabaseQueryBlock block = ^id(PFSQLiteDatabaseResult *result) {
+        return @([result next] ? [result longForColumnIndex:0] : 0);
+    };
+    if (condition || changedUUIDs.count > 0) {
+        countTask = [database executeQueryAsync:countQuery
+                           withArgumentsInArray:[arguments arrayByAddingObjectsFromArray:changedUUIDs]
+                                          block:block];
+    } else {
+        countTask = [database executeCachedQueryAsync:countQuery withArgumentsInArray:arguments block:block];
+    }
+    if (changedUUIDs.count == 0) {
+        return countTask;
+    }
+
+    return [countTask continueWithSuccessBlock:^id(BFTask<NSNumber *> *countTask) {
+        NSString *changedQuery = [NSString stringWithFormat:@"%@ AND %@ IN (%@);",
+                                  query, uuidColumn, changedUUIDsPlaceholders];
+        return [[database executeQueryAsync:changedQuery
+                       withArgumentsInArray:[queryArguments arrayByAddingObjectsFromArray:changedUUIDs]
+                                      block:[[self class] _uuidsQueryBlock]] continueWithSuccessBlock:^id(BFTask *task) {
+            PFOfflineQueryResultsCollector *collector = [PFOfflineQueryResultsCollector countingCollector];
+            return [[self _collectObjectsAsyncWithUUIDs:task.result
+                                          forQueryState:queryState
+                                                   user:user
+                                              collector:collector
+                                               database:database] continueWithSuccessBlock:^id(BFTask *_) {
+                return @(countTask.result.unsignedIntegerValue + collector.count);
+            }];
+        }];
+    }];
+}
+
+///--------------------------------------
+#pragma mark - Enumerate
+///--------------------------------------
+
+- (BFTask<PFVoid> *)enumerateObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                                  user:(PFUser *)user
+                                                   pin:(PFPin *)pin
+                                              pageSize:(NSUInteger)pageSize
+                                                 block:(PFOfflineStoreEnumerationBlock)block {
+    PFParameterAssert(pageSize > 0, @"`pageSize` should be greater than 0.");
+    PFConsistencyAssert(queryState.sortKeys.count == 0, @"Ordered queries can't be enumerated.");
+
+    NSUInteger skip = (queryState.skip > 0 ? queryState.skip : 0);
+    NSUInteger limit = (queryState.limit >= 0 ? queryState.limit : NSNotFound);
+    return [self _enumerateObjectsAsyncForQueryState:queryState
+                                                user:user
+                                                 pin:pin
+                                           afterUUID:nil
+                                            pageSize:pageSize
+                                                skip:skip
+                                               limit:limit
+                                               block:[block copy]];
+}
+
+/**
+ Enumerates the objects stored after `uuid` one page at a time. Every page is read in its own read-only operation,
+ so that a reader connection isn't held while `block` runs, and objects of previous pages can be released.
+ */
+- (BFTask<PFVoid> *)_enumerateObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                                   user:(PFUser *)user
+                                                    pin:(PFPin *)pin
+                                              afterUUID:(NSString *)uuid
+                                               pageSize:(NSUInteger)pageSize
+                                                   skip:(NSUInteger)skip
+                                                  limit:(NSUInteger)limit
+                                                  block:(PFOfflineStoreEnumerationBlock)block {
+    if (limit == 0) {
+        return [BFTask taskWithResult:nil];
+    }
+
+    // Collect enough objects to skip the ones that still have to be skipped.
+    PFOfflineQueryResultsCollector *collector = [[PFOfflineQueryResultsCollector alloc] initWithComparator:nil
+                                                                                                      skip:0
+                                                                                                     limit:(limit == NSNotFound ?
+                                                                                                            NSNotFound :
+                                                                                                            skip + limit)];
+    __block NSString *lastUUID = nil;
+    @weakify(self);
+    return [[self _performReadOnlyDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
+        @strongify(self);
+        return [[self _findPageAsyncForQueryState:queryState
+                                             user:user
+                                              pin:pin
+                                        afterUUID:uuid
+                                         pageSize:pageSize
+                                        collector:collector
+                                         database:database] continueWithSuccessBlock:^id(BFTask<NSString *> *task) {
+            lastUUID = task.result;
+            return [self.offlineQueryLogic fetchIncludesAsyncForResults:collector.results
+                                                           ofQueryState:queryState
+                                                             inDatabase:database];
         }];
     }] continueWithSuccessBlock:^id(BFTask *_) {
         @strongify(self);
+        NSArray<PFObject *> *objects = collector.results;
+        NSUInteger skippedCount = MIN(skip, objects.count);
+        objects = [objects subarrayWithRange:NSMakeRange(skippedCount, objects.count - skippedCount)];
 
-        // Sort, Apply Skip and Limit
-
-        PFOfflineQueryOption queryOptions = 0;
-        if (!isCount) {
-            queryOptions = PFOfflineQueryOptionOrder | PFOfflineQueryOptionSkip | PFOfflineQueryOptionLimit;
+        BOOL stop = NO;
+        if (objects.count > 0) {
+            block(objects, &stop);
+        }
+        if (stop || !lastUUID) {
+            return nil;
         }
-        NSArray<PFObject *> *results = [self.offlineQueryLogic resultsByApplyingOptions:queryOptions
-                                                                           ofQueryState:queryState
-                                                                              toResults:mutableResults];
+        return [self _enumerateObjectsAsyncForQueryState:queryState
+                                                    user:user
+                                                     pin:pin
+                                               afterUUID:lastUUID
+                                                pageSize:pageSize
+                                                    skip:skip - skippedCount
+                                                   limit:(limit == NSNotFound ? NSNotFound : limit - objects.count)
+                                                   block:block];
+    }];
+}
 
-        // Fetch includes
-        BFTask *fetchIncludesTask = [self.offlineQueryLogic fetchIncludesAsyncForResults:results
-                                                                            ofQueryState:queryState
-                                                                              inDatabase:database];
+/**
+ Matches the next `pageSize` stored objects after `uuid` and adds the ones that match to `collector`.
 
-        return [fetchIncludesTask continueWithSuccessBlock:^id(BFTask *_) {
-            return results;
+ @return A task that yields the UUID of the last object of the page, or `nil` if there are no more objects.
+ */
+- (BFTask<NSString *> *)_findPageAsyncForQueryState:(PFQueryState *)queryState
+                                               user:(PFUser *)user
+                                                pin:(PFPin *)pin
+                                          afterUUID:(NSString *)uuid
+                                           pageSize:(NSUInteger)pageSize
+                                          collector:(PFOfflineQueryResultsCollector *)collector
+                                           database:(PFSQLiteDatabase *)database {
+    NSString *uuidColumn = [self _uuidColumnForPin:pin];
+    NSMutableArray *arguments = [NSMutableArray array];
+
+    @weakify(self);
+    return [[self _uuidsQueryAsyncForQueryState:queryState
+                                            pin:pin
+                                      arguments:arguments] continueWithSuccessBlock:^id(BFTask<NSString *> *task) {
+        @strongify(self);
+        NSString *queryString = task.result;
+        if (!queryString) {
+            return nil;
+        }
+        return [[[self _indexedKeysAsyncForClassName:queryState.parseClassName
+                                            database:database] continueWithSuccessBlock:^id(BFTask *task) {
+            NSMutableString *query = [queryString mutableCopy];
+            NSString *indexedCondition = [self _indexedConditionForQueryState:queryState
+                                                                  indexedKeys:task.result
+                                                                   uuidColumn:uuidColumn
+                                                                    arguments:arguments];
+            if (indexedCondition) {
+                [query appendFormat:@" AND %@", indexedCondition];
+            }
+            // Seek past the previous page using the primary key, instead of an offset that SQLite would have to scan.
+            if (uuid) {
+                [query appendFormat:@" AND %@ > ?", uuidColumn];
+                [arguments addObject:uuid];
+            }
+            [query appendFormat:@" ORDER BY %@ LIMIT ?;", uuidColumn];
+            [arguments addObject:@(pageSize)];
+            return [database executeQueryAsync:query
+                          withArgumentsInArray:arguments
+                                         block:[[self class] _uuidsQueryBlock]];
+        }] continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
+            NSArray<NSString *> *uuids = task.result;
+            NSString *lastUUID = (uuids.count == pageSize ? uuids.lastObject : nil);
+            return [[self _collectObjectsAsyncWithUUIDs:uuids
+                                          forQueryState:queryState
+                                                   user:user
+                                              collector:collector
+                                               database:database] continueWithSuccessBlock:^id(BFTask *_) {
+                // Stop once there are no more stored objects, or enough objects were matched.
+                return (collector.saturated ? nil : lastUUID);
+            }];
         }];
     }];
 }
 
+///--------------------------------------
+#pragma mark - Find Helpers
+///--------------------------------------
+
+- (NSString *)_uuidColumnForPin:(PFPin *)pin {
+    if (pin) {
+        return [@"A." stringByAppendingString:PFOfflineStoreKeyOfUUID];
+    }
+    return PFOfflineStoreKeyOfUUID;
+}
+
+/**
+ @return A task that yields the statement, without a trailing `;`, that selects the UUIDs of the stored objects
+ the query can match, or `nil` if there can't be any. Its arguments are added to `arguments`.
+ */
+- (BFTask<NSString *> *)_uuidsQueryAsyncForQueryState:(PFQueryState *)queryState
+                                                  pin:(PFPin *)pin
+                                            arguments:(NSMutableArray *)arguments {
+    NSString *isDeletingEventuallyQuery = @"";
+    if (!queryState.shouldIncludeDeletingEventually) {
+        isDeletingEventuallyQuery = [NSString stringWithFormat:@"AND %@ = 0",
+                                     PFOfflineStoreKeyOfIsDeletingEventually];
+    }
+
+    // Objects that are only referenced by stored objects have a row without JSON, and never match.
+    if (!pin) {
+        NSString *queryString = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ? AND %@ IS NOT NULL %@",
+                                 PFOfflineStoreKeyOfUUID,
+                                 PFOfflineStoreTableOfObjects,
+                                 PFOfflineStoreKeyOfClassName,
+                                 PFOfflineStoreKeyOfJSON,
+                                 isDeletingEventuallyQuery];
+        [arguments addObject:queryState.parseClassName];
+        return [BFTask taskWithResult:queryString];
+    }
+
+    BFTask *uuidTask = [self.objectToUUIDMap objectForKey:pin];
+    if (!uuidTask) {
+        // Pin was never saved locally, therefore there won't be any results.
+        return [BFTask taskWithResult:nil];
+    }
+    return [uuidTask continueWithSuccessBlock:^id(BFTask *task) {
+        NSString *uuid = task.result;
+        NSString *queryString = [NSString stringWithFormat:@"SELECT A.%@ FROM %@ A "
+                                 @"INNER JOIN %@ B ON A.%@ = B.%@ WHERE %@ = ? AND %@ = ? AND A.%@ IS NOT NULL %@",
+                                 PFOfflineStoreKeyOfUUID, PFOfflineStoreTableOfObjects,
+                                 PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfUUID,
+                                 PFOfflineStoreKeyOfUUID, PFOfflineStoreKeyOfClassName,
+                                 PFOfflineStoreKeyOfKey, PFOfflineStoreKeyOfJSON, isDeletingEventuallyQuery];
+        [arguments addObjectsFromArray:@[ queryState.parseClassName, uuid ]];
+        return queryString;
+    }];
+}
+
++ (PFSQLiteDatabaseQueryBlock)_uuidsQueryBlock {
+    return ^id(PFSQLiteDatabaseResult *result) {
+        NSMutableArray<NSString *> *uuids = [NSMutableArray array];
+        while ([result next]) {
+            NSString *uuid = [result stringForColumnIndex:0];
+            [uuids addObject:uuid];
+        }
+        return uuids;
+    };
+}
+
+/**
+ Fetches the objects with the given UUIDs, 64 at a time, and adds the ones that match the query to `collector`.
+ Stops fetching once the collector is saturated.
+ */
+- (BFTask<PFVoid> *)_collectObjectsAsyncWithUUIDs:(NSArray<NSString *> *)uuids
+                                    forQueryState:(PFQueryState *)queryState
+                                             user:(PFUser *)user
+                                        collector:(PFOfflineQueryResultsCollector *)collector
+                                         database:(PFSQLiteDatabase *)database {
+    // Queries without subqueries are matched synchronously, the matcher is only used for the rest.
+    PFConstraintPredicateBlock predicateBlock = [self.offlineQueryLogic createPredicateForQueryState:queryState
+                                                                                                user:user];
+    PFConstraintMatcherBlock matcherBlock = nil;
+    if (!predicateBlock) {
+        matcherBlock = [self.offlineQueryLogic createMatcherForQueryState:queryState user:user];
+    }
+
+    BFTask *checkAllTask = [BFTask taskWithResult:nil];
+    NSArray<NSArray<NSString *> *> *uuidBatches = [PFInternalUtils arrayBySplittingArray:uuids
+                                                         withMaximumComponentsPerSegment:64];
+    for (NSArray <NSString *> *uuids in uuidBatches) {
+        checkAllTask = [[checkAllTask continueWithSuccessBlock:^id(BFTask *_) {
+            if (collector.saturated) {
+                return [BFTask taskWithResult:@[]];
+            }
+            return [self _getObjectPointersAsyncWithUUIDs:uuids fromDatabase:database];
+        }] continueWithSuccessBlock:^id(BFTask<NSArray<PFObject *> *> *task) {
+            BFTask *checkBatchTask = [BFTask taskWithResult:nil];
+            for (PFObject *object in task.result) {
+                checkBatchTask = [[checkBatchTask continueWithSuccessBlock:^id(BFTask *_) {
+                    if (collector.saturated) {
+                        return nil;
+                    }
+                    return [self fetchObjectLocallyAsync:object database:database];
+                }] continueWithSuccessBlock:^id(BFTask *_) {
+                    if (collector.saturated || !object.dataAvailable) {
+                        return nil;
+                    }
+                    if (predicateBlock) {
+                        NSError *error = nil;
+                        if (predicateBlock(object, &error)) {
+                            [collector addObject:object];
+                        }
+                        return (error ? [BFTask taskWithError:error] : nil);
+                    }
+                    return [matcherBlock(object, database) continueWithSuccessBlock:^id(BFTask *task) {
+                        if ([task.result boolValue]) {
+                            [collector addObject:object];
+                        }
+                        return nil;
+                    }];
+                }];
+            }
+            return checkBatchTask;
+        }];
+    }
+    return checkAllTask;
+}
+
 ///--------------------------------------
 #pragma mark - Update
 ///--------------------------------------
@@ -620,7 +990,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 
     __block NSString *uuid = nil;
     __block NSDictionary *dataDictionary = nil;
-    return [[uuidTask continueWithSuccessBlock:^id(BFTask *task) {
+    return [[[uuidTask continueWithSuccessBlock:^id(BFTask *task) {
         uuid = task.result;
 
         PFOfflineObjectEncoder *encoder = [PFOfflineObjectEncoder objectEncoderWithOfflineStore:self
@@ -634,7 +1004,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         // Put it in database
         NSString *className = object.parseClassName;
         NSString *objectId = object.objectId;
-        NSString *encodedDataDictionary = [PFJSONSerialization stringFromJSONObject:dataDictionary];
+        id json = [self _JSONColumnValueFromObject:dataDictionary];
         NSNumber *deletingEventually = dataDictionary[PFOfflineStoreKeyOfIsDeletingEventually];
 
         NSString *updateParams = nil;
@@ -643,18 +1013,20 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
             updateParams = [NSString stringWithFormat:@"%@ = ?, %@ = ?, %@ = ?, %@ = ?",
                             PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON,
                             PFOfflineStoreKeyOfIsDeletingEventually, PFOfflineStoreKeyOfObjectId];
-            updateArguments = @[ className, encodedDataDictionary, deletingEventually, objectId, uuid ];
+            updateArguments = @[ className, json, deletingEventually, objectId, uuid ];
         } else {
             updateParams = [NSString stringWithFormat:@"%@ = ?, %@ = ?, %@ = ?",
                             PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON,
                             PFOfflineStoreKeyOfIsDeletingEventually];
-            updateArguments = @[ className, encodedDataDictionary, deletingEventually, uuid ];
+            updateArguments = @[ className, json, deletingEventually, uuid ];
         }
 
         NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@ = ?",
                          PFOfflineStoreTableOfObjects, updateParams, PFOfflineStoreKeyOfUUID];
 
-        return [database executeSQLAsync:sql withArgumentsInArray:updateArguments];
+        return [database executeCachedSQLAsync:sql withArgumentsInArray:updateArguments];
+    }] continueWithSuccessBlock:^id(BFTask *task) {
+        return [self _updateIndexedValuesAsyncForObjects:@[ object ] uuids:@[ uuid ] database:database];
     }];
 }
 
@@ -692,7 +1064,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         NSString *sql = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ?",
                          PFOfflineStoreKeyOfKey, PFOfflineStoreTableOfDependencies,
                          PFOfflineStoreKeyOfUUID];
-        return [database executeQueryAsync:sql withArgumentsInArray:@[ uuid ] block:^id(PFSQLiteDatabaseResult *result) {
+        return [database executeCachedQueryAsync:sql withArgumentsInArray:@[ uuid ] block:^id(PFSQLiteDatabaseResult *result) {
             NSMutableArray<NSString *> *uuids = [NSMutableArray array];
             while (result.next) {
                 NSString *uuid = [result stringForColumnIndex:0];
@@ -730,10 +1102,14 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         return [BFTask taskForCompletionOfAllTasks:tasks];
     }];
 
-    return [[[unpinTask continueWithSuccessBlock:^id(BFTask *task) {
+    return [[[[unpinTask continueWithSuccessBlock:^id(BFTask *task) {
         NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?",
                          PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfUUID];
         return [database executeSQLAsync:sql withArgumentsInArray:@[ uuid ]];
+    }] continueWithSuccessBlock:^id(BFTask *task) {
+        NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?",
+                         PFOfflineStoreTableOfIndexedValues, PFOfflineStoreKeyOfUUID];
+        return [database executeSQLAsync:sql withArgumentsInArray:@[ uuid ]];
     }] continueWithSuccessBlock:^id(BFTask *task) {
         NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?",
                          PFOfflineStoreTableOfObjects, PFOfflineStoreKeyOfUUID];
@@ -790,7 +1166,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                        PFOfflineStoreTableOfDependencies,
                        PFOfflineStoreKeyOfUUID,
                        PFOfflineStoreKeyOfUUID];
-    return [[[[database executeQueryAsync:query withArgumentsInArray:@[ key ] block:^id(PFSQLiteDatabaseResult *result) {
+    return [[[[database executeCachedQueryAsync:query withArgumentsInArray:@[ key ] block:^id(PFSQLiteDatabaseResult *result) {
         while ([result next]) {
             [uuids addObject:[result stringForColumnIndex:0]];
         }
@@ -841,7 +1217,387 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                      PFOfflineStoreTableOfObjects,
                      PFOfflineStoreKeyOfUUID,
                      [placeholders componentsJoinedByString:@","]];
-    return [database executeSQLAsync:sql withArgumentsInArray:uuids];
+    return [[database executeSQLAsync:sql withArgumentsInArray:uuids] continueWithSuccessBlock:^id(BFTask *_) {
+        NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%@);",
+                         PFOfflineStoreTableOfIndexedValues,
+                         PFOfflineStoreKeyOfUUID,
+                         [placeholders componentsJoinedByString:@","]];
+        return [database executeSQLAsync:sql withArgumentsInArray:uuids];
+    }];
+}
+
+///--------------------------------------
+#pragma mark - Indexes
+///--------------------------------------
+
+- (BFTask<PFVoid> *)createIndexAsyncOnKey:(NSString *)key forClassName:(NSString *)className {
+    return [self _performDatabaseTransactionAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
+        return [[self _indexedKeysAsyncForClassName:className
+                                           database:database] continueWithSuccessBlock:^id(BFTask<NSSet<NSString *> *> *task) {
+            if ([task.result containsObject:key]) {
+                return nil;
+            }
+            NSString *sql = [NSString stringWithFormat:@"INSERT INTO %@(%@, %@) VALUES (?, ?);",
+                             PFOfflineStoreTableOfIndexedKeys, PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfKey];
+            return [[database executeSQLAsync:sql
+                         withArgumentsInArray:@[ className, key ]] continueWithSuccessBlock:^id(BFTask *_) {
+                return [self _indexObjectsAsyncWithClassName:className key:key database:database];
+            }];
+        }];
+    }];
+}
+
+- (BFTask<NSSet<NSString *> *> *)_indexedKeysAsyncForClassName:(NSString *)className
+                                                      database:(PFSQLiteDatabase *)database {
+    NSString *query = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ?;",
+                       PFOfflineStoreKeyOfKey, PFOfflineStoreTableOfIndexedKeys, PFOfflineStoreKeyOfClassName];
+    return [database executeCachedQueryAsync:query withArgumentsInArray:@[ className ] block:^id(PFSQLiteDatabaseResult *result) {
+        NSMutableSet<NSString *> *keys = [NSMutableSet set];
+        while ([result next]) {
+            [keys addObject:[result stringForColumnIndex:0]];
+        }
+        return keys;
+    }];
+}
+
+/**
+ Indexes `key` for every object of the class that is already in the database.
+ */
+- (BFTask<PFVoid> *)_indexObjectsAsyncWithClassName:(NSString *)className
+                                                key:(NSString *)key
+                                           database:(PFSQLiteDatabase *)database {
+    NSString *query = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ? AND %@ IS NOT NULL;",
+                       PFOfflineStoreKeyOfUUID, PFOfflineStoreTableOfObjects,
+                       PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfJSON];
+    return [[database executeQueryAsync:query withArgumentsInArray:@[ className ] block:^id(PFSQLiteDatabaseResult *result) {
+        NSMutableArray<NSString *> *uuids = [NSMutableArray array];
+        while ([result next]) {
+            [uuids addObject:[result stringForColumnIndex:0]];
+        }
+        return uuids;
+    }] continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
+        BFTask *indexAllTask = [BFTask taskWithResult:nil];
+        NSArray<NSArray<NSString *> *> *uuidBatches = [PFInternalUtils arrayBySplittingArray:task.result
+                                                             withMaximumComponentsPerSegment:64];
+        for (NSArray<NSString *> *uuids in uuidBatches) {
+            indexAllTask = [[indexAllTask continueWithSuccessBlock:^id(BFTask *_) {
+                return [self _getObjectPointersAsyncWithUUIDs:uuids fromDatabase:database];
+            }] continueWithSuccessBlock:^id(BFTask<NSArray<PFObject *> *> *task) {
+                BFTask *indexBatchTask = [BFTask taskWithResult:nil];
+                for (PFObject *object in task.result) {
+                    indexBatchTask = [[[indexBatchTask continueWithSuccessBlock:^id(BFTask *_) {
+                        return [self fetchObjectLocallyAsync:object database:database];
+                    }] continueWithSuccessBlock:^id(BFTask *_) {
+                        @synchronized(self.lock) {
+                            return [self.objectToUUIDMap objectForKey:object];
+                        }
+                    }] continueWithSuccessBlock:^id(BFTask<NSString *> *task) {
+                        return [self _insertIndexedValuesAsyncForObject:object
+                                                                   uuid:task.result
+                                                                   keys:@[ key ]
+                                                               database:database];
+                    }];
+                }
+                return indexBatchTask;
+            }];
+        }
+        return indexAllTask;
+    }];
+}
+
+/**
+ Replaces the indexed values of the objects, which are at the same indexes as their UUIDs in `uuids`.
+ */
+- (BFTask<PFVoid> *)_updateIndexedValuesAsyncForObjects:(NSArray<PFObject *> *)objects
+                                                  uuids:(NSArray<NSString *> *)uuids
+                                               database:(PFSQLiteDatabase *)database {
+    NSMutableDictionary<NSString *, NSMutableIndexSet *> *indexesByClassName = [NSMutableDictionary dictionary];
+    [objects enumerateObjectsUsingBlock:^(PFObject *object, NSUInteger i, BOOL *stop) {
+        NSMutableIndexSet *indexes = indexesByClassName[object.parseClassName];
+        if (!indexes) {
+            indexes = [NSMutableIndexSet indexSet];
+            indexesByClassName[object.parseClassName] = indexes;
+        }
+        [indexes addIndex:i];
+    }];
+
+    NSMutableArray<BFTask<PFVoid> *> *tasks = [NSMutableArray arrayWithCapacity:indexesByClassName.count];
+    [indexesByClassName enumerateKeysAndObjectsUsingBlock:^(NSString *className, NSIndexSet *indexes, BOOL *stop) {
+        NSArray<PFObject *> *classObjects = [objects objectsAtIndexes:indexes];
+        NSArray<NSString *> *classUUIDs = [uuids objectsAtIndexes:indexes];
+        BFTask *task = [[self _indexedKeysAsyncForClassName:className
+                                                   database:database] continueWithSuccessBlock:^id(BFTask<NSSet<NSString *> *> *task) {
+            NSArray<NSString *> *keys = task.result.allObjects;
+            if (keys.count == 0) {
+                return nil;
+            }
+            return [[self _deleteIndexedValuesAsyncWithUUIDs:classUUIDs database:database] continueWithSuccessBlock:^id(BFTask *_) {
+                NSMutableArray<NSArray *> *rows = [NSMutableArray array];
+                [classObjects enumerateObjectsUsingBlock:^(PFObject *object, NSUInteger i, BOOL *stop) {
+                    [rows addObjectsFromArray:[self _indexedValueRowsForObject:object uuid:classUUIDs[i] keys:keys]];
+                }];
+                return [self _insertIndexedValueRowsAsync:rows database:database];
+            }];
+        }];
+        [tasks addObject:task];
+    }];
+    return [BFTask taskForCompletionOfAllTasks:tasks];
+}
+
+- (BFTask<PFVoid> *)_deleteIndexedValuesAsyncWithUUIDs:(NSArray<NSString *> *)uuids
+                                              database:(PFSQLiteDatabase *)database {
+    NSMutableArray<BFTask *> *tasks = [NSMutableArray array];
+    NSArray<NSArray<NSString *> *> *uuidBatches = [PFInternalUtils arrayBySplittingArray:uuids
+                                                         withMaximumComponentsPerSegment:PFOfflineStoreMaximumSQLVariablesCount];
+    for (NSArray<NSString *> *uuids in uuidBatches) {
+        if (uuids.count == 1) {
+            NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?;",
+                             PFOfflineStoreTableOfIndexedValues, PFOfflineStoreKeyOfUUID];
+            [tasks addObject:[database executeCachedSQLAsync:sql withArgumentsInArray:uuids]];
+            continue;
+        }
+        NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:uuids.count];
+        for (NSUInteger i = 0; i < uuids.count; i++) {
+            [placeholders addObject:@"?"];
+        }
+        NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%@);",
+                         PFOfflineStoreTableOfIndexedValues, PFOfflineStoreKeyOfUUID,
+                         [placeholders componentsJoinedByString:@","]];
+        [tasks addObject:[database executeSQLAsync:sql withArgumentsInArray:uuids]];
+    }
+    return [BFTask taskForCompletionOfAllTasks:tasks];
+}
+
+/**
+ Indexes the values the matcher sees for `keys`, which include the operations that weren't saved to the server yet.
+ */
+- (BFTask<PFVoid> *)_insertIndexedValuesAsyncForObject:(PFObject *)object
+                                                  uuid:(NSString *)uuid
+                                                  keys:(NSArray<NSString *> *)keys
+                                              database:(PFSQLiteDatabase *)database {
+    NSArray<NSArray *> *rows = [self _indexedValueRowsForObject:object uuid:uuid keys:keys];
+    return [self _insertIndexedValueRowsAsync:rows database:database];
+}
+
+- (BFTask<PFVoid> *)_insertIndexedValueRowsAsync:(NSArray<NSArray *> *)rows database:(PFSQLiteDatabase *)database {
+    NSArray<NSString *> *columns = @[ PFOfflineStoreKeyOfUUID, PFOfflineStoreKeyOfClassName,
+                                      PFOfflineStoreKeyOfKey, PFOfflineStoreKeyOfValue ];
+    return [[self class] _insertRowsAsync:rows
+                                intoTable:PFOfflineStoreTableOfIndexedValues
+                                  columns:columns
+                         ignoreConflicts:NO
+                                 database:database];
+}
+
+/**
+ @return The rows of `IndexedValues` for the values of `keys` that the matcher sees on the object.
+ */
+- (NSArray<NSArray *> *)_indexedValueRowsForObject:(PFObject *)object
+                                              uuid:(NSString *)uuid
+                                              keys:(NSArray<NSString *> *)keys {
+    if (!object.dataAvailable) {
+        // The matcher skips objects without data, so they never need to be found.
+        return @[];
+    }
+
+    NSMutableArray<NSArray *> *rows = [NSMutableArray array];
+    for (NSString *key in keys) {
+        id value = [self.offlineQueryLogic valueForContainer:object key:key];
+        // Equality matches any element of an array, so each element is indexed on its own.
+        NSArray *values = ([value isKindOfClass:[NSArray class]] ? value : (value ? @[ value ] : @[]));
+        NSMutableSet *indexedValues = [NSMutableSet setWithCapacity:values.count];
+        for (id value in values) {
+            id indexedValue = [[self class] _indexedValueForValue:value];
+            if (indexedValue) {
+                [indexedValues addObject:indexedValue];
+            }
+        }
+        for (id indexedValue in indexedValues) {
+            [rows addObject:@[ uuid, object.parseClassName, key, indexedValue ]];
+        }
+    }
+    return rows;
+}
+
+/**
+ @return The representation of `value` in the index, or `nil` if values of its type are not indexed.
+ Dates are indexed with the same precision they are compared with by the matcher.
+ */
++ (id)_indexedValueForValue:(id)value {
+    if ([value isKindOfClass:[NSString class]] || [value isKindOfClass:[NSNumber class]]) {
+        return value;
+    }
+    if ([value isKindOfClass:[NSDate class]]) {
+        return [[PFDateFormatter sharedFormatter] preciseStringFromDate:value];
+    }
+    return nil;
+}
+
+/**
+ Translates the constraints of the query on indexed keys into a condition on `uuidColumn`.
+
+ The condition selects a superset of the matching objects, since the matcher still runs on every object
+ that is selected: it also checks ACLs, and compares the values of objects that were changed in memory
+ after being written to the database. Those objects are always selected.
+
+ @return The condition, or `nil` if none of the constraints can use an index.
+ */
+- (NSString *)_indexedConditionForQueryState:(PFQueryState *)queryState
+                                 indexedKeys:(NSSet<NSString *> *)indexedKeys
+                                  uuidColumn:(NSString *)uuidColumn
+                                   arguments:(NSMutableArray *)arguments {
+    NSMutableArray *conditionArguments = [NSMutableArray array];
+    NSString *condition = [self _indexedConstraintsConditionForQueryState:queryState
+                                                              indexedKeys:indexedKeys
+                                                               uuidColumn:uuidColumn
+                                                                arguments:conditionArguments
+                                                                  isExact:NULL];
+    if (!condition) {
+        return nil;
+    }
+
+    NSArray<NSString *> *changedUUIDs = [self _uuidsOfChangedObjectsWithClassName:queryState.parseClassName];
+    if (arguments.count + conditionArguments.count + changedUUIDs.count > PFOfflineStoreMaximumSQLVariablesCount) {
+        return nil;
+    }
+
+    if (changedUUIDs.count > 0) {
+        NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:changedUUIDs.count];
+        for (NSUInteger i = 0; i < changedUUIDs.count; i++) {
+            [placeholders addObject:@"?"];
+        }
+        condition = [NSString stringWithFormat:@"(%@) OR %@ IN (%@)",
+                     condition, uuidColumn, [placeholders componentsJoinedByString:@","]];
+    }
+    [arguments addObjectsFromArray:conditionArguments];
+    [arguments addObjectsFromArray:changedUUIDs];
+    return [NSString stringWithFormat:@"(%@)", condition];
+}
+
+/**
+ Translates the constraints of the query on indexed keys into a condition on `uuidColumn`, that only takes
+ the values that were indexed when objects were written into account.
+
+ @param isExact Set to `YES` if the condition selects exactly the stored objects that match every constraint,
+ which is the case when all constraints are equality or `$in` constraints on indexed keys with values other than dates.
+
+ @return The condition, or `nil` if none of the constraints can use an index.
+ */
+- (NSString *)_indexedConstraintsConditionForQueryState:(PFQueryState *)queryState
+                                            indexedKeys:(NSSet<NSString *> *)indexedKeys
+                                             uuidColumn:(NSString *)uuidColumn
+                                              arguments:(NSMutableArray *)arguments
+                                                isExact:(BOOL *)isExact {
+    __block BOOL exact = YES;
+    NSString *className = queryState.parseClassName;
+    NSMutableArray<NSString *> *conditions = [NSMutableArray array];
+    NSMutableArray *conditionArguments = [NSMutableArray array];
+    void (^addCondition)(NSString *, NSString *, NSArray *) = ^(NSString *key, NSString *comparison, NSArray *values) {
+        NSString *condition = [NSString stringWithFormat:@"%@ IN (SELECT %@ FROM %@ WHERE %@ = ? AND %@ = ? AND %@ %@)",
+                               uuidColumn, PFOfflineStoreKeyOfUUID, PFOfflineStoreTableOfIndexedValues,
+                               PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfKey, PFOfflineStoreKeyOfValue,
+                               comparison];
+        [conditions addObject:condition];
+        [conditionArguments addObject:className];
+        [conditionArguments addObject:key];
+        [conditionArguments addObjectsFromArray:values];
+    };
+
+    [queryState.conditions enumerateKeysAndObjectsUsingBlock:^(NSString *key, id constraint, BOOL *stop) {
+        if (![indexedKeys containsObject:key]) {
+            exact = NO;
+            return;
+        }
+        if (![constraint isKindOfClass:[NSDictionary class]]) {
+            id value = [[self class] _indexedValueForValue:constraint];
+            if (value) {
+                addCondition(key, @"= ?", @[ value ]);
+            }
+            // Indexed dates are truncated to milliseconds, so they might select dates that don't match.
+            if (!value || [constraint isKindOfClass:[NSDate class]]) {
+                exact = NO;
+            }
+            return;
+        }
+
+        // Every operator is a separate condition, since each of them may match a different element of an array.
+        [(NSDictionary *)constraint enumerateKeysAndObjectsUsingBlock:^(NSString *operator, id operand, BOOL *stop) {
+            if ([operator isEqualToString:PFQueryKeyContainedIn]) {
+                if (![operand isKindOfClass:[NSArray class]] || [operand count] == 0) {
+                    exact = NO;
+                    return;
+                }
+                NSMutableArray *values = [NSMutableArray arrayWithCapacity:[operand count]];
+                NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:[operand count]];
+                for (id element in operand) {
+                    id value = [[self class] _indexedValueForValue:element];
+                    if (!value) {
+                        exact = NO;
+                        return;
+                    }
+                    if ([element isKindOfClass:[NSDate class]]) {
+                        exact = NO;
+                    }
+                    [values addObject:value];
+                    [placeholders addObject:@"?"];
+                }
+                NSString *comparison = [NSString stringWithFormat:@"IN (%@)", [placeholders componentsJoinedByString:@","]];
+                addCondition(key, comparison, values);
+                return;
+            }
+
+            // Comparisons also select values of other types, and arrays with a single matching element.
+            exact = NO;
+            id value = [[self class] _indexedValueForValue:operand];
+            if (!value) {
+                return;
+            }
+            // Indexed dates are truncated, so strict comparisons of dates have to include the bound.
+            BOOL inclusive = [operand isKindOfClass:[NSDate class]];
+            if ([operator isEqualToString:PFQueryKeyLessThan]) {
+                addCondition(key, (inclusive ? @"<= ?" : @"< ?"), @[ value ]);
+            } else if ([operator isEqualToString:PFQueryKeyLessThanEqualTo]) {
+                addCondition(key, @"<= ?", @[ value ]);
+            } else if ([operator isEqualToString:PFQueryKeyGreaterThan]) {
+                addCondition(key, (inclusive ? @">= ?" : @"> ?"), @[ value ]);
+            } else if ([operator isEqualToString:PFQueryKeyGreaterThanOrEqualTo]) {
+                addCondition(key, @">= ?", @[ value ]);
+            }
+        }];
+    }];
+    if (isExact) {
+        *isExact = exact;
+    }
+    if (conditions.count == 0) {
+        return nil;
+    }
+    [arguments addObjectsFromArray:conditionArguments];
+    return [NSString stringWithFormat:@"(%@)", [conditions componentsJoinedByString:@" AND "]];
+}
+
+/**
+ @return UUIDs of the objects in memory that might differ from what was indexed when they were written.
+ */
+- (NSArray<NSString *> *)_uuidsOfChangedObjectsWithClassName:(NSString *)className {
+    NSMutableDictionary<NSString *, PFObject *> *objects = [NSMutableDictionary dictionary];
+    @synchronized(self.lock) {
+        for (NSString *uuid in self.UUIDToObjectMap) {
+            PFObject *object = [self.UUIDToObjectMap objectForKey:uuid];
+            if (object) {
+                objects[uuid] = object;
+            }
+        }
+    }
+
+    // Objects lock themselves, so they are only checked after releasing our lock.
+    NSMutableArray<NSString *> *uuids = [NSMutableArray array];
+    [objects enumerateKeysAndObjectsUsingBlock:^(NSString *uuid, PFObject *object, BOOL *stop) {
+        if ([object.parseClassName isEqualToString:className] &&
+            ([object _hasChanges] || [object _hasOutstandingOperations])) {
+            [uuids addObject:uuid];
+        }
+    }];
+    return uuids;
 }
 
 ///--------------------------------------
@@ -877,7 +1633,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                        PFOfflineStoreTableOfObjects,
                        PFOfflineStoreKeyOfUUID,
                        PFOfflineStoreKeyOfClassName];
-    [[database executeSQLAsync:query withArgumentsInArray:@[ newUUID, object.parseClassName ]] continueWithSuccessBlock:^id(BFTask *task) {
+    [[database executeCachedSQLAsync:query withArgumentsInArray:@[ newUUID, object.parseClassName ]] continueWithSuccessBlock:^id(BFTask *task) {
         [tcs setResult:newUUID];
         return nil;
     }];
@@ -885,6 +1641,132 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
     return tcs.task;
 }
 
+/**
+ Same as `getOrCreateUUIDAsyncForObject:database:` for many objects, but the placeholder rows
+ of the objects that don't have a UUID yet are inserted together.
+
+ @return A task that yields the UUIDs of the objects, in the same order.
+ */
+- (BFTask<NSArray<NSString *> *> *)_getOrCreateUUIDsAsyncForObjects:(NSArray<PFObject *> *)objects
+                                                           database:(PFSQLiteDatabase *)database {
+    NSMutableArray<BFTask<NSString *> *> *uuidTasks = [NSMutableArray arrayWithCapacity:objects.count];
+    NSMutableArray<BFTaskCompletionSource *> *newUUIDSources = [NSMutableArray array];
+    NSMutableArray<NSArray *> *rows = [NSMutableArray array];
+
+    @synchronized(self.lock) {
+        for (PFObject *object in objects) {
+            BFTask *uuidTask = [self.objectToUUIDMap objectForKey:object];
+            if (uuidTask != nil) {
+                [uuidTasks addObject:uuidTask];
+                continue;
+            }
+
+            NSString *newUUID = [NSUUID UUID].UUIDString;
+            BFTaskCompletionSource *tcs = [BFTaskCompletionSource taskCompletionSource];
+            [self.objectToUUIDMap setObject:tcs.task forKey:object];
+            [self.UUIDToObjectMap setObject:object forKey:newUUID];
+
+            __weak id weakObject = object;
+            [self.fetchedObjects setObject:[tcs.task continueWithSuccessBlock:^id(BFTask *task) {
+                return [PFWeakValue valueWithWeakObject:weakObject];
+            }] forKey:object];
+
+            [uuidTasks addObject:tcs.task];
+            [newUUIDSources addObject:tcs];
+            [rows addObject:@[ newUUID, object.parseClassName ]];
+        }
+    }
+
+    if (rows.count > 0) {
+        [[[self class] _insertRowsAsync:rows
+                              intoTable:PFOfflineStoreTableOfObjects
+                                columns:@[ PFOfflineStoreKeyOfUUID, PFOfflineStoreKeyOfClassName ]
+                       ignoreConflicts:NO
+                               database:database] continueWithBlock:^id(BFTask *task) {
+            [newUUIDSources enumerateObjectsUsingBlock:^(BFTaskCompletionSource *tcs, NSUInteger i, BOOL *stop) {
+                if (task.faulted) {
+                    [tcs setError:task.error];
+                } else {
+                    [tcs setResult:rows[i][0]];
+                }
+            }];
+            return nil;
+        }];
+    }
+
+    return [[BFTask taskForCompletionOfAllTasks:uuidTasks] continueWithSuccessBlock:^id(BFTask *_) {
+        NSMutableArray<NSString *> *uuids = [NSMutableArray arrayWithCapacity:uuidTasks.count];
+        for (BFTask<NSString *> *task in uuidTasks) {
+            [uuids addObject:task.result];
+        }
+        return uuids;
+    }];
+}
+
+/**
+ Inserts `rows` into `table`, with as many rows per statement as the maximum number of SQL variables allows.
+ All statements but the last one have the same number of rows, so they are prepared once,
+ and run without leaving the database queue.
+ */
++ (BFTask<PFVoid> *)_insertRowsAsync:(NSArray<NSArray *> *)rows
+                           intoTable:(NSString *)table
+                             columns:(NSArray<NSString *> *)columns
+                     ignoreConflicts:(BOOL)ignoreConflicts
+                            database:(PFSQLiteDatabase *)database {
+    if (rows.count == 0) {
+        return [BFTask taskWithResult:nil];
+    }
+
+    NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:columns.count];
+    for (NSUInteger i = 0; i < columns.count; i++) {
+        [placeholders addObject:@"?"];
+    }
+    NSString *rowPlaceholders = [NSString stringWithFormat:@"(%@)", [placeholders componentsJoinedByString:@", "]];
+    NSString *(^insertStatement)(NSUInteger) = ^NSString *(NSUInteger rowsCount) {
+        NSMutableArray<NSString *> *values = [NSMutableArray arrayWithCapacity:rowsCount];
+        for (NSUInteger i = 0; i < rowsCount; i++) {
+            [values addObject:rowPlaceholders];
+        }
+        return [NSString stringWithFormat:@"INSERT %@INTO %@(%@) VALUES %@;",
+                (ignoreConflicts ? @"OR IGNORE " : @""), table,
+                [columns componentsJoinedByString:@", "], [values componentsJoinedByString:@", "]];
+    };
+
+    NSUInteger rowsPerStatement = MAX(PFOfflineStoreMaximumSQLVariablesCount / columns.count, 1);
+    NSMutableArray<NSArray *> *fullStatementsArguments = [NSMutableArray array];
+    NSMutableArray *lastStatementArguments = nil;
+    NSUInteger lastStatementRowsCount = 0;
+    for (NSUInteger location = 0; location < rows.count; location += rowsPerStatement) {
+        NSUInteger rowsCount = MIN(rowsPerStatement, rows.count - location);
+        NSMutableArray *arguments = [NSMutableArray arrayWithCapacity:rowsCount * columns.count];
+        for (NSArray *row in [rows subarrayWithRange:NSMakeRange(location, rowsCount)]) {
+            [arguments addObjectsFromArray:row];
+        }
+        if (rowsCount == rowsPerStatement) {
+            [fullStatementsArguments addObject:arguments];
+        } else {
+            lastStatementArguments = arguments;
+            lastStatementRowsCount = rowsCount;
+        }
+    }
+
+    NSMutableArray<BFTask *> *tasks = [NSMutableArray arrayWithCapacity:2];
+    if (fullStatementsArguments.count > 0) {
+        [tasks addObject:[database executeCachedSQLAsync:insertStatement(rowsPerStatement)
+                                      withArgumentsArrays:fullStatementsArguments]];
+    }
+    if (lastStatementArguments) {
+        // Single rows are cached too, since most writes only insert one. Other sizes would fill the statement cache.
+        NSString *sql = insertStatement(lastStatementRowsCount);
+        if (lastStatementRowsCount == 1) {
+            [tasks addObject:[database executeCachedSQLAsync:sql withArgumentsInArray:lastStatementArguments]];
+        } else {
+            [tasks addObject:[database executeSQLAsync:sql withArgumentsInArray:lastStatementArguments]];
+        }
+    }
+    return [BFTask taskForCompletionOfAllTasks:tasks];
+}
+
 #pragma mark Pointers
 
 /**
@@ -915,9 +1797,13 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
 
     __block NSString *className = nil;
     __block NSString *objectId = nil;
-    return [[database executeQueryAsync:query withArgumentsInArray:@[ uuid ] block:^id(PFSQLiteDatabaseResult *result) {
+    return [[database executeCachedQueryAsync:query withArgumentsInArray:@[ uuid ] block:^id(PFSQLiteDatabaseResult *result) {
         if (![result next]) {
-            PFPreconditionFailure(@"Attempted to find non-existent uuid %@. Please report this issue with stack traces and logs.", uuid);
+            // The row might not be committed yet, which concurrent reads can't see.
+            NSError *error = [PFErrorUtilities errorWithCode:kPFErrorCacheMiss
+                                                     message:@"This object is not available in the offline cache."
+                                                   shouldLog:NO];
+            return [BFTask taskWithError:error];
         }
 
         className = [result stringForColumnIndex:0];
@@ -1086,42 +1972,133 @@ void PFOfflineStoreReplaceExisingObject() {}
             PFOfflineStoreKeyOfUUID];
 }
 
++ (NSString *)PFOfflineStoreIndexedKeysTableSchema {
+    return [NSString stringWithFormat:@"CREATE TABLE IF NOT EXISTS %@ ("
+            @"%@ TEXT NOT NULL, "
+            @"%@ TEXT NOT NULL, "
+            @"PRIMARY KEY(%@, %@));",
+            PFOfflineStoreTableOfIndexedKeys,
+            PFOfflineStoreKeyOfClassName,
+            PFOfflineStoreKeyOfKey,
+            PFOfflineStoreKeyOfClassName,
+            PFOfflineStoreKeyOfKey];
+}
+
+/**
+ `value` is declared without a type, so that SQLite stores and compares numbers and strings as they are bound.
+ */
++ (NSString *)PFOfflineStoreIndexedValuesTableSchema {
+    return [NSString stringWithFormat:@"CREATE TABLE IF NOT EXISTS %@ ("
+            @"%@ TEXT NOT NULL, "
+            @"%@ TEXT NOT NULL, "
+            @"%@ TEXT NOT NULL, "
+            @"%@);",
+            PFOfflineStoreTableOfIndexedValues,
+            PFOfflineStoreKeyOfUUID,
+            PFOfflineStoreKeyOfClassName,
+            PFOfflineStoreKeyOfKey,
+            PFOfflineStoreKeyOfValue];
+}
+
++ (NSArray<NSString *> *)PFOfflineStoreIndexedValuesIndexSchemas {
+    return @[ [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS %@LookupIndex ON %@(%@, %@, %@);",
+               PFOfflineStoreTableOfIndexedValues, PFOfflineStoreTableOfIndexedValues,
+               PFOfflineStoreKeyOfClassName, PFOfflineStoreKeyOfKey, PFOfflineStoreKeyOfValue],
+              [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS %@UUIDIndex ON %@(%@);",
+               PFOfflineStoreTableOfIndexedValues, PFOfflineStoreTableOfIndexedValues,
+               PFOfflineStoreKeyOfUUID] ];
+}
+
 + (BFTask<PFVoid> *)_initializeTablesInBackgroundWithDatabaseController:(PFSQLiteDatabaseController *)databaseController {
-    return [[databaseController openDatabaseWithNameAsync:PFOfflineStoreDatabaseName] continueWithBlock:^id(BFTask *task) {
-        PFSQLiteDatabase *database = task.result;
-        return [[[[[database beginTransactionAsync] continueWithSuccessBlock:^id(BFTask *task) {
-            return [database executeSQLAsync:[self PFOfflineStoreParseObjectsTableSchema] withArgumentsInArray:nil];
-        }] continueWithSuccessBlock:^id(BFTask *task) {
-            return [database executeSQLAsync:[self PFOfflineStoreDependenciesTableSchema] withArgumentsInArray:nil];
-        }] continueWithSuccessBlock:^id(BFTask *task) {
-            return [database commitAsync];
-        }] continueWithBlock:^id(BFTask *task) {
-            return [database closeAsync];
+    // Reads can't run before the tables exist, even with a write-ahead log.
+    return [databaseController performDatabaseBarrierOperationAsyncWithName:PFOfflineStoreDatabaseName block:^BFTask *(PFSQLiteDatabase *database) {
+        return [self _performTransactionAsyncInDatabase:database deferred:NO block:^BFTask *(PFSQLiteDatabase *database) {
+            NSMutableArray<NSString *> *schemas = [NSMutableArray arrayWithObjects:
+                                                   [self PFOfflineStoreParseObjectsTableSchema],
+                                                   [self PFOfflineStoreDependenciesTableSchema],
+                                                   [self PFOfflineStoreIndexedKeysTableSchema],
+                                                   [self PFOfflineStoreIndexedValuesTableSchema],
+                                                   nil];
+            [schemas addObjectsFromArray:[self PFOfflineStoreIndexedValuesIndexSchemas]];
+
+            BFTask *task = [BFTask taskWithResult:nil];
+            for (NSString *schema in schemas) {
+                task = [task continueWithSuccessBlock:^id(BFTask *_) {
+                    return [database executeSQLAsync:schema withArgumentsInArray:nil];
+                }];
+            }
+            return task;
         }];
     }];
 }
 
+///--------------------------------------
+#pragma mark - JSON Column
+///--------------------------------------
+
+/**
+ @return Value to store in the json column for the encoded object, in the format selected by the store options.
+ */
+- (id)_JSONColumnValueFromObject:(id)object {
+    if (self.options & PFOfflineStoreOptionBinaryEncoding) {
+        return [PFBinaryJSONSerialization dataFromJSONObject:object];
+    }
+    return [PFJSONSerialization stringFromJSONObject:object];
+}
+
+/**
+ Decodes the json column straight from the bytes of the current row, regardless of the format it was stored in.
+ Must be called before the result moves to another row.
+ */
++ (id)_JSONObjectForColumnIndex:(int)columnIndex ofResult:(PFSQLiteDatabaseResult *)result {
+    NSData *data = [result dataNoCopyForColumnIndex:columnIndex];
+    if (data == nil) {
+        return nil;
+    }
+    if ([PFBinaryJSONSerialization isBinaryJSONData:data]) {
+        return [PFBinaryJSONSerialization JSONObjectFromData:data];
+    }
+    return [PFJSONSerialization JSONObjectFromData:data];
+}
+
 ///--------------------------------------
 #pragma mark - Database Helpers
 ///--------------------------------------
 
 - (BFTask<PFVoid> *)_performDatabaseTransactionAsyncWithBlock:(PFOfflineStoreDatabaseExecutionBlock)block {
-    return [self _performDatabaseOperationAsyncWithBlock:^BFTask *(PFSQLiteDatabase *database) {
-        BFTask *task = [database beginTransactionAsync];
-        task = [task continueWithSuccessBlock:^id(BFTask *task) {
-            return block(database);
-        }];
-        return [task continueWithSuccessBlock:^id(BFTask *task) {
-            return [database commitAsync];
-        }];
+    return [self.databaseController performDatabaseOperationAsyncWithName:PFOfflineStoreDatabaseName block:^BFTask *(PFSQLiteDatabase *database) {
+        return [[self class] _performTransactionAsyncInDatabase:database deferred:NO block:block];
+    }];
+}
+
+- (BFTask *)_performReadOnlyDatabaseOperationAsyncWithBlock:(PFOfflineStoreDatabaseExecutionBlock)block {
+    return [self.databaseController performReadOnlyDatabaseOperationAsyncWithName:PFOfflineStoreDatabaseName block:^BFTask *(PFSQLiteDatabase *database) {
+        // Reads go through a deferred transaction, so that every statement sees the same snapshot of the database.
+        return [[self class] _performTransactionAsyncInDatabase:database deferred:YES block:block];
     }];
 }
 
-- (BFTask<PFVoid> *)_performDatabaseOperationAsyncWithBlock:(PFOfflineStoreDatabaseExecutionBlock)block {
-    return [[self.databaseController openDatabaseWithNameAsync:PFOfflineStoreDatabaseName] continueWithBlock:^id(BFTask *task) {
-        PFSQLiteDatabase *database = task.result;
-        return [block(database) continueWithBlock:^id(BFTask *task) {
-            return [database closeAsync];
+/**
+ @return A task that yields the result of the task returned from `block`, once the transaction is committed.
+ */
++ (BFTask *)_performTransactionAsyncInDatabase:(PFSQLiteDatabase *)database
+                                      deferred:(BOOL)deferred
+                                         block:(PFOfflineStoreDatabaseExecutionBlock)block {
+    BFTask *beginTask = (deferred ? [database beginDeferredTransactionAsync] : [database beginTransactionAsync]);
+    return [beginTask continueWithSuccessBlock:^id(BFTask *_) {
+        return [[block(database) continueWithBlock:^id(BFTask *task) {
+            if (task.faulted || task.cancelled) {
+                return task;
+            }
+            return [[database commitAsync] continueWithSuccessResult:task.result];
+        }] continueWithBlock:^id(BFTask *task) {
+            if (task.faulted || task.cancelled) {
+                // The connection outlives this operation, so the transaction must not be left open.
+                return [[database rollbackAsync] continueWithBlock:^id(BFTask *_) {
+                    return task;
+                }];
+            }
+            return task;
         }];
     }];
 }
@@ -1153,6 +2130,9 @@ void PFOfflineStoreReplaceExisingObject() {}
 }
 
 - (void)clearDatabase {
+    // Close pooled connections, so that none of them keeps using the removed file.
+    [[self.databaseController closeDatabaseWithNameAsync:PFOfflineStoreDatabaseName] waitForResult:nil withMainThreadWarning:NO];
+
     // Delete DB file
     NSString *filePath = [self.fileManager parseDataItemPathForPathComponent:PFOfflineStoreDatabaseName];
     [[PFFileManager removeItemAtPathAsync:filePath] waitForResult:nil withMainThreadWarning:NO];
@@ -83,6 +83,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BFTask *)beginTransactionAsync;
 
+/**
+ Begins a database transaction in DEFERRED mode. No lock is acquired until the database is first accessed,
+ which makes this the right mode for read-only transactions.
+ */
+- (BFTask *)beginDeferredTransactionAsync;
+
 /**
  Commits running transaction.
  */
@@ -107,11 +113,32 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BFTask *)executeCachedQueryAsync:(NSString *)sql withArgumentsInArray:(nullable NSArray *)args;
 
+/**
+ Runs a single SQL statement which return result (SELECT), while caching the prepared statement for future use.
+ The statement is reset once the block returns, so the block must not retain the result.
+ */
+- (BFTask *)executeCachedQueryAsync:(NSString *)sql
+               withArgumentsInArray:(nullable NSArray *)args
+                              block:(PFSQLiteDatabaseQueryBlock)block;
+
 /**
  Runs a single SQL statement which doesn't return result (UPDATE/INSERT/DELETE).
  */
 - (BFTask *)executeSQLAsync:(NSString *)sql withArgumentsInArray:(nullable NSArray *)args;
 
+/**
+ Runs a single SQL statement which doesn't return result (UPDATE/INSERT/DELETE),
+ while caching the prepared statement for future use.
+ */
+- (BFTask *)executeCachedSQLAsync:(NSString *)sql withArgumentsInArray:(nullable NSArray *)args;
+
+/**
+ Runs a single SQL statement which doesn't return result once for every array of arguments,
+ reusing the same prepared statement, without leaving the database queue in between.
+ Stops at the first statement that fails.
+ */
+- (BFTask *)executeCachedSQLAsync:(NSString *)sql withArgumentsArrays:(NSArray<NSArray *> *)argumentsArrays;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -31,6 +31,7 @@
 #import "PFThreadsafety.h"
 
 static NSString *const PFSQLiteDatabaseBeginExclusiveOperationCommand = @"BEGIN EXCLUSIVE";
+static NSString *const PFSQLiteDatabaseBeginDeferredOperationCommand = @"BEGIN DEFERRED";
 static NSString *const PFSQLiteDatabaseCommitOperationCommand = @"COMMIT";
 static NSString *const PFSQLiteDatabaseRollbackOperationCommand = @"ROLLBACK";
 
@@ -85,6 +86,7 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
     }];
 
     _cachedStatements = [[NSMutableDictionary alloc] init];
+    _locksFileWhileOpen = YES;
 
     return self;
 }
@@ -121,7 +123,9 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
         }
 
         // Lock the file to avoid multi-process access.
-        [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.databasePath];
+        if (self.locksFileWhileOpen) {
+            [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.databasePath];
+        }
 
         sqlite3 *db;
         int resultCode = sqlite3_open(self.databasePath.UTF8String, &db);
@@ -146,7 +150,9 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
         [self _clearCachedStatements];
         int resultCode = sqlite3_close(self.database);
 
-        [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.databasePath];
+        if (self.locksFileWhileOpen) {
+            [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.databasePath];
+        }
 
         if (resultCode == SQLITE_OK) {
 
@@ -169,6 +175,11 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
             withArgumentsInArray:nil];
 }
 
+- (BFTask *)beginDeferredTransactionAsync {
+    return [self executeSQLAsync:PFSQLiteDatabaseBeginDeferredOperationCommand
+            withArgumentsInArray:nil];
+}
+
 - (BFTask *)commitAsync {
     return [self executeSQLAsync:PFSQLiteDatabaseCommitOperationCommand
             withArgumentsInArray:nil];
@@ -231,6 +242,21 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
     }];
 }
 
+- (BFTask *)executeCachedQueryAsync:(NSString *)sql
+               withArgumentsInArray:(nullable NSArray *)args
+                              block:(PFSQLiteDatabaseQueryBlock)block {
+    return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
+        BFTask<PFSQLiteDatabaseResult *> *task = [self _executeQueryAsync:sql withArgumentsInArray:args cachingEnabled:YES];
+        return [[task continueImmediatelyWithSuccessBlock:^id(BFTask<PFSQLiteDatabaseResult *> *task) {
+            return block(task.result);
+        }] continueImmediatelyWithBlock:^id(BFTask *resultTask) {
+            // Reset instead of closing, so the statement stays prepared and releases its read lock.
+            [[self _cachedStatementForQuery:sql] reset];
+            return resultTask;
+        }];
+    }];
+}
+
 - (BFTask *)executeQueryAsync:(NSString *)query withArgumentsInArray:(nullable NSArray *)args block:(PFSQLiteDatabaseQueryBlock)block {
     return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
         BFTask<PFSQLiteDatabaseResult *> *task = [self _executeQueryAsync:query withArgumentsInArray:args cachingEnabled:NO];
@@ -245,29 +271,60 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
 
 - (BFTask *)executeSQLAsync:(NSString *)sql withArgumentsInArray:(NSArray *)args {
     return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
-        return [[self _executeQueryAsync:sql
-                    withArgumentsInArray:args
-                          cachingEnabled:NO] continueWithExecutor:[BFExecutor immediateExecutor] withSuccessBlock:^id(BFTask *task) {
-            PFSQLiteDatabaseResult *databaseResult = task.result;
-            int sqliteResultCode = [databaseResult step];
+        return [self _executeSQL:sql withArgumentsInArray:args cachingEnabled:NO];
+    }];
+}
+
+- (BFTask *)executeCachedSQLAsync:(NSString *)sql withArgumentsInArray:(NSArray *)args {
+    return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
+        return [self _executeSQL:sql withArgumentsInArray:args cachingEnabled:YES];
+    }];
+}
+
+- (BFTask *)executeCachedSQLAsync:(NSString *)sql withArgumentsArrays:(NSArray<NSArray *> *)argumentsArrays {
+    return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
+        for (NSArray *args in argumentsArrays) {
+            BFTask *task = [self _executeSQL:sql withArgumentsInArray:args cachingEnabled:YES];
+            if (task.faulted) {
+                return task;
+            }
+        }
+        return nil;
+    }];
+}
+
+/**
+ Runs a statement that doesn't return a result. Must be called on the database queue.
+ Cached statements are reset instead of closed, so that they can be bound again by the next call.
+ */
+- (BFTask *)_executeSQL:(NSString *)sql withArgumentsInArray:(NSArray *)args cachingEnabled:(BOOL)enableCaching {
+    BFTask<PFSQLiteDatabaseResult *> *task = [self _executeQueryAsync:sql
+                                                 withArgumentsInArray:args
+                                                       cachingEnabled:enableCaching];
+    return [task continueWithExecutor:[BFExecutor immediateExecutor] withSuccessBlock:^id(BFTask *task) {
+        PFSQLiteDatabaseResult *databaseResult = task.result;
+        int sqliteResultCode = [databaseResult step];
+        if (enableCaching) {
+            [[self _cachedStatementForQuery:sql] reset];
+        } else {
             [databaseResult close];
+        }
 
-            switch (sqliteResultCode) {
-                case SQLITE_DONE: {
-                    return nil;
-                }
-                case SQLITE_ROW: {
-                    NSError *error = [self _errorWithErrorCode:PFSQLiteDatabaseInvalidSQL
-                                                  errorMessage:@"Cannot SELECT on executeSQLAsync."
-                                                               @"Please use executeQueryAsync."
-                                                        domain:NSStringFromClass([self class])];
-                    return [BFTask taskWithError:error];
-                }
-                default: {
-                    return [BFTask taskWithError:[self _errorWithErrorCode:sqliteResultCode]];
-                }
+        switch (sqliteResultCode) {
+            case SQLITE_DONE: {
+                return nil;
             }
-        }];
+            case SQLITE_ROW: {
+                NSError *error = [self _errorWithErrorCode:PFSQLiteDatabaseInvalidSQL
+                                              errorMessage:@"Cannot SELECT on executeSQLAsync."
+                                                           @"Please use executeQueryAsync."
+                                                    domain:NSStringFromClass([self class])];
+                return [BFTask taskWithError:error];
+            }
+            default: {
+                return [BFTask taskWithError:[self _errorWithErrorCode:sqliteResultCode]];
+            }
+        }
     }];
 }
 
@@ -17,10 +17,38 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+typedef BFTask *_Nonnull(^PFSQLiteDatabaseOperationBlock)(PFSQLiteDatabase *database);
+
+typedef NS_ENUM(uint8_t, PFSQLiteDatabaseJournalMode) {
+    /**
+     Default SQLite rollback journal. Read-only operations never overlap with other operations.
+     */
+    PFSQLiteDatabaseJournalModeDelete = 0,
+    /**
+     Write-ahead log. Read-only operations run concurrently with other operations and see the last committed state.
+     */
+    PFSQLiteDatabaseJournalModeWriteAheadLog = 1,
+};
+
 @interface PFSQLiteDatabaseController : NSObject
 
 @property (nonatomic, strong, readonly) PFFileManager *fileManager;
 
+@property (nonatomic, assign, readonly) PFSQLiteDatabaseJournalMode journalMode;
+
+/**
+ The maximum number of connections per database that are used to run read-only operations concurrently.
+ */
+@property (nonatomic, assign, readonly) NSUInteger maximumReaderConnectionsCount;
+
+/**
+ The number of pages in the write-ahead log after which it is checkpointed automatically when a transaction commits,
+ or `0` to never checkpoint automatically. Only used in `PFSQLiteDatabaseJournalModeWriteAheadLog`,
+ and only applies to databases that are opened after it is set.
+ Lower values keep the log and the cost of reads small, higher values make commits cheaper. Default: `1000`.
+ */
+@property (atomic, assign) NSUInteger writeAheadLogAutoCheckpointPagesCount;
+
 ///--------------------------------------
 #pragma mark - Init
 ///--------------------------------------
@@ -28,23 +56,56 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)init NS_UNAVAILABLE;
 + (instancetype)new NS_UNAVAILABLE;
 
-- (instancetype)initWithFileManager:(PFFileManager *)fileManager NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithFileManager:(PFFileManager *)fileManager;
+- (instancetype)initWithFileManager:(PFFileManager *)fileManager
+                        journalMode:(PFSQLiteDatabaseJournalMode)journalMode
+      maximumReaderConnectionsCount:(NSUInteger)maximumReaderConnectionsCount NS_DESIGNATED_INITIALIZER;
+
 + (instancetype)controllerWithFileManager:(PFFileManager *)fileManager;
++ (instancetype)controllerWithFileManager:(PFFileManager *)fileManager journalMode:(PFSQLiteDatabaseJournalMode)journalMode;
 
 ///--------------------------------------
-#pragma mark - Opening
+#pragma mark - Operations
 ///--------------------------------------
 
 /**
- Asynchronously opens a database connection to the database with the name specified.
- @note Only one database can be actively open at a time.
+ Asynchronously performs an operation against the database with the name specified.
+ Operations run one at a time on a single long-lived connection, so they are free to begin transactions and write
+ to the database. They only overlap with read-only operations in `PFSQLiteDatabaseJournalModeWriteAheadLog`.
+
+ @param name  The name of the database.
+ @param block The block to perform. The connection must not be closed or used after the returned task completes.
+
+ @return A task that yields the result of the task returned from `block`.
+ */
+- (BFTask *)performDatabaseOperationAsyncWithName:(NSString *)name block:(PFSQLiteDatabaseOperationBlock)block;
+
+/**
+ Same as `performDatabaseOperationAsyncWithName:block:`, but never overlaps with read-only operations,
+ regardless of the journal mode. Use it for operations that read-only operations depend on, like schema changes.
+ */
+- (BFTask *)performDatabaseBarrierOperationAsyncWithName:(NSString *)name block:(PFSQLiteDatabaseOperationBlock)block;
+
+/**
+ Asynchronously performs a read-only operation against the database with the name specified.
+ Read-only operations run concurrently with each other on a pool of long-lived reader connections.
 
- @param name The name of the database to open.
+ @param name  The name of the database.
+ @param block The block to perform. It must not write to the database.
 
- @return A task, which yields a `PFSQLiteDatabase`, with the open database. 
- When the database is closed, a new database connection can be opened.
+ @return A task that yields the result of the task returned from `block`.
+ */
+- (BFTask *)performReadOnlyDatabaseOperationAsyncWithName:(NSString *)name block:(PFSQLiteDatabaseOperationBlock)block;
+
+///--------------------------------------
+#pragma mark - Closing
+///--------------------------------------
+
+/**
+ Closes all pooled connections to the database with the name specified, once every in-flight operation finishes.
+ New connections are opened by the next operation.
  */
-- (BFTask *)openDatabaseWithNameAsync:(NSString *)name;
+- (BFTask *)closeDatabaseWithNameAsync:(NSString *)name;
 
 @end
 
@@ -17,13 +17,356 @@
 #import "BFTaskCompletionSource.h"
 #endif
 
-#import "PFAssert.h"
-#import "PFAsyncTaskQueue.h"
+#import "BFTask+Private.h"
 #import "PFFileManager.h"
+#import "PFLogging.h"
+#import "PFMultiProcessFileLockController.h"
+#import "PFSQLiteDatabaseResult.h"
 #import "PFSQLiteDatabase_Private.h"
 
+static NSUInteger const PFSQLiteDatabaseControllerDefaultMaximumReaderConnectionsCount = 4;
+static NSUInteger const PFSQLiteDatabaseControllerDefaultWriteAheadLogAutoCheckpointPagesCount = 1000;
+/**
+ How long a connection retries while the database file is locked by another connection, e.g. during a checkpoint
+ or by another process, before it fails with `SQLITE_BUSY`.
+ */
+static NSUInteger const PFSQLiteDatabaseControllerBusyTimeoutMilliseconds = 5000;
+
+///--------------------------------------
+#pragma mark - PFSQLiteDatabasePool
+///--------------------------------------
+
+/**
+ Internal class that owns the long-lived connections to a single database file.
+ Writes are serialized on one connection, reads share a bounded set of reader connections.
+ */
+@interface PFSQLiteDatabasePool : NSObject
+
+@property (nonatomic, copy, readonly) NSString *databasePath;
+@property (nonatomic, assign, readonly) PFSQLiteDatabaseJournalMode journalMode;
+@property (nonatomic, assign, readonly) NSUInteger maximumReadersCount;
+@property (nonatomic, assign, readonly) NSUInteger autoCheckpointPagesCount;
+
+- (instancetype)initWithDatabasePath:(NSString *)path
+                         journalMode:(PFSQLiteDatabaseJournalMode)journalMode
+                 maximumReadersCount:(NSUInteger)maximumReadersCount
+            autoCheckpointPagesCount:(NSUInteger)autoCheckpointPagesCount;
+
+- (BFTask *)performOperationAsyncWithBlock:(PFSQLiteDatabaseOperationBlock)block barrier:(BOOL)barrier;
+- (BFTask *)performReadOnlyOperationAsyncWithBlock:(PFSQLiteDatabaseOperationBlock)block;
+
+- (BFTask *)closeAsync;
+
+@end
+
+@implementation PFSQLiteDatabasePool {
+    NSObject *_lock;
+    NSObject *_fileLockLock;
+
+    // Completes once the last exclusive operation has finished.
+    BFTask *_exclusiveTail;
+    // Completes once the last exclusive operation that read-only operations have to wait for has finished.
+    BFTask *_barrierTail;
+    // Read-only operations that were started after the last barrier had been enqueued.
+    NSMutableArray<BFTask *> *_sharedTasks;
+
+    BFTask<PFSQLiteDatabase *> *_writerTask;
+
+    NSMutableArray<PFSQLiteDatabase *> *_idleReaders;
+    NSMutableArray<BFTaskCompletionSource *> *_readerWaiters;
+    NSUInteger _readersCount;
+
+    NSUInteger _activeOperationsCount;
+}
+
+- (instancetype)initWithDatabasePath:(NSString *)path
+                         journalMode:(PFSQLiteDatabaseJournalMode)journalMode
+                 maximumReadersCount:(NSUInteger)maximumReadersCount
+            autoCheckpointPagesCount:(NSUInteger)autoCheckpointPagesCount {
+    self = [super init];
+    if (!self) return nil;
+
+    _databasePath = [path copy];
+    _journalMode = journalMode;
+    _maximumReadersCount = MAX(maximumReadersCount, 1);
+    _autoCheckpointPagesCount = autoCheckpointPagesCount;
+
+    _lock = [[NSObject alloc] init];
+    _fileLockLock = [[NSObject alloc] init];
+
+    _exclusiveTail = [BFTask taskWithResult:nil];
+    _barrierTail = _exclusiveTail;
+    _sharedTasks = [NSMutableArray array];
+
+    _idleReaders = [NSMutableArray array];
+    _readerWaiters = [NSMutableArray array];
+
+    return self;
+}
+
+- (void)dealloc {
+    // Nothing can be in flight at this point, since every operation retains the pool.
+    [_writerTask.result closeAsync];
+    for (PFSQLiteDatabase *database in _idleReaders) {
+        [database closeAsync];
+    }
+}
+
+///--------------------------------------
+#pragma mark - Operations
+///--------------------------------------
+
+- (BFTask *)performOperationAsyncWithBlock:(PFSQLiteDatabaseOperationBlock)block barrier:(BOOL)barrier {
+    return [self _enqueueExclusiveBlock:^BFTask * {
+        return [self _performOperationAsyncReadOnly:NO withBlock:block];
+    } barrier:barrier];
+}
+
+- (BFTask *)performReadOnlyOperationAsyncWithBlock:(PFSQLiteDatabaseOperationBlock)block {
+    return [self _enqueueSharedBlock:^BFTask * {
+        return [self _performOperationAsyncReadOnly:YES withBlock:block];
+    }];
+}
+
+- (BFTask *)_performOperationAsyncReadOnly:(BOOL)readOnly withBlock:(PFSQLiteDatabaseOperationBlock)block {
+    // Lock before opening, so that a new connection never observes a file that another process is writing.
+    [self _beginLockedAccess];
+    BFTask<PFSQLiteDatabase *> *databaseTask = (readOnly ? [self _dequeueReaderDatabaseAsync] : [self _writerDatabaseAsync]);
+    return [databaseTask continueWithBlock:^id(BFTask<PFSQLiteDatabase *> *task) {
+        if (task.faulted || task.cancelled) {
+            [self _endLockedAccess];
+            return task;
+        }
+
+        PFSQLiteDatabase *database = task.result;
+        BFTask *operationTask = block(database);
+        return [operationTask continueWithBlock:^id(BFTask *_) {
+            if (readOnly) {
+                [self _enqueueReaderDatabase:database];
+            }
+            [self _endLockedAccess];
+            return operationTask;
+        }];
+    }];
+}
+
+///--------------------------------------
+#pragma mark - Scheduling
+///--------------------------------------
+
+/**
+ Runs the block once the previously enqueued exclusive blocks have finished. No other exclusive block starts until it finishes.
+ Barriers, and every exclusive block unless the database uses a write-ahead log, also exclude shared blocks.
+ */
+- (BFTask *)_enqueueExclusiveBlock:(BFTask *(^)(void))block barrier:(BOOL)barrier {
+    barrier = (barrier || self.journalMode != PFSQLiteDatabaseJournalModeWriteAheadLog);
+    @synchronized(_lock) {
+        NSMutableArray<BFTask *> *tasks = [NSMutableArray arrayWithObject:_exclusiveTail];
+        if (barrier) {
+            [tasks addObjectsFromArray:_sharedTasks];
+            [_sharedTasks removeAllObjects];
+        }
+
+        BFTask *task = [[BFTask taskForCompletionOfAllTasks:tasks] continueAsyncWithBlock:^id(BFTask *_) {
+            return block();
+        }];
+        _exclusiveTail = task;
+        if (barrier) {
+            _barrierTail = task;
+        }
+        return task;
+    }
+}
+
+/**
+ Runs the block once the last enqueued barrier has finished, concurrently with other shared blocks.
+ */
+- (BFTask *)_enqueueSharedBlock:(BFTask *(^)(void))block {
+    @synchronized(_lock) {
+        BFTask *task = [_barrierTail continueAsyncWithBlock:^id(BFTask *_) {
+            return block();
+        }];
+        [_sharedTasks filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(BFTask *task, NSDictionary *bindings) {
+            return !task.completed;
+        }]];
+        [_sharedTasks addObject:task];
+        return task;
+    }
+}
+
+///--------------------------------------
+#pragma mark - Connections
+///--------------------------------------
+
+- (BFTask<PFSQLiteDatabase *> *)_openDatabaseAsync {
+    PFSQLiteDatabase *database = [PFSQLiteDatabase databaseWithPath:self.databasePath];
+    database.locksFileWhileOpen = NO;
+    NSString *busyTimeout = [NSString stringWithFormat:@"PRAGMA busy_timeout = %lu",
+                             (unsigned long)PFSQLiteDatabaseControllerBusyTimeoutMilliseconds];
+    return [[[database openAsync] continueWithSuccessBlock:^id(BFTask *task) {
+        return [self _executePragmaAsync:busyTimeout inDatabase:database];
+    }] continueWithSuccessResult:database];
+}
+
+- (BFTask<PFSQLiteDatabase *> *)_writerDatabaseAsync {
+    // Only ever called from exclusive operations, so there is no one to race with for the writer.
+    if (!_writerTask || _writerTask.faulted || _writerTask.cancelled) {
+        _writerTask = [[self _openDatabaseAsync] continueWithSuccessBlock:^id(BFTask<PFSQLiteDatabase *> *task) {
+            return [[self _configureJournalAsyncForDatabase:task.result] continueWithResult:task.result];
+        }];
+    }
+    return _writerTask;
+}
+
+/**
+ The journal mode is persisted in the database file, so it is set on the writer only.
+ Failing to switch it is not fatal, the database keeps working in whatever mode it is in.
+ */
+- (BFTask *)_configureJournalAsyncForDatabase:(PFSQLiteDatabase *)database {
+    if (self.journalMode != PFSQLiteDatabaseJournalModeWriteAheadLog) {
+        return [self _executePragmaAsync:@"PRAGMA journal_mode = DELETE" inDatabase:database];
+    }
+
+    NSString *autoCheckpoint = [NSString stringWithFormat:@"PRAGMA wal_autocheckpoint = %lu",
+                                (unsigned long)self.autoCheckpointPagesCount];
+    return [[[self _executePragmaAsync:@"PRAGMA journal_mode = WAL" inDatabase:database] continueWithBlock:^id(BFTask *task) {
+        // Syncing on checkpoints only is safe with a write-ahead log, the database can't be corrupted.
+        return [self _executePragmaAsync:@"PRAGMA synchronous = NORMAL" inDatabase:database];
+    }] continueWithBlock:^id(BFTask *task) {
+        return [self _executePragmaAsync:autoCheckpoint inDatabase:database];
+    }];
+}
+
+- (BFTask *)_executePragmaAsync:(NSString *)pragma inDatabase:(PFSQLiteDatabase *)database {
+    // Some pragmas return their new value as a row, so they can't go through `executeSQLAsync:`.
+    return [[database executeQueryAsync:pragma withArgumentsInArray:nil block:^id(PFSQLiteDatabaseResult *result) {
+        while ([result next]) {}
+        return nil;
+    }] continueWithBlock:^id(BFTask *task) {
+        if (task.faulted) {
+            PFLogWarning(PFLoggingTagCommon, @"Failed to execute `%@` on %@: %@", pragma, self.databasePath, task.error);
+        }
+        return nil;
+    }];
+}
+
+- (BFTask<PFSQLiteDatabase *> *)_dequeueReaderDatabaseAsync {
+    BFTaskCompletionSource *waiter = nil;
+    @synchronized(_lock) {
+        PFSQLiteDatabase *database = _idleReaders.lastObject;
+        if (database) {
+            [_idleReaders removeLastObject];
+            return [BFTask taskWithResult:database];
+        }
+
+        if (_readersCount >= self.maximumReadersCount) {
+            waiter = [BFTaskCompletionSource taskCompletionSource];
+            [_readerWaiters addObject:waiter];
+            return waiter.task;
+        }
+        _readersCount++;
+    }
+
+    return [[self _openDatabaseAsync] continueWithBlock:^id(BFTask<PFSQLiteDatabase *> *task) {
+        if (task.faulted || task.cancelled) {
+            BFTaskCompletionSource *nextWaiter = nil;
+            @synchronized(self->_lock) {
+                self->_readersCount--;
+                nextWaiter = self->_readerWaiters.firstObject;
+                if (nextWaiter) {
+                    [self->_readerWaiters removeObjectAtIndex:0];
+                }
+            }
+            if (!nextWaiter) {
+                return task;
+            }
+            // Let the next waiter attempt to open a connection of its own, instead of waiting forever.
+            [[self _dequeueReaderDatabaseAsync] continueWithBlock:^id(BFTask<PFSQLiteDatabase *> *task) {
+                if (task.faulted) {
+                    [nextWaiter trySetError:task.error];
+                } else if (task.cancelled) {
+                    [nextWaiter trySetCancelled];
+                } else {
+                    [nextWaiter trySetResult:task.result];
+                }
+                return nil;
+            }];
+        }
+        return task;
+    }];
+}
+
+- (void)_enqueueReaderDatabase:(PFSQLiteDatabase *)database {
+    BFTaskCompletionSource *waiter = nil;
+    @synchronized(_lock) {
+        waiter = _readerWaiters.firstObject;
+        if (waiter) {
+            [_readerWaiters removeObjectAtIndex:0];
+        } else {
+            [_idleReaders addObject:database];
+        }
+    }
+    [waiter setResult:database];
+}
+
+///--------------------------------------
+#pragma mark - File Lock
+///--------------------------------------
+
+// Connections stay open between operations, but other processes should still be able to access the file
+// while this one is idle. So the lock is held only while there is at least one operation in flight.
+
+- (void)_beginLockedAccess {
+    @synchronized(_fileLockLock) {
+        if (_activeOperationsCount++ == 0) {
+            [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.databasePath];
+        }
+    }
+}
+
+- (void)_endLockedAccess {
+    @synchronized(_fileLockLock) {
+        if (--_activeOperationsCount == 0) {
+            [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.databasePath];
+        }
+    }
+}
+
+///--------------------------------------
+#pragma mark - Closing
+///--------------------------------------
+
+- (BFTask *)closeAsync {
+    return [self _enqueueExclusiveBlock:^BFTask * {
+        NSMutableArray<PFSQLiteDatabase *> *databases = nil;
+        @synchronized(self->_lock) {
+            // No shared operations are running, so every reader is idle.
+            databases = [self->_idleReaders mutableCopy];
+            [self->_idleReaders removeAllObjects];
+            self->_readersCount = 0;
+        }
+        PFSQLiteDatabase *writer = self->_writerTask.result;
+        if (writer) {
+            [databases addObject:writer];
+        }
+        self->_writerTask = nil;
+
+        NSMutableArray<BFTask *> *tasks = [NSMutableArray arrayWithCapacity:databases.count];
+        for (PFSQLiteDatabase *database in databases) {
+            [tasks addObject:[database closeAsync]];
+        }
+        return [BFTask taskForCompletionOfAllTasks:tasks];
+    } barrier:YES];
+}
+
+@end
+
+///--------------------------------------
+#pragma mark - PFSQLiteDatabaseController
+///--------------------------------------
+
 @implementation PFSQLiteDatabaseController {
-    PFAsyncTaskQueue *_openDatabaseQueue;
+    NSMutableDictionary<NSString *, PFSQLiteDatabasePool *> *_pools;
 }
 
 ///--------------------------------------
@@ -31,11 +374,22 @@
 ///--------------------------------------
 
 - (instancetype)initWithFileManager:(PFFileManager *)fileManager {
+    return [self initWithFileManager:fileManager
+                         journalMode:PFSQLiteDatabaseJournalModeDelete
+       maximumReaderConnectionsCount:PFSQLiteDatabaseControllerDefaultMaximumReaderConnectionsCount];
+}
+
+- (instancetype)initWithFileManager:(PFFileManager *)fileManager
+                        journalMode:(PFSQLiteDatabaseJournalMode)journalMode
+      maximumReaderConnectionsCount:(NSUInteger)maximumReaderConnectionsCount {
     self = [super init];
     if (!self) return nil;
 
     _fileManager = fileManager;
-    _openDatabaseQueue = [[PFAsyncTaskQueue alloc] init];
+    _journalMode = journalMode;
+    _maximumReaderConnectionsCount = maximumReaderConnectionsCount;
+    _writeAheadLogAutoCheckpointPagesCount = PFSQLiteDatabaseControllerDefaultWriteAheadLogAutoCheckpointPagesCount;
+    _pools = [NSMutableDictionary dictionary];
 
     return self;
 }
@@ -44,35 +398,53 @@
     return [[self alloc] initWithFileManager:fileManager];
 }
 
++ (instancetype)controllerWithFileManager:(PFFileManager *)fileManager journalMode:(PFSQLiteDatabaseJournalMode)journalMode {
+    return [[self alloc] initWithFileManager:fileManager
+                                 journalMode:journalMode
+               maximumReaderConnectionsCount:PFSQLiteDatabaseControllerDefaultMaximumReaderConnectionsCount];
+}
+
 ///--------------------------------------
-#pragma mark - Opening
+#pragma mark - Operations
 ///--------------------------------------
 
-// TODO: (richardross) Implement connection pooling using NSCache or similar mechanism.
-- (BFTask *)openDatabaseWithNameAsync:(NSString *)name {
-    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
-    [_openDatabaseQueue enqueue:^id(BFTask *task) {
-        NSString *databasePath = [self.fileManager parseDataItemPathForPathComponent:name];
-        PFSQLiteDatabase *sqliteDatabase = [PFSQLiteDatabase databaseWithPath:databasePath];
-        [[sqliteDatabase openAsync] continueWithBlock:^id(BFTask *task) {
-            if (task.faulted) {
-                NSError *error = task.error;
-                if (error) {
-                    [taskCompletionSource trySetError:error];
-                }
-            } else if (task.cancelled) {
-                [taskCompletionSource trySetCancelled];
-            } else {
-                [taskCompletionSource trySetResult:sqliteDatabase];
-            }
+- (BFTask *)performDatabaseOperationAsyncWithName:(NSString *)name block:(PFSQLiteDatabaseOperationBlock)block {
+    return [[self _poolForDatabaseWithName:name] performOperationAsyncWithBlock:block barrier:NO];
+}
 
-            return nil;
-        }];
+- (BFTask *)performDatabaseBarrierOperationAsyncWithName:(NSString *)name block:(PFSQLiteDatabaseOperationBlock)block {
+    return [[self _poolForDatabaseWithName:name] performOperationAsyncWithBlock:block barrier:YES];
+}
 
-        return sqliteDatabase.databaseClosedTask;
-    }];
+- (BFTask *)performReadOnlyDatabaseOperationAsyncWithName:(NSString *)name block:(PFSQLiteDatabaseOperationBlock)block {
+    return [[self _poolForDatabaseWithName:name] performReadOnlyOperationAsyncWithBlock:block];
+}
+
+///--------------------------------------
+#pragma mark - Closing
+///--------------------------------------
+
+- (BFTask *)closeDatabaseWithNameAsync:(NSString *)name {
+    return [[self _poolForDatabaseWithName:name] closeAsync];
+}
+
+///--------------------------------------
+#pragma mark - Private
+///--------------------------------------
 
-    return taskCompletionSource.task;
+- (PFSQLiteDatabasePool *)_poolForDatabaseWithName:(NSString *)name {
+    @synchronized(_pools) {
+        PFSQLiteDatabasePool *pool = _pools[name];
+        if (!pool) {
+            NSString *databasePath = [self.fileManager parseDataItemPathForPathComponent:name];
+            pool = [[PFSQLiteDatabasePool alloc] initWithDatabasePath:databasePath
+                                                          journalMode:self.journalMode
+                                                  maximumReadersCount:self.maximumReaderConnectionsCount
+                                             autoCheckpointPagesCount:self.writeAheadLogAutoCheckpointPagesCount];
+            _pools[name] = pool;
+        }
+        return pool;
+    }
 }
 
 @end
@@ -59,6 +59,12 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable NSData *)dataForColumn:(NSString *)columnName;
 - (nullable NSData *)dataForColumnIndex:(int)columnIndex;
 
+/**
+ Returns the bytes of a TEXT or BLOB column without copying them.
+ The data is only valid until the result moves to another row or is closed, so it must not be retained.
+ */
+- (nullable NSData *)dataNoCopyForColumnIndex:(int)columnIndex;
+
 - (nullable id)objectForColumn:(NSString *)columnName;
 - (nullable id)objectForColumnIndex:(int)columnIndex;
 
@@ -134,6 +134,22 @@
     });
 }
 
+- (NSData *)dataNoCopyForColumnIndex:(int)columnIndex {
+    return PFThreadSafetyPerform(_databaseQueue, ^NSData *{
+        if ([self columnIndexIsNull:columnIndex]) {
+            return nil;
+        }
+
+        // Reading the blob of a TEXT column yields its UTF-8 bytes.
+        const void *buffer = sqlite3_column_blob([self.statement sqliteStatement], columnIndex);
+        int size = sqlite3_column_bytes([self.statement sqliteStatement], columnIndex);
+        if (buffer == NULL) {
+            return [NSData data];
+        }
+        return [NSData dataWithBytesNoCopy:(void *)buffer length:size freeWhenDone:NO];
+    });
+}
+
 - (id)objectForColumn:(NSString *)columnName {
     return [self objectForColumnIndex:[self columnIndexForName:columnName]];
 }
@@ -15,6 +15,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, strong, readonly) BFTask *databaseClosedTask;
 
+/**
+ Whether the connection acquires the multi-process file lock when opened and releases it when closed.
+ Defaults to `YES`. Long-lived pooled connections turn this off and are locked around each operation instead.
+ */
+@property (nonatomic, assign) BOOL locksFileWhileOpen;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The version of the format that is written by `PFBinaryJSONSerialization`.
+ */
+extern const uint8_t PFBinaryJSONSerializationVersion;
+
+/**
+ Compact binary representation of JSON objects.
+
+ The data starts with a header that can never begin a JSON document, followed by the format version,
+ so it can be stored alongside JSON and told apart from it with `isBinaryJSONData:`.
+ Strings that occur more than once, like dictionary keys, are only stored once.
+ */
+@interface PFBinaryJSONSerialization : NSObject
+
+/**
+ The object passed in must be one of:
+ * NSString
+ * NSNumber
+ * NSDictionary
+ * NSArray
+ * NSNull
+
+ @return NSData with the binary representation of the passed in object.
+ */
++ (NSData *)dataFromJSONObject:(id)object;
+
+/**
+ Takes binary data produced by `dataFromJSONObject:` and returns the NSDictionaries and NSArrays in it.
+ You should still call decodeObject if you want Parse types.
+
+ @return Decoded object, or `nil` if the data is malformed or was written by a newer version of the format.
+ */
++ (nullable id)JSONObjectFromData:(NSData *)data;
+
+/**
+ @return `YES` if the data starts with the binary header, regardless of the format version.
+ */
++ (BOOL)isBinaryJSONData:(NSData *)data;
+
+@end
+
+NS_ASSUME_NONNULL_END
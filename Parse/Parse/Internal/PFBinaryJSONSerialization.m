@@ -0,0 +1,321 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import "PFBinaryJSONSerialization.h"
+
+#import "PFAssert.h"
+#import "PFLogging.h"
+
+const uint8_t PFBinaryJSONSerializationVersion = 1;
+
+// Starts with a zero byte, which can't start a JSON document in any of the encodings it can be stored in.
+static const uint8_t PFBinaryJSONSerializationMagic[] = { 0x00, 'P', 'F', 'J' };
+static const NSUInteger PFBinaryJSONSerializationHeaderLength = sizeof(PFBinaryJSONSerializationMagic) + 1;
+
+// Nesting depth after which the data is considered malformed, so that decoding never exhausts the stack.
+static const NSUInteger PFBinaryJSONSerializationMaximumDepth = 512;
+
+typedef NS_ENUM(uint8_t, PFBinaryJSONTag) {
+    PFBinaryJSONTagNull = 0,
+    PFBinaryJSONTagFalse = 1,
+    PFBinaryJSONTagTrue = 2,
+    PFBinaryJSONTagInteger = 3, // Zigzag-encoded varint.
+    PFBinaryJSONTagDouble = 4, // 8 bytes, little endian.
+    PFBinaryJSONTagString = 5, // Varint length, followed by UTF-8 bytes.
+    PFBinaryJSONTagStringReference = 6, // Varint index of a string that was written before.
+    PFBinaryJSONTagArray = 7, // Varint count, followed by the elements.
+    PFBinaryJSONTagDictionary = 8, // Varint count, followed by string keys, each followed by its value.
+};
+
+///--------------------------------------
+#pragma mark - Writer
+///--------------------------------------
+
+@interface PFBinaryJSONWriter : NSObject
+
+@property (nonatomic, strong, readonly) NSMutableData *data;
+
+- (void)writeObject:(id)object;
+
+@end
+
+@implementation PFBinaryJSONWriter {
+    NSMutableDictionary<NSString *, NSNumber *> *_stringIndexes;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) return nil;
+
+    _data = [NSMutableData dataWithBytes:PFBinaryJSONSerializationMagic length:sizeof(PFBinaryJSONSerializationMagic)];
+    [_data appendBytes:&PFBinaryJSONSerializationVersion length:sizeof(PFBinaryJSONSerializationVersion)];
+    _stringIndexes = [NSMutableDictionary dictionary];
+
+    return self;
+}
+
+- (void)writeObject:(id)object {
+    if ([object isKindOfClass:[NSString class]]) {
+        [self _writeString:object];
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        [self _writeNumber:object];
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dictionary = object;
+        [self _writeTag:PFBinaryJSONTagDictionary];
+        [self _writeVarint:dictionary.count];
+        [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+            PFParameterAssert([key isKindOfClass:[NSString class]], @"PFObject values must be serializable to JSON");
+            [self _writeString:key];
+            [self writeObject:value];
+        }];
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        NSArray *array = object;
+        [self _writeTag:PFBinaryJSONTagArray];
+        [self _writeVarint:array.count];
+        for (id value in array) {
+            [self writeObject:value];
+        }
+    } else if (object == [NSNull null]) {
+        [self _writeTag:PFBinaryJSONTagNull];
+    } else {
+        PFParameterAssertionFailure(@"PFObject values must be serializable to JSON");
+    }
+}
+
+- (void)_writeTag:(PFBinaryJSONTag)tag {
+    [_data appendBytes:&tag length:sizeof(tag)];
+}
+
+- (void)_writeVarint:(uint64_t)value {
+    uint8_t buffer[10];
+    size_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    [_data appendBytes:buffer length:length];
+}
+
+- (void)_writeString:(NSString *)string {
+    NSNumber *index = _stringIndexes[string];
+    if (index) {
+        [self _writeTag:PFBinaryJSONTagStringReference];
+        [self _writeVarint:index.unsignedLongLongValue];
+        return;
+    }
+    _stringIndexes[string] = @(_stringIndexes.count);
+
+    NSUInteger length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    PFParameterAssert(length > 0 || string.length == 0, @"PFObject values must be serializable to JSON");
+    [self _writeTag:PFBinaryJSONTagString];
+    [self _writeVarint:length];
+
+    NSUInteger offset = _data.length;
+    _data.length = offset + length;
+    [string getBytes:(uint8_t *)_data.mutableBytes + offset
+           maxLength:length
+          usedLength:NULL
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, string.length)
+      remainingRange:NULL];
+}
+
+- (void)_writeNumber:(NSNumber *)number {
+    if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+        [self _writeTag:(number.boolValue ? PFBinaryJSONTagTrue : PFBinaryJSONTagFalse)];
+        return;
+    }
+
+    char type = number.objCType[0];
+    BOOL isFloatingPoint = (type == 'f' || type == 'd');
+    // Unsigned values that don't fit into a signed integer lose precision the same way they would in JSON.
+    if (isFloatingPoint || (type == 'Q' && number.unsignedLongLongValue > INT64_MAX)) {
+        double value = number.doubleValue;
+        PFParameterAssert(isfinite(value), @"PFObject values must be serializable to JSON");
+
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        bits = CFSwapInt64HostToLittle(bits);
+        [self _writeTag:PFBinaryJSONTagDouble];
+        [_data appendBytes:&bits length:sizeof(bits)];
+        return;
+    }
+
+    int64_t value = number.longLongValue;
+    [self _writeTag:PFBinaryJSONTagInteger];
+    [self _writeVarint:(((uint64_t)value << 1) ^ (uint64_t)(value >> 63))];
+}
+
+@end
+
+///--------------------------------------
+#pragma mark - Reader
+///--------------------------------------
+
+typedef struct {
+    const uint8_t *bytes;
+    const uint8_t *end;
+} PFBinaryJSONReader;
+
+static BOOL PFBinaryJSONReadVarint(PFBinaryJSONReader *reader, uint64_t *value) {
+    uint64_t result = 0;
+    for (unsigned int shift = 0; shift < 64 && reader->bytes < reader->end; shift += 7) {
+        uint8_t byte = *reader->bytes++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static NSString *PFBinaryJSONReadString(PFBinaryJSONReader *reader, uint8_t tag, NSMutableArray<NSString *> *strings) {
+    uint64_t value = 0;
+    if (!PFBinaryJSONReadVarint(reader, &value)) {
+        return nil;
+    }
+    if (tag == PFBinaryJSONTagStringReference) {
+        return (value < strings.count ? strings[(NSUInteger)value] : nil);
+    }
+    if (tag != PFBinaryJSONTagString || value > (uint64_t)(reader->end - reader->bytes)) {
+        return nil;
+    }
+
+    NSString *string = [[NSString alloc] initWithBytes:reader->bytes length:(NSUInteger)value encoding:NSUTF8StringEncoding];
+    reader->bytes += value;
+    if (string) {
+        [strings addObject:string];
+    }
+    return string;
+}
+
+static id PFBinaryJSONReadObject(PFBinaryJSONReader *reader, NSMutableArray<NSString *> *strings, NSUInteger depth) {
+    if (depth > PFBinaryJSONSerializationMaximumDepth || reader->bytes >= reader->end) {
+        return nil;
+    }
+
+    uint8_t tag = *reader->bytes++;
+    switch (tag) {
+        case PFBinaryJSONTagNull:
+            return [NSNull null];
+        case PFBinaryJSONTagFalse:
+            return @NO;
+        case PFBinaryJSONTagTrue:
+            return @YES;
+        case PFBinaryJSONTagInteger: {
+            uint64_t value = 0;
+            if (!PFBinaryJSONReadVarint(reader, &value)) {
+                return nil;
+            }
+            return @((int64_t)(value >> 1) ^ -(int64_t)(value & 1));
+        }
+        case PFBinaryJSONTagDouble: {
+            uint64_t bits = 0;
+            if (reader->end - reader->bytes < (ptrdiff_t)sizeof(bits)) {
+                return nil;
+            }
+            memcpy(&bits, reader->bytes, sizeof(bits));
+            reader->bytes += sizeof(bits);
+            bits = CFSwapInt64LittleToHost(bits);
+
+            double value = 0.0;
+            memcpy(&value, &bits, sizeof(value));
+            return @(value);
+        }
+        case PFBinaryJSONTagString:
+        case PFBinaryJSONTagStringReference:
+            return PFBinaryJSONReadString(reader, tag, strings);
+        case PFBinaryJSONTagArray: {
+            uint64_t count = 0;
+            // Every element takes at least one byte, which bounds the capacity for malformed data.
+            if (!PFBinaryJSONReadVarint(reader, &count) || count > (uint64_t)(reader->end - reader->bytes)) {
+                return nil;
+            }
+            NSMutableArray *array = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+            for (uint64_t i = 0; i < count; i++) {
+                id value = PFBinaryJSONReadObject(reader, strings, depth + 1);
+                if (!value) {
+                    return nil;
+                }
+                [array addObject:value];
+            }
+            return array;
+        }
+        case PFBinaryJSONTagDictionary: {
+            uint64_t count = 0;
+            if (!PFBinaryJSONReadVarint(reader, &count) || count > (uint64_t)(reader->end - reader->bytes)) {
+                return nil;
+            }
+            NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+            for (uint64_t i = 0; i < count; i++) {
+                if (reader->bytes >= reader->end) {
+                    return nil;
+                }
+                uint8_t keyTag = *reader->bytes++;
+                NSString *key = PFBinaryJSONReadString(reader, keyTag, strings);
+                id value = (key ? PFBinaryJSONReadObject(reader, strings, depth + 1) : nil);
+                if (!value) {
+                    return nil;
+                }
+                dictionary[key] = value;
+            }
+            return dictionary;
+        }
+        default:
+            return nil;
+    }
+}
+
+///--------------------------------------
+#pragma mark - PFBinaryJSONSerialization
+///--------------------------------------
+
+@implementation PFBinaryJSONSerialization
+
++ (NSData *)dataFromJSONObject:(id)object {
+    PFBinaryJSONWriter *writer = [[PFBinaryJSONWriter alloc] init];
+    [writer writeObject:object];
+    return writer.data;
+}
+
++ (id)JSONObjectFromData:(NSData *)data {
+    if (![self isBinaryJSONData:data]) {
+        PFLogError(PFLoggingTagCommon, @"Binary JSON deserialization failed: missing header.");
+        return nil;
+    }
+
+    const uint8_t *bytes = data.bytes;
+    uint8_t version = bytes[sizeof(PFBinaryJSONSerializationMagic)];
+    if (version != PFBinaryJSONSerializationVersion) {
+        PFLogError(PFLoggingTagCommon, @"Binary JSON deserialization failed: unsupported version %d.", version);
+        return nil;
+    }
+
+    PFBinaryJSONReader reader = {
+        .bytes = bytes + PFBinaryJSONSerializationHeaderLength,
+        .end = bytes + data.length
+    };
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    id object = PFBinaryJSONReadObject(&reader, strings, 0);
+    if (!object || reader.bytes != reader.end) {
+        PFLogError(PFLoggingTagCommon, @"Binary JSON deserialization failed: malformed data.");
+        return nil;
+    }
+    return object;
+}
+
++ (BOOL)isBinaryJSONData:(NSData *)data {
+    return (data.length >= PFBinaryJSONSerializationHeaderLength &&
+            memcmp(data.bytes, PFBinaryJSONSerializationMagic, sizeof(PFBinaryJSONSerializationMagic)) == 0);
+}
+
+@end
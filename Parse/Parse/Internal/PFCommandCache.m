@@ -27,6 +27,7 @@
 #import "PFErrorUtilities.h"
 #import "PFEventuallyQueue_Private.h"
 #import "PFFileManager.h"
+#import "PFKeyValueCacheLog.h"
 #import "PFLogging.h"
 #import "PFMacros.h"
 #import "PFMultiProcessFileLockController.h"
@@ -43,6 +44,11 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
 
 @interface PFCommandCache () <PFEventuallyQueueSubclass> {
     unsigned int _fileCounter;
+
+    // Commands are kept in a journal, in the order they were enqueued.
+    dispatch_queue_t _journalQueue;
+    PFKeyValueCacheLog *_journal;
+    BOOL _journalCompactionScheduled;
 }
 
 @property (nonatomic, assign, readwrite, setter=_setDiskCacheSize:) unsigned long long diskCacheSize;
@@ -85,6 +91,7 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
     _diskCachePath = diskCachePath;
     _diskCacheSize = diskCacheSize;
     _fileCounter = 0;
+    _journalQueue = dispatch_queue_create("com.parse.commandCache.journal", DISPATCH_QUEUE_SERIAL);
 
     [self _createDiskCachePathIfNeeded];
 
@@ -100,15 +107,9 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
 
     [super removeAllCommands];
 
-    NSArray *commandIdentifiers = [self _pendingCommandIdentifiers];
-    NSMutableArray *tasks = [NSMutableArray arrayWithCapacity:commandIdentifiers.count];
-
-    for (NSString *identifier in commandIdentifiers) {
-        BFTask *task = [self _removeFileForCommandWithIdentifier:identifier];
-        [tasks addObject:task];
-    }
-
-    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+    [self _accessJournalWithBlock:^(PFKeyValueCacheLog *journal) {
+        [journal removeAllValues];
+    }];
 
     [self resume];
 }
@@ -120,6 +121,12 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
 - (void)_simulateReboot {
     [super _simulateReboot];
     [self _createDiskCachePathIfNeeded];
+
+    // Read the journal from disk again, like a new process would.
+    dispatch_sync(_journalQueue, ^{
+        [self->_journal close];
+        self->_journal = nil;
+    });
 }
 
 ///--------------------------------------
@@ -136,29 +143,23 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
 }
 
 - (NSArray *)_pendingCommandIdentifiers {
-    NSArray *result = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.diskCachePath error:nil];
-    // Only accept files that starts with "Command" since sometimes the directory is filled with garbage
-    // e.g.: https://phab.parse.com/file/info/PHID-FILE-qgbwk7sm7kcyaks6n4j7/
-    result = [result filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF BEGINSWITH %@", PFCommandCachePrefixString]];
-
-    return [result sortedArrayUsingSelector:@selector(compare:)];
+    __block NSArray *identifiers = nil;
+    [self _accessJournalWithBlock:^(PFKeyValueCacheLog *journal) {
+        identifiers = journal.keys;
+    }];
+    return identifiers ?: @[];
 }
 
 - (id<PFNetworkCommand>)_commandWithIdentifier:(NSString *)identifier error:(NSError **)error {
-    [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.diskCachePath];
+    __block NSData *jsonData = nil;
+    [self _accessJournalWithBlock:^(PFKeyValueCacheLog *journal) {
+        jsonData = [journal peekDataForKey:identifier];
+    }];
 
     NSError *innerError = nil;
-    NSData *jsonData = [NSData dataWithContentsOfFile:[self _filePathForCommandWithIdentifier:identifier]
-                                              options:NSDataReadingUncached
-                                                error:&innerError];
-
-    [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.diskCachePath];
-
-    if (innerError || !jsonData) {
-        NSString *message = [NSString stringWithFormat:@"Failed to read command from cache. %@",
-                             innerError ? innerError.localizedDescription : @""];
+    if (!jsonData) {
         innerError = [PFErrorUtilities errorWithCode:kPFErrorInternalServer
-                                             message:message];
+                                             message:@"Failed to read command from cache."];
         if (error) {
             *error = innerError;
         }
@@ -219,7 +220,7 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
         }
     }
 
-    [[self _removeFileForCommandWithIdentifier:identifier] waitUntilFinished];
+    [self _removeCommandWithIdentifier:identifier];
     return [super _didFinishRunningCommand:command withIdentifier:identifier resultTask:resultTask];
 }
 
@@ -232,59 +233,12 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
 #pragma mark - Disk Cache
 ///--------------------------------------
 
-- (BFTask *)_cleanupDiskCacheWithRequiredFreeSize:(NSUInteger)requiredSize {
-    return [BFTask taskFromExecutor:[BFExecutor defaultExecutor] withBlock:^id{
-        NSUInteger size = requiredSize;
-
-        NSMutableDictionary<NSString *, NSNumber *> *commandSizes = [NSMutableDictionary dictionary];
-
-        [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.diskCachePath];
-
-        NSDictionary *directoryAttributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.diskCachePath error:nil];
-        if ([directoryAttributes[NSFileSize] unsignedLongLongValue] > self.diskCacheSize) {
-            NSDirectoryEnumerator<NSURL *> *enumerator = [[NSFileManager defaultManager] enumeratorAtURL:[NSURL fileURLWithPath:self.diskCachePath]
-                                                                              includingPropertiesForKeys:@[ NSURLFileSizeKey ]
-                                                                                                 options:NSDirectoryEnumerationSkipsSubdirectoryDescendants
-                                                                                            errorHandler:nil];
-            NSURL *fileURL = nil;
-            while ((fileURL = [enumerator nextObject])) {
-                NSNumber *fileSize = nil;
-                if (![fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:nil]) {
-                    continue;
-                }
-                if (fileSize) {
-                    commandSizes[fileURL.path.lastPathComponent] = fileSize;
-                    size += fileSize.unsignedIntegerValue;
-                }
-            }
-        }
-
-        [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.diskCachePath];
-
-        if (size > self.diskCacheSize) {
-            // Get identifiers and sort them to remove oldest commands first
-            NSArray<NSString *> *identifiers = [commandSizes.allKeys sortedArrayUsingSelector:@selector(compare:)];
-            for (NSString *identifier in identifiers) @autoreleasepool {
-                [self _removeFileForCommandWithIdentifier:identifier];
-                size -= [commandSizes[identifier] unsignedIntegerValue];
-
-                if (size <= self.diskCacheSize) {
-                    break;
-                }
-                [commandSizes removeObjectForKey:identifier];
-            }
-        }
-
-        return nil;
-    }];
-}
-
 - (void)_setDiskCacheSize:(unsigned long long)diskCacheSize {
     _diskCacheSize = diskCacheSize;
 }
 
 ///--------------------------------------
-#pragma mark - Files
+#pragma mark - Journal
 ///--------------------------------------
 
 - (BFTask *)_saveCommandToCacheInBackground:(id<PFNetworkCommand>)command
@@ -317,30 +271,79 @@ static unsigned long long const PFCommandCacheDefaultDiskCacheSize = 10 * 1024 *
             return [BFTask taskWithError:error];
         }
 
-        [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.diskCachePath];
-        return [[[self _cleanupDiskCacheWithRequiredFreeSize:commandSize] continueWithBlock:^id(BFTask *task) {
-            NSString *filePath = [self _filePathForCommandWithIdentifier:identifier];
-            return [PFFileManager writeDataAsync:data toFile:filePath];
-        }] continueWithBlock:^id(BFTask *task) {
-            [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.diskCachePath];
-            return task;
+        __block BOOL saved = NO;
+        [self _accessJournalWithBlock:^(PFKeyValueCacheLog *journal) {
+            // Make room by dropping the oldest commands first.
+            [journal trimToCount:NSUIntegerMax size:(NSUInteger)(self.diskCacheSize - commandSize)];
+            saved = [journal setData:data forKey:identifier creationDate:[NSDate date]];
         }];
+        if (!saved) {
+            error = [PFErrorUtilities errorWithCode:kPFErrorInternalServer
+                                            message:@"Failed to save command to cache."];
+            return [BFTask taskWithError:error];
+        }
+        return nil;
     }];
 }
 
-- (BFTask *)_removeFileForCommandWithIdentifier:(NSString *)identifier {
-    NSString *filePath = [self _filePathForCommandWithIdentifier:identifier];
-    return [[BFTask taskFromExecutor:[BFExecutor defaultPriorityBackgroundExecutor] withBlock:^id{
+- (void)_removeCommandWithIdentifier:(NSString *)identifier {
+    __block BOOL shouldCompact = NO;
+    [self _accessJournalWithBlock:^(PFKeyValueCacheLog *journal) {
+        // Only appends a tombstone, the space is reclaimed by compaction later on.
+        [journal removeStringForKey:identifier];
+        shouldCompact = !self->_journalCompactionScheduled;
+        self->_journalCompactionScheduled = YES;
+    }];
+    if (!shouldCompact) {
+        return;
+    }
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        [self _accessJournalWithBlock:^(PFKeyValueCacheLog *journal) {
+            self->_journalCompactionScheduled = NO;
+            [journal compactIfNeeded];
+        }];
+    });
+}
+
+/**
+ Runs the block with the journal on the journal queue, while holding the file lock that other processes
+ use for this cache, after picking up the changes they made to it.
+ */
+- (void)_accessJournalWithBlock:(void (^)(PFKeyValueCacheLog *journal))block {
+    dispatch_sync(_journalQueue, ^{
         [[PFMultiProcessFileLockController sharedController] beginLockedContentAccessForFileAtPath:self.diskCachePath];
-        return [PFFileManager removeItemAtPathAsync:filePath withFileLock:NO];
-    }] continueWithBlock:^id(BFTask *task) {
+
+        if (!self->_journal) {
+            self->_journal = [PFKeyValueCacheLog logWithDirectoryURL:[NSURL fileURLWithPath:self.diskCachePath]];
+            self->_journal.automaticallyCompacts = NO;
+            [self _importCommandFilesIntoJournal:self->_journal];
+        } else {
+            [self->_journal synchronize];
+        }
+        block(self->_journal);
+
         [[PFMultiProcessFileLockController sharedController] endLockedContentAccessForFileAtPath:self.diskCachePath];
-        return task; // Roll-forward the previous task.
-    }];
+    });
 }
 
-- (NSString *)_filePathForCommandWithIdentifier:(NSString *)identifier {
-    return [self.diskCachePath stringByAppendingPathComponent:identifier];
+/**
+ Moves commands that were saved one per file by previous versions into the journal, oldest first.
+ */
+- (void)_importCommandFilesIntoJournal:(PFKeyValueCacheLog *)journal {
+    NSArray<NSString *> *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.diskCachePath error:nil];
+    // Only accept files that starts with "Command" since sometimes the directory is filled with garbage
+    // e.g.: https://phab.parse.com/file/info/PHID-FILE-qgbwk7sm7kcyaks6n4j7/
+    fileNames = [fileNames filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF BEGINSWITH %@", PFCommandCachePrefixString]];
+    for (NSString *identifier in [fileNames sortedArrayUsingSelector:@selector(compare:)]) @autoreleasepool {
+        NSString *filePath = [self.diskCachePath stringByAppendingPathComponent:identifier];
+        NSData *data = [NSData dataWithContentsOfFile:filePath options:NSDataReadingUncached error:nil];
+        if (data.length > 0 && ![journal setData:data forKey:identifier creationDate:[NSDate date]]) {
+            // Keep the file, so that the next launch tries again.
+            continue;
+        }
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    }
 }
 
 - (void)_createDiskCachePathIfNeeded {
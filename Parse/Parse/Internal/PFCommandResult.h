@@ -14,6 +14,10 @@ NS_ASSUME_NONNULL_BEGIN
 @interface PFCommandResult : NSObject
 
 @property (nonatomic, strong, readonly) id result;
+
+/**
+ The response body, decoded on first access if the result was created from the raw data.
+ */
 @property (nullable, nonatomic, copy, readonly) NSString *resultString;
 @property (nullable, nonatomic, strong, readonly) NSHTTPURLResponse *httpResponse;
 
@@ -31,6 +35,13 @@ NS_ASSUME_NONNULL_BEGIN
                            resultString:(nullable NSString *)resultString
                            httpResponse:(nullable NSHTTPURLResponse *)response;
 
+- (instancetype)initWithResult:(NSDictionary *)result
+                    resultData:(nullable NSData *)resultData
+                  httpResponse:(nullable NSHTTPURLResponse *)response;
++ (instancetype)commandResultWithResult:(NSDictionary *)result
+                             resultData:(nullable NSData *)resultData
+                           httpResponse:(nullable NSHTTPURLResponse *)response;
+
 @end
 
 NS_ASSUME_NONNULL_END
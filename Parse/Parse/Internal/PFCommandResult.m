@@ -11,8 +11,16 @@
 
 #import "PFAssert.h"
 
+@interface PFCommandResult () {
+    NSData *_resultData;
+}
+
+@end
+
 @implementation PFCommandResult
 
+@synthesize resultString = _resultString;
+
 ///--------------------------------------
 #pragma mark - Init
 ///--------------------------------------
@@ -36,4 +44,35 @@
     return [[self alloc] initWithResult:result resultString:resultString httpResponse:response];
 }
 
+- (instancetype)initWithResult:(NSDictionary *)result
+                    resultData:(NSData *)resultData
+                  httpResponse:(NSHTTPURLResponse *)response {
+    self = [self initWithResult:result resultString:nil httpResponse:response];
+    if (!self) return nil;
+
+    _resultData = resultData;
+
+    return self;
+}
+
++ (instancetype)commandResultWithResult:(NSDictionary *)result
+                             resultData:(NSData *)resultData
+                           httpResponse:(NSHTTPURLResponse *)response {
+    return [[self alloc] initWithResult:result resultData:resultData httpResponse:response];
+}
+
+///--------------------------------------
+#pragma mark - Accessors
+///--------------------------------------
+
+- (NSString *)resultString {
+    @synchronized(self) {
+        if (!_resultString && _resultData) {
+            _resultString = [[NSString alloc] initWithData:_resultData encoding:NSUTF8StringEncoding];
+            _resultData = nil;
+        }
+        return _resultString;
+    }
+}
+
 @end
@@ -44,6 +44,8 @@ NS_ASSUME_NONNULL_BEGIN
  YYYY-MM-DDTHH:MM:SS'Z'
  YYYY-MM-DDTHH:MM:SS.SSS'Z'
 
+ Formats with seconds, like the ones Parse Server emits, are parsed without taking any locks.
+
  @param string `NSString` representation to convert.
 
  @return `NSDate` incapsulating the date.
@@ -12,6 +12,146 @@
 #import <sqlite3.h>
 #import <sys/time.h>
 
+// Julian day of the Unix epoch in milliseconds, and the end of year 9999, which is as far as SQLite goes.
+static const double PFDateFormatterUnixEpochJulianDayMilliseconds = 210866760000000.0;
+static const double PFDateFormatterMaximumJulianDayMilliseconds = 464269060800000.0;
+
+// Length of `YYYY-MM-DDTHH:MM:SSZ` and `YYYY-MM-DDTHH:MM:SS.SSSZ`.
+enum {
+    PFDateFormatterSecondsStringLength = 20,
+    PFDateFormatterMillisecondsStringLength = 24,
+};
+
+///--------------------------------------
+#pragma mark - ISO 8601
+///--------------------------------------
+
+/**
+ Days since 1970-01-01 for a date in the proleptic Gregorian calendar.
+ */
+static int64_t PFDateFormatterDaysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= (month <= 2);
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ Inverse of `PFDateFormatterDaysFromCivil`.
+ */
+static void PFDateFormatterCivilFromDays(int64_t days, int *year, int *month, int *day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    *day = (int)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    *month = (int)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    *year = (int)(yearOfEra + era * 400 + (*month <= 2));
+}
+
+static int PFDateFormatterDaysInMonth(int year, int month) {
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    BOOL isLeapYear = ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0);
+    return (month == 2 && isLeapYear ? 29 : days[month - 1]);
+}
+
+static BOOL PFDateFormatterParseDigits(const char *string, int count, int *value) {
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        char c = string[i];
+        if (c < '0' || c > '9') {
+            return NO;
+        }
+        result = result * 10 + (c - '0');
+    }
+    *value = result;
+    return YES;
+}
+
+static void PFDateFormatterWriteDigits(char *buffer, int count, int value) {
+    for (int i = count - 1; i >= 0; i--) {
+        buffer[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+/**
+ Parses `YYYY-MM-DDTHH:MM:SS.SSSZ` and `YYYY-MM-DDTHH:MM:SSZ`, with either `T` or a space as the separator.
+ Produces exactly the same value as the SQLite route, and returns `NO` for anything it doesn't handle,
+ including out-of-range components that SQLite normalizes.
+ */
+static BOOL PFDateFormatterParseISO8601(const char *string, NSUInteger length, NSTimeInterval *interval) {
+    if (length != PFDateFormatterSecondsStringLength && length != PFDateFormatterMillisecondsStringLength) {
+        return NO;
+    }
+    if (string[4] != '-' || string[7] != '-' || (string[10] != 'T' && string[10] != ' ') ||
+        string[13] != ':' || string[16] != ':' || string[length - 1] != 'Z') {
+        return NO;
+    }
+
+    int year, month, day, hour, minute, second, millisecond = 0;
+    if (!PFDateFormatterParseDigits(string, 4, &year) ||
+        !PFDateFormatterParseDigits(string + 5, 2, &month) ||
+        !PFDateFormatterParseDigits(string + 8, 2, &day) ||
+        !PFDateFormatterParseDigits(string + 11, 2, &hour) ||
+        !PFDateFormatterParseDigits(string + 14, 2, &minute) ||
+        !PFDateFormatterParseDigits(string + 17, 2, &second)) {
+        return NO;
+    }
+    if (length == PFDateFormatterMillisecondsStringLength &&
+        (string[19] != '.' || !PFDateFormatterParseDigits(string + 20, 3, &millisecond))) {
+        return NO;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > PFDateFormatterDaysInMonth(year, month) ||
+        hour > 23 || minute > 59 || second > 59) {
+        return NO;
+    }
+
+    int64_t seconds = PFDateFormatterDaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    // SQLite yields the fraction by parsing `SS.SSS` as a double, which this division reproduces exactly.
+    double secondsInMinute = (second * 1000 + millisecond) / 1000.0;
+    double integral = 0.0;
+    *interval = (double)seconds + modf(secondsInMinute, &integral);
+    return YES;
+}
+
+/**
+ Formats as `YYYY-MM-DDTHH:MM:SS.SSSZ` into a buffer of `PFDateFormatterMillisecondsStringLength` bytes,
+ rounding to the nearest millisecond like the SQLite route. Returns `NO` if the date is out of the range that SQLite supports.
+ */
+static BOOL PFDateFormatterFormatISO8601(NSTimeInterval interval, char *buffer) {
+    double julianDayMilliseconds = interval * 1000.0 + PFDateFormatterUnixEpochJulianDayMilliseconds;
+    if (!(julianDayMilliseconds >= 0.0 && julianDayMilliseconds < PFDateFormatterMaximumJulianDayMilliseconds)) {
+        return NO;
+    }
+    int64_t milliseconds = (int64_t)(julianDayMilliseconds + 0.5) - (int64_t)PFDateFormatterUnixEpochJulianDayMilliseconds;
+
+    int64_t days = milliseconds / 86400000;
+    int64_t millisecondsInDay = milliseconds % 86400000;
+    if (millisecondsInDay < 0) {
+        days -= 1;
+        millisecondsInDay += 86400000;
+    }
+
+    int year, month, day;
+    PFDateFormatterCivilFromDays(days, &year, &month, &day);
+    int value = (int)millisecondsInDay;
+
+    memcpy(buffer, "0000-00-00T00:00:00.000Z", PFDateFormatterMillisecondsStringLength);
+    PFDateFormatterWriteDigits(buffer, 4, year);
+    PFDateFormatterWriteDigits(buffer + 5, 2, month);
+    PFDateFormatterWriteDigits(buffer + 8, 2, day);
+    PFDateFormatterWriteDigits(buffer + 11, 2, value / 3600000);
+    PFDateFormatterWriteDigits(buffer + 14, 2, value / 60000 % 60);
+    PFDateFormatterWriteDigits(buffer + 17, 2, value / 1000 % 60);
+    PFDateFormatterWriteDigits(buffer + 20, 3, value % 1000);
+    return YES;
+}
+
 @interface PFDateFormatter () {
     dispatch_queue_t _synchronizationQueue;
 
@@ -70,8 +210,18 @@
 ///--------------------------------------
 
 - (NSString *)preciseStringFromDate:(NSDate *)date {
-    __block NSString *string = @"";
     NSTimeInterval interval = date.timeIntervalSince1970;
+    char buffer[PFDateFormatterMillisecondsStringLength];
+    if (PFDateFormatterFormatISO8601(interval, buffer)) {
+        return [[NSString alloc] initWithBytes:buffer
+                                        length:PFDateFormatterMillisecondsStringLength
+                                      encoding:NSASCIIStringEncoding];
+    }
+    return [self _sqlitePreciseStringFromInterval:interval];
+}
+
+- (NSString *)_sqlitePreciseStringFromInterval:(NSTimeInterval)interval {
+    __block NSString *string = @"";
     dispatch_sync(_synchronizationQueue, ^{
         sqlite3_bind_double(self->_dateToStringStatement, 1, interval);
 
@@ -90,6 +240,18 @@
 ///--------------------------------------
 
 - (NSDate *)dateFromString:(NSString *)string {
+    // Anything that doesn't fit the buffer isn't one of the shapes that are parsed without SQLite.
+    char buffer[PFDateFormatterMillisecondsStringLength + 1];
+    NSTimeInterval interval = 0.0;
+    if (string.length <= PFDateFormatterMillisecondsStringLength &&
+        [string getCString:buffer maxLength:sizeof(buffer) encoding:NSASCIIStringEncoding] &&
+        PFDateFormatterParseISO8601(buffer, strlen(buffer), &interval)) {
+        return [NSDate dateWithTimeIntervalSince1970:interval];
+    }
+    return [self _sqliteDateFromString:string];
+}
+
+- (NSDate *)_sqliteDateFromString:(NSString *)string {
     __block sqlite3_int64 interval = 0;
     __block double seconds = 0.0;
     dispatch_sync(_synchronizationQueue, ^{
@@ -21,16 +21,34 @@
 
 extern NSUInteger const PFEventuallyQueueDefaultMaxAttemptsCount;
 extern NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval;
+extern NSUInteger const PFEventuallyQueueDefaultMaxConcurrentCommandsCount;
 
 @interface PFEventuallyQueue : NSObject
 
 @property (nonatomic, weak, readonly) id<PFCommandRunnerProvider> dataSource;
 
 @property (nonatomic, assign, readonly) NSUInteger maxAttemptsCount;
+
+/**
+ The longest time a command waits before it's tried again after failing with a temporary error.
+ The wait starts shorter and doubles with every failed attempt, and is cut short when the connection comes back.
+ */
 @property (nonatomic, assign, readonly) NSTimeInterval retryInterval;
 
+/**
+ The maximum number of commands that are run at the same time.
+ Commands that touch the same object are always run one after another, in the order they were enqueued.
+ Default: `PFEventuallyQueueDefaultMaxConcurrentCommandsCount`.
+ */
+@property (nonatomic, assign, readonly) NSUInteger maxConcurrentCommandsCount;
+
 @property (nonatomic, assign, readonly) NSUInteger commandCount;
 
+/**
+ When the earliest command that failed with a temporary error is tried again, or `nil` if no command is waiting.
+ */
+@property (nonatomic, strong, readonly) NSDate *nextRetryDate;
+
 /**
  Controls whether the queue should monitor network reachability and pause itself when there is no connection.
  Default: `YES`.
@@ -22,11 +22,17 @@
 #import "PFAssert.h"
 #import "PFCommandResult.h"
 #import "PFCommandRunning.h"
+#import "PFCoreManager.h"
 #import "PFErrorUtilities.h"
+#import "PFHTTPRequest.h"
 #import "PFLogging.h"
 #import "PFMacros.h"
+#import "PFObjectLocalIdStore.h"
+#import "PFObjectUtilities.h"
 #import "PFRESTCommand.h"
+#import "PFRESTObjectBatchCommand.h"
 #import "PFTaskQueue.h"
+#import "Parse_Private.h"
 
 #if !TARGET_OS_WATCH
 #import "PFReachability.h"
@@ -34,6 +40,112 @@
 
 NSUInteger const PFEventuallyQueueDefaultMaxAttemptsCount = 5;
 NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
+NSUInteger const PFEventuallyQueueDefaultMaxConcurrentCommandsCount = 4;
+
+static NSTimeInterval const PFEventuallyQueueInitialRetryInterval = 5.0;
+
+/**
+ A pending command, along with the commands that were coalesced into it.
+ */
+@interface PFEventuallyQueueEntry : NSObject
+
+@property (nonatomic, copy) NSArray<NSString *> *identifiers;
+@property (nonatomic, copy) NSArray<id<PFNetworkCommand>> *commands;
+
+@property (nonatomic, strong) id<PFNetworkCommand> command;
+
+/**
+ Keys of the objects that the command touches, or `nil` if they are unknown and the command has to run alone.
+ */
+@property (nonatomic, copy) NSSet<NSString *> *dependencyKeys;
+
+/**
+ Entries whose commands are sent together in `command`, if it's a batch command.
+ */
+@property (nonatomic, copy) NSArray<PFEventuallyQueueEntry *> *batchedEntries;
+
+@property (nonatomic, assign, getter=isLoaded) BOOL loaded;
+@property (nonatomic, strong) BFTask *resultTask;
+
+@end
+
+@implementation PFEventuallyQueueEntry
+
+- (instancetype)initWithIdentifier:(NSString *)identifier {
+    self = [super init];
+    if (!self) return nil;
+
+    _identifiers = @[ identifier ];
+    _commands = @[];
+
+    return self;
+}
+
+- (instancetype)initWithBatchCommand:(PFRESTCommand *)command
+                      batchedEntries:(NSArray<PFEventuallyQueueEntry *> *)entries
+                      dependencyKeys:(NSSet<NSString *> *)dependencyKeys {
+    self = [super init];
+    if (!self) return nil;
+
+    _identifiers = @[ entries.firstObject.identifiers.firstObject ];
+    _commands = @[];
+    _command = command;
+    _batchedEntries = [entries copy];
+    _dependencyKeys = [dependencyKeys copy];
+    _loaded = YES;
+
+    return self;
+}
+
+@end
+
+/**
+ State of a single run over the pending commands. Only accessed on `_schedulingQueue`.
+ */
+@interface PFEventuallyQueueRun : NSObject
+
+@property (nonatomic, strong, readonly) NSMutableArray<PFEventuallyQueueEntry *> *pendingEntries;
+@property (nonatomic, strong, readonly) NSCountedSet *runningKeys;
+@property (nonatomic, assign) NSUInteger runningCount;
+@property (nonatomic, assign, getter=isRunningBarrier) BOOL runningBarrier;
+
+/**
+ Identifiers of commands that are waiting out a backoff after failing, and aren't started until a later run.
+ */
+@property (nonatomic, strong, readonly) NSMutableSet<NSString *> *deferredIdentifiers;
+
+@property (nonatomic, strong, readonly) BFTaskCompletionSource *finishedTaskCompletionSource;
+
+@end
+
+@implementation PFEventuallyQueueRun
+
+- (instancetype)initWithCommandIdentifiers:(NSArray<NSString *> *)identifiers
+                       deferredIdentifiers:(NSSet<NSString *> *)deferredIdentifiers {
+    self = [super init];
+    if (!self) return nil;
+
+    _pendingEntries = [NSMutableArray arrayWithCapacity:identifiers.count];
+    for (NSString *identifier in identifiers) {
+        [_pendingEntries addObject:[[PFEventuallyQueueEntry alloc] initWithIdentifier:identifier]];
+    }
+    _runningKeys = [NSCountedSet set];
+    _deferredIdentifiers = [deferredIdentifiers mutableCopy];
+    _finishedTaskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+
+    return self;
+}
+
+- (BOOL)isEntryDeferred:(PFEventuallyQueueEntry *)entry {
+    for (NSString *identifier in entry.identifiers) {
+        if ([_deferredIdentifiers containsObject:identifier]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+@end
 
 @interface PFEventuallyQueue ()
 #if !TARGET_OS_WATCH
@@ -60,6 +172,7 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     _dataSource = dataSource;
     _maxAttemptsCount = attemptsCount;
     _retryInterval = retryInterval;
+    _maxConcurrentCommandsCount = PFEventuallyQueueDefaultMaxConcurrentCommandsCount;
 
     // Set up all the queues
     NSString *queueBaseLabel = [NSString stringWithFormat:@"com.parse.%@", NSStringFromClass([self class])];
@@ -74,10 +187,24 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     PFMarkDispatchQueue(_processingQueue);
 
     _processingQueueSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_ADD, 0, 0, _processingQueue);
+
+    dispatch_source_t processingQueueSource = _processingQueueSource;
+    _retryTimerSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _processingQueue);
+    dispatch_source_set_timer(_retryTimerSource, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+    dispatch_source_set_event_handler(_retryTimerSource, ^{
+        dispatch_source_merge_data(processingQueueSource, 1);
+    });
+    dispatch_resume(_retryTimerSource);
+
+    _schedulingQueue = dispatch_queue_create([NSString stringWithFormat:@"%@.scheduling", queueBaseLabel].UTF8String,
+                                             DISPATCH_QUEUE_SERIAL);
+    PFMarkDispatchQueue(_schedulingQueue);
     
     _commandEnqueueTaskQueue = [[PFTaskQueue alloc] init];
 
     _taskCompletionSources = [NSMutableDictionary dictionary];
+    _failedAttemptsCounts = [NSMutableDictionary dictionary];
+    _retryDates = [NSMutableDictionary dictionary];
 
     [self _startMonitoringNetworkReachability];
 
@@ -140,10 +267,6 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
 
     _taskCompletionSources[identifier] = taskCompletionSource;
     dispatch_source_merge_data(_processingQueueSource, 1);
-
-    if (_retryingSemaphore) {
-        dispatch_semaphore_signal(_retryingSemaphore);
-    }
 }
 
 ///--------------------------------------
@@ -166,6 +289,14 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     return [self _pendingCommandIdentifiers].count;
 }
 
+- (NSDate *)nextRetryDate {
+    __block NSDate *date = nil;
+    dispatch_sync(_synchronizationQueue, ^{
+        date = [self _nextRetryDate];
+    });
+    return date;
+}
+
 ///--------------------------------------
 #pragma mark - Controlling Queue
 ///--------------------------------------
@@ -196,12 +327,15 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
 
 - (void)terminate {
     [self _stopMonitoringNetworkReachability];
+    dispatch_source_cancel(_retryTimerSource);
     dispatch_source_cancel(_processingQueueSource);
 }
 
 - (void)removeAllCommands {
     dispatch_sync(_synchronizationQueue, ^{
         [self->_taskCompletionSources removeAllObjects];
+        [self->_failedAttemptsCounts removeAllObjects];
+        [self->_retryDates removeAllObjects];
     });
 }
 
@@ -212,114 +346,218 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
 - (void)_runCommands {
     PFAssertIsOnDispatchQueue(_processingQueue);
 
-    [self _runCommandsWithRetriesCount:self.maxAttemptsCount];
-}
-
-- (void)_runCommandsWithRetriesCount:(NSUInteger)retriesCount {
-    PFAssertIsOnDispatchQueue(_processingQueue);
-
     if (!self.running || !self.connected) {
         return;
     }
 
+    __block NSMutableSet<NSString *> *deferredIdentifiers = [NSMutableSet set];
+    dispatch_sync(_synchronizationQueue, ^{
+        [self->_retryDates enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSDate *date, BOOL *stop) {
+            if (date.timeIntervalSinceNow > 0) {
+                [deferredIdentifiers addObject:identifier];
+            }
+        }];
+    });
+
     // Expect sorted result from _pendingCommandIdentifiers
-    NSArray *commandIdentifiers = [self _pendingCommandIdentifiers];
-    BOOL shouldRetry = NO;
-    for (NSString *identifier in commandIdentifiers) {
-        NSError *error = nil;
-        id<PFNetworkCommand> command = [self _commandWithIdentifier:identifier error:&error];
-        if (!command || error) {
-            if (!error) {
-                error = [PFErrorUtilities errorWithCode:kPFErrorInternalServer
-                                                message:@"Failed to dequeue an eventually command."
-                                              shouldLog:NO];
+    PFEventuallyQueueRun *run = [[PFEventuallyQueueRun alloc] initWithCommandIdentifiers:[self _pendingCommandIdentifiers]
+                                                                      deferredIdentifiers:deferredIdentifiers];
+    dispatch_async(_schedulingQueue, ^{
+        [self _startCommandsForRun:run];
+    });
+    [run.finishedTaskCompletionSource.task waitForResult:nil];
+
+    [self _scheduleRetryTimer];
+}
+
+/**
+ Starts as many pending commands of the run as the width allows.
+ A command is held back while an earlier command that touches any of the same objects is running or held back,
+ so commands for a single object always run in the order they were enqueued.
+ */
+- (void)_startCommandsForRun:(PFEventuallyQueueRun *)run {
+    PFAssertIsOnDispatchQueue(_schedulingQueue);
+
+    NSMutableSet<NSString *> *heldBackKeys = [NSMutableSet set];
+    NSUInteger index = 0;
+    while (!run.runningBarrier &&
+           run.runningCount < self.maxConcurrentCommandsCount &&
+           index < run.pendingEntries.count) {
+        PFEventuallyQueueEntry *entry = run.pendingEntries[index];
+        [self _loadEntry:entry];
+
+        NSSet<NSString *> *keys = entry.dependencyKeys;
+        if ([run isEntryDeferred:entry]) {
+            // Commands that touch the same objects wait along with it.
+            if (!keys) {
+                break;
             }
-            BFTask *task = [BFTask taskWithError:error];
-            [self _didFinishRunningCommand:command withIdentifier:identifier resultTask:task];
+            [heldBackKeys unionSet:keys];
+            index++;
             continue;
         }
+        if (!keys) {
+            // Nothing is known about what this command touches, so it runs alone.
+            if (index == 0 && run.runningCount == 0) {
+                [run.pendingEntries removeObjectAtIndex:index];
+                [self _startEntry:entry forRun:run];
+            }
+            break;
+        }
 
-        __block BFTaskCompletionSource *taskCompletionSource = nil;
-        dispatch_sync(_synchronizationQueue, ^{
-            taskCompletionSource = self->_taskCompletionSources[identifier];
-        });
+        if ([keys intersectsSet:heldBackKeys] || [run.runningKeys intersectsSet:keys]) {
+            [heldBackKeys unionSet:keys];
+            index++;
+            continue;
+        }
+
+        [run.pendingEntries removeObjectAtIndex:index];
+        if ([self _combinesCommands]) {
+            [self _coalesceEntry:entry withPendingEntriesOfRun:run atIndex:index];
+            entry = [self _batchEntryWithEntry:entry pendingEntriesOfRun:run atIndex:index heldBackKeys:heldBackKeys];
+        }
+        [self _startEntry:entry forRun:run];
+    }
+
+    // Whatever is left is waiting for a retry.
+    if (run.runningCount == 0) {
+        [run.finishedTaskCompletionSource trySetResult:nil];
+    }
+}
+
+- (void)_loadEntry:(PFEventuallyQueueEntry *)entry {
+    if (entry.loaded) {
+        return;
+    }
+    entry.loaded = YES;
+
+    NSError *error = nil;
+    id<PFNetworkCommand> command = [self _commandWithIdentifier:entry.identifiers.firstObject error:&error];
+    if (!command || error) {
+        if (!error) {
+            error = [PFErrorUtilities errorWithCode:kPFErrorInternalServer
+                                            message:@"Failed to dequeue an eventually command."
+                                          shouldLog:NO];
+        }
+        entry.resultTask = [BFTask taskWithError:error];
+        entry.dependencyKeys = [NSSet set];
+        return;
+    }
+
+    entry.command = command;
+    entry.commands = @[ command ];
+    entry.dependencyKeys = [self _dependencyKeysForCommand:command];
+}
 
-        BFTask *resultTask = nil;
-        PFCommandResult *result = nil;
+- (void)_startEntry:(PFEventuallyQueueEntry *)entry forRun:(PFEventuallyQueueRun *)run {
+    PFAssertIsOnDispatchQueue(_schedulingQueue);
+
+    run.runningCount++;
+    if (entry.dependencyKeys) {
+        for (NSString *key in entry.dependencyKeys) {
+            [run.runningKeys addObject:key];
+        }
+    } else {
+        run.runningBarrier = YES;
+    }
+
+    BFTask *resultTask = entry.resultTask;
+    if (!resultTask) {
         @try {
-            resultTask = [self _runCommand:command withIdentifier:identifier];
-            result = [resultTask waitForResult:&error];
+            resultTask = [self _runCommand:entry.command withIdentifier:entry.identifiers.firstObject];
         }
         @catch (NSException *exception) {
-            error = [NSError errorWithDomain:PFParseErrorDomain
-                                        code:kPFErrorInvalidPointer
-                                    userInfo:@{ @"message" : @"Failed to run an eventually command.",
-                                                @"exception" : exception }];
+            NSError *error = [NSError errorWithDomain:PFParseErrorDomain
+                                                 code:kPFErrorInvalidPointer
+                                             userInfo:@{ @"message" : @"Failed to run an eventually command.",
+                                                         @"exception" : exception }];
             resultTask = [BFTask taskWithError:error];
         }
+    }
+
+    [resultTask continueWithExecutor:[BFExecutor defaultPriorityBackgroundExecutor] withBlock:^id(BFTask *task) {
+        [self _didRunEntry:entry withResultTask:task forRun:run];
+        return nil;
+    }];
+}
 
+- (void)_didRunEntry:(PFEventuallyQueueEntry *)entry withResultTask:(BFTask *)resultTask forRun:(PFEventuallyQueueRun *)run {
+    NSArray<PFEventuallyQueueEntry *> *entries = entry.batchedEntries ?: @[ entry ];
+    NSArray<BFTask *> *resultTasks = (entry.batchedEntries ?
+                                      [self _resultTasksForBatchEntry:entry withResultTask:resultTask] :
+                                      @[ resultTask ]);
+
+    NSMutableArray<PFEventuallyQueueEntry *> *deferredEntries = [NSMutableArray array];
+    [entries enumerateObjectsUsingBlock:^(PFEventuallyQueueEntry *finishedEntry, NSUInteger idx, BOOL *stop) {
+        BFTask *finishedTask = resultTasks[idx];
+        NSError *error = finishedTask.error;
         if (error) {
             BOOL permanent = (![error.userInfo[@"temporary"] boolValue] &&
                               ([error.domain isEqualToString:PFParseErrorDomain] ||
                                error.code != kPFErrorConnectionFailed));
-
-            if (!permanent) {
-                PFLogWarning(PFLoggingTagCommon,
-                             @"Attempt at runEventually command timed out. Waiting %f seconds. %d retries remaining.",
-                             self.retryInterval,
-                             (int)retriesCount);
-
-                __block dispatch_semaphore_t semaphore = NULL;
-                dispatch_sync(_synchronizationQueue, ^{
-                    self->_retryingSemaphore = dispatch_semaphore_create(0);
-                    semaphore = self->_retryingSemaphore;
-                });
-
-                dispatch_time_t timeoutTime = dispatch_time(DISPATCH_TIME_NOW,
-                                                            (int64_t)(self.retryInterval * NSEC_PER_SEC));
-
-                long waitResult = dispatch_semaphore_wait(semaphore, timeoutTime);
-                dispatch_sync(_synchronizationQueue, ^{
-                    self->_retryingSemaphore = NULL;
-                });
-
-                if (waitResult == 0) {
-                    // We haven't waited long enough, but if we lost the connection, or should stop, just quit.
-                    return;
-                }
-
-                // We need to go out of the loop.
-                if (retriesCount > 0) {
-                    shouldRetry = YES;
-                    break;
-                }
+            if (!permanent && [self _scheduleRetryOfEntry:finishedEntry]) {
+                [deferredEntries addObject:finishedEntry];
+                return;
             }
 
             PFLogError(PFLoggingTagCommon, @"Failed to run command eventually with error: %@", error);
         }
+        [self _finishEntry:finishedEntry withResultTask:finishedTask];
+    }];
+
+    dispatch_async(_schedulingQueue, ^{
+        // Put the commands back where they were, so that the commands after them keep their order.
+        for (PFEventuallyQueueEntry *deferredEntry in deferredEntries) {
+            [run.deferredIdentifiers addObjectsFromArray:deferredEntry.identifiers];
+        }
+        [run.pendingEntries insertObjects:deferredEntries
+                                atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, deferredEntries.count)]];
+        [self _releaseEntry:entry forRun:run];
+    });
+}
+
+- (void)_releaseEntry:(PFEventuallyQueueEntry *)entry forRun:(PFEventuallyQueueRun *)run {
+    PFAssertIsOnDispatchQueue(_schedulingQueue);
+
+    run.runningCount--;
+    if (entry.dependencyKeys) {
+        for (NSString *key in entry.dependencyKeys) {
+            [run.runningKeys removeObject:key];
+        }
+    } else {
+        run.runningBarrier = NO;
+    }
+    [self _startCommandsForRun:run];
+}
+
+- (void)_finishEntry:(PFEventuallyQueueEntry *)entry withResultTask:(BFTask *)resultTask {
+    [entry.identifiers enumerateObjectsUsingBlock:^(NSString *identifier, NSUInteger idx, BOOL *stop) {
+        __block BFTaskCompletionSource *taskCompletionSource = nil;
+        dispatch_sync(self->_synchronizationQueue, ^{
+            taskCompletionSource = self->_taskCompletionSources[identifier];
+            [self->_failedAttemptsCounts removeObjectForKey:identifier];
+            [self->_retryDates removeObjectForKey:identifier];
+        });
 
         // Post processing shouldn't make the queue retry the command.
-        resultTask = [self _didFinishRunningCommand:command withIdentifier:identifier resultTask:resultTask];
-        [resultTask waitForResult:nil];
+        id<PFNetworkCommand> command = (idx < entry.commands.count ? entry.commands[idx] : nil);
+        BFTask *task = [self _didFinishRunningCommand:command withIdentifier:identifier resultTask:resultTask];
+        [task waitForResult:nil];
 
         // Notify anyone waiting that the operation is completed.
-        if (resultTask.error) {
-            taskCompletionSource.error = resultTask.error;
-        } else if (resultTask.cancelled) {
+        if (task.error) {
+            taskCompletionSource.error = task.error;
+        } else if (task.cancelled) {
             [taskCompletionSource cancel];
         } else {
-            taskCompletionSource.result = resultTask.result;
+            taskCompletionSource.result = task.result;
         }
-    }
-
-    // Retry here so that we're in cleaner state.
-    if (shouldRetry) {
-        return [self _runCommandsWithRetriesCount:(retriesCount - 1)];
-    }
+    }];
 }
 
 - (BFTask *)_runCommand:(id<PFNetworkCommand>)command withIdentifier:(NSString *)identifier {
     if ([command isKindOfClass:[PFRESTCommand class]]) {
+        ((PFRESTCommand *)command).lane = PFCommandRunningLaneEventuallyQueue;
         return [self.dataSource.commandRunner runCommandAsync:(PFRESTCommand *)command withOptions:0];
     }
 
@@ -346,6 +584,368 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     return [BFTask taskWithResult:nil];
 }
 
+///--------------------------------------
+#pragma mark - Retrying Commands
+///--------------------------------------
+
+/**
+ Records a failed attempt of the entry's commands and picks when to try them again.
+
+ @return `NO` if the commands ran out of attempts.
+ */
+- (BOOL)_scheduleRetryOfEntry:(PFEventuallyQueueEntry *)entry {
+    __block NSUInteger failedAttemptsCount = 0;
+    __block NSTimeInterval delay = 0.0;
+    dispatch_sync(_synchronizationQueue, ^{
+        for (NSString *identifier in entry.identifiers) {
+            failedAttemptsCount = MAX(failedAttemptsCount, [self->_failedAttemptsCounts[identifier] unsignedIntegerValue]);
+        }
+        failedAttemptsCount++;
+        if (failedAttemptsCount > self.maxAttemptsCount) {
+            return;
+        }
+
+        delay = [self _retryDelayForFailedAttemptsCount:failedAttemptsCount];
+        NSDate *retryDate = [NSDate dateWithTimeIntervalSinceNow:delay];
+        for (NSString *identifier in entry.identifiers) {
+            self->_failedAttemptsCounts[identifier] = @(failedAttemptsCount);
+            self->_retryDates[identifier] = retryDate;
+        }
+    });
+    if (failedAttemptsCount > self.maxAttemptsCount) {
+        return NO;
+    }
+
+    PFLogWarning(PFLoggingTagCommon,
+                 @"Attempt at runEventually command timed out. Waiting %f seconds. %d retries remaining.",
+                 delay,
+                 (int)(self.maxAttemptsCount - failedAttemptsCount));
+    return YES;
+}
+
+/**
+ Doubles the delay with every failed attempt up to `retryInterval`, and picks a random point in the second half of it,
+ so that commands that failed together don't all come back at once.
+ */
+- (NSTimeInterval)_retryDelayForFailedAttemptsCount:(NSUInteger)failedAttemptsCount {
+    NSTimeInterval delay = MIN(self.retryInterval, PFEventuallyQueueInitialRetryInterval * pow(2.0, failedAttemptsCount - 1));
+    return delay * (0.5 + 0.5 * ((double)(arc4random() & 0x0FFFF) / (double)0x0FFFF));
+}
+
+- (NSDate *)_nextRetryDate {
+    PFAssertIsOnDispatchQueue(_synchronizationQueue);
+
+    NSDate *nextRetryDate = nil;
+    for (NSDate *date in _retryDates.objectEnumerator) {
+        nextRetryDate = (nextRetryDate ? [nextRetryDate earlierDate:date] : date);
+    }
+    return nextRetryDate;
+}
+
+/**
+ Starts another run when the earliest retry is due, instead of waiting on `_processingQueue`,
+ so that enqueued commands and reconnects can start a run at any time.
+ */
+- (void)_scheduleRetryTimer {
+    PFAssertIsOnDispatchQueue(_processingQueue);
+
+    __block NSDate *retryDate = nil;
+    dispatch_sync(_synchronizationQueue, ^{
+        retryDate = [self _nextRetryDate];
+    });
+
+    if (!retryDate) {
+        dispatch_source_set_timer(_retryTimerSource, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        return;
+    }
+    NSTimeInterval delay = MAX(retryDate.timeIntervalSinceNow, 0.0);
+    dispatch_source_set_timer(_retryTimerSource,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
+                              DISPATCH_TIME_FOREVER,
+                              (uint64_t)(delay * 0.1 * NSEC_PER_SEC));
+}
+
+///--------------------------------------
+#pragma mark - Dependencies
+///--------------------------------------
+
+/**
+ Returns keys for the object that the command writes and the unsaved objects it points to,
+ or `nil` if the command isn't about a single object or none of the objects it touches can be told apart.
+ */
+- (NSSet<NSString *> *)_dependencyKeysForCommand:(id<PFNetworkCommand>)command {
+    if (![command isKindOfClass:[PFRESTCommand class]]) {
+        return nil;
+    }
+    PFRESTCommand *restCommand = (PFRESTCommand *)command;
+
+    NSArray<NSString *> *components = restCommand.httpPath.pathComponents;
+    NSUInteger objectPathLength = 0;
+    if ([components.firstObject isEqualToString:@"classes"]) {
+        objectPathLength = 3;
+    } else if ([components.firstObject isEqualToString:@"users"]) {
+        objectPathLength = 2;
+    }
+    if (objectPathLength == 0) {
+        return nil;
+    }
+
+    NSMutableSet<NSString *> *keys = [NSMutableSet set];
+    if (components.count == objectPathLength) {
+        [keys addObject:restCommand.httpPath];
+    } else if (components.count != objectPathLength - 1 ||
+               ![restCommand.httpMethod isEqualToString:PFHTTPRequestMethodPOST]) {
+        return nil;
+    }
+
+    NSString *localId = restCommand.localId;
+    if (localId) {
+        [keys addObject:[self _dependencyKeyForLocalId:localId]];
+
+        // The object might have been created already, in which case the command is going to become an update.
+        NSString *objectId = [[Parse _currentManager].coreManager.objectLocalIdStore objectIdForLocalId:localId];
+        if (objectId && components.count == objectPathLength - 1) {
+            [keys addObject:[NSString pathWithComponents:[components arrayByAddingObject:objectId]]];
+        }
+    }
+    [self _addLocalIdDependencyKeysFromObject:restCommand.parameters toSet:keys];
+
+    // Creating an object without a local id, as the pinning queue does, might be what any later command waits for.
+    if (keys.count == 0) {
+        return nil;
+    }
+    return keys;
+}
+
+- (void)_addLocalIdDependencyKeysFromObject:(id)object toSet:(NSMutableSet<NSString *> *)keys {
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dictionary = object;
+        if ([dictionary[@"__type"] isEqual:@"Pointer"] && [dictionary[@"localId"] isKindOfClass:[NSString class]]) {
+            [keys addObject:[self _dependencyKeyForLocalId:dictionary[@"localId"]]];
+            return;
+        }
+        for (id value in dictionary.objectEnumerator) {
+            [self _addLocalIdDependencyKeysFromObject:value toSet:keys];
+        }
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        for (id value in object) {
+            [self _addLocalIdDependencyKeysFromObject:value toSet:keys];
+        }
+    }
+}
+
+- (NSString *)_dependencyKeyForLocalId:(NSString *)localId {
+    return [@"localId:" stringByAppendingString:localId];
+}
+
+///--------------------------------------
+#pragma mark - Combining Commands
+///--------------------------------------
+
+- (BOOL)_combinesCommands {
+    return YES;
+}
+
+/**
+ Folds the updates of the same object that directly follow the entry into it, as long as they don't depend on
+ any other object, and don't touch the same keys with field operations, which can't be combined without knowing the object.
+ */
+- (void)_coalesceEntry:(PFEventuallyQueueEntry *)entry
+withPendingEntriesOfRun:(PFEventuallyQueueRun *)run
+               atIndex:(NSUInteger)index {
+    PFRESTCommand *command = (PFRESTCommand *)entry.command;
+    if (entry.resultTask || ![self _canCoalesceCommand:command]) {
+        return;
+    }
+
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionaryWithDictionary:command.parameters];
+    NSMutableArray<NSString *> *identifiers = [entry.identifiers mutableCopy];
+    NSMutableArray<id<PFNetworkCommand>> *commands = [entry.commands mutableCopy];
+    NSUInteger count = 0;
+    while (index + count < run.pendingEntries.count) {
+        PFEventuallyQueueEntry *nextEntry = run.pendingEntries[index + count];
+        [self _loadEntry:nextEntry];
+
+        PFRESTCommand *nextCommand = (PFRESTCommand *)nextEntry.command;
+        if (nextEntry.resultTask ||
+            [run isEntryDeferred:nextEntry] ||
+            ![nextEntry.dependencyKeys isSubsetOfSet:entry.dependencyKeys] ||
+            ![self _canCoalesceCommand:nextCommand] ||
+            ![nextCommand.httpPath isEqualToString:command.httpPath] ||
+            ![PFObjectUtilities isObject:nextCommand.sessionToken equalToObject:command.sessionToken] ||
+            ![PFObjectUtilities isObject:nextCommand.additionalRequestHeaders equalToObject:command.additionalRequestHeaders] ||
+            ![self _mergeParameters:nextCommand.parameters intoParameters:parameters]) {
+            break;
+        }
+        [identifiers addObjectsFromArray:nextEntry.identifiers];
+        [commands addObjectsFromArray:nextEntry.commands];
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    PFRESTCommand *coalescedCommand = [PFRESTCommand commandWithHTTPPath:command.httpPath
+                                                              httpMethod:command.httpMethod
+                                                              parameters:parameters
+                                                            sessionToken:command.sessionToken
+                                                                   error:nil];
+    if (!coalescedCommand) {
+        return;
+    }
+    coalescedCommand.additionalRequestHeaders = command.additionalRequestHeaders;
+
+    [run.pendingEntries removeObjectsInRange:NSMakeRange(index, count)];
+    entry.command = coalescedCommand;
+    entry.identifiers = identifiers;
+    entry.commands = commands;
+}
+
+- (BOOL)_canCoalesceCommand:(id<PFNetworkCommand>)command {
+    return ([command isKindOfClass:[PFRESTCommand class]] &&
+            [((PFRESTCommand *)command).httpMethod isEqualToString:PFHTTPRequestMethodPUT] &&
+            !command.localId);
+}
+
+- (BOOL)_mergeParameters:(NSDictionary *)parameters intoParameters:(NSMutableDictionary *)mergedParameters {
+    for (NSString *key in parameters) {
+        id value = mergedParameters[key];
+        if (value && ([self _isFieldOperation:value] || [self _isFieldOperation:parameters[key]])) {
+            return NO;
+        }
+    }
+    [mergedParameters addEntriesFromDictionary:parameters];
+    return YES;
+}
+
+- (BOOL)_isFieldOperation:(id)value {
+    return ([value isKindOfClass:[NSDictionary class]] && ((NSDictionary *)value)[@"__op"] != nil);
+}
+
+/**
+ Sends the commands after the entry that could start right away together with it, in a single batch command.
+ Commands in a batch never touch the same objects, since the server doesn't guarantee the order they run in.
+ */
+- (PFEventuallyQueueEntry *)_batchEntryWithEntry:(PFEventuallyQueueEntry *)entry
+                             pendingEntriesOfRun:(PFEventuallyQueueRun *)run
+                                         atIndex:(NSUInteger)index
+                                    heldBackKeys:(NSSet<NSString *> *)heldBackKeys {
+    if (entry.resultTask || ![self _canBatchCommand:entry.command] || ![self _resolveLocalIdsOfCommand:entry.command]) {
+        return entry;
+    }
+
+    NSMutableArray<PFEventuallyQueueEntry *> *entries = [NSMutableArray arrayWithObject:entry];
+    NSMutableIndexSet *batchedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableSet<NSString *> *batchKeys = [entry.dependencyKeys mutableCopy];
+    NSMutableSet<NSString *> *skippedKeys = [heldBackKeys mutableCopy];
+    for (NSUInteger nextIndex = index;
+         nextIndex < run.pendingEntries.count && entries.count < PFRESTObjectBatchCommandSubcommandsLimit;
+         nextIndex++) {
+        PFEventuallyQueueEntry *nextEntry = run.pendingEntries[nextIndex];
+        [self _loadEntry:nextEntry];
+
+        NSSet<NSString *> *keys = nextEntry.dependencyKeys;
+        if (!keys) {
+            break;
+        }
+        if (nextEntry.resultTask ||
+            [run isEntryDeferred:nextEntry] ||
+            [keys intersectsSet:skippedKeys] ||
+            [keys intersectsSet:batchKeys] ||
+            [run.runningKeys intersectsSet:keys] ||
+            ![self _canBatchCommand:nextEntry.command] ||
+            ![PFObjectUtilities isObject:nextEntry.command.sessionToken equalToObject:entry.command.sessionToken]) {
+            [skippedKeys unionSet:keys];
+            continue;
+        }
+
+        [self _coalesceEntry:nextEntry withPendingEntriesOfRun:run atIndex:(nextIndex + 1)];
+        if (![self _resolveLocalIdsOfCommand:nextEntry.command]) {
+            [skippedKeys unionSet:keys];
+            continue;
+        }
+        [entries addObject:nextEntry];
+        [batchedIndexes addIndex:nextIndex];
+        [batchKeys unionSet:keys];
+    }
+    if (entries.count == 1) {
+        return entry;
+    }
+
+    NSMutableArray<PFRESTCommand *> *commands = [NSMutableArray arrayWithCapacity:entries.count];
+    for (PFEventuallyQueueEntry *batchedEntry in entries) {
+        [commands addObject:(PFRESTCommand *)batchedEntry.command];
+    }
+    PFRESTCommand *batchCommand = [PFRESTObjectBatchCommand batchCommandWithCommands:commands
+                                                                        sessionToken:entry.command.sessionToken
+                                                                           serverURL:self.dataSource.commandRunner.serverURL
+                                                                               error:nil];
+    if (!batchCommand) {
+        return entry;
+    }
+
+    [run.pendingEntries removeObjectsAtIndexes:batchedIndexes];
+    return [[PFEventuallyQueueEntry alloc] initWithBatchCommand:batchCommand
+                                                 batchedEntries:entries
+                                                 dependencyKeys:batchKeys];
+}
+
+/**
+ Splits the result of a batch command into results of the batched commands.
+ */
+- (NSArray<BFTask *> *)_resultTasksForBatchEntry:(PFEventuallyQueueEntry *)entry withResultTask:(BFTask *)resultTask {
+    NSUInteger count = entry.batchedEntries.count;
+    NSMutableArray<BFTask *> *resultTasks = [NSMutableArray arrayWithCapacity:count];
+    if (resultTask.faulted || resultTask.cancelled) {
+        for (NSUInteger i = 0; i < count; i++) {
+            [resultTasks addObject:resultTask];
+        }
+        return resultTasks;
+    }
+
+    PFCommandResult *commandResult = resultTask.result;
+    NSArray *results = ([commandResult.result isKindOfClass:[NSArray class]] ? commandResult.result : nil);
+    for (NSUInteger i = 0; i < count; i++) {
+        NSDictionary *result = (i < results.count ? results[i] : nil);
+        NSDictionary *errorResult = result[@"error"];
+        NSDictionary *successResult = result[@"success"];
+        if (errorResult) {
+            [resultTasks addObject:[BFTask taskWithError:[PFErrorUtilities errorFromResult:errorResult shouldLog:NO]]];
+        } else if (successResult) {
+            PFCommandResult *subcommandResult = [PFCommandResult commandResultWithResult:successResult
+                                                                            resultString:nil
+                                                                            httpResponse:commandResult.httpResponse];
+            [resultTasks addObject:[BFTask taskWithResult:subcommandResult]];
+        } else {
+            NSError *error = [PFErrorUtilities errorWithCode:kPFErrorInternalServer
+                                                     message:@"Missing result of a batched eventually command."
+                                                   shouldLog:NO];
+            [resultTasks addObject:[BFTask taskWithError:error]];
+        }
+    }
+    return resultTasks;
+}
+
+- (BOOL)_canBatchCommand:(id<PFNetworkCommand>)command {
+    return ([command isKindOfClass:[PFRESTCommand class]] &&
+            ![command isKindOfClass:[PFRESTObjectBatchCommand class]] &&
+            [((PFRESTCommand *)command).httpPath hasPrefix:@"classes/"] &&
+            ((PFRESTCommand *)command).additionalRequestHeaders.count == 0);
+}
+
+/**
+ Batched commands are sent as a part of another command, so the runner doesn't resolve their local ids.
+ */
+- (BOOL)_resolveLocalIdsOfCommand:(id<PFNetworkCommand>)command {
+    @try {
+        NSError *error = nil;
+        return [command resolveLocalIds:&error];
+    }
+    @catch (NSException *exception) {
+        return NO;
+    }
+}
+
 ///--------------------------------------
 #pragma mark - Reachability
 ///--------------------------------------
@@ -389,22 +989,16 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     dispatch_async(_processingQueue, ^{
         dispatch_sync(self->_synchronizationQueue, ^{
             @strongify(self);
-            if (self.connected != connected) {
-                self->_connected = connected;
-                if (connected) {
-                    dispatch_source_merge_data(self->_processingQueueSource, 1);
-                }
+            BOOL changed = (self.connected != connected);
+            self->_connected = connected;
+            if (connected && (changed || self->_retryDates.count > 0)) {
+                // Most commands wait out a backoff because the network was down, so retry them right away.
+                [self->_retryDates removeAllObjects];
+                dispatch_source_merge_data(self->_processingQueueSource, 1);
             }
         });
         barrier.result = nil;
     });
-    if (connected) {
-        dispatch_async(_synchronizationQueue, ^{
-            if (self->_retryingSemaphore) {
-                dispatch_semaphore_signal(self->_retryingSemaphore);
-            }
-        });
-    }
     [barrier.task waitForResult:nil];
 }
 
@@ -420,6 +1014,8 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     }] continueWithExecutor:_synchronizationExecutor withBlock:^id(BFTask *task) {
         // Remove all state task completion sources
         [self->_taskCompletionSources removeAllObjects];
+        [self->_failedAttemptsCounts removeAllObjects];
+        [self->_retryDates removeAllObjects];
         return nil;
     }] continueWithExecutor:[BFExecutor executorWithDispatchQueue:_processingQueue] withBlock:^id(BFTask *task) {
         // Let all operations in the queue run at least once
@@ -429,7 +1025,11 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
 
 /** Test helper to return how many commands are being retained in memory by the cache. */
 - (int)_commandsInMemory {
-    return (int)_taskCompletionSources.count;
+    __block int count = 0;
+    dispatch_sync(_synchronizationQueue, ^{
+        count = (int)self->_taskCompletionSources.count;
+    });
+    return count;
 }
 
 - (void)_setMaxAttemptsCount:(NSUInteger)attemptsCount {
@@ -440,6 +1040,10 @@ NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval = 600.0f;
     _retryInterval = retryInterval;
 }
 
+- (void)_setMaxConcurrentCommandsCount:(NSUInteger)count {
+    _maxConcurrentCommandsCount = MAX(count, 1);
+}
+
 #if !TARGET_OS_WATCH
 
 ///--------------------------------------
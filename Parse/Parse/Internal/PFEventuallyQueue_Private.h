@@ -17,6 +17,7 @@
 
 extern NSUInteger const PFEventuallyQueueDefaultMaxAttemptsCount;
 extern NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval;
+extern NSUInteger const PFEventuallyQueueDefaultMaxConcurrentCommandsCount;
 
 @class BFTaskCompletionSource;
 
@@ -30,10 +31,24 @@ extern NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval;
     dispatch_queue_t _processingQueue;
     dispatch_source_t _processingQueueSource;
 
-    dispatch_semaphore_t _retryingSemaphore;
+    /**
+     Serial queue that starts commands of a single run over the queue, while `_processingQueue` waits for all of them.
+     */
+    dispatch_queue_t _schedulingQueue;
+
+    /**
+     Timer that starts another run over the queue once the earliest failed command is due for a retry.
+     */
+    dispatch_source_t _retryTimerSource;
 
     NSMutableDictionary *_taskCompletionSources;
 
+    /**
+     Failed attempts and the earliest next attempt of commands that failed with a temporary error, by identifier.
+     */
+    NSMutableDictionary<NSString *, NSNumber *> *_failedAttemptsCounts;
+    NSMutableDictionary<NSString *, NSDate *> *_retryDates;
+
     /**
      Task queue that will enqueue command enqueueing task so that we enqueue the command
      one at a time.
@@ -57,6 +72,21 @@ extern NSTimeInterval const PFEventuallyQueueDefaultTimeoutRetryInterval;
                       withIdentifier:(NSString *)identifier
                           resultTask:(BFTask *)resultTask;
 
+/**
+ Whether commands can be combined before they are sent: consecutive updates of the same object as a single command,
+ and commands for different objects in batches. Subclasses that construct commands right before running them
+ should return `NO`. Default: `YES`.
+ */
+- (BOOL)_combinesCommands;
+
+- (void)_setRetryInterval:(NSTimeInterval)retryInterval;
+- (void)_setMaxConcurrentCommandsCount:(NSUInteger)count;
+
+/**
+ The number of enqueued commands that didn't finish running yet.
+ */
+- (int)_commandsInMemory;
+
 ///--------------------------------------
 #pragma mark - Reachability
 ///--------------------------------------
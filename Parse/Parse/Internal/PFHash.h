@@ -19,3 +19,24 @@ extern NSUInteger PFLongHash(unsigned long long l);
 
 extern NSString *PFMD5HashFromData(NSData *data);
 extern NSString *PFMD5HashFromString(NSString *string);
+
+/**
+ Context of the non-cryptographic 128-bit MurmurHash3 (x64 variant), which is hashed incrementally.
+ */
+typedef struct {
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t length;
+    uint8_t buffer[16];
+    size_t bufferLength;
+} PFHash128Context;
+
+extern void PFHash128Init(PFHash128Context *context);
+extern void PFHash128Update(PFHash128Context *context, const void *bytes, size_t length);
+
+/**
+ Returns the hash of all the bytes passed to the context as a lowercase hex string, 32 characters long.
+ */
+extern NSString *PFHash128Final(PFHash128Context *context);
+
+extern NSString *PFHash128FromString(NSString *string);
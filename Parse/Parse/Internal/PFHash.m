@@ -74,3 +74,143 @@ extern NSString *PFMD5HashFromData(NSData *data) {
 extern NSString *PFMD5HashFromString(NSString *string) {
     return PFMD5HashFromData([string dataUsingEncoding:NSUTF8StringEncoding]);
 }
+
+///--------------------------------------
+#pragma mark - MurmurHash3
+///--------------------------------------
+
+static const uint64_t PFHash128C1 = 0x87c37b91114253d5ULL;
+static const uint64_t PFHash128C2 = 0x4cf5ad432745937fULL;
+
+static inline uint64_t PFHash128Rotl(uint64_t x, int8_t r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t PFHash128Fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint64_t PFHash128MixK1(uint64_t k1) {
+    k1 *= PFHash128C1;
+    k1 = PFHash128Rotl(k1, 31);
+    k1 *= PFHash128C2;
+    return k1;
+}
+
+static inline uint64_t PFHash128MixK2(uint64_t k2) {
+    k2 *= PFHash128C2;
+    k2 = PFHash128Rotl(k2, 33);
+    k2 *= PFHash128C1;
+    return k2;
+}
+
+static inline uint64_t PFHash128ReadLittleEndian(const uint8_t *bytes) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt64LittleToHost(value);
+}
+
+static void PFHash128ProcessBlock(PFHash128Context *context, const uint8_t *block) {
+    uint64_t h1 = context->h1;
+    uint64_t h2 = context->h2;
+
+    h1 ^= PFHash128MixK1(PFHash128ReadLittleEndian(block));
+    h1 = PFHash128Rotl(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    h2 ^= PFHash128MixK2(PFHash128ReadLittleEndian(block + 8));
+    h2 = PFHash128Rotl(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+
+    context->h1 = h1;
+    context->h2 = h2;
+}
+
+extern void PFHash128Init(PFHash128Context *context) {
+    memset(context, 0, sizeof(PFHash128Context));
+}
+
+extern void PFHash128Update(PFHash128Context *context, const void *bytes, size_t length) {
+    const uint8_t *data = bytes;
+    context->length += length;
+
+    if (context->bufferLength > 0) {
+        size_t count = MIN(length, sizeof(context->buffer) - context->bufferLength);
+        memcpy(context->buffer + context->bufferLength, data, count);
+        context->bufferLength += count;
+        data += count;
+        length -= count;
+
+        if (context->bufferLength < sizeof(context->buffer)) {
+            return;
+        }
+        PFHash128ProcessBlock(context, context->buffer);
+        context->bufferLength = 0;
+    }
+
+    while (length >= sizeof(context->buffer)) {
+        PFHash128ProcessBlock(context, data);
+        data += sizeof(context->buffer);
+        length -= sizeof(context->buffer);
+    }
+
+    if (length > 0) {
+        memcpy(context->buffer, data, length);
+        context->bufferLength = length;
+    }
+}
+
+extern NSString *PFHash128Final(PFHash128Context *context) {
+    uint64_t h1 = context->h1;
+    uint64_t h2 = context->h2;
+
+    const uint8_t *tail = context->buffer;
+    size_t tailLength = context->bufferLength;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    for (size_t i = 8; i < tailLength; i++) {
+        k2 |= (uint64_t)tail[i] << ((i - 8) * 8);
+    }
+    if (tailLength > 8) {
+        h2 ^= PFHash128MixK2(k2);
+    }
+    for (size_t i = 0; i < MIN(tailLength, 8); i++) {
+        k1 |= (uint64_t)tail[i] << (i * 8);
+    }
+    if (tailLength > 0) {
+        h1 ^= PFHash128MixK1(k1);
+    }
+
+    h1 ^= context->length;
+    h2 ^= context->length;
+    h1 += h2;
+    h2 += h1;
+    h1 = PFHash128Fmix(h1);
+    h2 = PFHash128Fmix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    // Bytes of both halves in little endian order, as other implementations print them.
+    // All supported platforms are little endian, so converting to big endian reverses the bytes.
+    return [NSString stringWithFormat:@"%016llx%016llx", CFSwapInt64HostToBig(h1), CFSwapInt64HostToBig(h2)];
+}
+
+extern NSString *PFHash128FromString(NSString *string) {
+    PFHash128Context context;
+    PFHash128Init(&context);
+
+    // Same as in `PFMD5HashFromData`, the block only uses a pointer to the context.
+    PFHash128Context *contextPointer = &context;
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        PFHash128Update(contextPointer, bytes, byteRange.length);
+    }];
+    return PFHash128Final(contextPointer);
+}
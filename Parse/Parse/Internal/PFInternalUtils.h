@@ -34,9 +34,9 @@
 + (NSNumber *)addNumber:(NSNumber *)first withNumber:(NSNumber *)second;
 
 //
-// Given an NSDictionary/NSArray/NSNumber/NSString even nested ones
-// Generates a cache key that can be used to identify this object
-+ (NSString *)cacheKeyForObject:(id)object;
+// Given an NSDictionary/NSArray/NSNumber/NSString/NSNull even nested ones
+// Generates a 128-bit hash that can be used to identify this object, regardless of the order of dictionary keys
++ (NSString *)cacheKeyHashForObject:(id)object;
 
 /**!
  * Does a deep traversal of every item in object, calling block on every one.
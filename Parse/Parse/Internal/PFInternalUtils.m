@@ -113,61 +113,115 @@
 
 #pragma mark Public
 
-+ (NSString *)cacheKeyForObject:(id)object {
-    NSMutableString *string = [NSMutableString string];
-    [self appendObject:object toString:string];
-    return string;
++ (NSString *)cacheKeyHashForObject:(id)object {
+    PFHash128Context context;
+    PFHash128Init(&context);
+    [self hashObject:object withContext:&context];
+    return PFHash128Final(&context);
 }
 
 #pragma mark Private
 
-+ (void)appendObject:(id)object toString:(NSMutableString *)string {
+// Every value starts with a tag byte, and every container and string with its length,
+// so the bytes fed to the hash map back to exactly one object.
++ (void)hashObject:(id)object withContext:(PFHash128Context *)context {
     if ([object isKindOfClass:[NSDictionary class]]) {
-        [self appendDictionary:object toString:string];
+        [self hashDictionary:object withContext:context];
     } else if ([object isKindOfClass:[NSArray class]]) {
-        [self appendArray:object toString:string];
+        [self hashArray:object withContext:context];
     } else if ([object isKindOfClass:[NSString class]]) {
-        [string appendFormat:@"\"%@\"", object];
+        [self hashString:object withContext:context];
     } else if ([object isKindOfClass:[NSNumber class]]) {
-        [self appendNumber:object toString:string];
+        [self hashNumber:object withContext:context];
     } else if ([object isKindOfClass:[NSNull class]]) {
-        [self appendNullToString:string];
+        [self hashTag:'n' withContext:context];
     } else {
         PFParameterAssertionFailure(@"Couldn't create cache key from %@", object);
     }
 }
 
-+ (void)appendDictionary:(NSDictionary *)dictionary toString:(NSMutableString *)string {
-    [string appendString:@"{"];
++ (void)hashDictionary:(NSDictionary *)dictionary withContext:(PFHash128Context *)context {
+    [self hashTag:'{' withContext:context];
+    [self hashUnsignedInteger:dictionary.count withContext:context];
 
-    NSArray *keys = [dictionary.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    NSArray *keys = dictionary.allKeys;
+    if (keys.count > 1) {
+        keys = [keys sortedArrayUsingSelector:@selector(compare:)];
+    }
     for (NSString *key in keys) {
-        [string appendFormat:@"%@:", key];
-
-        id value = dictionary[key];
-        [self appendObject:value toString:string];
+        [self hashString:key withContext:context];
+        [self hashObject:dictionary[key] withContext:context];
+    }
+}
 
-        [string appendString:@","];
++ (void)hashArray:(NSArray *)array withContext:(PFHash128Context *)context {
+    [self hashTag:'[' withContext:context];
+    [self hashUnsignedInteger:array.count withContext:context];
+    for (id object in array) {
+        [self hashObject:object withContext:context];
     }
+}
 
-    [string appendString:@"}"];
++ (void)hashString:(NSString *)string withContext:(PFHash128Context *)context {
+    [self hashTag:'"' withContext:context];
+    [self hashUnsignedInteger:string.length withContext:context];
+
+    // Converts the string to UTF-8 in chunks, without copying it whole.
+    uint8_t buffer[256];
+    NSRange range = NSMakeRange(0, string.length);
+    while (range.length > 0) {
+        NSUInteger usedLength = 0;
+        NSRange remainingRange = range;
+        if ([string getBytes:buffer
+                   maxLength:sizeof(buffer)
+                  usedLength:&usedLength
+                    encoding:NSUTF8StringEncoding
+                     options:0
+                       range:range
+              remainingRange:&remainingRange] && usedLength > 0) {
+            PFHash128Update(context, buffer, usedLength);
+            range = remainingRange;
+        } else {
+            // Unpaired surrogates can't be converted to UTF-8.
+            unichar character = [string characterAtIndex:range.location];
+            PFHash128Update(context, &character, sizeof(character));
+            range = NSMakeRange(range.location + 1, range.length - 1);
+        }
+    }
 }
 
-+ (void)appendArray:(NSArray *)array toString:(NSMutableString *)string {
-    [string appendString:@"["];
-    for (id object in array) {
-        [self appendObject:object toString:string];
-        [string appendString:@","];
++ (void)hashNumber:(NSNumber *)number withContext:(PFHash128Context *)context {
+    CFNumberRef numberRef = (__bridge CFNumberRef)number;
+    if (CFGetTypeID(numberRef) == CFBooleanGetTypeID()) {
+        [self hashTag:(number.boolValue ? 't' : 'f') withContext:context];
+    } else if (CFNumberIsFloatType(numberRef)) {
+        double value = number.doubleValue;
+        if (value == trunc(value) && fabs(value) < 0x1p63) {
+            // Same as the integer it's equal to, like in JSON.
+            [self hashTag:'i' withContext:context];
+            [self hashUnsignedInteger:(uint64_t)(int64_t)value withContext:context];
+        } else {
+            uint64_t bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+            [self hashTag:'d' withContext:context];
+            [self hashUnsignedInteger:bits withContext:context];
+        }
+    } else if (strcmp(number.objCType, @encode(unsigned long long)) == 0 && number.unsignedLongLongValue > LLONG_MAX) {
+        [self hashTag:'u' withContext:context];
+        [self hashUnsignedInteger:number.unsignedLongLongValue withContext:context];
+    } else {
+        [self hashTag:'i' withContext:context];
+        [self hashUnsignedInteger:(uint64_t)number.longLongValue withContext:context];
     }
-    [string appendString:@"]"];
 }
 
-+ (void)appendNumber:(NSNumber *)number toString:(NSMutableString *)string {
-    [string appendFormat:@"%@", number.stringValue];
++ (void)hashTag:(uint8_t)tag withContext:(PFHash128Context *)context {
+    PFHash128Update(context, &tag, sizeof(tag));
 }
 
-+ (void)appendNullToString:(NSMutableString *)string {
-    [string appendString:@"null"];
++ (void)hashUnsignedInteger:(uint64_t)value withContext:(PFHash128Context *)context {
+    value = CFSwapInt64HostToLittle(value);
+    PFHash128Update(context, &value, sizeof(value));
 }
 
 + (id)traverseObject:(id)object usingBlock:(id (^)(id object))block seenObjects:(NSMutableSet *)seen {
@@ -81,6 +81,10 @@
     self = [super initWithDataSource:dataSource maxAttemptsCount:attemptsCount retryInterval:retryInterval];
     if (!self) return nil;
 
+    // Commands are constructed from pins right before they run, so that they pick up objectIds of
+    // objects saved by earlier commands. That only works if they run one at a time.
+    [self _setMaxConcurrentCommandsCount:1];
+
     _taskQueue = [[PFTaskQueue alloc] init];
 
     dispatch_sync(_synchronizationQueue, ^{
@@ -203,6 +207,10 @@
     }];
 }
 
+- (BOOL)_combinesCommands {
+    return NO;
+}
+
 - (BFTask *)_didFinishRunningCommand:(id<PFNetworkCommand>)command
                       withIdentifier:(NSString *)identifier
                           resultTask:(BFTask *)resultTask {
@@ -22,12 +22,18 @@ extern NSString *const _ParseDefaultServerURLString;
 @property (nonatomic, copy, readwrite) NSString *server;
 
 @property (nonatomic, assign, readwrite, getter=isLocalDatastoreEnabled) BOOL localDatastoreEnabled;
+@property (nonatomic, assign, readwrite, getter=isLocalDatastoreWriteAheadLoggingEnabled) BOOL localDatastoreWriteAheadLoggingEnabled;
+@property (nonatomic, assign, readwrite, getter=isLocalDatastoreBinaryEncodingEnabled) BOOL localDatastoreBinaryEncodingEnabled;
 
 @property (nullable, nonatomic, copy, readwrite) NSString *applicationGroupIdentifier;
 @property (nullable, nonatomic, copy, readwrite) NSString *containingApplicationBundleIdentifier;
 @property (nonatomic, strong, readwrite) NSURLSessionConfiguration *URLSessionConfiguration;
 
+@property (nonatomic, assign, readwrite, getter=isSingleFileQueryCacheEnabled) BOOL singleFileQueryCacheEnabled;
+@property (nonatomic, assign, readwrite, getter=isQueryCacheCompressionEnabled) BOOL queryCacheCompressionEnabled;
+
 @property (nonatomic, assign, readwrite) NSUInteger networkRetryAttempts;
+@property (nonatomic, assign, readwrite, getter=isNetworkCompressionEnabled) BOOL networkCompressionEnabled;
 
 + (instancetype)emptyConfiguration;
 - (instancetype)initEmpty NS_DESIGNATED_INITIALIZER;
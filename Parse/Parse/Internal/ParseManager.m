@@ -24,6 +24,7 @@
 #import "PFFileManager.h"
 #import "PFInstallationIdentifierStore.h"
 #import "PFKeyValueCache.h"
+#import "PFKeyValueCacheCodec.h"
 #import "PFKeychainStore.h"
 #import "PFLogging.h"
 #import "PFMultiProcessFileLockController.h"
@@ -124,6 +125,12 @@ static NSString *const _ParseApplicationIdFileName = @"applicationId";
     if (self.configuration.localDatastoreEnabled) {
         PFOfflineStoreOptions options = (self.configuration.applicationGroupIdentifier ?
                                          PFOfflineStoreOptionAlwaysFetchFromSQLite : 0);
+        if (self.configuration.localDatastoreWriteAheadLoggingEnabled) {
+            options |= PFOfflineStoreOptionWriteAheadLogging;
+        }
+        if (self.configuration.localDatastoreBinaryEncodingEnabled) {
+            options |= PFOfflineStoreOptionBinaryEncoding;
+        }
         [self loadOfflineStoreWithOptions:options];
     }
 }
@@ -338,8 +345,17 @@ static NSString *const _ParseApplicationIdFileName = @"applicationId";
     __block PFKeyValueCache *cache = nil;
     dispatch_sync(_keyValueCacheAccessQueue, ^{
         if (!self->_keyValueCache) {
-            NSString *path = [self.fileManager parseCacheItemPathForPathComponent:@"../ParseKeyValueCache/"];
-            self->_keyValueCache = [[PFKeyValueCache alloc] initWithCacheDirectoryPath:path];
+            if (self.configuration.singleFileQueryCacheEnabled) {
+                NSString *path = [self.fileManager parseCacheItemPathForPathComponent:@"../ParseKeyValueCacheLog/"];
+                self->_keyValueCache = [[PFKeyValueCache alloc] initWithCacheDirectoryPath:path
+                                                                                   storage:PFKeyValueCacheStorageLog];
+            } else {
+                NSString *path = [self.fileManager parseCacheItemPathForPathComponent:@"../ParseKeyValueCache/"];
+                self->_keyValueCache = [[PFKeyValueCache alloc] initWithCacheDirectoryPath:path];
+            }
+            if (self.configuration.queryCacheCompressionEnabled) {
+                self->_keyValueCache.codec = [PFKeyValueCacheCompressionCodec zlibCodec];
+            }
         }
         cache = self->_keyValueCache;
     });
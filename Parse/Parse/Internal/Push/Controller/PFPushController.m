@@ -46,6 +46,7 @@
         NSError *error;
         PFRESTCommand *command = [PFRESTPushCommand sendPushCommandWithPushState:state sessionToken:sessionToken error:&error];
         PFPreconditionReturnFailedTask(command, error);
+        command.lane = PFCommandRunningLaneBackground;
         return [self.commandRunner runCommandAsync:command withOptions:PFCommandRunningOptionRetryIfFailed];
     }] continueWithSuccessBlock:^id(BFTask *task) {
         return @(task.result != nil);
@@ -10,9 +10,15 @@
 #import "PFCachedQueryController.h"
 
 #if __has_include(<Bolts/BFTask.h>)
+#import <Bolts/BFCancellationToken.h>
+#import <Bolts/BFCancellationTokenRegistration.h>
 #import <Bolts/BFTask.h>
+#import <Bolts/BFTaskCompletionSource.h>
 #else
+#import "BFCancellationToken.h"
+#import "BFCancellationTokenRegistration.h"
 #import "BFTask.h"
+#import "BFTaskCompletionSource.h"
 #endif
 
 #import "PFAssert.h"
@@ -23,12 +29,58 @@
 #import "PFJSONSerialization.h"
 #import "PFKeyValueCache.h"
 #import "PFMacros.h"
-#import "PFQueryState.h"
+#import "PFQueryState_Private.h"
 #import "PFRESTCommand.h"
 #import "PFRESTQueryCommand.h"
 #import "PFUser.h"
 
-@implementation PFCachedQueryController
+// Measured in characters of the JSON string, parsed results take a few times as much memory.
+static const NSUInteger PFCachedQueryControllerResultsCacheCostLimit = 2 << 20;
+
+/**
+ A cached query result that was already parsed.
+ The parsed object is immutable, and is decoded again for every query, so that each one gets its own objects.
+ */
+@interface PFCachedQueryResult : NSObject
+
+@property (nonatomic, copy, readonly) NSString *resultString;
+@property (nonatomic, copy, readonly) NSDictionary *object;
+@property (nonatomic, strong, readonly) NSDate *creationDate;
+
+- (instancetype)initWithResultString:(NSString *)resultString
+                              object:(NSDictionary *)object
+                        creationDate:(NSDate *)creationDate;
+
+@end
+
+@implementation PFCachedQueryResult
+
+- (instancetype)initWithResultString:(NSString *)resultString
+                              object:(NSDictionary *)object
+                        creationDate:(NSDate *)creationDate {
+    self = [super init];
+    if (!self) return nil;
+
+    _resultString = [resultString copy];
+    _object = [object copy];
+    _creationDate = creationDate;
+
+    return self;
+}
+
+@end
+
+@implementation PFCachedQueryController {
+    // Keyed by the cache key of the command. Only holds values that are still in the key value cache.
+    NSCache<NSString *, PFCachedQueryResult *> *_resultsCache;
+    // Guards the generation, which changes whenever results are removed, so reads that raced with it don't add them back.
+    dispatch_queue_t _resultsCacheAccessQueue;
+    uint64_t _resultsCacheGeneration;
+
+    // Network requests that refresh the cache, by the cache key of the command.
+    dispatch_queue_t _revalidationTasksAccessQueue;
+    NSMutableDictionary<NSString *, BFTask *> *_revalidationTasks;
+}
 
 @dynamic commonDataSource;
 
@@ -37,13 +89,37 @@
 ///--------------------------------------
 
 - (instancetype)initWithCommonDataSource:(id<PFCommandRunnerProvider, PFKeyValueCacheProvider>)dataSource {
-    return [super initWithCommonDataSource:dataSource];
+    self = [super initWithCommonDataSource:dataSource];
+    if (!self) return nil;
+
+    _resultsCache = [[NSCache alloc] init];
+    _resultsCache.totalCostLimit = PFCachedQueryControllerResultsCacheCostLimit;
+    _resultsCacheAccessQueue = dispatch_queue_create("com.parse.query.cache.results", DISPATCH_QUEUE_SERIAL);
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(_keyValueCacheDidRemoveValues:)
+                                                 name:PFKeyValueCacheDidRemoveValuesNotification
+                                               object:nil];
+
+    _revalidationTasksAccessQueue = dispatch_queue_create("com.parse.query.cache.revalidation", DISPATCH_QUEUE_SERIAL);
+    _revalidationTasks = [NSMutableDictionary dictionary];
+
+    return self;
 }
 
 + (instancetype)controllerWithCommonDataSource:(id<PFCommandRunnerProvider, PFKeyValueCacheProvider>)dataSource {
     return [super controllerWithCommonDataSource:dataSource];
 }
 
+///--------------------------------------
+#pragma mark - Dealloc
+///--------------------------------------
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:PFKeyValueCacheDidRemoveValuesNotification
+                                                  object:nil];
+}
+
 ///--------------------------------------
 #pragma mark - PFQueryControllerSubclass
 ///--------------------------------------
@@ -114,6 +190,22 @@
             } cancellationToken:cancellationToken];
         }
             break;
+        case kPFCachePolicyStaleWhileRevalidate: {
+            BFTask *cacheTask = [self _runNetworkCommandAsyncFromCache:command
+                                                 withCancellationToken:cancellationToken
+                                                         forQueryState:queryState];
+            @weakify(self);
+            return [cacheTask continueWithBlock:^id(BFTask *task) {
+                @strongify(self);
+                if (task.error) {
+                    // Nothing to show yet, so wait for the network.
+                    return [self _revalidateCacheWithCommandAsync:command withCancellationToken:cancellationToken];
+                }
+                [self _revalidateCacheWithCommandAsync:command withCancellationToken:nil];
+                return task;
+            } cancellationToken:cancellationToken];
+        }
+            break;
         case kPFCachePolicyCacheThenNetwork: {
             NSError *error = [PFErrorUtilities errorWithCode:kPFErrorInvalidQuery
                                                      message:@"Cache then network is not supported directly in PFCachedQueryController."];
@@ -152,13 +244,92 @@
     } cancellationToken:cancellationToken];
 }
 
+/**
+ Runs the command and saves its result to the cache, unless the same command is already running,
+ in which case that request is waited for instead.
+ The request is shared between queries, so the cancellation token only cancels the returned task,
+ the request keeps running for the other queries and the cache.
+ */
+- (BFTask *)_revalidateCacheWithCommandAsync:(PFRESTCommand *)command
+                       withCancellationToken:(BFCancellationToken *)cancellationToken {
+    BFTask *sharedTask = [self _sharedRevalidationTaskForCommand:command];
+    if (!cancellationToken) {
+        return sharedTask;
+    }
+
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    BFCancellationTokenRegistration *registration = [cancellationToken registerCancellationObserverWithBlock:^{
+        [taskCompletionSource trySetCancelled];
+    }];
+    [sharedTask continueWithBlock:^id(BFTask *task) {
+        [registration dispose];
+        if (task.cancelled) {
+            [taskCompletionSource trySetCancelled];
+        } else if (task.error) {
+            [taskCompletionSource trySetError:task.error];
+        } else {
+            [taskCompletionSource trySetResult:task.result];
+        }
+        return nil;
+    }];
+    return taskCompletionSource.task;
+}
+
+- (BFTask *)_sharedRevalidationTaskForCommand:(PFRESTCommand *)command {
+    NSString *cacheKey = command.cacheKey;
+
+    __block BFTask *task = nil;
+    __block BFTaskCompletionSource *taskCompletionSource = nil;
+    dispatch_sync(_revalidationTasksAccessQueue, ^{
+        task = self->_revalidationTasks[cacheKey];
+        if (!task) {
+            taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+            task = taskCompletionSource.task;
+            self->_revalidationTasks[cacheKey] = task;
+        }
+    });
+    if (!taskCompletionSource) {
+        return task;
+    }
+
+    BFTask *networkTask = [self.commonDataSource.commandRunner runCommandAsync:command
+                                                                   withOptions:PFCommandRunningOptionRetryIfFailed
+                                                             cancellationToken:nil];
+    [[networkTask continueWithSuccessBlock:^id(BFTask *task) {
+        return [self _saveCommandResultAsync:task.result forCommandCacheKey:cacheKey];
+    }] continueWithBlock:^id(BFTask *task) {
+        // Queries issued from now on see the new result in the cache, or start another request if this one failed.
+        dispatch_sync(self->_revalidationTasksAccessQueue, ^{
+            [self->_revalidationTasks removeObjectForKey:cacheKey];
+        });
+        if (task.cancelled) {
+            [taskCompletionSource cancel];
+        } else if (task.error) {
+            [taskCompletionSource setError:task.error];
+        } else {
+            [taskCompletionSource setResult:task.result];
+        }
+        return nil;
+    }];
+    return task;
+}
+
 ///--------------------------------------
 #pragma mark - Cache
 ///--------------------------------------
 
 - (NSString *)cacheKeyForQueryState:(PFQueryState *)queryState sessionToken:(NSString *)sessionToken {
+    NSString *cacheKey = [queryState cacheKeyForSessionToken:sessionToken];
+    if (cacheKey) {
+        return cacheKey;
+    }
+
     // TODO (flovilmart): verify if safe to swallow error here
-    return [PFRESTQueryCommand findCommandForQueryState:queryState withSessionToken:sessionToken error:nil].cacheKey;
+    cacheKey = [PFRESTQueryCommand findCommandForQueryState:queryState withSessionToken:sessionToken error:nil].cacheKey;
+    if (cacheKey) {
+        [queryState setCacheKey:cacheKey forSessionToken:sessionToken];
+    }
+    return cacheKey;
 }
 
 - (BOOL)hasCachedResultForQueryState:(PFQueryState *)queryState sessionToken:(NSString *)sessionToken {
@@ -166,42 +337,111 @@
     // TODO: (nlutsenko) We should cache this result.
 
     NSString *cacheKey = [self cacheKeyForQueryState:queryState sessionToken:sessionToken];
+    if ([self _cachedResultForKey:cacheKey maxAge:queryState.maxCacheAge]) {
+        return YES;
+    }
     return ([self.commonDataSource.keyValueCache objectForKey:cacheKey maxAge:queryState.maxCacheAge] != nil);
 }
 
 - (void)clearCachedResultForQueryState:(PFQueryState *)queryState sessionToken:(NSString *)sessionToken {
     // TODO: (nlutsenko) Once there is caching for `count`, the results for that command should also be cleared.
     NSString *cacheKey = [self cacheKeyForQueryState:queryState sessionToken:sessionToken];
+    [self _removeCachedResultsForKeys:@[ cacheKey ]];
     [self.commonDataSource.keyValueCache removeObjectForKey:cacheKey];
 }
 
 - (void)clearAllCachedResults {
+    [self _removeCachedResultsForKeys:nil];
     [self.commonDataSource.keyValueCache removeAllObjects];
 }
 
+- (PFCachedQueryResult *)_cachedResultForKey:(NSString *)cacheKey maxAge:(NSTimeInterval)maxAge {
+    PFCachedQueryResult *cachedResult = [_resultsCache objectForKey:cacheKey];
+    if (cachedResult && [[NSDate date] timeIntervalSinceDate:cachedResult.creationDate] > maxAge) {
+        // The key value cache finds it expired as well, and removes it from disk.
+        [self _removeCachedResultsForKeys:@[ cacheKey ]];
+        return nil;
+    }
+    return cachedResult;
+}
+
+- (uint64_t)_cachedResultsGeneration {
+    __block uint64_t generation = 0;
+    dispatch_sync(_resultsCacheAccessQueue, ^{
+        generation = self->_resultsCacheGeneration;
+    });
+    return generation;
+}
+
+- (void)_setCachedResult:(PFCachedQueryResult *)cachedResult
+                  forKey:(NSString *)cacheKey
+              generation:(uint64_t)generation {
+    dispatch_sync(_resultsCacheAccessQueue, ^{
+        if (self->_resultsCacheGeneration == generation) {
+            [self->_resultsCache setObject:cachedResult forKey:cacheKey cost:cachedResult.resultString.length];
+        }
+    });
+}
+
+/**
+ @param cacheKeys The keys to remove results for, or `nil` to remove all of them.
+ */
+- (void)_removeCachedResultsForKeys:(NSArray<NSString *> *)cacheKeys {
+    dispatch_sync(_resultsCacheAccessQueue, ^{
+        self->_resultsCacheGeneration++;
+        if (!cacheKeys) {
+            [self->_resultsCache removeAllObjects];
+        }
+        for (NSString *cacheKey in cacheKeys) {
+            [self->_resultsCache removeObjectForKey:cacheKey];
+        }
+    });
+}
+
+- (void)_keyValueCacheDidRemoveValues:(NSNotification *)notification {
+    if (notification.object != self.commonDataSource.keyValueCache) {
+        return;
+    }
+    [self _removeCachedResultsForKeys:notification.userInfo[PFKeyValueCacheRemovedKeysUserInfoKey]];
+}
+
 - (BFTask *)_runNetworkCommandAsyncFromCache:(PFRESTCommand *)command
                        withCancellationToken:(BFCancellationToken *)cancellationToken
                                forQueryState:(PFQueryState *)queryState {
-    NSString *jsonString = [self.commonDataSource.keyValueCache objectForKey:command.cacheKey
-                                                                      maxAge:queryState.maxCacheAge];
-    if (!jsonString) {
-        NSError *error = [PFErrorUtilities errorWithCode:kPFErrorCacheMiss
-                                                message:@"Cache miss."
-                                              shouldLog:NO];
-        return [BFTask taskWithError:error];
-    }
+    NSString *cacheKey = command.cacheKey;
+    PFCachedQueryResult *cachedResult = [self _cachedResultForKey:cacheKey maxAge:queryState.maxCacheAge];
+    if (!cachedResult) {
+        uint64_t generation = [self _cachedResultsGeneration];
+        NSDate *creationDate = nil;
+        NSString *jsonString = [self.commonDataSource.keyValueCache objectForKey:cacheKey
+                                                                          maxAge:queryState.maxCacheAge
+                                                                    creationDate:&creationDate];
+        if (!jsonString) {
+            NSError *error = [PFErrorUtilities errorWithCode:kPFErrorCacheMiss
+                                                    message:@"Cache miss."
+                                                  shouldLog:NO];
+            return [BFTask taskWithError:error];
+        }
 
-    NSDictionary *object = [PFJSONSerialization JSONObjectFromString:jsonString];
-    if (!object) {
-        NSError *error = [PFErrorUtilities errorWithCode:kPFErrorCacheMiss
-                                                message:@"Cache contains corrupted JSON."];
-        return [BFTask taskWithError:error];
-    }
+        NSDictionary *object = [PFJSONSerialization JSONObjectFromString:jsonString];
+        if (![object isKindOfClass:[NSDictionary class]]) {
+            NSError *error = [PFErrorUtilities errorWithCode:kPFErrorCacheMiss
+                                                    message:@"Cache contains corrupted JSON."];
+            return [BFTask taskWithError:error];
+        }
 
-    NSDictionary *decodedObject = [[PFDecoder objectDecoder] decodeObject:object];
+        cachedResult = [[PFCachedQueryResult alloc] initWithResultString:jsonString
+                                                                  object:object
+                                                            creationDate:creationDate];
+        if (creationDate) {
+            [self _setCachedResult:cachedResult forKey:cacheKey generation:generation];
+        }
+    }
 
+    // Decoded for every query, as decoded objects are mutable.
+    NSDictionary *decodedObject = [[PFDecoder objectDecoder] decodeObject:cachedResult.object];
     PFCommandResult *result = [PFCommandResult commandResultWithResult:decodedObject
-                                                          resultString:jsonString
+                                                          resultString:cachedResult.resultString
                                                           httpResponse:nil];
     return [BFTask taskWithResult:result];
 }
@@ -210,6 +450,8 @@
     NSString *resultString = result.resultString;
     if (resultString) {
         self.commonDataSource.keyValueCache[cacheKey] = resultString;
+        // Parsed again on the next cache hit, so the cached result never shares containers with the network result.
+        [self _removeCachedResultsForKeys:@[ cacheKey ]];
     }
     // Roll-forward the original result.
     return [BFTask taskWithResult:result];
@@ -9,6 +9,7 @@
 
 #import <Foundation/Foundation.h>
 
+#import "PFOfflineStore.h"
 #import "PFQueryController.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -26,6 +27,21 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)controllerWithCommonDataSource:(id<PFCommandRunnerProvider, PFOfflineStoreProvider>)dataSource
                                 coreDataSource:(id<PFPinningObjectStoreProvider>)coreDataSource;
 
+///--------------------------------------
+#pragma mark - Enumerate
+///--------------------------------------
+
+/**
+ Enumerates the objects that match a Local Datastore query a page at a time.
+
+ @see `-[PFOfflineStore enumerateObjectsAsyncForQueryState:user:pin:pageSize:block:]`
+ */
+- (BFTask<PFVoid> *)enumerateObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                              pageSize:(NSUInteger)pageSize
+                                 withCancellationToken:(nullable BFCancellationToken *)cancellationToken
+                                                  user:(nullable PFUser *)user
+                                                 block:(PFOfflineStoreEnumerationBlock)block;
+
 @end
 
 NS_ASSUME_NONNULL_END
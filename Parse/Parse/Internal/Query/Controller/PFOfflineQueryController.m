@@ -57,7 +57,8 @@
 
 - (BFTask *)findObjectsAsyncForQueryState:(PFQueryState *)queryState
                     withCancellationToken:(BFCancellationToken *)cancellationToken
-                                     user:(PFUser *)user {
+                                     user:(PFUser *)user
+                  progressiveResultsBlock:(void (^)(NSArray *))progressiveResultsBlock {
     if (queryState.queriesLocalDatastore) {
         return [self _findObjectsFromLocalDatastoreAsyncForQueryState:queryState
                                                 withCancellationToken:cancellationToken
@@ -74,21 +75,27 @@
                                             ofObject:object
                                        forQueryState:queryState
                                withCancellationToken:cancellationToken
-                                                user:user];
+                                                user:user
+                             progressiveResultsBlock:progressiveResultsBlock];
         }
     }
 
-    return [super findObjectsAsyncForQueryState:queryState withCancellationToken:cancellationToken user:user];
+    return [super findObjectsAsyncForQueryState:queryState
+                          withCancellationToken:cancellationToken
+                                           user:user
+                        progressiveResultsBlock:progressiveResultsBlock];
 }
 
 - (BFTask *)_findObjectsAsyncInRelation:(PFRelation *)relation
                                ofObject:(PFObject *)parentObject
                           forQueryState:(PFQueryState *)queryState
                   withCancellationToken:(BFCancellationToken *)cancellationToken
-                                   user:(PFUser *)user {
+                                   user:(PFUser *)user
+                progressiveResultsBlock:(void (^)(NSArray *))progressiveResultsBlock {
     return [[super findObjectsAsyncForQueryState:queryState
                            withCancellationToken:cancellationToken
-                                            user:user] continueWithSuccessBlock:^id(BFTask *fetchTask) {
+                                            user:user
+                         progressiveResultsBlock:progressiveResultsBlock] continueWithSuccessBlock:^id(BFTask *fetchTask) {
 
         NSArray *objects = fetchTask.result;
         for (PFObject *object in objects) {
@@ -162,6 +169,49 @@
     } cancellationToken:cancellationToken];
 }
 
+///--------------------------------------
+#pragma mark - Enumerate
+///--------------------------------------
+
+- (BFTask<PFVoid> *)enumerateObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                              pageSize:(NSUInteger)pageSize
+                                 withCancellationToken:(BFCancellationToken *)cancellationToken
+                                                  user:(PFUser *)user
+                                                 block:(PFOfflineStoreEnumerationBlock)block {
+    PFConsistencyAssert(queryState.queriesLocalDatastore, @"Only Local Datastore queries can be enumerated.");
+
+    @weakify(self);
+    return [[[BFTask taskFromExecutor:[BFExecutor defaultPriorityBackgroundExecutor] withBlock:^id{
+        @strongify(self);
+        if (cancellationToken.cancellationRequested) {
+            return [BFTask cancelledTask];
+        }
+
+        NSString *pinName = queryState.localDatastorePinName;
+        if (pinName) {
+            PFPinningObjectStore *objectStore = self.coreDataSource.pinningObjectStore;
+            return [objectStore fetchPinAsyncWithName:pinName];
+        }
+        return nil;
+    }] continueWithSuccessBlock:^id(BFTask *task) {
+        PFPin *pin = task.result;
+        return [self->_offlineStore enumerateObjectsAsyncForQueryState:queryState
+                                                                  user:user
+                                                                   pin:pin
+                                                              pageSize:pageSize
+                                                                 block:^(NSArray<PFObject *> *objects, BOOL *stop) {
+            if (cancellationToken.cancellationRequested) {
+                *stop = YES;
+                return;
+            }
+            block(objects, stop);
+        }];
+    } cancellationToken:cancellationToken] continueWithSuccessBlock:^id(BFTask *task) {
+        // Pages after the cancellation aren't enumerated.
+        return (cancellationToken.cancellationRequested ? [BFTask cancelledTask] : task);
+    }];
+}
+
 ///--------------------------------------
 #pragma mark - PFQueryControllerSubclass
 ///--------------------------------------
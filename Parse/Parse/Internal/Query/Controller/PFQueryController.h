@@ -56,6 +56,23 @@ NS_ASSUME_NONNULL_BEGIN
                     withCancellationToken:(nullable BFCancellationToken *)cancellationToken
                                      user:(nullable PFUser *)user; // TODO: (nlutsenko) Pass `PFUserState` instead of user.
 
+/**
+ Same as `-findObjectsAsyncForQueryState:withCancellationToken:user:`, and also calls `progressiveResultsBlock`
+ with objects of a network response as soon as they are received. The block is called on a background thread,
+ never with the same object twice, and not at all if the results don't come from the network.
+
+ @param queryState              Query state to use.
+ @param cancellationToken       Cancellation token or `nil`.
+ @param user                    `user` to use for ACLs or `nil`.
+ @param progressiveResultsBlock Block to call with the objects that were received or `nil`.
+
+ @return Task that resolves to `NSArray` of `PFObject`s, the same ones that were passed to the block.
+ */
+- (BFTask *)findObjectsAsyncForQueryState:(PFQueryState *)queryState
+                    withCancellationToken:(nullable BFCancellationToken *)cancellationToken
+                                     user:(nullable PFUser *)user
+                  progressiveResultsBlock:(nullable void (^)(NSArray *objects))progressiveResultsBlock;
+
 ///--------------------------------------
 #pragma mark - Count
 ///--------------------------------------
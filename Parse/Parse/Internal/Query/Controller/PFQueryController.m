@@ -57,9 +57,23 @@
 - (BFTask *)findObjectsAsyncForQueryState:(PFQueryState *)queryState
                     withCancellationToken:(BFCancellationToken *)cancellationToken
                                      user:(PFUser *)user {
+    return [self findObjectsAsyncForQueryState:queryState
+                         withCancellationToken:cancellationToken
+                                          user:user
+                       progressiveResultsBlock:nil];
+}
+
+- (BFTask *)findObjectsAsyncForQueryState:(PFQueryState *)queryState
+                    withCancellationToken:(BFCancellationToken *)cancellationToken
+                                     user:(PFUser *)user
+                  progressiveResultsBlock:(void (^)(NSArray *))progressiveResultsBlock {
     NSDate *queryStart = (queryState.trace ? [NSDate date] : nil);
     __block NSDate *querySent = nil;
 
+    // Objects that were decoded while the response was still being received, and the results they were decoded from.
+    NSMutableArray *foundObjects = [NSMutableArray array];
+    NSMutableArray *foundResults = [NSMutableArray array];
+
     NSString *sessionToken = user.sessionToken;
     return [[BFTask taskFromExecutor:[BFExecutor defaultPriorityBackgroundExecutor] withBlock:^id{
         if (cancellationToken.cancellationRequested) {
@@ -69,6 +83,19 @@
         NSError *error;
         PFRESTCommand *command = [PFRESTQueryCommand findCommandForQueryState:queryState withSessionToken:sessionToken error:&error];
         PFPreconditionReturnFailedTask(command, error);
+        if (progressiveResultsBlock && !queryState.explain) {
+            command.partialResultsBlock = ^(NSArray *results, NSUInteger index) {
+                NSArray *objects = [self _objectsFromResults:results
+                                                     atIndex:index
+                                            defaultClassName:queryState.parseClassName
+                                                selectedKeys:queryState.selectedKeys.allObjects
+                                                foundResults:foundResults
+                                                foundObjects:foundObjects];
+                if (objects.count > 0) {
+                    progressiveResultsBlock(objects);
+                }
+            };
+        }
         querySent = (queryState.trace ? [NSDate date] : nil);
         return [self runNetworkCommandAsync:command
                       withCancellationToken:cancellationToken
@@ -81,18 +108,31 @@
             return result.result[@"results"];
         }
         NSArray *resultObjects = result.result[@"results"];
-        NSMutableArray *foundObjects = [NSMutableArray arrayWithCapacity:resultObjects.count];
+        NSMutableArray *objects = [NSMutableArray array];
         if (resultObjects != nil) {
             NSString *resultClassName = result.result[@"className"];
             if (!resultClassName) {
                 resultClassName = queryState.parseClassName;
             }
-            NSArray *selectedKeys = queryState.selectedKeys.allObjects;
-            for (NSDictionary *resultObject in resultObjects) {
-                PFObject *object = [PFObject _objectFromDictionary:resultObject
-                                                  defaultClassName:resultClassName
-                                                      selectedKeys:selectedKeys];
-                [foundObjects addObject:object];
+
+            // The response might come from another attempt or from the cache, so streamed objects are only kept
+            // for the results they were decoded from.
+            if ([resultClassName isEqualToString:queryState.parseClassName]) {
+                [self _objectsFromResults:resultObjects
+                                  atIndex:0
+                         defaultClassName:resultClassName
+                             selectedKeys:queryState.selectedKeys.allObjects
+                             foundResults:foundResults
+                             foundObjects:foundObjects];
+                @synchronized (foundObjects) {
+                    [objects addObjectsFromArray:[foundObjects subarrayWithRange:NSMakeRange(0, resultObjects.count)]];
+                }
+            } else {
+                for (NSDictionary *resultObject in resultObjects) {
+                    [objects addObject:[PFObject _objectFromDictionary:resultObject
+                                                      defaultClassName:resultClassName
+                                                          selectedKeys:queryState.selectedKeys.allObjects]];
+                }
             }
         }
 
@@ -103,10 +143,53 @@
                   queryReceived.timeIntervalSinceNow);
         }
 
-        return foundObjects;
+        return objects;
     } cancellationToken:cancellationToken];
 }
 
+/**
+ Decodes the results that weren't decoded yet and adds them to `foundObjects`, and the results to `foundResults`.
+ Objects that were found before are only kept as long as their results match the ones at the same position,
+ e.g. when a retried request reports them again.
+
+ @return The objects that were added.
+ */
+- (NSArray *)_objectsFromResults:(NSArray *)results
+                         atIndex:(NSUInteger)index
+                defaultClassName:(NSString *)className
+                    selectedKeys:(NSArray *)selectedKeys
+                    foundResults:(NSMutableArray *)foundResults
+                    foundObjects:(NSMutableArray *)foundObjects {
+    @synchronized (foundObjects) {
+        NSUInteger foundCount = foundObjects.count;
+        if (index > foundCount) {
+            return @[];
+        }
+
+        NSUInteger matchingCount = 0;
+        while (matchingCount < results.count && index + matchingCount < foundCount &&
+               [foundResults[index + matchingCount] isEqual:results[matchingCount]]) {
+            matchingCount++;
+        }
+        if (matchingCount < results.count && index + matchingCount < foundCount) {
+            NSRange staleRange = NSMakeRange(index + matchingCount, foundCount - index - matchingCount);
+            [foundResults removeObjectsInRange:staleRange];
+            [foundObjects removeObjectsInRange:staleRange];
+        }
+
+        NSMutableArray *objects = [NSMutableArray array];
+        for (NSUInteger i = matchingCount; i < results.count; i++) {
+            PFObject *object = [PFObject _objectFromDictionary:results[i]
+                                              defaultClassName:className
+                                                  selectedKeys:selectedKeys];
+            [objects addObject:object];
+        }
+        [foundResults addObjectsFromArray:[results subarrayWithRange:NSMakeRange(matchingCount, objects.count)]];
+        [foundObjects addObjectsFromArray:objects];
+        return objects;
+    }
+}
+
 ///--------------------------------------
 #pragma mark - Count
 ///--------------------------------------
@@ -86,9 +86,10 @@
     NSMutableDictionary *conditionObject = nil;
 
     // Check if we already have some sort of condition
+    // Copied, because immutable copies of this state share the existing one.
     id existingCondition = _conditions[key];
     if ([existingCondition isKindOfClass:[NSMutableDictionary class]]) {
-        conditionObject = existingCondition;
+        conditionObject = [existingCondition mutableCopy];
     }
     if (!conditionObject) {
         conditionObject = [NSMutableDictionary dictionary];
@@ -202,6 +203,14 @@
     }
 }
 
+///--------------------------------------
+#pragma mark - Cache Key
+///--------------------------------------
+
+- (void)setCacheKey:(NSString *)cacheKey forSessionToken:(NSString *)sessionToken {
+    // Any change to the state would change the key too.
+}
+
 ///--------------------------------------
 #pragma mark - Redirect
 ///--------------------------------------
@@ -13,8 +13,29 @@
 #import "PFMutableQueryState.h"
 #import "PFPropertyInfo.h"
 #import "PFMacros.h"
+#import "PFQuery.h"
+
+static BOOL PFQueryStateObjectContainsQuery(id object) {
+    if ([object isKindOfClass:[PFQuery class]]) {
+        return YES;
+    }
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        object = [object allValues];
+    }
+    if ([object isKindOfClass:[NSArray class]]) {
+        for (id value in object) {
+            if (PFQueryStateObjectContainsQuery(value)) {
+                return YES;
+            }
+        }
+    }
+    return NO;
+}
 
-@implementation PFQueryState
+@implementation PFQueryState {
+    NSString *_cacheKey;
+    NSString *_cacheKeySessionToken;
+}
 
 ///--------------------------------------
 #pragma mark - PFBaseStateSubclass
@@ -77,6 +98,30 @@
     return [self.sortKeys componentsJoinedByString:@","];
 }
 
+///--------------------------------------
+#pragma mark - Cache Key
+///--------------------------------------
+
+- (NSString *)cacheKeyForSessionToken:(NSString *)sessionToken {
+    @synchronized(self) {
+        if (_cacheKey && (_cacheKeySessionToken == sessionToken || [_cacheKeySessionToken isEqualToString:sessionToken])) {
+            return _cacheKey;
+        }
+        return nil;
+    }
+}
+
+- (void)setCacheKey:(NSString *)cacheKey forSessionToken:(NSString *)sessionToken {
+    // Subqueries are mutable, so the cache key changes together with them.
+    if (PFQueryStateObjectContainsQuery(self.conditions)) {
+        return;
+    }
+    @synchronized(self) {
+        _cacheKey = [cacheKey copy];
+        _cacheKeySessionToken = [sessionToken copy];
+    }
+}
+
 ///--------------------------------------
 #pragma mark - Mutable Copying
 ///--------------------------------------
@@ -76,4 +76,19 @@
 @property (nonatomic, assign, readwrite) BOOL queriesLocalDatastore;
 @property (nonatomic, copy, readwrite) NSString *localDatastorePinName;
 
+///--------------------------------------
+#pragma mark - Cache Key
+///--------------------------------------
+
+/**
+ Returns the cache key that was kept for the session token, if any.
+ */
+- (NSString *)cacheKeyForSessionToken:(NSString *)sessionToken;
+
+/**
+ Keeps the cache key for the session token, replacing the one kept for another session token.
+ Mutable states and states with subqueries don't keep it, because their cache key can change.
+ */
+- (void)setCacheKey:(NSString *)cacheKey forSessionToken:(NSString *)sessionToken;
+
 @end
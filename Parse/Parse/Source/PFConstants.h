@@ -67,7 +67,13 @@ typedef NS_ENUM(uint8_t, PFCachePolicy) {
      The callback will be called twice - first with the cached results, then with the network results.
      Since it returns two results at different times, this cache policy cannot be used with synchronous or task methods.
      */
-    kPFCachePolicyCacheThenNetwork
+    kPFCachePolicyCacheThenNetwork,
+    /**
+     The query loads from the cache, and refreshes the cache from the network in the background.
+     If there are no cached results, it loads results from the network.
+     Identical queries share a single network request while it is in flight.
+     */
+    kPFCachePolicyStaleWhileRevalidate
 };
 
 ///--------------------------------------
@@ -400,6 +406,20 @@ extern NSString *const _Nonnull PFNetworkNotificationURLResponseUserInfoKey;
  */
 extern NSString *const _Nonnull PFNetworkNotificationURLResponseBodyUserInfoKey;
 
+/**
+ The key of the compression ratio of request body (`NSNumber`, original length over sent length)
+ in the userInfo dictionary of `PFNetworkWillSendURLRequestNotification`.
+ @note This key is populated in userInfo, only if the request body was compressed.
+ */
+extern NSString *const _Nonnull PFNetworkNotificationURLRequestBodyCompressionRatioUserInfoKey;
+
+/**
+ The key of the compression ratio of response body (`NSNumber`, decoded length over received length)
+ in the userInfo dictionary of `PFNetworkDidReceiveURLResponseNotification`.
+ @note This key is populated in userInfo, only if the response body was compressed.
+ */
+extern NSString *const _Nonnull PFNetworkNotificationURLResponseBodyCompressionRatioUserInfoKey;
+
 
 ///--------------------------------------
 #pragma mark - Deprecated Macros
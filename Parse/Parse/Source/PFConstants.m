@@ -30,4 +30,6 @@ NSString *const PFNetworkDidReceiveURLResponseNotification = @"PFNetworkDidRecei
 NSString *const PFNetworkNotificationURLRequestUserInfoKey = @"PFNetworkNotificationURLRequestUserInfoKey";
 NSString *const PFNetworkNotificationURLResponseUserInfoKey = @"PFNetworkNotificationURLResponseUserInfoKey";
 NSString *const PFNetworkNotificationURLResponseBodyUserInfoKey = @"PFNetworkNotificationURLResponseBodyUserInfoKey";
+NSString *const PFNetworkNotificationURLRequestBodyCompressionRatioUserInfoKey = @"PFNetworkNotificationURLRequestBodyCompressionRatioUserInfoKey";
+NSString *const PFNetworkNotificationURLResponseBodyCompressionRatioUserInfoKey = @"PFNetworkNotificationURLResponseBodyCompressionRatioUserInfoKey";
 NSString *const PFInvalidSessionTokenNotification = @"PFInvalidSessionTokenNotification";
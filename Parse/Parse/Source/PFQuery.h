@@ -32,6 +32,8 @@ NS_ASSUME_NONNULL_BEGIN
 ///--------------------------------------
 
 typedef void (^PFQueryArrayResultBlock)(NSArray<PFGenericObject> *_Nullable objects, NSError * _Nullable error);
+typedef void (^PFQueryEnumerationBlock)(NSArray<PFGenericObject> *objects, BOOL *stop);
+typedef void (^PFQueryProgressiveResultsBlock)(NSArray<PFGenericObject> *objects);
 
 ///--------------------------------------
 #pragma mark - Creating a Query for a Class
@@ -652,6 +654,19 @@ typedef void (^PFQueryArrayResultBlock)(NSArray<PFGenericObject> *_Nullable obje
  */
 - (void)findObjectsInBackgroundWithBlock:(nullable PFQueryArrayResultBlock)block;
 
+/**
+ Finds objects *asynchronously*, and calls the given block with objects as soon as they are received,
+ before the whole response is, so that the first results can be shown early.
+
+ The block is not called for objects that come from the cache or the Local Datastore.
+
+ @param block The block to execute on the main thread, in order, with every batch of received objects.
+ It should have the following argument signature: `^(NSArray *objects)`.
+
+ @return The task, that encapsulates the work being done. Its result has all of the objects that were passed to the block.
+ */
+- (BFTask<NSArray<PFGenericObject> *> *)findObjectsInBackgroundWithProgressiveResultsBlock:(PFQueryProgressiveResultsBlock)block;
+
 ///--------------------------------------
 #pragma mark - Getting the First Match in a Query
 ///--------------------------------------
@@ -828,6 +843,81 @@ typedef void (^PFQueryArrayResultBlock)(NSArray<PFGenericObject> *_Nullable obje
 @property (nonatomic, copy) NSString *hint;
 @property (nonatomic, assign) BOOL explain;
 
+///--------------------------------------
+#pragma mark - Local Datastore Indexes
+///--------------------------------------
+
+/**
+ *Asynchronously* indexes the values of a key for all objects of a class in the Local Datastore.
+
+ Queries from the Local Datastore with `equalTo`, `lessThan`, `lessThanOrEqualTo`, `greaterThan`,
+ `greaterThanOrEqualTo` or `containedIn` constraints on an indexed key only load the objects that can match
+ from disk, instead of every object of the class. Indexes are persisted and kept up to date as objects are pinned.
+ String, number and date values are indexed, including the ones that are stored in arrays.
+
+ @warning Requires Local Datastore to be enabled.
+
+ @param key       The key to index. Only top-level keys can be indexed.
+ @param className The class name of the objects to index.
+
+ @return The task that will be completed once all objects of the class are indexed.
+ */
++ (BFTask<NSNumber *> *)createLocalIndexInBackgroundOnKey:(NSString *)key forClassName:(NSString *)className;
+
+/**
+ *Asynchronously* indexes the values of a key for all objects of a class in the Local Datastore
+ and executes the given callback block.
+
+ @warning Requires Local Datastore to be enabled.
+
+ @param key       The key to index. Only top-level keys can be indexed.
+ @param className The class name of the objects to index.
+ @param block     The block to execute.
+ It should have the following argument signature: `^(BOOL succeeded, NSError *error)`.
+
+ @see createLocalIndexInBackgroundOnKey:forClassName:
+ */
++ (void)createLocalIndexInBackgroundOnKey:(NSString *)key
+                             forClassName:(NSString *)className
+                                    block:(nullable PFBooleanResultBlock)block;
+
+///--------------------------------------
+#pragma mark - Enumerating Objects from Local Datastore
+///--------------------------------------
+
+/**
+ *Asynchronously* enumerates the objects that match this query in the Local Datastore a page at a time,
+ without loading all of them into memory at once.
+
+ Objects are enumerated in no particular order, so the query must not be ordered. `skip` and `limit` apply to all pages.
+
+ @warning Requires Local Datastore to be enabled, and the query to be made with `fromLocalDatastore` or `fromPin`.
+
+ @param pageSize The maximum number of objects that are loaded from the Local Datastore for each page.
+ @param block    The block to execute serially, on a background thread, with every non-empty page of objects.
+ Set `stop` to `YES` to stop enumerating.
+ It should have the following argument signature: `^(NSArray *objects, BOOL *stop)`.
+
+ @return The task that will be completed once all objects are enumerated, or the enumeration is stopped.
+ */
+- (BFTask<NSNumber *> *)enumerateObjectsInBackgroundWithPageSize:(NSUInteger)pageSize
+                                                           block:(PFQueryEnumerationBlock)block;
+
+/**
+ *Asynchronously* enumerates the objects that match this query in the Local Datastore a page at a time,
+ and executes the given callback block once the enumeration is completed.
+
+ @param pageSize        The maximum number of objects that are loaded from the Local Datastore for each page.
+ @param block           The block to execute with every non-empty page of objects.
+ @param completionBlock The block to execute on the main thread once the enumeration is completed.
+ It should have the following argument signature: `^(BOOL succeeded, NSError *error)`.
+
+ @see enumerateObjectsInBackgroundWithPageSize:block:
+ */
+- (void)enumerateObjectsInBackgroundWithPageSize:(NSUInteger)pageSize
+                                           block:(PFQueryEnumerationBlock)block
+                                      completion:(nullable PFBooleanResultBlock)completionBlock;
+
 ///--------------------------------------
 #pragma mark - Advanced Settings
 ///--------------------------------------
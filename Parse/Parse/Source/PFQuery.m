@@ -14,9 +14,11 @@
 
 #if __has_include(<Bolts/BFCancellationTokenSource.h>)
 #import <Bolts/BFCancellationTokenSource.h>
+#import <Bolts/BFExecutor.h>
 #import <Bolts/BFTask.h>
 #else
 #import "BFCancellationTokenSource.h"
+#import "BFExecutor.h"
 #import "BFTask.h"
 #endif
 
@@ -31,6 +33,7 @@
 #import "PFMutableQueryState.h"
 #import "PFObject.h"
 #import "PFObjectPrivate.h"
+#import "PFOfflineQueryController.h"
 #import "PFOfflineStore.h"
 #import "PFPin.h"
 #import "PFQueryController.h"
@@ -801,7 +804,26 @@ static void PFQueryAssertValidOrderingClauseClass(id object) {
     }
 }
 
+- (BFTask *)findObjectsInBackgroundWithProgressiveResultsBlock:(PFQueryProgressiveResultsBlock)block {
+    PFParameterAssert(block, @"`block` should not be nil.");
+    PFQueryState *state = [self _queryStateCopy];
+
+    PFConsistencyAssert(state.cachePolicy != kPFCachePolicyCacheThenNetwork,
+                        @"kPFCachePolicyCacheThenNetwork can only be used with methods that have a callback.");
+    return [self _findObjectsAsyncForQueryState:state after:nil progressiveResultsBlock:^(NSArray *objects) {
+        [[BFExecutor mainThreadExecutor] execute:^{
+            block(objects);
+        }];
+    }];
+}
+
 - (BFTask *)_findObjectsAsyncForQueryState:(PFQueryState *)queryState after:(BFTask *)previous {
+    return [self _findObjectsAsyncForQueryState:queryState after:previous progressiveResultsBlock:nil];
+}
+
+- (BFTask *)_findObjectsAsyncForQueryState:(PFQueryState *)queryState
+                                     after:(BFTask *)previous
+                   progressiveResultsBlock:(void (^)(NSArray *objects))progressiveResultsBlock {
     BFCancellationTokenSource *cancellationTokenSource = _cancellationTokenSource;
     if (!previous) {
         cancellationTokenSource = [BFCancellationTokenSource cancellationTokenSource];
@@ -817,6 +839,12 @@ static void PFQueryAssertValidOrderingClauseClass(id object) {
         return [selfClass _getCurrentUserForQueryState:queryState];
     }] continueWithBlock:^id(BFTask *task) {
         PFUser *user = task.result;
+        if (progressiveResultsBlock) {
+            return [[selfClass queryController] findObjectsAsyncForQueryState:queryState
+                                                       withCancellationToken:cancellationTokenSource.token
+                                                                        user:user
+                                                     progressiveResultsBlock:progressiveResultsBlock];
+        }
         return [[selfClass queryController] findObjectsAsyncForQueryState:queryState
                                                    withCancellationToken:cancellationTokenSource.token
                                                                     user:user];
@@ -834,6 +862,54 @@ static void PFQueryAssertValidOrderingClauseClass(id object) {
     }];
 }
 
+///--------------------------------------
+#pragma mark - Enumerate Objects
+///--------------------------------------
+
+- (BFTask *)enumerateObjectsInBackgroundWithPageSize:(NSUInteger)pageSize block:(PFQueryEnumerationBlock)block {
+    PFParameterAssert(pageSize > 0, @"`pageSize` should be greater than 0.");
+    PFParameterAssert(block, @"`block` should not be nil.");
+    [self _checkPinningEnabled:YES];
+
+    PFQueryState *state = [self _queryStateCopy];
+    PFConsistencyAssert(state.queriesLocalDatastore,
+                        @"Only queries made with `fromLocalDatastore` or `fromPin` can be enumerated.");
+    PFConsistencyAssert(state.sortKeys.count == 0, @"Ordered queries can't be enumerated.");
+    [self _validateQueryState];
+
+    BFCancellationTokenSource *cancellationTokenSource = [BFCancellationTokenSource cancellationTokenSource];
+    [self markAsRunning:cancellationTokenSource];
+
+    Class selfClass = [self class];
+    @weakify(self);
+    return [[[[selfClass _getCurrentUserForQueryState:state] continueWithBlock:^id(BFTask *task) {
+        PFOfflineQueryController *controller = (PFOfflineQueryController *)[selfClass queryController];
+        return [controller enumerateObjectsAsyncForQueryState:state
+                                                     pageSize:pageSize
+                                        withCancellationToken:cancellationTokenSource.token
+                                                         user:task.result
+                                                        block:block];
+    }] continueWithSuccessResult:@YES] continueWithBlock:^id(BFTask *task) {
+        @strongify(self);
+        if (!self) {
+            return task;
+        }
+        @synchronized (self) {
+            if (self->_cancellationTokenSource == cancellationTokenSource) {
+                self->_cancellationTokenSource = nil;
+            }
+        }
+        return task;
+    }];
+}
+
+- (void)enumerateObjectsInBackgroundWithPageSize:(NSUInteger)pageSize
+                                           block:(PFQueryEnumerationBlock)block
+                                      completion:(PFBooleanResultBlock)completionBlock {
+    [[self enumerateObjectsInBackgroundWithPageSize:pageSize
+                                              block:block] thenCallBackOnMainThreadWithBoolValueAsync:completionBlock];
+}
+
 ///--------------------------------------
 #pragma mark - Get Object
 ///--------------------------------------
@@ -1056,6 +1132,26 @@ static void PFQueryAssertValidOrderingClauseClass(id object) {
     return self;
 }
 
+///--------------------------------------
+#pragma mark - Local Datastore Indexes
+///--------------------------------------
+
++ (BFTask<NSNumber *> *)createLocalIndexInBackgroundOnKey:(NSString *)key forClassName:(NSString *)className {
+    PFParameterAssert(className.length, @"`className` should not be empty.");
+    PFParameterAssert([key rangeOfString:@"^[A-Za-z][A-Za-z0-9_]*$" options:NSRegularExpressionSearch].location != NSNotFound,
+                      @"Invalid key name: %@", key);
+    PFConsistencyAssert([Parse _currentManager].offlineStoreLoaded, @"Method requires Pinning enabled.");
+
+    PFOfflineStore *store = [Parse _currentManager].offlineStore;
+    return [[store createIndexAsyncOnKey:key forClassName:className] continueWithSuccessResult:@YES];
+}
+
++ (void)createLocalIndexInBackgroundOnKey:(NSString *)key
+                             forClassName:(NSString *)className
+                                    block:(PFBooleanResultBlock)block {
+    [[self createLocalIndexInBackgroundOnKey:key forClassName:className] thenCallBackOnMainThreadWithBoolValueAsync:block];
+}
+
 ///--------------------------------------
 #pragma mark - Query State
 ///--------------------------------------
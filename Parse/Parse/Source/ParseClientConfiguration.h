@@ -67,6 +67,24 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign, getter=isLocalDatastoreEnabled) BOOL localDatastoreEnabled PF_TV_UNAVAILABLE;
 
+/**
+ Whether or not to keep the local datastore in write-ahead logging mode.
+
+ When enabled, local queries and fetches are not blocked by pinning and saving objects in the background.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, getter=isLocalDatastoreWriteAheadLoggingEnabled) BOOL localDatastoreWriteAheadLoggingEnabled PF_TV_UNAVAILABLE;
+
+/**
+ Whether or not to store objects in the local datastore in a compact binary format instead of JSON.
+
+ Objects already stored in either format can still be read, and are converted when they are saved again.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, getter=isLocalDatastoreBinaryEncodingEnabled) BOOL localDatastoreBinaryEncodingEnabled PF_TV_UNAVAILABLE;
+
 ///--------------------------------------
 #pragma mark - Enabling Extensions Data Sharing
 ///--------------------------------------
@@ -100,6 +118,40 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign) NSUInteger networkRetryAttempts;
 
+/**
+ Whether or not to compress large request bodies and ask the server for compressed responses.
+
+ Bodies of 1 KB or more are sent with `Content-Encoding: deflate`, which saves upload time for batch saves.
+ Your server must accept compressed request bodies.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, getter=isNetworkCompressionEnabled) BOOL networkCompressionEnabled;
+
+///--------------------------------------
+#pragma mark - Caching Query Results
+///--------------------------------------
+
+/**
+ Whether or not to store cached query results in a single file instead of a file per query.
+
+ This avoids file system calls on every cache hit, and works better with many cached queries.
+ Results cached with the other storage are not carried over.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, getter=isSingleFileQueryCacheEnabled) BOOL singleFileQueryCacheEnabled;
+
+/**
+ Whether or not to compress cached query results on disk.
+
+ Compressed results take several times less space, so many more of them fit in the cache.
+ Results cached either way can still be read.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, getter=isQueryCacheCompressionEnabled) BOOL queryCacheCompressionEnabled;
+
 @end
 
 /**
@@ -148,6 +200,24 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign, readonly, getter=isLocalDatastoreEnabled) BOOL localDatastoreEnabled;
 
+/**
+ Whether or not to keep the local datastore in write-ahead logging mode.
+
+ When enabled, local queries and fetches are not blocked by pinning and saving objects in the background.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, readonly, getter=isLocalDatastoreWriteAheadLoggingEnabled) BOOL localDatastoreWriteAheadLoggingEnabled;
+
+/**
+ Whether or not to store objects in the local datastore in a compact binary format instead of JSON.
+
+ Objects already stored in either format can still be read, and are converted when they are saved again.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, readonly, getter=isLocalDatastoreBinaryEncodingEnabled) BOOL localDatastoreBinaryEncodingEnabled;
+
 ///--------------------------------------
 #pragma mark - Enabling Extensions Data Sharing
 ///--------------------------------------
@@ -183,6 +253,37 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign, readonly) NSUInteger networkRetryAttempts;
 
+/**
+ Whether or not to compress large request bodies and ask the server for compressed responses.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, readonly, getter=isNetworkCompressionEnabled) BOOL networkCompressionEnabled;
+
+///--------------------------------------
+#pragma mark - Caching Query Results
+///--------------------------------------
+
+/**
+ Whether or not to store cached query results in a single file instead of a file per query.
+
+ This avoids file system calls on every cache hit, and works better with many cached queries.
+ Results cached with the other storage are not carried over.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, readonly, getter=isSingleFileQueryCacheEnabled) BOOL singleFileQueryCacheEnabled;
+
+/**
+ Whether or not to compress cached query results on disk.
+
+ Compressed results take several times less space, so many more of them fit in the cache.
+ Results cached either way can still be read.
+
+ The default value is `NO`.
+ */
+@property (nonatomic, assign, readonly, getter=isQueryCacheCompressionEnabled) BOOL queryCacheCompressionEnabled;
+
 ///--------------------------------------
 #pragma mark - Creating a Configuration
 ///--------------------------------------
@@ -116,10 +116,15 @@ NSString *const _ParseDefaultServerURLString = @"https://api.parse.com/1";
             [self.server isEqualToString:other.server] &&
             self.fileUploadController == other.fileUploadController &&
             self.localDatastoreEnabled == other.localDatastoreEnabled &&
+            self.localDatastoreWriteAheadLoggingEnabled == other.localDatastoreWriteAheadLoggingEnabled &&
+            self.localDatastoreBinaryEncodingEnabled == other.localDatastoreBinaryEncodingEnabled &&
             [PFObjectUtilities isObject:self.applicationGroupIdentifier equalToObject:other.applicationGroupIdentifier] &&
             [PFObjectUtilities isObject:self.containingApplicationBundleIdentifier equalToObject:other.containingApplicationBundleIdentifier] &&
             [PFObjectUtilities isObject:self.URLSessionConfiguration equalToObject:other.URLSessionConfiguration] &&
-            self.networkRetryAttempts == other.networkRetryAttempts);
+            self.networkRetryAttempts == other.networkRetryAttempts &&
+            self.networkCompressionEnabled == other.networkCompressionEnabled &&
+            self.singleFileQueryCacheEnabled == other.singleFileQueryCacheEnabled &&
+            self.queryCacheCompressionEnabled == other.queryCacheCompressionEnabled);
 }
 
 ///--------------------------------------
@@ -135,10 +140,15 @@ NSString *const _ParseDefaultServerURLString = @"https://api.parse.com/1";
     configuration->_server = [self.server copy];
     configuration->_fileUploadController = self->_fileUploadController;
     configuration->_localDatastoreEnabled = self->_localDatastoreEnabled;
+    configuration->_localDatastoreWriteAheadLoggingEnabled = self->_localDatastoreWriteAheadLoggingEnabled;
+    configuration->_localDatastoreBinaryEncodingEnabled = self->_localDatastoreBinaryEncodingEnabled;
     configuration->_applicationGroupIdentifier = [self->_applicationGroupIdentifier copy];
     configuration->_containingApplicationBundleIdentifier = [self->_containingApplicationBundleIdentifier copy];
     configuration->_networkRetryAttempts = self->_networkRetryAttempts;
+    configuration->_networkCompressionEnabled = self->_networkCompressionEnabled;
     configuration->_URLSessionConfiguration = self->_URLSessionConfiguration;
+    configuration->_singleFileQueryCacheEnabled = self->_singleFileQueryCacheEnabled;
+    configuration->_queryCacheCompressionEnabled = self->_queryCacheCompressionEnabled;
     return configuration;
 }
 
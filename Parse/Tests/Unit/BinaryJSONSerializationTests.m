@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import "PFBinaryJSONSerialization.h"
+#import "PFJSONSerialization.h"
+#import "PFTestCase.h"
+
+static NSUInteger const BinaryJSONSerializationTestsBenchmarkObjectsCount = 1000;
+
+@interface BinaryJSONSerializationTests : PFTestCase
+
+@end
+
+@implementation BinaryJSONSerializationTests
+
+///--------------------------------------
+#pragma mark - Helpers
+///--------------------------------------
+
+/**
+ Shaped like the REST dictionaries that the offline store keeps in its json column.
+ */
+- (NSDictionary *)storedObjectWithIndex:(NSUInteger)index {
+    NSString *objectId = [NSString stringWithFormat:@"obj%07lu", (unsigned long)index];
+    return @{ @"className" : @"Yarr",
+              @"objectId" : objectId,
+              @"createdAt" : @"2015-06-01T12:00:00.000Z",
+              @"updatedAt" : @"2015-06-02T08:30:15.123Z",
+              @"ACL" : @{ @"*" : @{ @"read" : @YES }, @"userId" : @{ @"read" : @YES, @"write" : @YES } },
+              @"__complete" : @YES,
+              @"__operations" : @[ @{ @"__uuid" : [NSUUID UUID].UUIDString } ],
+              @"isDeletingEventually" : @0,
+              @"name" : [NSString stringWithFormat:@"Object %lu", (unsigned long)index],
+              @"index" : @(index),
+              @"score" : @(index * 1.5),
+              @"negative" : @(-(long long)index),
+              @"tags" : @[ @"all", @"pirates", @"ships" ],
+              @"location" : @{ @"__type" : @"GeoPoint", @"latitude" : @37.77, @"longitude" : @-122.42 },
+              @"date" : @{ @"__type" : @"Date", @"iso" : @"2015-06-03T00:00:00.000Z" },
+              @"owner" : @{ @"__type" : @"OfflineObject", @"uuid" : [NSUUID UUID].UUIDString },
+              @"missing" : [NSNull null] };
+}
+
+///--------------------------------------
+#pragma mark - Tests
+///--------------------------------------
+
+- (void)testRoundTrip {
+    NSDictionary *object = [self storedObjectWithIndex:7];
+    NSData *data = [PFBinaryJSONSerialization dataFromJSONObject:object];
+    XCTAssertTrue([PFBinaryJSONSerialization isBinaryJSONData:data]);
+    XCTAssertEqualObjects([PFBinaryJSONSerialization JSONObjectFromData:data], object);
+}
+
+- (void)testRoundTripScalars {
+    NSArray *values = @[ @YES, @NO, @0, @1, @-1, @(INT64_MAX), @(INT64_MIN), @0.5, @-1e300,
+                         @"", @"ünïcødé \U0001F3F4", [NSNull null], @[], @{} ];
+    for (id value in values) {
+        id decoded = [PFBinaryJSONSerialization JSONObjectFromData:[PFBinaryJSONSerialization dataFromJSONObject:value]];
+        XCTAssertEqualObjects(decoded, value);
+    }
+
+    id decoded = [PFBinaryJSONSerialization JSONObjectFromData:[PFBinaryJSONSerialization dataFromJSONObject:@YES]];
+    XCTAssertEqual(CFGetTypeID((__bridge CFTypeRef)decoded), CFBooleanGetTypeID());
+    decoded = [PFBinaryJSONSerialization JSONObjectFromData:[PFBinaryJSONSerialization dataFromJSONObject:@1]];
+    XCTAssertNotEqual(CFGetTypeID((__bridge CFTypeRef)decoded), CFBooleanGetTypeID());
+}
+
+- (void)testRepeatedStringsAreStoredOnce {
+    NSMutableArray *objects = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [objects addObject:[self storedObjectWithIndex:i]];
+    }
+    NSData *binaryData = [PFBinaryJSONSerialization dataFromJSONObject:objects];
+    NSData *JSONData = [PFJSONSerialization dataFromJSONObject:objects];
+    XCTAssertLessThan(binaryData.length, JSONData.length);
+    XCTAssertEqualObjects([PFBinaryJSONSerialization JSONObjectFromData:binaryData], objects);
+}
+
+- (void)testJSONIsNotBinaryData {
+    NSData *data = [PFJSONSerialization dataFromJSONObject:[self storedObjectWithIndex:0]];
+    XCTAssertFalse([PFBinaryJSONSerialization isBinaryJSONData:data]);
+    XCTAssertFalse([PFBinaryJSONSerialization isBinaryJSONData:[NSData data]]);
+    XCTAssertNil([PFBinaryJSONSerialization JSONObjectFromData:data]);
+}
+
+- (void)testMalformedData {
+    NSData *data = [PFBinaryJSONSerialization dataFromJSONObject:[self storedObjectWithIndex:0]];
+    for (NSUInteger length = 5; length < data.length; length += 7) {
+        XCTAssertNil([PFBinaryJSONSerialization JSONObjectFromData:[data subdataWithRange:NSMakeRange(0, length)]]);
+    }
+
+    NSMutableData *trailingData = [data mutableCopy];
+    [trailingData appendBytes:"\0" length:1];
+    XCTAssertNil([PFBinaryJSONSerialization JSONObjectFromData:trailingData]);
+}
+
+- (void)testUnsupportedVersion {
+    NSMutableData *data = [[PFBinaryJSONSerialization dataFromJSONObject:@{ @"a" : @1 }] mutableCopy];
+    uint8_t version = PFBinaryJSONSerializationVersion + 1;
+    [data replaceBytesInRange:NSMakeRange(4, 1) withBytes:&version];
+    XCTAssertTrue([PFBinaryJSONSerialization isBinaryJSONData:data]);
+    XCTAssertNil([PFBinaryJSONSerialization JSONObjectFromData:data]);
+}
+
+- (void)testNonJSONObjectsThrow {
+    PFAssertThrowsInvalidArgumentException([PFBinaryJSONSerialization dataFromJSONObject:[NSDate date]]);
+    PFAssertThrowsInvalidArgumentException([PFBinaryJSONSerialization dataFromJSONObject:@{ @1 : @"a" }]);
+    PFAssertThrowsInvalidArgumentException([PFBinaryJSONSerialization dataFromJSONObject:@(NAN)]);
+}
+
+///--------------------------------------
+#pragma mark - Performance
+///--------------------------------------
+
+- (void)testJSONDecodePerformance {
+    NSMutableArray<NSData *> *datas = [NSMutableArray array];
+    for (NSUInteger i = 0; i < BinaryJSONSerializationTestsBenchmarkObjectsCount; i++) {
+        [datas addObject:[PFJSONSerialization dataFromJSONObject:[self storedObjectWithIndex:i]]];
+    }
+    [self measureBlock:^{
+        for (NSData *data in datas) {
+            XCTAssertNotNil([PFJSONSerialization JSONObjectFromData:data]);
+        }
+    }];
+}
+
+- (void)testBinaryDecodePerformance {
+    NSMutableArray<NSData *> *datas = [NSMutableArray array];
+    for (NSUInteger i = 0; i < BinaryJSONSerializationTestsBenchmarkObjectsCount; i++) {
+        [datas addObject:[PFBinaryJSONSerialization dataFromJSONObject:[self storedObjectWithIndex:i]]];
+    }
+    [self measureBlock:^{
+        for (NSData *data in datas) {
+            XCTAssertNotNil([PFBinaryJSONSerialization JSONObjectFromData:data]);
+        }
+    }];
+}
+
+@end
@@ -38,4 +38,20 @@
     XCTAssertEqualObjects(commandResult.httpResponse, response);
 }
 
+- (void)testResultStringFromData {
+    NSDictionary *result = @{ @"a" : @"b" };
+    NSData *resultData = [@"{\"a\":\"b\"}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] init];
+
+    PFCommandResult *commandResult = [PFCommandResult commandResultWithResult:result
+                                                                   resultData:resultData
+                                                                 httpResponse:response];
+    XCTAssertEqualObjects(commandResult.result, result);
+    XCTAssertEqualObjects(commandResult.resultString, @"{\"a\":\"b\"}");
+    XCTAssertEqualObjects(commandResult.httpResponse, response);
+
+    commandResult = [PFCommandResult commandResultWithResult:result resultData:nil httpResponse:response];
+    XCTAssertNil(commandResult.resultString);
+}
+
 @end
@@ -9,10 +9,13 @@
 
 #import <OCMock/OCMock.h>
 
+#import <compression.h>
+
 #import "BFTask+Private.h"
 #import "PFCommandRunningConstants.h"
 #import "PFCommandURLRequestConstructor.h"
 #import "PFHTTPRequest.h"
+#import "PFHTTPURLRequestConstructor.h"
 #import "PFInstallationIdentifierStore.h"
 #import "PFRESTCommand.h"
 #import "PFTestCase.h"
@@ -177,4 +180,49 @@
     XCTAssertEqualObjects(error.localizedDescription, @"Tried to save an object with a new, unsaved child.");
 }
 
+- (void)testCompressedBody {
+    NSMutableArray *objects = [NSMutableArray array];
+    for (int i = 0; i < 100; i++) {
+        [objects addObject:@{ @"objectId" : [NSString stringWithFormat:@"object%d", i], @"score" : @(i) }];
+    }
+    NSDictionary *parameters = @{ @"objects" : objects };
+    NSMutableURLRequest *request = [PFHTTPURLRequestConstructor urlRequestWithURL:[NSURL URLWithString:@"https://parse.com/123"]
+                                                                       httpMethod:PFHTTPRequestMethodPOST
+                                                                      httpHeaders:nil
+                                                                       parameters:parameters];
+    NSData *body = request.HTTPBody;
+    XCTAssertGreaterThanOrEqual(body.length, PFHTTPURLRequestMinimumCompressedBodyLength);
+
+    XCTAssertTrue([PFHTTPURLRequestConstructor compressBodyOfURLRequest:request]);
+    XCTAssertEqualObjects([request valueForHTTPHeaderField:PFHTTPRequestHeaderNameContentEncoding], @"deflate");
+    XCTAssertEqualObjects([NSURLProtocol propertyForKey:PFHTTPURLRequestUncompressedBodyLengthPropertyKey inRequest:request],
+                          @(body.length));
+    XCTAssertLessThan(request.HTTPBody.length, body.length);
+
+    // Skip the zlib header and the checksum to inflate the raw deflate data.
+    const uint8_t *bytes = request.HTTPBody.bytes;
+    XCTAssertEqual(bytes[0], 0x78);
+    NSMutableData *inflatedBody = [NSMutableData dataWithLength:body.length + 1];
+    size_t length = compression_decode_buffer(inflatedBody.mutableBytes, inflatedBody.length,
+                                              bytes + 2, request.HTTPBody.length - 6,
+                                              NULL, COMPRESSION_ZLIB);
+    inflatedBody.length = length;
+    XCTAssertEqualObjects(inflatedBody, body);
+    XCTAssertEqualObjects([NSJSONSerialization JSONObjectWithData:inflatedBody options:0 error:nil], parameters);
+
+    // Already compressed.
+    XCTAssertFalse([PFHTTPURLRequestConstructor compressBodyOfURLRequest:request]);
+}
+
+- (void)testSmallBodyIsNotCompressed {
+    NSMutableURLRequest *request = [PFHTTPURLRequestConstructor urlRequestWithURL:[NSURL URLWithString:@"https://parse.com/123"]
+                                                                       httpMethod:PFHTTPRequestMethodPOST
+                                                                      httpHeaders:nil
+                                                                       parameters:@{ @"a" : @"b" }];
+    NSData *body = request.HTTPBody;
+    XCTAssertFalse([PFHTTPURLRequestConstructor compressBodyOfURLRequest:request]);
+    XCTAssertNil([request valueForHTTPHeaderField:PFHTTPRequestHeaderNameContentEncoding]);
+    XCTAssertEqualObjects(request.HTTPBody, body);
+}
+
 @end
@@ -127,4 +127,39 @@
                           @"identifiers should be invariant to dictionary key orders");
 }
 
+- (void)testCacheKeysDistinguishParameters {
+    NSArray *parameters = @[ @{ @"a" : @"bc" },
+                             @{ @"ab" : @"c" },
+                             @{ @"a" : @[ @"b", @"c" ] },
+                             @{ @"a" : @[ @"bc" ] },
+                             @{ @"a" : @1 },
+                             @{ @"a" : @"1" },
+                             @{ @"a" : @YES },
+                             @{ @"a" : @1.5 },
+                             @{ @"a" : [NSNull null] },
+                             @{ @"a" : @{ @"b" : @"c" } } ];
+    NSMutableSet *cacheKeys = [NSMutableSet set];
+    for (NSDictionary *parameter in parameters) {
+        PFRESTCommand *command = [PFRESTCommand commandWithHTTPPath:@"foo"
+                                                         httpMethod:PFHTTPRequestMethodGET
+                                                         parameters:parameter
+                                                       sessionToken:nil
+                                                              error:nil];
+        [cacheKeys addObject:command.cacheKey];
+    }
+    XCTAssertEqual(cacheKeys.count, parameters.count);
+
+    PFRESTCommand *integerCommand = [PFRESTCommand commandWithHTTPPath:@"foo"
+                                                            httpMethod:PFHTTPRequestMethodGET
+                                                            parameters:@{ @"a" : @2 }
+                                                          sessionToken:nil
+                                                                 error:nil];
+    PFRESTCommand *doubleCommand = [PFRESTCommand commandWithHTTPPath:@"foo"
+                                                           httpMethod:PFHTTPRequestMethodGET
+                                                           parameters:@{ @"a" : @2.0 }
+                                                         sessionToken:nil
+                                                                error:nil];
+    XCTAssertEqualObjects(integerCommand.cacheKey, doubleCommand.cacheKey);
+}
+
 @end
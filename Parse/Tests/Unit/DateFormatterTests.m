@@ -58,4 +58,84 @@
     }
 }
 
+- (void)testKnownDates {
+    PFDateFormatter *formatter = [PFDateFormatter sharedFormatter];
+    NSDictionary<NSString *, NSNumber *> *dates = @{ @"1970-01-01T00:00:00.000Z" : @0,
+                                                     @"2013-12-16T00:00:00.500Z" : @1387152000.5,
+                                                     @"1969-12-31T23:59:58.500Z" : @-1.5,
+                                                     @"2000-02-29T00:00:00.000Z" : @951782400,
+                                                     @"2015-07-01T12:00:00.123Z" : @1435752000.123 };
+    [dates enumerateKeysAndObjectsUsingBlock:^(NSString *string, NSNumber *interval, BOOL *stop) {
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:interval.doubleValue];
+        XCTAssertEqualObjects([formatter preciseStringFromDate:date], string);
+        XCTAssertEqualWithAccuracy([formatter dateFromString:string].timeIntervalSince1970, interval.doubleValue, 0.0005);
+    }];
+}
+
+- (void)testParsingMatchesFallback {
+    PFDateFormatter *formatter = [PFDateFormatter sharedFormatter];
+    for (int i = 0; i < 5000; ++i) {
+        NSTimeInterval interval = arc4random_uniform(1387152000) + arc4random_uniform(1000) / 1000.0;
+        NSString *string = [formatter preciseStringFromDate:[NSDate dateWithTimeIntervalSince1970:interval]];
+
+        // More than three fractional digits always go through SQLite.
+        NSString *fallbackString = [string stringByReplacingOccurrencesOfString:@"Z" withString:@"0Z"];
+        XCTAssertEqualObjects([formatter dateFromString:string], [formatter dateFromString:fallbackString]);
+
+        NSString *secondsString = [[string substringToIndex:19] stringByAppendingString:@"Z"];
+        NSString *fallbackSecondsString = [[string substringToIndex:19] stringByAppendingString:@".0Z"];
+        XCTAssertEqualObjects([formatter dateFromString:secondsString], [formatter dateFromString:fallbackSecondsString]);
+    }
+}
+
+- (void)testOddDateStrings {
+    PFDateFormatter *formatter = [PFDateFormatter sharedFormatter];
+    XCTAssertEqualObjects([formatter dateFromString:@"2015-06-01"], [NSDate dateWithTimeIntervalSince1970:1433116800]);
+    XCTAssertEqualObjects([formatter dateFromString:@"2015-06-01T12:30Z"], [NSDate dateWithTimeIntervalSince1970:1433161800]);
+    XCTAssertEqualObjects([formatter dateFromString:@"2015-06-01 12:30:15Z"], [NSDate dateWithTimeIntervalSince1970:1433161815]);
+    // SQLite rolls days that are out of range over into the next month.
+    XCTAssertEqualObjects([formatter dateFromString:@"2015-02-30T00:00:00.000Z"],
+                          [formatter dateFromString:@"2015-03-02T00:00:00.000Z"]);
+}
+
+- (void)testConcurrentConversions {
+    PFDateFormatter *formatter = [PFDateFormatter sharedFormatter];
+    dispatch_apply(1000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:1387152000 + i * 3600.25];
+        NSString *string = [formatter preciseStringFromDate:date];
+        XCTAssertEqualObjects([formatter preciseStringFromDate:[formatter dateFromString:string]], string);
+    });
+}
+
+///--------------------------------------
+#pragma mark - Performance
+///--------------------------------------
+
+- (void)testDateFromStringPerformance {
+    PFDateFormatter *formatter = [PFDateFormatter sharedFormatter];
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    for (int i = 0; i < 10000; ++i) {
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:arc4random_uniform(1387152000) + i / 1000.0];
+        [strings addObject:[formatter preciseStringFromDate:date]];
+    }
+    [self measureBlock:^{
+        for (NSString *string in strings) {
+            [formatter dateFromString:string];
+        }
+    }];
+}
+
+- (void)testPreciseStringFromDatePerformance {
+    PFDateFormatter *formatter = [PFDateFormatter sharedFormatter];
+    NSMutableArray<NSDate *> *dates = [NSMutableArray array];
+    for (int i = 0; i < 10000; ++i) {
+        [dates addObject:[NSDate dateWithTimeIntervalSince1970:arc4random_uniform(1387152000) + i / 1000.0]];
+    }
+    [self measureBlock:^{
+        for (NSDate *date in dates) {
+            [formatter preciseStringFromDate:date];
+        }
+    }];
+}
+
 @end
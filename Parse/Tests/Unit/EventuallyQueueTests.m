@@ -0,0 +1,572 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import <OCMock/OCMock.h>
+
+@import Bolts;
+
+#import "PFCommandCache.h"
+#import "PFCommandCache_Private.h"
+#import "PFCommandResult.h"
+#import "PFCommandRunning.h"
+#import "PFCoreManager.h"
+#import "PFEventuallyQueue_Private.h"
+#import "PFHTTPRequest.h"
+#import "PFMockURLProtocol.h"
+#import "PFObjectLocalIdStore.h"
+#import "PFRESTCommand.h"
+#import "PFRESTObjectBatchCommand.h"
+#import "PFUnitTestCase.h"
+#import "Parse_Private.h"
+
+static NSUInteger const EventuallyQueueTestsBenchmarkCommandsCount = 1000;
+static unsigned long long const EventuallyQueueTestsDiskCacheSize = 10 * 1024 * 1024;
+
+@interface EventuallyQueueTests : PFUnitTestCase
+
+@property (nonatomic, strong) NSMutableArray<PFRESTCommand *> *runCommands;
+@property (nonatomic, strong) NSMutableArray<BFTaskCompletionSource *> *runTaskCompletionSources;
+
+@end
+
+@implementation EventuallyQueueTests
+
+///--------------------------------------
+#pragma mark - XCTestCase
+///--------------------------------------
+
+- (void)setUp {
+    [super setUp];
+
+    self.runCommands = [NSMutableArray array];
+    self.runTaskCompletionSources = [NSMutableArray array];
+}
+
+///--------------------------------------
+#pragma mark - Helpers
+///--------------------------------------
+
+- (NSString *)cachePath {
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+}
+
+- (PFCommandCache *)queueWithDataSource:(id<PFCommandRunnerProvider>)dataSource {
+    return [self queueWithDataSource:dataSource diskCachePath:[self cachePath]];
+}
+
+- (PFCommandCache *)queueWithDataSource:(id<PFCommandRunnerProvider>)dataSource diskCachePath:(NSString *)diskCachePath {
+    PFCommandCache *queue = [[PFCommandCache alloc] initWithDataSource:dataSource
+                                                        coreDataSource:[Parse _currentManager].coreManager
+                                                      maxAttemptsCount:PFEventuallyQueueDefaultMaxAttemptsCount
+                                                         retryInterval:PFEventuallyQueueDefaultTimeoutRetryInterval
+                                                         diskCachePath:diskCachePath
+                                                         diskCacheSize:EventuallyQueueTestsDiskCacheSize];
+    [queue start];
+    [queue pause];
+    queue.connected = YES;
+    return queue;
+}
+
+/**
+ Returns a data source whose runner records every command and leaves it running until the test finishes it.
+ */
+- (id<PFCommandRunnerProvider>)recordingDataSource {
+    id<PFCommandRunnerProvider> dataSource = PFStrictProtocolMock(@protocol(PFCommandRunnerProvider));
+    id<PFCommandRunning> runner = PFStrictProtocolMock(@protocol(PFCommandRunning));
+    OCMStub(dataSource.commandRunner).andReturn(runner);
+    OCMStub(runner.serverURL).andReturn([NSURL URLWithString:_ParseDefaultServerURLString]);
+
+    OCMStub([runner runCommandAsync:[OCMArg isNotNil] withOptions:0]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained PFRESTCommand *command = nil;
+        [invocation getArgument:&command atIndex:2];
+
+        BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+        @synchronized (self) {
+            [self.runCommands addObject:command];
+            [self.runTaskCompletionSources addObject:taskCompletionSource];
+        }
+
+        __autoreleasing BFTask *resultTask = taskCompletionSource.task;
+        [invocation setReturnValue:&resultTask];
+    });
+    return dataSource;
+}
+
+- (PFRESTCommand *)updateCommandForObjectId:(NSString *)objectId parameters:(NSDictionary *)parameters {
+    return [PFRESTCommand commandWithHTTPPath:[NSString stringWithFormat:@"classes/Yarr/%@", objectId]
+                                   httpMethod:PFHTTPRequestMethodPUT
+                                   parameters:parameters
+                                 sessionToken:nil
+                                        error:nil];
+}
+
+- (PFRESTCommand *)updateUserCommandForObjectId:(NSString *)objectId parameters:(NSDictionary *)parameters {
+    return [PFRESTCommand commandWithHTTPPath:[NSString stringWithFormat:@"users/%@", objectId]
+                                   httpMethod:PFHTTPRequestMethodPUT
+                                   parameters:parameters
+                                 sessionToken:nil
+                                        error:nil];
+}
+
+- (NSArray<BFTask *> *)enqueueCommands:(NSArray<PFRESTCommand *> *)commands intoQueue:(PFEventuallyQueue *)queue {
+    NSMutableArray<BFTask *> *tasks = [NSMutableArray arrayWithCapacity:commands.count];
+    for (PFRESTCommand *command in commands) {
+        [tasks addObject:[queue enqueueCommandInBackground:command]];
+    }
+    [self waitForCommandsCount:commands.count inQueue:queue];
+    return tasks;
+}
+
+/**
+ Returns the commands that are stored in the journal of the queue, from the oldest one.
+ */
+- (NSArray<PFRESTCommand *> *)pendingCommandsInQueue:(PFCommandCache *)queue {
+    id<PFEventuallyQueueSubclass> subclass = (id<PFEventuallyQueueSubclass>)queue;
+    NSMutableArray<PFRESTCommand *> *commands = [NSMutableArray array];
+    for (NSString *identifier in [subclass _pendingCommandIdentifiers]) {
+        [commands addObject:(PFRESTCommand *)[subclass _commandWithIdentifier:identifier error:nil]];
+    }
+    return commands;
+}
+
+- (NSData *)JSONDataForCommand:(PFRESTCommand *)command {
+    return [NSJSONSerialization dataWithJSONObject:[command dictionaryRepresentation:nil] options:0 error:nil];
+}
+
+- (void)waitForCommandsCount:(NSUInteger)count inQueue:(PFEventuallyQueue *)queue {
+    NSPredicate *predicate = [NSPredicate predicateWithBlock:^BOOL(PFEventuallyQueue *queue, NSDictionary *bindings) {
+        return ([queue _commandsInMemory] == (int)count);
+    }];
+    [self expectationForPredicate:predicate evaluatedWithObject:queue handler:nil];
+    [self waitForTestExpectations];
+}
+
+- (void)waitForRunCommandsCount:(NSUInteger)count {
+    NSPredicate *predicate = [NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        @synchronized (self) {
+            return (self.runCommands.count == count);
+        }
+    }];
+    [self expectationForPredicate:predicate evaluatedWithObject:self handler:nil];
+    [self waitForTestExpectations];
+}
+
+- (void)finishRunCommandAtIndex:(NSUInteger)index {
+    [self finishRunCommandAtIndex:index withResult:@{ @"index" : @(index) }];
+}
+
+- (void)finishRunCommandAtIndex:(NSUInteger)index withResult:(id)result {
+    BFTaskCompletionSource *taskCompletionSource = nil;
+    @synchronized (self) {
+        taskCompletionSource = self.runTaskCompletionSources[index];
+    }
+    taskCompletionSource.result = [PFCommandResult commandResultWithResult:result resultString:nil httpResponse:nil];
+}
+
+- (void)failRunCommandAtIndex:(NSUInteger)index {
+    BFTaskCompletionSource *taskCompletionSource = nil;
+    @synchronized (self) {
+        taskCompletionSource = self.runTaskCompletionSources[index];
+    }
+    taskCompletionSource.error = [NSError errorWithDomain:NSURLErrorDomain
+                                                     code:NSURLErrorTimedOut
+                                                 userInfo:@{ @"temporary" : @YES }];
+}
+
+///--------------------------------------
+#pragma mark - Tests
+///--------------------------------------
+
+- (void)testIndependentCommandsRunConcurrently {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateUserCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                              [self updateUserCommandForObjectId:@"b" parameters:@{ @"k" : @1 }],
+                                              [self updateUserCommandForObjectId:@"c" parameters:@{ @"k" : @1 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:3];
+    for (NSUInteger i = 0; i < 3; i++) {
+        [self finishRunCommandAtIndex:i];
+    }
+    XCTAssertNotNil([[BFTask taskForCompletionOfAllTasks:tasks] waitForResult:nil]);
+    for (BFTask *task in tasks) {
+        XCTAssertNotNil(task.result);
+    }
+
+    [queue terminate];
+}
+
+- (void)testCommandsForSameObjectRunInOrder {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateUserCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                              [self updateUserCommandForObjectId:@"b" parameters:@{ @"k" : @1 }],
+                                              [self updateUserCommandForObjectId:@"a" parameters:@{ @"k" : @2 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:2];
+    XCTAssertEqualObjects(self.runCommands[0].httpPath, @"users/a");
+    XCTAssertEqualObjects(self.runCommands[1].httpPath, @"users/b");
+
+    [self finishRunCommandAtIndex:1];
+    [tasks[1] waitUntilFinished];
+    XCTAssertEqual(self.runCommands.count, 2);
+
+    [self finishRunCommandAtIndex:0];
+    [self waitForRunCommandsCount:3];
+    XCTAssertEqualObjects(self.runCommands[2].httpPath, @"users/a");
+    XCTAssertEqualObjects(self.runCommands[2].parameters, @{ @"k" : @2 });
+
+    [self finishRunCommandAtIndex:2];
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+
+    [queue terminate];
+}
+
+- (void)testCommandsWithUnknownTargetsRunAlone {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    PFRESTCommand *functionCommand = [PFRESTCommand commandWithHTTPPath:@"functions/yarr"
+                                                             httpMethod:PFHTTPRequestMethodPOST
+                                                             parameters:nil
+                                                           sessionToken:nil
+                                                                  error:nil];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                              functionCommand,
+                                              [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:1];
+    [self finishRunCommandAtIndex:0];
+    [self waitForRunCommandsCount:2];
+    XCTAssertEqualObjects(self.runCommands[1].httpPath, @"functions/yarr");
+
+    [self finishRunCommandAtIndex:1];
+    [self waitForRunCommandsCount:3];
+    [self finishRunCommandAtIndex:2];
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+
+    [queue terminate];
+}
+
+- (void)testConsecutiveUpdatesAreCoalesced {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSDictionary *increment = @{ @"__op" : @"Increment", @"amount" : @1 };
+    NSArray *tasks = [self enqueueCommands:@[ [self updateCommandForObjectId:@"a" parameters:@{ @"name" : @"yarr" }],
+                                              [self updateCommandForObjectId:@"a" parameters:@{ @"score" : @1 }],
+                                              [self updateCommandForObjectId:@"a" parameters:@{ @"score" : increment }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:1];
+    XCTAssertEqualObjects(self.runCommands[0].parameters, (@{ @"name" : @"yarr", @"score" : @1 }));
+    [self finishRunCommandAtIndex:0];
+
+    // Field operations on the same key can't be folded into a single update.
+    [self waitForRunCommandsCount:2];
+    XCTAssertEqualObjects(self.runCommands[1].parameters, @{ @"score" : increment });
+    [self finishRunCommandAtIndex:1];
+
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+    XCTAssertEqualObjects([tasks[0] result], [tasks[1] result]);
+    XCTAssertNotEqualObjects([tasks[1] result], [tasks[2] result]);
+    XCTAssertEqual([queue _commandsInMemory], 0);
+    XCTAssertEqual(queue.commandCount, 0);
+
+    [queue terminate];
+}
+
+- (void)testIndependentUpdatesAreBatched {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                              [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }],
+                                              [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @2 }],
+                                              [self updateCommandForObjectId:@"c" parameters:@{ @"k" : @1 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    // The second update of `a` has to wait for the first one, but `c` can go along.
+    [self waitForRunCommandsCount:1];
+    NSArray *requests = self.runCommands[0].parameters[@"requests"];
+    XCTAssertEqualObjects(self.runCommands[0].httpPath, @"batch");
+    XCTAssertEqualObjects([requests valueForKey:@"path"], (@[ @"/1/classes/Yarr/a", @"/1/classes/Yarr/b", @"/1/classes/Yarr/c" ]));
+
+    [self finishRunCommandAtIndex:0 withResult:@[ @{ @"success" : @{ @"updatedAt" : @"yesterday" } },
+                                                  @{ @"error" : @{ @"code" : @(kPFErrorObjectNotFound), @"error" : @"yarr" } },
+                                                  @{ @"success" : @{ @"updatedAt" : @"today" } } ]];
+    [self waitForRunCommandsCount:2];
+    XCTAssertEqualObjects(self.runCommands[1].httpPath, @"classes/Yarr/a");
+    [self finishRunCommandAtIndex:1];
+
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+    XCTAssertEqualObjects([[tasks[0] result] result], @{ @"updatedAt" : @"yesterday" });
+    XCTAssertEqual([tasks[1] error].code, kPFErrorObjectNotFound);
+    XCTAssertEqualObjects([[tasks[2] result] result], @{ @"index" : @1 });
+    XCTAssertEqualObjects([[tasks[3] result] result], @{ @"updatedAt" : @"today" });
+    XCTAssertEqual(queue.commandCount, 0);
+
+    [queue terminate];
+}
+
+- (void)testBatchesWaitForLocalIds {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSString *localId = [[Parse _currentManager].coreManager.objectLocalIdStore createLocalId];
+    PFRESTCommand *createCommand = [PFRESTCommand commandWithHTTPPath:@"classes/Yarr"
+                                                           httpMethod:PFHTTPRequestMethodPOST
+                                                           parameters:@{ @"k" : @1 }
+                                                         sessionToken:nil
+                                                                error:nil];
+    createCommand.localId = localId;
+    NSDictionary *pointer = @{ @"__type" : @"Pointer", @"className" : @"Yarr", @"localId" : localId };
+    NSArray *tasks = [self enqueueCommands:@[ createCommand,
+                                              [self updateCommandForObjectId:@"a" parameters:@{ @"owner" : pointer }],
+                                              [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:1];
+    NSArray *requests = self.runCommands[0].parameters[@"requests"];
+    XCTAssertEqualObjects([requests valueForKey:@"path"], (@[ @"/1/classes/Yarr", @"/1/classes/Yarr/b" ]));
+    [self finishRunCommandAtIndex:0 withResult:@[ @{ @"success" : @{ @"objectId" : @"yolo" } },
+                                                  @{ @"success" : @{} } ]];
+
+    [self waitForRunCommandsCount:2];
+    XCTAssertEqualObjects(self.runCommands[1].httpPath, @"classes/Yarr/a");
+    XCTAssertEqualObjects(self.runCommands[1].parameters[@"owner"][@"objectId"], @"yolo");
+    [self finishRunCommandAtIndex:1];
+
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+    XCTAssertEqual(queue.commandCount, 0);
+
+    [queue terminate];
+}
+
+- (void)testFailedCommandsAreRetriedWithoutHoldingBackOthers {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    [queue _setRetryInterval:0.5];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateUserCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                              [self updateUserCommandForObjectId:@"b" parameters:@{ @"k" : @1 }],
+                                              [self updateUserCommandForObjectId:@"a" parameters:@{ @"k" : @2 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:2];
+    [self failRunCommandAtIndex:0];
+    [self finishRunCommandAtIndex:1];
+    XCTAssertNotNil([tasks[1] waitForResult:nil]);
+    XCTAssertNotNil(queue.nextRetryDate);
+
+    // The second update of `a` waits for the first one to succeed.
+    [self waitForRunCommandsCount:3];
+    XCTAssertEqualObjects(self.runCommands[2].httpPath, @"users/a");
+    XCTAssertEqualObjects(self.runCommands[2].parameters, @{ @"k" : @1 });
+    [self finishRunCommandAtIndex:2];
+
+    [self waitForRunCommandsCount:4];
+    XCTAssertEqualObjects(self.runCommands[3].parameters, @{ @"k" : @2 });
+    [self finishRunCommandAtIndex:3];
+
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+    XCTAssertNil(queue.nextRetryDate);
+    XCTAssertEqual(queue.commandCount, 0);
+
+    [queue terminate];
+}
+
+- (void)testFailedCreateWithoutLocalIdHoldsBackLaterCommands {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    [queue _setRetryInterval:0.5];
+    PFRESTCommand *createCommand = [PFRESTCommand commandWithHTTPPath:@"classes/Yarr"
+                                                           httpMethod:PFHTTPRequestMethodPOST
+                                                           parameters:@{ @"k" : @1 }
+                                                         sessionToken:nil
+                                                                error:nil];
+    NSArray *tasks = [self enqueueCommands:@[ createCommand,
+                                              [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:1];
+    [self failRunCommandAtIndex:0];
+
+    // Nothing tells which object the create is for, so the update waits for its retry.
+    [self waitForRunCommandsCount:2];
+    XCTAssertEqualObjects(self.runCommands[1].httpPath, @"classes/Yarr");
+    [self finishRunCommandAtIndex:1];
+
+    [self waitForRunCommandsCount:3];
+    XCTAssertEqualObjects(self.runCommands[2].httpPath, @"classes/Yarr/b");
+    [self finishRunCommandAtIndex:2];
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+
+    [queue terminate];
+}
+
+- (void)testReconnectingRetriesFailedCommandsRightAway {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateUserCommandForObjectId:@"a" parameters:@{ @"k" : @1 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:1];
+    [self failRunCommandAtIndex:0];
+
+    NSPredicate *predicate = [NSPredicate predicateWithBlock:^BOOL(PFEventuallyQueue *queue, NSDictionary *bindings) {
+        return (queue.nextRetryDate != nil);
+    }];
+    [self expectationForPredicate:predicate evaluatedWithObject:queue handler:nil];
+    [self waitForTestExpectations];
+
+    queue.connected = NO;
+    queue.connected = YES;
+    [self waitForRunCommandsCount:2];
+    [self finishRunCommandAtIndex:1];
+    XCTAssertNotNil([tasks[0] waitForResult:nil]);
+
+    [queue terminate];
+}
+
+///--------------------------------------
+#pragma mark - Journal
+///--------------------------------------
+
+- (void)testImportsCommandFiles {
+    NSString *cachePath = [self cachePath];
+    XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:cachePath
+                                            withIntermediateDirectories:YES
+                                                             attributes:nil
+                                                                  error:nil]);
+    // Previous versions saved every command to a file of its own.
+    NSArray<PFRESTCommand *> *commands = @[ [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                            [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }] ];
+    [commands enumerateObjectsUsingBlock:^(PFRESTCommand *command, NSUInteger index, BOOL *stop) {
+        NSString *fileName = [NSString stringWithFormat:@"Command-%016lx-00000000-%lu",
+                              (unsigned long)index, (unsigned long)index];
+        XCTAssertTrue([[self JSONDataForCommand:command] writeToFile:[cachePath stringByAppendingPathComponent:fileName]
+                                                          atomically:YES]);
+    }];
+    XCTAssertTrue([[NSData data] writeToFile:[cachePath stringByAppendingPathComponent:@"Garbage"] atomically:YES]);
+
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource] diskCachePath:cachePath];
+    NSArray<PFRESTCommand *> *pendingCommands = [self pendingCommandsInQueue:queue];
+    XCTAssertEqualObjects([pendingCommands valueForKey:@"httpPath"], (@[ @"classes/Yarr/a", @"classes/Yarr/b" ]));
+
+    // The files are removed once the commands are in the journal, other files are left alone.
+    NSArray<NSString *> *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:cachePath error:nil];
+    XCTAssertEqual([fileNames filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF BEGINSWITH 'Command'"]].count, 0);
+    XCTAssertTrue([fileNames containsObject:@"Garbage"]);
+
+    [queue terminate];
+}
+
+- (void)testFinishedCommandsAreRemovedFromJournal {
+    NSString *cachePath = [self cachePath];
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource] diskCachePath:cachePath];
+    NSArray *tasks = [self enqueueCommands:@[ [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                              [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @2 }] ]
+                                 intoQueue:queue];
+    [queue resume];
+
+    [self waitForRunCommandsCount:1];
+    [self finishRunCommandAtIndex:0];
+    XCTAssertNotNil([tasks[0] waitForResult:nil]);
+    [self waitForRunCommandsCount:2];
+
+    // Another process reading the journal doesn't see the finished command.
+    PFCommandCache *otherQueue = [self queueWithDataSource:[self recordingDataSource] diskCachePath:cachePath];
+    XCTAssertEqualObjects([[self pendingCommandsInQueue:otherQueue] valueForKey:@"parameters"], (@[ @{ @"k" : @2 } ]));
+    [otherQueue terminate];
+
+    [self finishRunCommandAtIndex:1];
+    XCTAssertNotNil([tasks[1] waitForResult:nil]);
+    XCTAssertEqual(queue.commandCount, 0);
+
+    [queue terminate];
+}
+
+- (void)testEnqueueDropsOldestCommandsWhenFull {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    NSArray<PFRESTCommand *> *commands = @[ [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                                            [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }],
+                                            [self updateCommandForObjectId:@"c" parameters:@{ @"k" : @1 }] ];
+    NSUInteger commandSize = [self JSONDataForCommand:commands.firstObject].length;
+    [queue _setDiskCacheSize:commandSize * 2 + commandSize / 2];
+
+    for (PFRESTCommand *command in commands) {
+        [queue enqueueCommandInBackground:command];
+    }
+    // Waits for every command to be saved.
+    [queue _simulateReboot];
+
+    NSArray<PFRESTCommand *> *pendingCommands = [self pendingCommandsInQueue:queue];
+    XCTAssertEqualObjects([pendingCommands valueForKey:@"httpPath"], (@[ @"classes/Yarr/b", @"classes/Yarr/c" ]));
+
+    [queue terminate];
+}
+
+- (void)testJournalIsReopenedAfterReboot {
+    PFCommandCache *queue = [self queueWithDataSource:[self recordingDataSource]];
+    [self enqueueCommands:@[ [self updateCommandForObjectId:@"a" parameters:@{ @"k" : @1 }],
+                             [self updateCommandForObjectId:@"b" parameters:@{ @"k" : @1 }] ]
+                intoQueue:queue];
+
+    [queue _simulateReboot];
+    XCTAssertEqual(queue.commandCount, 2);
+
+    // The reopened journal keeps taking commands after the ones that were read from disk.
+    [self enqueueCommands:@[ [self updateCommandForObjectId:@"c" parameters:@{ @"k" : @1 }] ] intoQueue:queue];
+    NSArray<PFRESTCommand *> *pendingCommands = [self pendingCommandsInQueue:queue];
+    XCTAssertEqualObjects([pendingCommands valueForKey:@"httpPath"],
+                          (@[ @"classes/Yarr/a", @"classes/Yarr/b", @"classes/Yarr/c" ]));
+
+    [queue terminate];
+}
+
+///--------------------------------------
+#pragma mark - Performance
+///--------------------------------------
+
+- (void)testReplayPerformance {
+    NSString *result = @"{\"updatedAt\":\"2015-06-01T12:00:00.000Z\"}";
+    NSMutableArray<NSString *> *batchResults = [NSMutableArray array];
+    for (NSUInteger i = 0; i < PFRESTObjectBatchCommandSubcommandsLimit; i++) {
+        [batchResults addObject:[NSString stringWithFormat:@"{\"success\":%@}", result]];
+    }
+    NSString *batchResult = [NSString stringWithFormat:@"[%@]", [batchResults componentsJoinedByString:@","]];
+    [PFMockURLProtocol mockRequestsWithResponse:^PFMockURLResponse *(NSURLRequest *request) {
+        BOOL isBatch = [request.URL.lastPathComponent isEqualToString:@"batch"];
+        return [PFMockURLResponse responseWithString:(isBatch ? batchResult : result)
+                                          statusCode:200
+                                               delay:0.002];
+    }];
+
+    NSMutableArray<PFRESTCommand *> *commands = [NSMutableArray array];
+    for (NSUInteger i = 0; i < EventuallyQueueTestsBenchmarkCommandsCount; i++) {
+        NSString *objectId = [NSString stringWithFormat:@"obj%04lu", (unsigned long)i];
+        [commands addObject:[self updateCommandForObjectId:objectId parameters:@{ @"index" : @(i) }]];
+    }
+
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        PFCommandCache *queue = [self queueWithDataSource:[Parse _currentManager]];
+        NSArray *tasks = [self enqueueCommands:commands intoQueue:queue];
+
+        [self startMeasuring];
+        [queue resume];
+        [[BFTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+        [self stopMeasuring];
+
+        XCTAssertEqual(queue.commandCount, 0);
+        [queue terminate];
+    }];
+
+    [PFMockURLProtocol removeAllMocking];
+}
+
+@end
@@ -33,4 +33,24 @@
                           PFMD5HashFromData([@"foo \327\220" dataUsingEncoding:NSUTF8StringEncoding]));
 }
 
+- (void)testHash128 {
+    XCTAssertEqualObjects(@"00000000000000000000000000000000", PFHash128FromString(@""));
+    XCTAssertEqualObjects(@"0e617feb46603f53b163eb607d4697ab", PFHash128FromString(@"hello world"));
+    XCTAssertEqualObjects(@"5991bce80e088d89029e897af32f232b", PFHash128FromString(@"foo א"));
+    XCTAssertEqualObjects(@"6c1b07bc7bbc4be347939ac4a93c437a",
+                          PFHash128FromString(@"The quick brown fox jumps over the lazy dog"));
+}
+
+- (void)testHash128Incremental {
+    const char *string = "The quick brown fox jumps over the lazy dog";
+    for (size_t chunkLength = 1; chunkLength <= 17; chunkLength++) {
+        PFHash128Context context;
+        PFHash128Init(&context);
+        for (size_t offset = 0; offset < strlen(string); offset += chunkLength) {
+            PFHash128Update(&context, string + offset, MIN(chunkLength, strlen(string) - offset));
+        }
+        XCTAssertEqualObjects(@"6c1b07bc7bbc4be347939ac4a93c437a", PFHash128Final(&context));
+    }
+}
+
 @end
@@ -9,12 +9,48 @@
 
 #import <OCMock/OCMock.h>
 
+#import "PFKeyValueCacheCodec.h"
+#import "PFKeyValueCacheLog.h"
 #import "PFKeyValueCache_Private.h"
 #import "PFMacros.h"
 #import "PFTestCase.h"
 #import "TestCache.h"
 #import "TestFileManager.h"
 
+/**
+ Holds every file write until it is opened, so tests can keep the disk queue busy.
+ */
+@interface KeyValueCacheTestsBlockingFileManager : TestFileManager
+
+- (void)open;
+
+@end
+
+@implementation KeyValueCacheTestsBlockingFileManager {
+    dispatch_semaphore_t _gate;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) return nil;
+
+    _gate = dispatch_semaphore_create(0);
+
+    return self;
+}
+
+- (void)open {
+    dispatch_semaphore_signal(_gate);
+}
+
+- (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)data attributes:(NSDictionary *)attr {
+    dispatch_semaphore_wait(_gate, DISPATCH_TIME_FOREVER);
+    dispatch_semaphore_signal(_gate);
+    return [super createFileAtPath:path contents:data attributes:attr];
+}
+
+@end
+
 @interface KeyValueCacheTests : PFTestCase
 @end
 
@@ -32,6 +68,31 @@
     return [NSURL URLWithString:[self sampleDirectoryPath]];
 }
 
+- (NSURL *)uniqueDirectoryURL {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    return [NSURL fileURLWithPath:path isDirectory:YES];
+}
+
+/**
+ A JSON string shaped like a cached query result, which compresses well.
+ */
+- (NSString *)sampleQueryResultString {
+    NSMutableString *string = [NSMutableString stringWithString:@"{\"results\":["];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [string appendFormat:@"%@{\"objectId\":\"obj%05lu\",\"className\":\"Yarr\",\"createdAt\":\"2015-06-01T12:00:00.000Z\"}",
+         (i == 0 ? @"" : @","), (unsigned long)i];
+    }
+    [string appendString:@"]}"];
+    return string;
+}
+
+- (PFKeyValueCache *)logCacheWithDirectoryURL:(NSURL *)url {
+    return [[PFKeyValueCache alloc] initWithCacheDirectoryURL:url
+                                                  fileManager:[NSFileManager defaultManager]
+                                                  memoryCache:nil
+                                                      storage:PFKeyValueCacheStorageLog];
+}
+
 ///--------------------------------------
 #pragma mark - XCTestCase
 ///--------------------------------------
@@ -174,4 +235,440 @@
 
     [cache waitForOutstandingOperations];
 }
+
+- (void)testAsyncGet {
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:[self sampleDirectoryURL]
+                                                                    fileManager:[TestFileManager fileManager]
+                                                                    memoryCache:nil];
+    [cache setObject:@"value" forKey:@"key1"];
+
+    XCTestExpectation *expectation = [self currentSelectorTestExpectation];
+    [cache objectForKey:@"key1" maxAge:INFINITY completion:^(NSString *value) {
+        XCTAssertFalse([NSThread isMainThread]);
+        XCTAssertEqualObjects(value, @"value");
+        [expectation fulfill];
+    }];
+    [self waitForTestExpectations];
+
+    expectation = [self expectationWithDescription:@"missing"];
+    [cache objectForKey:@"key2" maxAge:INFINITY completion:^(NSString *value) {
+        XCTAssertNil(value);
+        [expectation fulfill];
+    }];
+    [self waitForTestExpectations];
+
+    [cache waitForOutstandingOperations];
+}
+
+- (void)testReadsDontWaitForDiskWrites {
+    KeyValueCacheTestsBlockingFileManager *fileManager = [[KeyValueCacheTestsBlockingFileManager alloc] init];
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:[self sampleDirectoryURL]
+                                                                    fileManager:(NSFileManager *)fileManager
+                                                                    memoryCache:nil];
+    [cache setObject:@"value1" forKey:@"key1"];
+    [cache setObject:@"value2" forKey:@"key2"];
+    [cache setObject:@"value3" forKey:@"key2"];
+    [cache removeObjectForKey:@"key1"];
+
+    // The disk queue is stuck on the first write, and reads still see every change.
+    XCTAssertNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertEqualObjects([cache objectForKey:@"key2" maxAge:INFINITY], @"value3");
+
+    [fileManager open];
+    [cache waitForOutstandingOperations];
+
+    XCTAssertNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertEqualObjects([cache objectForKey:@"key2" maxAge:INFINITY], @"value3");
+}
+
+- (void)testFilesStorageEvictsLeastRecentlyUsed {
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:[self sampleDirectoryURL]
+                                                                    fileManager:[TestFileManager fileManager]
+                                                                    memoryCache:nil];
+    cache.maxDiskCacheRecords = 2;
+
+    [cache setObject:@"value" forKey:@"key1"];
+    [cache setObject:@"value" forKey:@"key2"];
+    [cache waitForOutstandingOperations];
+
+    XCTAssertNotNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    [cache setObject:@"value" forKey:@"key3"];
+    [cache waitForOutstandingOperations];
+
+    XCTAssertNotNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertNil([cache objectForKey:@"key2" maxAge:INFINITY]);
+    XCTAssertNotNil([cache objectForKey:@"key3" maxAge:INFINITY]);
+
+    [cache waitForOutstandingOperations];
+}
+
+- (void)testFilesStorageCountsRewrittenKeysOnce {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:url
+                                                                    fileManager:[NSFileManager defaultManager]
+                                                                    memoryCache:nil];
+    cache.maxDiskCacheRecords = 2;
+
+    [cache setObject:@"value" forKey:@"key1"];
+    [cache setObject:@"value" forKey:@"key2"];
+    [cache setObject:@"value" forKey:@"key2"];
+    [cache waitForOutstandingOperations];
+
+    XCTAssertNotNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertNotNil([cache objectForKey:@"key2" maxAge:INFINITY]);
+
+    [cache removeAllObjects];
+}
+
+#pragma mark Compression
+
+- (void)testCompressionCodecs {
+    NSData *data = [[self sampleQueryResultString] dataUsingEncoding:NSUTF8StringEncoding];
+    for (id<PFKeyValueCacheCodec> codec in @[ [PFKeyValueCacheCompressionCodec zlibCodec],
+                                              [PFKeyValueCacheCompressionCodec lz4Codec] ]) {
+        NSData *compressedData = [codec compressedDataFromData:data];
+        XCTAssertLessThan(compressedData.length, data.length);
+        XCTAssertEqualObjects([codec dataFromCompressedData:compressedData uncompressedLength:data.length], data);
+        XCTAssertNil([codec dataFromCompressedData:compressedData uncompressedLength:data.length - 1]);
+        XCTAssertNil([codec dataFromCompressedData:compressedData uncompressedLength:data.length + 1]);
+        XCTAssertEqual([PFKeyValueCacheCompressionCodec codecWithIdentifier:codec.identifier].identifier, codec.identifier);
+
+        // Short values don't get any smaller.
+        XCTAssertNil([codec compressedDataFromData:[@"{}" dataUsingEncoding:NSUTF8StringEncoding]]);
+    }
+    XCTAssertNil([PFKeyValueCacheCompressionCodec codecWithIdentifier:0]);
+}
+
+- (void)testCompressedValues {
+    NSFileManager *fileManager = [TestFileManager fileManager];
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:[self sampleDirectoryURL]
+                                                                    fileManager:fileManager
+                                                                    memoryCache:nil];
+    cache.codec = [PFKeyValueCacheCompressionCodec zlibCodec];
+
+    NSString *value = [self sampleQueryResultString];
+    [cache setObject:value forKey:@"key1"];
+    [cache setObject:@"short" forKey:@"key2"];
+    [cache waitForOutstandingOperations];
+
+    NSUInteger storedLength = [fileManager contentsAtPath:[self.sampleDirectoryPath stringByAppendingPathComponent:@"key1"]].length;
+    XCTAssertLessThan(storedLength, value.length / 2);
+
+    XCTAssertEqualObjects([cache objectForKey:@"key1" maxAge:INFINITY], value);
+    XCTAssertEqualObjects([cache objectForKey:@"key2" maxAge:INFINITY], @"short");
+
+    PFKeyValueCacheStatistics *statistics = cache.statistics;
+    XCTAssertEqual(statistics.writtenValuesCount, 2);
+    XCTAssertEqual(statistics.compressedValuesCount, 1);
+    XCTAssertEqual(statistics.uncompressedBytes, value.length + 5);
+    XCTAssertEqual(statistics.storedBytes, storedLength + 5);
+    XCTAssertGreaterThan(statistics.compressionRatio, 2.0);
+    XCTAssertEqual(statistics.decodingFailuresCount, 0);
+
+    // Values stay readable when the codec changes.
+    cache.codec = nil;
+    XCTAssertEqualObjects([cache objectForKey:@"key1" maxAge:INFINITY], value);
+    cache.codec = [PFKeyValueCacheCompressionCodec lz4Codec];
+    XCTAssertEqualObjects([cache objectForKey:@"key1" maxAge:INFINITY], value);
+}
+
+- (void)testCorruptedCompressedValue {
+    NSFileManager *fileManager = [TestFileManager fileManager];
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:[self sampleDirectoryURL]
+                                                                    fileManager:fileManager
+                                                                    memoryCache:nil];
+    cache.codec = [PFKeyValueCacheCompressionCodec zlibCodec];
+
+    const uint8_t bytes[] = { 0x00, 'P', 'F', 'Z', PFKeyValueCacheCompressionCodecIdentifierZlib, 100, 0, 0, 0, 1, 2, 3 };
+    NSString *path = [self.sampleDirectoryPath stringByAppendingPathComponent:@"key1"];
+    [fileManager createFileAtPath:path contents:[NSData dataWithBytes:bytes length:sizeof(bytes)] attributes:nil];
+
+    XCTAssertNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertEqual(cache.statistics.decodingFailuresCount, 1);
+
+    [cache waitForOutstandingOperations];
+    XCTAssertNil([fileManager contentsAtPath:path]);
+}
+
+- (void)testLogStorageCompression {
+    PFKeyValueCache *cache = [self logCacheWithDirectoryURL:[self uniqueDirectoryURL]];
+    cache.codec = [PFKeyValueCacheCompressionCodec lz4Codec];
+
+    NSString *value = [self sampleQueryResultString];
+    [cache setObject:value forKey:@"key1"];
+    [cache waitForOutstandingOperations];
+
+    XCTAssertEqualObjects([cache objectForKey:@"key1" maxAge:INFINITY], value);
+    XCTAssertEqual(cache.statistics.compressedValuesCount, 1);
+
+    [cache removeAllObjects];
+}
+
+#pragma mark Log Storage
+
+- (void)testLogStorage {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCache *cache = [self logCacheWithDirectoryURL:url];
+    XCTAssertEqual(cache.storage, PFKeyValueCacheStorageLog);
+
+    [cache setObject:@"value1" forKey:@"key1"];
+    [cache setObject:@"value2" forKey:@"key2"];
+    [cache setObject:@"value3" forKey:@"key2"];
+
+    XCTAssertEqualObjects([cache objectForKey:@"key1" maxAge:INFINITY], @"value1");
+    XCTAssertEqualObjects([cache objectForKey:@"key2" maxAge:INFINITY], @"value3");
+
+    [cache removeObjectForKey:@"key1"];
+    XCTAssertNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertNil([cache objectForKey:@"key2" maxAge:0]);
+    XCTAssertNil([cache objectForKey:@"key2" maxAge:INFINITY]);
+
+    [cache removeAllObjects];
+    [cache setObject:@"value" forKey:@"key"];
+    XCTAssertEqualObjects([cache objectForKey:@"key" maxAge:INFINITY], @"value");
+    [cache removeAllObjects];
+}
+
+- (void)testLogStorageIsPersistent {
+    NSURL *url = [self uniqueDirectoryURL];
+    @autoreleasepool {
+        PFKeyValueCache *cache = [self logCacheWithDirectoryURL:url];
+        [cache setObject:@"value1" forKey:@"key1"];
+        [cache setObject:@"value2" forKey:@"key2"];
+        [cache removeObjectForKey:@"key1"];
+        [cache waitForOutstandingOperations];
+    }
+
+    PFKeyValueCache *cache = [self logCacheWithDirectoryURL:url];
+    XCTAssertNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertEqualObjects([cache objectForKey:@"key2" maxAge:INFINITY], @"value2");
+    [cache removeAllObjects];
+}
+
+- (void)testLogStorageRecoversFromTornWrites {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCacheLog *log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    [log setString:@"value1" forKey:@"key1" creationDate:[NSDate date]];
+    [log setString:@"value2" forKey:@"key2" creationDate:[NSDate date]];
+    [log close];
+
+    // Records appended after the index was written are replayed, up to the first torn one.
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    [log setString:@"value3" forKey:@"key3" creationDate:[NSDate date]];
+    log = nil;
+
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:[url URLByAppendingPathComponent:@"cache.log"]
+                                                                 error:NULL];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:[@"torn record" dataUsingEncoding:NSUTF8StringEncoding]];
+    [fileHandle closeFile];
+
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    XCTAssertEqual(log.count, 3);
+    XCTAssertEqualObjects([log stringForKey:@"key1" creationDate:NULL], @"value1");
+    XCTAssertEqualObjects([log stringForKey:@"key3" creationDate:NULL], @"value3");
+
+    [log setString:@"value4" forKey:@"key4" creationDate:[NSDate date]];
+    log = nil;
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    XCTAssertEqualObjects([log stringForKey:@"key4" creationDate:NULL], @"value4");
+    [log close];
+    [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+}
+
+- (void)testLogStorageDiscardsCorruptValues {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCacheLog *log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    [log setString:@"value1" forKey:@"key1" creationDate:[NSDate date]];
+    [log setString:@"value2" forKey:@"key2" creationDate:[NSDate date]];
+    [log close];
+
+    // The index trusts the records it points to, so only reading a value finds out that it's corrupt.
+    NSString *path = [url URLByAppendingPathComponent:@"cache.log"].path;
+    NSMutableData *data = [NSMutableData dataWithContentsOfFile:path];
+    NSRange range = [data rangeOfData:[@"value1" dataUsingEncoding:NSUTF8StringEncoding] options:0 range:NSMakeRange(0, data.length)];
+    XCTAssertNotEqual(range.location, NSNotFound);
+    [data replaceBytesInRange:range withBytes:"VALUE1"];
+    XCTAssertTrue([data writeToFile:path atomically:YES]);
+
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    XCTAssertEqual(log.count, 2);
+    XCTAssertNil([log stringForKey:@"key1" creationDate:NULL]);
+    XCTAssertEqualObjects([log stringForKey:@"key2" creationDate:NULL], @"value2");
+    XCTAssertEqual(log.count, 1);
+    [log close];
+
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    XCTAssertEqualObjects(log.keys, @[ @"key2" ]);
+    [log close];
+    [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+}
+
+- (void)testLogStorageCompaction {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCacheLog *log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    NSString *value = [@"" stringByPaddingToLength:10 * 1024 withString:@"value" startingAtIndex:0];
+    for (int i = 0; i < 1000; i++) {
+        [log setString:value forKey:[NSString stringWithFormat:@"key%d", i % 10] creationDate:[NSDate date]];
+    }
+    XCTAssertEqual(log.count, 10);
+    XCTAssertEqual(log.size, 10 * value.length);
+
+    NSString *path = [url URLByAppendingPathComponent:@"cache.log"].path;
+    unsigned long long fileSize = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL].fileSize;
+    XCTAssertLessThan(fileSize, 1024 * 1024);
+    XCTAssertEqualObjects([log stringForKey:@"key5" creationDate:NULL], value);
+    [log close];
+
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    XCTAssertEqual(log.count, 10);
+    XCTAssertEqualObjects([log stringForKey:@"key9" creationDate:NULL], value);
+    [log close];
+    [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+}
+
+- (void)testLogStorageEvictsLeastRecentlyUsed {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCache *cache = [self logCacheWithDirectoryURL:url];
+    cache.maxDiskCacheRecords = 2;
+
+    [cache setObject:@"value" forKey:@"key1"];
+    [cache setObject:@"value" forKey:@"key2"];
+    XCTAssertNotNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    [cache setObject:@"value" forKey:@"key3"];
+
+    XCTAssertNotNil([cache objectForKey:@"key1" maxAge:INFINITY]);
+    XCTAssertNil([cache objectForKey:@"key2" maxAge:INFINITY]);
+    XCTAssertNotNil([cache objectForKey:@"key3" maxAge:INFINITY]);
+    [cache removeAllObjects];
+}
+
+- (void)testRemovalNotifications {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCache *cache = [self logCacheWithDirectoryURL:url];
+    cache.maxDiskCacheRecords = 2;
+
+    NSMutableArray *removals = [NSMutableArray array];
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:PFKeyValueCacheDidRemoveValuesNotification
+                                                                    object:cache
+                                                                     queue:nil
+                                                                usingBlock:^(NSNotification *notification) {
+        @synchronized(removals) {
+            [removals addObject:notification.userInfo[PFKeyValueCacheRemovedKeysUserInfoKey] ?: [NSNull null]];
+        }
+    }];
+
+    [cache setObject:@"value" forKey:@"key1"];
+    [cache setObject:@"value" forKey:@"key2"];
+    [cache setObject:@"value" forKey:@"key3"];
+    [cache waitForOutstandingOperations];
+    [cache removeObjectForKey:@"key2"];
+    [cache removeAllObjects];
+
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    NSArray *expectedRemovals = @[ @[ @"key1" ], @[ @"key2" ], [NSNull null] ];
+    XCTAssertEqualObjects(removals, expectedRemovals);
+}
+
+- (void)testLogStorageKeepsInsertionOrderWithoutReads {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCacheLog *log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    [log setString:@"value1" forKey:@"key1" creationDate:[NSDate date]];
+    [log setString:@"value2" forKey:@"key2" creationDate:[NSDate date]];
+    [log setString:@"value3" forKey:@"key3" creationDate:[NSDate date]];
+
+    XCTAssertEqualObjects([log peekDataForKey:@"key1"], [@"value1" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(log.keys, (@[ @"key1", @"key2", @"key3" ]));
+
+    [log removeStringForKey:@"key2"];
+    XCTAssertEqualObjects(log.keys, (@[ @"key1", @"key3" ]));
+
+    [log removeAllValues];
+    XCTAssertEqual(log.count, 0);
+    [log close];
+
+    log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    XCTAssertEqual(log.count, 0);
+    [log close];
+    [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+}
+
+- (void)testLogStorageSynchronizesWithOtherWriters {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCacheLog *log = [PFKeyValueCacheLog logWithDirectoryURL:url];
+    PFKeyValueCacheLog *otherLog = [PFKeyValueCacheLog logWithDirectoryURL:url];
+
+    [log setString:@"value1" forKey:@"key1" creationDate:[NSDate date]];
+    [otherLog synchronize];
+    [otherLog setString:@"value2" forKey:@"key2" creationDate:[NSDate date]];
+    [otherLog removeStringForKey:@"key1"];
+
+    [log synchronize];
+    XCTAssertEqualObjects(log.keys, @[ @"key2" ]);
+    XCTAssertEqualObjects([log stringForKey:@"key2" creationDate:NULL], @"value2");
+
+    // Compaction replaces the data file.
+    NSString *value = [@"" stringByPaddingToLength:10 * 1024 withString:@"value" startingAtIndex:0];
+    for (int i = 0; i < 100; i++) {
+        [log setString:value forKey:[NSString stringWithFormat:@"key%d", i % 10] creationDate:[NSDate date]];
+    }
+    [otherLog synchronize];
+    XCTAssertEqual(otherLog.count, 10);
+    XCTAssertEqualObjects([otherLog stringForKey:@"key9" creationDate:NULL], value);
+
+    [otherLog removeAllValues];
+    [log synchronize];
+    XCTAssertEqual(log.count, 0);
+
+    [log close];
+    [otherLog close];
+    [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+}
+
+#pragma mark Performance
+
+/**
+ Sets twice as many entries as the cache holds, so half of the sets evict an entry, then gets every key.
+ */
+- (void)measureThroughputWithStorage:(PFKeyValueCacheStorage)storage entriesCount:(NSUInteger)count {
+    NSURL *url = [self uniqueDirectoryURL];
+    PFKeyValueCache *cache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:url
+                                                                    fileManager:[NSFileManager defaultManager]
+                                                                    memoryCache:nil
+                                                                        storage:storage];
+    cache.maxDiskCacheRecords = count;
+
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:count * 2];
+    for (NSUInteger i = 0; i < count * 2; i++) {
+        [keys addObject:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+    }
+    NSString *value = [@"" stringByPaddingToLength:512 withString:@"value" startingAtIndex:0];
+
+    [self measureBlock:^{
+        for (NSString *key in keys) {
+            [cache setObject:value forKey:key];
+        }
+        for (NSString *key in keys) {
+            [cache objectForKey:key maxAge:INFINITY];
+        }
+        [cache removeAllObjects];
+    }];
+}
+
+- (void)testFilesStoragePerformanceWith1000Entries {
+    [self measureThroughputWithStorage:PFKeyValueCacheStorageFiles entriesCount:1000];
+}
+
+- (void)testFilesStoragePerformanceWith10000Entries {
+    [self measureThroughputWithStorage:PFKeyValueCacheStorageFiles entriesCount:10000];
+}
+
+- (void)testLogStoragePerformanceWith1000Entries {
+    [self measureThroughputWithStorage:PFKeyValueCacheStorageLog entriesCount:1000];
+}
+
+- (void)testLogStoragePerformanceWith10000Entries {
+    [self measureThroughputWithStorage:PFKeyValueCacheStorageLog entriesCount:10000];
+}
+
 @end
@@ -14,6 +14,8 @@
 #import "PFSQLiteDatabase.h"
 #import "PFUnitTestCase.h"
 
+static NSUInteger const OfflineQueryLogicUnitTestsBenchmarkObjectsCount = 10000;
+
 @interface OfflineQueryLogicUnitTests : PFUnitTestCase {
     PFUser *_user;
 }
@@ -1533,6 +1535,137 @@
     [task waitUntilFinished];
 }
 
+- (void)testPredicate {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+
+    PFObject *object = [PFObject objectWithClassName:@"Object"];
+    object[@"foo"] = @"bar";
+    object[@"sum"] = @1337;
+    object[@"ArrezTheGodOfWar"] = @[@"bar", @1337];
+
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    [query whereKey:@"foo" equalTo:@"bar"];
+    [query whereKey:@"sum" greaterThan:@1000];
+    [query whereKey:@"sum" lessThanOrEqualTo:@1337];
+    [query whereKey:@"ArrezTheGodOfWar" containsAllObjectsInArray:@[@1337]];
+    PFConstraintPredicateBlock predicateBlock = [logic createPredicateForQueryState:query.state user:_user];
+    NSError *error = nil;
+    XCTAssertTrue(predicateBlock(object, &error));
+    XCTAssertNil(error);
+
+    PFQuery *query1 = [PFQuery queryWithClassName:@"Object"];
+    [query1 whereKey:@"foo" equalTo:@"baz"];
+    PFQuery *query2 = [PFQuery queryWithClassName:@"Object"];
+    [query2 whereKey:@"sum" lessThan:@1337];
+    query = [PFQuery orQueryWithSubqueries:@[query1, query2]];
+    predicateBlock = [logic createPredicateForQueryState:query.state user:_user];
+    XCTAssertFalse(predicateBlock(object, &error));
+    XCTAssertNil(error);
+}
+
+- (void)testPredicateWithSubquery {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+
+    PFQuery *innerQuery = [PFQuery queryWithClassName:@"Inner"];
+    [innerQuery whereKey:@"foo" equalTo:@"bar"];
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    [query whereKey:@"inner" matchesQuery:innerQuery];
+    XCTAssertNil([logic createPredicateForQueryState:query.state user:_user]);
+
+    query = [PFQuery orQueryWithSubqueries:@[ query, [PFQuery queryWithClassName:@"Object"] ]];
+    XCTAssertNil([logic createPredicateForQueryState:query.state user:_user]);
+}
+
+- (void)testPredicateWithInvalidConstraint {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+
+    PFObject *object = [PFObject objectWithClassName:@"Object"];
+    object[@"foo"] = @"bar";
+
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    [query whereKey:@"foo" containsAllObjectsInArray:@[@"bar"]];
+    PFConstraintPredicateBlock predicateBlock = [logic createPredicateForQueryState:query.state user:_user];
+    NSError *error = nil;
+    XCTAssertFalse(predicateBlock(object, &error));
+    XCTAssertEqual(error.code, kPFErrorInvalidQuery);
+}
+
+#pragma mark Benchmarks
+
+- (NSArray<PFObject *> *)benchmarkObjects {
+    NSMutableArray<PFObject *> *objects = [NSMutableArray array];
+    for (NSUInteger i = 0; i < OfflineQueryLogicUnitTestsBenchmarkObjectsCount; i++) {
+        PFObject *object = [PFObject objectWithClassName:@"Object"];
+        object[@"index"] = @(i);
+        object[@"name"] = [NSString stringWithFormat:@"Object %lu", (unsigned long)i];
+        object[@"tags"] = @[ @"a", @(i % 10) ];
+        object[@"flag"] = @(i % 2 == 0);
+        [objects addObject:object];
+    }
+    return objects;
+}
+
+- (PFQuery *)benchmarkQuery {
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    [query whereKey:@"index" greaterThanOrEqualTo:@0];
+    [query whereKey:@"name" hasPrefix:@"Object"];
+    [query whereKey:@"tags" containedIn:@[ @"a", @"b" ]];
+    [query whereKey:@"flag" equalTo:@YES];
+    [query whereKeyExists:@"tags"];
+    return query;
+}
+
+- (void)testMatcherPerformance {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+    PFSQLiteDatabase *database = [[PFSQLiteDatabase alloc] init];
+    NSArray<PFObject *> *objects = [self benchmarkObjects];
+    PFQueryState *state = [self benchmarkQuery].state;
+    PFUser *user = _user;
+
+    [self measureBlock:^{
+        PFConstraintMatcherBlock matcherBlock = [logic createMatcherForQueryState:state user:user];
+        NSUInteger matchesCount = 0;
+        for (PFObject *object in objects) {
+            matchesCount += [[matcherBlock(object, database) waitForResult:nil] boolValue];
+        }
+        XCTAssertEqual(matchesCount, OfflineQueryLogicUnitTestsBenchmarkObjectsCount / 2);
+    }];
+}
+
+- (void)testPredicatePerformance {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+    NSArray<PFObject *> *objects = [self benchmarkObjects];
+    PFQueryState *state = [self benchmarkQuery].state;
+    PFUser *user = _user;
+
+    [self measureBlock:^{
+        PFConstraintPredicateBlock predicateBlock = [logic createPredicateForQueryState:state user:user];
+        NSUInteger matchesCount = 0;
+        for (PFObject *object in objects) {
+            matchesCount += predicateBlock(object, nil);
+        }
+        XCTAssertEqual(matchesCount, OfflineQueryLogicUnitTestsBenchmarkObjectsCount / 2);
+    }];
+}
+
+- (void)testSortWithLimitPerformance {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+    NSArray<PFObject *> *objects = [self benchmarkObjects];
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    [query orderByDescending:@"index"];
+    query.limit = 20;
+    PFQueryState *state = query.state;
+
+    [self measureBlock:^{
+        NSArray<PFObject *> *results = [logic resultsByApplyingOptions:(PFOfflineQueryOptionOrder |
+                                                                        PFOfflineQueryOptionLimit)
+                                                          ofQueryState:state
+                                                             toResults:objects];
+        XCTAssertEqual([results.firstObject[@"index"] unsignedIntegerValue],
+                       OfflineQueryLogicUnitTestsBenchmarkObjectsCount - 1);
+    }];
+}
+
 - (void)testSortDate {
     PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
 
@@ -1631,4 +1764,75 @@
     XCTAssertEqual(results.count, strippedArray.count);
 }
 
+- (void)testSortWithSkipAndLimit {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+
+    NSMutableArray<PFObject *> *objects = [NSMutableArray array];
+    for (int i = 0; i < 100; ++i) {
+        PFObject *object = [PFObject objectWithClassName:@"Object"];
+        object[@"id"] = @(i);
+        if (i % 10 != 0) {
+            object[@"num"] = @((i * 37) % 17);
+        }
+        [objects addObject:object];
+    }
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    [query orderByDescending:@"num"];
+    query.skip = 5;
+    query.limit = 20;
+
+    NSArray *all = [logic resultsByApplyingOptions:PFOfflineQueryOptionOrder
+                                      ofQueryState:query.state
+                                         toResults:objects];
+    NSArray *page = [logic resultsByApplyingOptions:(PFOfflineQueryOptionOrder |
+                                                     PFOfflineQueryOptionSkip |
+                                                     PFOfflineQueryOptionLimit)
+                                       ofQueryState:query.state
+                                          toResults:objects];
+    // Objects with equal values keep the order in which they were matched.
+    XCTAssertEqualObjects(page, [all subarrayWithRange:NSMakeRange(5, 20)]);
+
+    query.skip = 90;
+    page = [logic resultsByApplyingOptions:(PFOfflineQueryOptionOrder |
+                                            PFOfflineQueryOptionSkip |
+                                            PFOfflineQueryOptionLimit)
+                              ofQueryState:query.state
+                                 toResults:objects];
+    // Objects without a value are sorted last.
+    XCTAssertEqualObjects(page, [all subarrayWithRange:NSMakeRange(90, 10)]);
+    XCTAssertNil(page.lastObject[@"num"]);
+
+    query.limit = 0;
+    page = [logic resultsByApplyingOptions:(PFOfflineQueryOptionOrder | PFOfflineQueryOptionLimit)
+                              ofQueryState:query.state
+                                 toResults:objects];
+    XCTAssertEqual(page.count, 0);
+}
+
+- (void)testResultsCollectorSaturation {
+    PFOfflineQueryLogic *logic = [[PFOfflineQueryLogic alloc] init];
+    PFQuery *query = [PFQuery queryWithClassName:@"Object"];
+    query.skip = 1;
+    query.limit = 2;
+    PFOfflineQueryOption options = (PFOfflineQueryOptionOrder | PFOfflineQueryOptionSkip | PFOfflineQueryOptionLimit);
+
+    PFOfflineQueryResultsCollector *collector = [logic resultsCollectorWithOptions:options ofQueryState:query.state];
+    NSMutableArray<PFObject *> *objects = [NSMutableArray array];
+    for (int i = 0; i < 3; ++i) {
+        XCTAssertFalse(collector.saturated);
+        [objects addObject:[PFObject objectWithClassName:@"Object"]];
+        [collector addObject:objects.lastObject];
+    }
+    XCTAssertTrue(collector.saturated);
+    XCTAssertEqualObjects(collector.results, [objects subarrayWithRange:NSMakeRange(1, 2)]);
+
+    // Ordered queries need to see every object.
+    [query orderByAscending:@"num"];
+    collector = [logic resultsCollectorWithOptions:options ofQueryState:query.state];
+    for (PFObject *object in objects) {
+        [collector addObject:object];
+    }
+    XCTAssertFalse(collector.saturated);
+}
+
 @end
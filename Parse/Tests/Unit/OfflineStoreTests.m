@@ -0,0 +1,456 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+@import Bolts;
+
+#import "BFTask+Private.h"
+#import "PFObjectPrivate.h"
+#import "PFOfflineStore.h"
+#import "PFQueryPrivate.h"
+#import "PFUnitTestCase.h"
+#import "Parse_Private.h"
+
+static NSUInteger const OfflineStoreTestsBenchmarkObjectsCount = 500;
+
+@interface OfflineStoreTests : PFUnitTestCase
+
+@end
+
+@implementation OfflineStoreTests
+
+///--------------------------------------
+#pragma mark - XCTestCase
+///--------------------------------------
+
+- (void)setUp {
+    [super setUp];
+
+    [[Parse _currentManager] clearEventuallyQueue];
+    [Parse _clearCurrentManager];
+    [Parse enableLocalDatastore];
+    [Parse setApplicationId:self.applicationId clientKey:self.clientKey];
+}
+
+///--------------------------------------
+#pragma mark - Helpers
+///--------------------------------------
+
+- (PFOfflineStore *)offlineStore {
+    return [Parse _currentManager].offlineStore;
+}
+
+- (NSArray<PFObject *> *)objectsWithClassName:(NSString *)className count:(NSUInteger)count {
+    NSMutableArray<PFObject *> *objects = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        PFObject *object = [PFObject objectWithClassName:className];
+        object[@"index"] = @(i);
+        object[@"name"] = [NSString stringWithFormat:@"Object %lu", (unsigned long)i];
+        object[@"createdOn"] = [NSDate dateWithTimeIntervalSince1970:i];
+        [objects addObject:object];
+    }
+    return objects;
+}
+
+///--------------------------------------
+#pragma mark - Tests
+///--------------------------------------
+
+- (void)testPinAndFind {
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:10];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    NSError *error = nil;
+    XCTAssertEqual([query findObjects:&error].count, 10);
+    XCTAssertNil(error);
+}
+
+- (void)testConcurrentFindsWhilePinning {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:10] error:nil]);
+
+    PFQueryState *state = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore].state;
+
+    NSMutableArray<BFTask *> *tasks = [NSMutableArray array];
+    for (int i = 0; i < 8; i++) {
+        [tasks addObject:[self.offlineStore findAsyncForQueryState:state user:nil pin:nil]];
+        if (i % 2 == 0) {
+            PFObject *object = [PFObject objectWithClassName:@"Yarr"];
+            [tasks addObject:[self.offlineStore saveObjectLocallyAsync:object includeChildren:YES]];
+        }
+    }
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitForResult:nil withMainThreadWarning:NO];
+
+    for (BFTask *task in tasks) {
+        XCTAssertNil(task.error);
+    }
+    NSArray *results = [[self.offlineStore findAsyncForQueryState:state user:nil pin:nil] waitForResult:nil
+                                                                                 withMainThreadWarning:NO];
+    XCTAssertEqual(results.count, 14);
+}
+
+- (void)testConcurrentFindsWhilePinningWithWriteAheadLogging {
+    PFFileManager *fileManager = [Parse _currentManager].fileManager;
+    PFOfflineStore *store = [[PFOfflineStore alloc] initWithFileManager:fileManager
+                                                                options:PFOfflineStoreOptionWriteAheadLogging];
+    [store clearDatabase];
+
+    PFQueryState *state = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore].state;
+
+    NSMutableArray<BFTask *> *tasks = [NSMutableArray array];
+    for (int i = 0; i < 8; i++) {
+        [tasks addObject:[store saveObjectLocallyAsync:[PFObject objectWithClassName:@"Yarr"] includeChildren:YES]];
+        [tasks addObject:[store findAsyncForQueryState:state user:nil pin:nil]];
+    }
+    [[BFTask taskForCompletionOfAllTasks:tasks] waitForResult:nil withMainThreadWarning:NO];
+
+    for (BFTask *task in tasks) {
+        XCTAssertNil(task.error);
+    }
+    NSArray *results = [[store findAsyncForQueryState:state user:nil pin:nil] waitForResult:nil
+                                                                     withMainThreadWarning:NO];
+    XCTAssertEqual(results.count, 8);
+    [store clearDatabase];
+}
+
+- (void)testBinaryEncodingReadsBothFormats {
+    PFFileManager *fileManager = [Parse _currentManager].fileManager;
+    PFOfflineStore *JSONStore = [[PFOfflineStore alloc] initWithFileManager:fileManager options:0];
+    [JSONStore clearDatabase];
+    for (PFObject *object in [self objectsWithClassName:@"Yarr" count:4]) {
+        [[JSONStore saveObjectLocallyAsync:object includeChildren:YES] waitForResult:nil withMainThreadWarning:NO];
+    }
+
+    PFQueryState *state = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] orderByAscending:@"index"].state;
+
+    // Rows stored as JSON are read, and the ones that are saved again are stored in the binary format.
+    PFOfflineStore *binaryStore = [[PFOfflineStore alloc] initWithFileManager:fileManager
+                                                                      options:PFOfflineStoreOptionBinaryEncoding];
+    NSArray<PFObject *> *results = [[binaryStore findAsyncForQueryState:state user:nil pin:nil] waitForResult:nil
+                                                                                        withMainThreadWarning:NO];
+    XCTAssertEqual(results.count, 4);
+    for (NSUInteger i = 0; i < 2; i++) {
+        XCTAssertEqualObjects(results[i][@"name"], ([NSString stringWithFormat:@"Object %lu", (unsigned long)i]));
+        results[i][@"name"] = @"Migrated";
+        [[binaryStore saveObjectLocallyAsync:results[i] includeChildren:YES] waitForResult:nil withMainThreadWarning:NO];
+    }
+
+    // Turning the option off doesn't lose the objects stored in the binary format.
+    JSONStore = [[PFOfflineStore alloc] initWithFileManager:fileManager options:0];
+    results = [[JSONStore findAsyncForQueryState:state user:nil pin:nil] waitForResult:nil withMainThreadWarning:NO];
+    XCTAssertEqual(results.count, 4);
+    XCTAssertEqualObjects(results[0][@"name"], @"Migrated");
+    XCTAssertEqualObjects(results[1][@"name"], @"Migrated");
+    XCTAssertEqualObjects(results[2][@"name"], @"Object 2");
+    XCTAssertEqualObjects(results[3][@"createdOn"], [NSDate dateWithTimeIntervalSince1970:3]);
+    [JSONStore clearDatabase];
+}
+
+- (void)testClearDatabaseReopensConnections {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:3] error:nil]);
+
+    [self.offlineStore clearDatabase];
+    [self.offlineStore simulateReboot];
+
+    PFQueryState *state = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore].state;
+    NSError *error = nil;
+    NSArray *results = [[self.offlineStore findAsyncForQueryState:state user:nil pin:nil] waitForResult:&error
+                                                                                 withMainThreadWarning:NO];
+    XCTAssertNil(error);
+    XCTAssertEqual(results.count, 0);
+}
+
+- (void)testPinManyObjects {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"tags" forClassName:@"Yarr"] waitForResult:nil]);
+    // More rows than fit in a single statement.
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:1200];
+    for (PFObject *object in objects) {
+        object[@"tags"] = @[ @"all", object[@"name"] ];
+    }
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+    XCTAssertTrue([PFObject pinAll:[objects subarrayWithRange:NSMakeRange(0, 10)] withName:@"Pirates" error:nil]);
+    [self.offlineStore simulateReboot];
+
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    [query whereKey:@"tags" equalTo:@"all"];
+    XCTAssertEqual([query countObjects:nil], 1200);
+
+    query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"tags" equalTo:@"Object 1100"];
+    XCTAssertEqual([[query getFirstObject:nil][@"index"] integerValue], 1100);
+
+    query = [[[PFQuery queryWithClassName:@"Yarr"] fromPinWithName:@"Pirates"] ignoreACLs];
+    XCTAssertEqual([query countObjects:nil], 10);
+}
+
+#pragma mark Indexes
+
+- (void)testIndexedFind {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"index" forClassName:@"Yarr"] waitForResult:nil]);
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"createdOn" forClassName:@"Yarr"] waitForResult:nil]);
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:20] error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" greaterThanOrEqualTo:@5];
+    [query whereKey:@"index" lessThan:@10];
+    XCTAssertEqual([query findObjects:nil].count, 5);
+
+    query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" containedIn:@[ @1, @3, @100 ]];
+    XCTAssertEqual([query findObjects:nil].count, 2);
+
+    query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"createdOn" lessThan:[NSDate dateWithTimeIntervalSince1970:3]];
+    [query whereKey:@"name" hasPrefix:@"Object"];
+    XCTAssertEqual([query findObjects:nil].count, 3);
+
+    query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"createdOn" equalTo:[NSDate dateWithTimeIntervalSince1970:7]];
+    XCTAssertEqual([[query getFirstObject:nil][@"index"] integerValue], 7);
+}
+
+- (void)testIndexedFindMatchesArrayElements {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"tags" forClassName:@"Yarr"] waitForResult:nil]);
+
+    PFObject *object = [PFObject objectWithClassName:@"Yarr"];
+    object[@"tags"] = @[ @"a", @"b" ];
+    XCTAssertTrue([object pin]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"tags" equalTo:@"b"];
+    XCTAssertEqual([query findObjects:nil].count, 1);
+
+    query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"tags" equalTo:@"c"];
+    XCTAssertEqual([query findObjects:nil].count, 0);
+}
+
+- (void)testIndexedFindAfterCreatingIndexOnPinnedObjects {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:10] error:nil]);
+    [self.offlineStore simulateReboot];
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"index" forClassName:@"Yarr"] waitForResult:nil]);
+    [self.offlineStore simulateReboot];
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" equalTo:@4];
+    XCTAssertEqual([[query getFirstObject:nil][@"index"] integerValue], 4);
+}
+
+- (void)testIndexedFindIncludesObjectsChangedInMemory {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"index" forClassName:@"Yarr"] waitForResult:nil]);
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:3];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+
+    objects[0][@"index"] = @42;
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" equalTo:@42];
+    XCTAssertEqualObjects([query findObjects:nil], @[ objects[0] ]);
+
+    query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" equalTo:@0];
+    XCTAssertEqual([query findObjects:nil].count, 0);
+}
+
+- (void)testIndexedFindAfterUnpinning {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"index" forClassName:@"Yarr"] waitForResult:nil]);
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:3];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+    XCTAssertTrue([objects[1] unpin]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" lessThanOrEqualTo:@2];
+    XCTAssertEqual([query findObjects:nil].count, 2);
+}
+
+#pragma mark Count
+
+- (void)testCount {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:10] error:nil]);
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:4] withName:@"Pirates" error:nil]);
+
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    XCTAssertEqual([query countObjects:nil], 14);
+
+    query = [[[PFQuery queryWithClassName:@"Yarr"] fromPinWithName:@"Pirates"] ignoreACLs];
+    XCTAssertEqual([query countObjects:nil], 4);
+
+    query = [[[PFQuery queryWithClassName:@"Yarr"] fromPinWithName:@"Nobody"] ignoreACLs];
+    XCTAssertEqual([query countObjects:nil], 0);
+}
+
+- (void)testCountWithIndexedConstraints {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"index" forClassName:@"Yarr"] waitForResult:nil]);
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:10];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    [query whereKey:@"index" containedIn:@[ @1, @2, @3 ]];
+    XCTAssertEqual([query countObjects:nil], 3);
+
+    // Objects changed in memory are matched with their current values.
+    objects[1][@"index"] = @42;
+    objects[5][@"index"] = @3;
+    XCTAssertEqual([query countObjects:nil], 3);
+
+    query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    [query whereKey:@"index" lessThan:@4];
+    [query whereKey:@"name" hasPrefix:@"Object"];
+    XCTAssertEqual([query countObjects:nil], 3);
+}
+
+- (void)testCountWithIndexedDates {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"createdOn" forClassName:@"Yarr"] waitForResult:nil]);
+    PFObject *object = [PFObject objectWithClassName:@"Yarr"];
+    object[@"createdOn"] = [NSDate dateWithTimeIntervalSince1970:7.0004];
+    XCTAssertTrue([object pin:nil]);
+
+    // The index only keeps milliseconds, the object doesn't match.
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    [query whereKey:@"createdOn" equalTo:[NSDate dateWithTimeIntervalSince1970:7]];
+    XCTAssertEqual([query countObjects:nil], [query findObjects:nil].count);
+}
+
+- (void)testCountChecksACLs {
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:3];
+    objects[0].ACL = [PFACL ACL];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    XCTAssertEqual([query countObjects:nil], 2);
+
+    query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    XCTAssertEqual([query countObjects:nil], 3);
+}
+
+- (void)testCountSkipsReferencedObjects {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:2] error:nil]);
+    // Objects that are only pointed to are stored without data.
+    PFObject *ship = [PFObject objectWithClassName:@"Ship"];
+    ship[@"pirate"] = [PFObject objectWithoutDataWithClassName:@"Yarr" objectId:@"ghost"];
+    XCTAssertTrue([ship pin:nil]);
+
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    XCTAssertEqual([query countObjects:nil], 2);
+    XCTAssertEqual([query findObjects:nil].count, 2);
+}
+
+#pragma mark Enumeration
+
+- (void)testEnumerateObjects {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:25] error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" lessThan:@20];
+    NSMutableArray<NSNumber *> *pageCounts = [NSMutableArray array];
+    NSMutableSet<NSNumber *> *indexes = [NSMutableSet set];
+    BFTask *task = [query enumerateObjectsInBackgroundWithPageSize:10 block:^(NSArray *objects, BOOL *stop) {
+        [pageCounts addObject:@(objects.count)];
+        for (PFObject *object in objects) {
+            [indexes addObject:object[@"index"]];
+        }
+    }];
+    XCTAssertEqualObjects([task waitForResult:nil], @YES);
+    XCTAssertEqual(indexes.count, 20);
+    for (NSNumber *count in pageCounts) {
+        XCTAssertLessThanOrEqual(count.unsignedIntegerValue, 10);
+    }
+}
+
+- (void)testEnumerateObjectsWithSkipAndLimit {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:25] error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    query.skip = 7;
+    query.limit = 11;
+    __block NSUInteger count = 0;
+    BFTask *task = [query enumerateObjectsInBackgroundWithPageSize:4 block:^(NSArray *objects, BOOL *stop) {
+        count += objects.count;
+    }];
+    XCTAssertNotNil([task waitForResult:nil]);
+    XCTAssertEqual(count, 11);
+}
+
+- (void)testEnumerateObjectsStopsEarly {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:25] error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    __block NSUInteger pagesCount = 0;
+    BFTask *task = [query enumerateObjectsInBackgroundWithPageSize:5 block:^(NSArray *objects, BOOL *stop) {
+        pagesCount++;
+        *stop = YES;
+    }];
+    XCTAssertNotNil([task waitForResult:nil]);
+    XCTAssertEqual(pagesCount, 1);
+}
+
+- (void)testEnumerateObjectsFromPin {
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:5] withName:@"Pirates" error:nil]);
+    XCTAssertTrue([PFObject pinAll:[self objectsWithClassName:@"Yarr" count:3] error:nil]);
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromPinWithName:@"Pirates"];
+    __block NSUInteger count = 0;
+    BFTask *task = [query enumerateObjectsInBackgroundWithPageSize:2 block:^(NSArray *objects, BOOL *stop) {
+        count += objects.count;
+    }];
+    XCTAssertNotNil([task waitForResult:nil]);
+    XCTAssertEqual(count, 5);
+}
+
+- (void)testEnumerateOrderedQuery {
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] orderByAscending:@"index"];
+    PFAssertThrowsInconsistencyException([query enumerateObjectsInBackgroundWithPageSize:10
+                                                                                   block:^(NSArray *objects, BOOL *stop) {}]);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPinPerformance {
+    [self measureBlock:^{
+        NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:OfflineStoreTestsBenchmarkObjectsCount];
+        XCTAssertTrue([PFObject pinAll:objects error:nil]);
+    }];
+}
+
+- (void)testFindPerformance {
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:OfflineStoreTestsBenchmarkObjectsCount];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+    [self.offlineStore simulateReboot];
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" lessThan:@(OfflineStoreTestsBenchmarkObjectsCount / 2)];
+    [self measureBlock:^{
+        XCTAssertEqual([query findObjects:nil].count, OfflineStoreTestsBenchmarkObjectsCount / 2);
+    }];
+}
+
+- (void)testCountPerformance {
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:OfflineStoreTestsBenchmarkObjectsCount];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+    [self.offlineStore simulateReboot];
+
+    PFQuery *query = [[[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore] ignoreACLs];
+    [self measureBlock:^{
+        XCTAssertEqual([query countObjects:nil], OfflineStoreTestsBenchmarkObjectsCount);
+    }];
+}
+
+- (void)testIndexedFindPerformance {
+    XCTAssertNotNil([[PFQuery createLocalIndexInBackgroundOnKey:@"index" forClassName:@"Yarr"] waitForResult:nil]);
+    NSArray<PFObject *> *objects = [self objectsWithClassName:@"Yarr" count:OfflineStoreTestsBenchmarkObjectsCount];
+    XCTAssertTrue([PFObject pinAll:objects error:nil]);
+    [self.offlineStore simulateReboot];
+
+    PFQuery *query = [[PFQuery queryWithClassName:@"Yarr"] fromLocalDatastore];
+    [query whereKey:@"index" lessThan:@10];
+    [self measureBlock:^{
+        XCTAssertEqual([query findObjects:nil].count, 10);
+    }];
+}
+
+@end
@@ -39,14 +39,24 @@
         configuration.clientKey = @"bar";
         configuration.server = @"http://localhost";
         configuration.localDatastoreEnabled = YES;
+        configuration.localDatastoreWriteAheadLoggingEnabled = YES;
+        configuration.localDatastoreBinaryEncodingEnabled = YES;
         configuration.networkRetryAttempts = 1337;
+        configuration.networkCompressionEnabled = YES;
+        configuration.singleFileQueryCacheEnabled = YES;
+        configuration.queryCacheCompressionEnabled = YES;
     }];
 
     XCTAssertEqualObjects(configuration.applicationId, @"foo");
     XCTAssertEqualObjects(configuration.clientKey, @"bar");
     XCTAssertEqualObjects(configuration.server, @"http://localhost");
     XCTAssertTrue(configuration.localDatastoreEnabled);
+    XCTAssertTrue(configuration.localDatastoreWriteAheadLoggingEnabled);
+    XCTAssertTrue(configuration.localDatastoreBinaryEncodingEnabled);
     XCTAssertEqual(configuration.networkRetryAttempts, 1337);
+    XCTAssertTrue(configuration.networkCompressionEnabled);
+    XCTAssertTrue(configuration.singleFileQueryCacheEnabled);
+    XCTAssertTrue(configuration.queryCacheCompressionEnabled);
 }
 
 - (void)testEqual {
@@ -83,11 +93,46 @@
     XCTAssertNotEqualObjects(configurationA, configurationB);
     configurationB.localDatastoreEnabled = configurationA.localDatastoreEnabled;
 
+    configurationA.localDatastoreWriteAheadLoggingEnabled = configurationB.localDatastoreWriteAheadLoggingEnabled = YES;
+    XCTAssertEqualObjects(configurationA, configurationB);
+    XCTAssertEqual(configurationA.hash, configurationB.hash);
+    configurationB.localDatastoreWriteAheadLoggingEnabled = NO;
+    XCTAssertNotEqualObjects(configurationA, configurationB);
+    configurationB.localDatastoreWriteAheadLoggingEnabled = configurationA.localDatastoreWriteAheadLoggingEnabled;
+
+    configurationA.localDatastoreBinaryEncodingEnabled = configurationB.localDatastoreBinaryEncodingEnabled = YES;
+    XCTAssertEqualObjects(configurationA, configurationB);
+    XCTAssertEqual(configurationA.hash, configurationB.hash);
+    configurationB.localDatastoreBinaryEncodingEnabled = NO;
+    XCTAssertNotEqualObjects(configurationA, configurationB);
+    configurationB.localDatastoreBinaryEncodingEnabled = configurationA.localDatastoreBinaryEncodingEnabled;
+
     configurationA.networkRetryAttempts = configurationB.networkRetryAttempts = 1337;
     XCTAssertEqualObjects(configurationA, configurationB);
     XCTAssertEqual(configurationA.hash, configurationB.hash);
     configurationB.networkRetryAttempts = 7;
     XCTAssertNotEqualObjects(configurationA, configurationB);
+    configurationB.networkRetryAttempts = configurationA.networkRetryAttempts;
+
+    configurationA.networkCompressionEnabled = configurationB.networkCompressionEnabled = YES;
+    XCTAssertEqualObjects(configurationA, configurationB);
+    XCTAssertEqual(configurationA.hash, configurationB.hash);
+    configurationB.networkCompressionEnabled = NO;
+    XCTAssertNotEqualObjects(configurationA, configurationB);
+    configurationB.networkCompressionEnabled = configurationA.networkCompressionEnabled;
+
+    configurationA.singleFileQueryCacheEnabled = configurationB.singleFileQueryCacheEnabled = YES;
+    XCTAssertEqualObjects(configurationA, configurationB);
+    XCTAssertEqual(configurationA.hash, configurationB.hash);
+    configurationB.singleFileQueryCacheEnabled = NO;
+    XCTAssertNotEqualObjects(configurationA, configurationB);
+    configurationB.singleFileQueryCacheEnabled = configurationA.singleFileQueryCacheEnabled;
+
+    configurationA.queryCacheCompressionEnabled = configurationB.queryCacheCompressionEnabled = YES;
+    XCTAssertEqualObjects(configurationA, configurationB);
+    XCTAssertEqual(configurationA.hash, configurationB.hash);
+    configurationB.queryCacheCompressionEnabled = NO;
+    XCTAssertNotEqualObjects(configurationA, configurationB);
 }
 
 - (void)testCopy {
@@ -15,11 +15,13 @@
 #import "PFCommandResult.h"
 #import "PFCommandRunning.h"
 #import "PFJSONSerialization.h"
-#import "PFKeyValueCache.h"
+#import "PFKeyValueCache_Private.h"
 #import "PFMutableQueryState.h"
 #import "PFObject.h"
+#import "PFQueryState_Private.h"
 #import "PFRESTQueryCommand.h"
 #import "PFTestCase.h"
+#import "TestCache.h"
 
 @protocol CachedQueryControllerDataSource <PFCommandRunnerProvider, PFKeyValueCacheProvider>
 
@@ -47,6 +49,27 @@
     return dataSource;
 }
 
+- (id<PFCommandRunnerProvider, PFKeyValueCacheProvider>)dataSourceWithMemoryKeyValueCache {
+    id<CachedQueryControllerDataSource> dataSource = PFStrictProtocolMock(@protocol(CachedQueryControllerDataSource));
+
+    id<PFCommandRunning> runner = PFStrictProtocolMock(@protocol(PFCommandRunning));
+    OCMStub(dataSource.commandRunner).andReturn(runner);
+
+    PFKeyValueCache *keyValueCache = [[PFKeyValueCache alloc] initWithCacheDirectoryURL:nil
+                                                                            fileManager:nil
+                                                                            memoryCache:[TestCache cache]];
+    OCMStub(dataSource.keyValueCache).andReturn(keyValueCache);
+
+    return dataSource;
+}
+
+- (BFTask *)findObjectsFromCacheWithController:(PFCachedQueryController *)controller {
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheOnly];
+    BFTask *task = [controller findObjectsAsyncForQueryState:state withCancellationToken:nil user:nil];
+    [task waitUntilFinished];
+    return task;
+}
+
 - (PFQueryState *)sampleQueryStateWithCachePolicy:(PFCachePolicy)cachePolicy {
     PFMutableQueryState *queryState = [PFMutableQueryState stateWithParseClassName:@"Yolo"];
     [queryState setEqualityConditionWithObject:@"yarr" forKey:@"name"];
@@ -120,7 +143,7 @@
     id cache = dataSource.keyValueCache;
 
     NSString *jsonString = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(jsonString);
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(jsonString);
 
     PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
     PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheOnly];
@@ -139,7 +162,7 @@
 - (void)testFindObjectsCacheOnlyCorruptJSON {
     id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self mockedDataSource];
     id cache = dataSource.keyValueCache;
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(@"blah blah");
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(@"blah blah");
 
     PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
     PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheOnly];
@@ -188,7 +211,7 @@
 - (void)testFindObjectsCacheElseNetwork {
     id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self mockedDataSource];
     id cache = dataSource.keyValueCache;
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(nil);
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(nil);
     OCMStub([[cache ignoringNonObjectArgs] setObject:[OCMArg isEqual:@"yolo"] forKey:[OCMArg isNotNil]]);
 
     id runner = dataSource.commandRunner;
@@ -216,7 +239,7 @@
 
     id cache = dataSource.keyValueCache;
     NSString *jsonString = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(jsonString);
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(jsonString);
 
     PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
     PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheElseNetwork];
@@ -237,7 +260,7 @@
 
     id cache = dataSource.keyValueCache;
     NSString *jsonString = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(jsonString);
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(jsonString);
 
     id runner = dataSource.commandRunner;
     BFTask *commandTask = [BFTask taskWithError:[NSError errorWithDomain:@"TestErrorDomain" code:100500 userInfo:nil]];
@@ -343,7 +366,7 @@
     id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self mockedDataSource];
     id cache = dataSource.keyValueCache;
     NSString *jsonString = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(jsonString);
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(jsonString);
 
     PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
     PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheOnly];
@@ -359,18 +382,212 @@
     [self waitForTestExpectations];
 }
 
+- (void)testFindObjectsCacheOnlyKeepsParsedResults {
+    id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self dataSourceWithMemoryKeyValueCache];
+    PFKeyValueCache *cache = dataSource.keyValueCache;
+    PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
+
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheOnly];
+    NSString *cacheKey = [controller cacheKeyForQueryState:state sessionToken:nil];
+    cache[cacheKey] = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
+    [cache waitForOutstandingOperations];
+
+    BFTask *task = [self findObjectsFromCacheWithController:controller];
+    [self assertFindObjectsResult:task.result];
+    PFObject *object = [task.result firstObject];
+
+    // Served from the parsed results without the key value cache, but with objects of its own.
+    [cache.memoryCache removeAllObjects];
+    task = [self findObjectsFromCacheWithController:controller];
+    [self assertFindObjectsResult:task.result];
+    XCTAssertNotEqual([task.result firstObject], object);
+    XCTAssertTrue([controller hasCachedResultForQueryState:state sessionToken:nil]);
+
+    [controller clearCachedResultForQueryState:state sessionToken:nil];
+    task = [self findObjectsFromCacheWithController:controller];
+    XCTAssertEqual(task.error.code, kPFErrorCacheMiss);
+    XCTAssertFalse([controller hasCachedResultForQueryState:state sessionToken:nil]);
+
+    [cache waitForOutstandingOperations];
+}
+
+- (void)testParsedResultsAreRemovedWithKeyValueCacheValues {
+    id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self dataSourceWithMemoryKeyValueCache];
+    PFKeyValueCache *cache = dataSource.keyValueCache;
+    PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
+
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyCacheOnly];
+    NSString *cacheKey = [controller cacheKeyForQueryState:state sessionToken:nil];
+    NSString *jsonString = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
+
+    cache[cacheKey] = jsonString;
+    [self assertFindObjectsResult:[self findObjectsFromCacheWithController:controller].result];
+    [cache removeObjectForKey:cacheKey];
+    XCTAssertEqual([self findObjectsFromCacheWithController:controller].error.code, kPFErrorCacheMiss);
+
+    cache[cacheKey] = jsonString;
+    [self assertFindObjectsResult:[self findObjectsFromCacheWithController:controller].result];
+    [cache removeAllObjects];
+    XCTAssertEqual([self findObjectsFromCacheWithController:controller].error.code, kPFErrorCacheMiss);
+
+    // Values evicted by the key value cache are removed as well.
+    cache[cacheKey] = jsonString;
+    [self assertFindObjectsResult:[self findObjectsFromCacheWithController:controller].result];
+    [[NSNotificationCenter defaultCenter] postNotificationName:PFKeyValueCacheDidRemoveValuesNotification
+                                                        object:cache
+                                                      userInfo:@{ PFKeyValueCacheRemovedKeysUserInfoKey : @[ cacheKey ] }];
+    [cache.memoryCache removeAllObjects];
+    XCTAssertEqual([self findObjectsFromCacheWithController:controller].error.code, kPFErrorCacheMiss);
+
+    [cache waitForOutstandingOperations];
+}
+
+- (void)testFindObjectsNetworkOnlySavesResult {
+    id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self dataSourceWithMemoryKeyValueCache];
+    PFKeyValueCache *cache = dataSource.keyValueCache;
+
+    NSDictionary *resultObject = [self sampleCommandResult].result;
+    PFCommandResult *commandResult = [PFCommandResult commandResultWithResult:resultObject
+                                                                 resultString:[PFJSONSerialization stringFromJSONObject:resultObject]
+                                                                 httpResponse:nil];
+    id runner = dataSource.commandRunner;
+    OCMStub([[runner ignoringNonObjectArgs] runCommandAsync:[OCMArg isNotNil]
+                                                withOptions:0
+                                          cancellationToken:[OCMArg isNil]]).andReturn([BFTask taskWithResult:commandResult]);
+
+    PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyNetworkOnly];
+    BFTask *task = [controller findObjectsAsyncForQueryState:state withCancellationToken:nil user:nil];
+    [task waitUntilFinished];
+    [self assertFindObjectsResult:task.result];
+
+    task = [self findObjectsFromCacheWithController:controller];
+    [self assertFindObjectsResult:task.result];
+
+    [controller clearAllCachedResults];
+    task = [self findObjectsFromCacheWithController:controller];
+    XCTAssertEqual(task.error.code, kPFErrorCacheMiss);
+
+    [cache waitForOutstandingOperations];
+}
+
+- (void)testFindObjectsStaleWhileRevalidate {
+    id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self dataSourceWithMemoryKeyValueCache];
+    PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyStaleWhileRevalidate];
+
+    NSString *cacheKey = [controller cacheKeyForQueryState:state sessionToken:nil];
+    dataSource.keyValueCache[cacheKey] = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
+
+    __block NSUInteger requestsCount = 0;
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    id runner = dataSource.commandRunner;
+    OCMStub([[runner ignoringNonObjectArgs] runCommandAsync:[OCMArg isNotNil]
+                                                withOptions:0
+                                          cancellationToken:[OCMArg isNil]]).andReturn(taskCompletionSource.task).andDo(^(NSInvocation *invocation) {
+        requestsCount++;
+    });
+
+    // Both queries are answered from the cache while the refresh is still running.
+    for (NSUInteger i = 0; i < 2; i++) {
+        BFTask *task = [controller findObjectsAsyncForQueryState:state withCancellationToken:nil user:nil];
+        [task waitUntilFinished];
+        [self assertFindObjectsResult:task.result];
+    }
+    XCTAssertEqual(requestsCount, 1);
+
+    NSDictionary *resultObject = [self sampleCommandResult].result;
+    [taskCompletionSource setResult:[PFCommandResult commandResultWithResult:resultObject
+                                                                resultString:[PFJSONSerialization stringFromJSONObject:resultObject]
+                                                                httpResponse:nil]];
+    [dataSource.keyValueCache waitForOutstandingOperations];
+}
+
+- (void)testFindObjectsStaleWhileRevalidateCacheMiss {
+    id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self dataSourceWithMemoryKeyValueCache];
+    PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyStaleWhileRevalidate];
+
+    __block NSUInteger requestsCount = 0;
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    id runner = dataSource.commandRunner;
+    OCMStub([[runner ignoringNonObjectArgs] runCommandAsync:[OCMArg isNotNil]
+                                                withOptions:0
+                                          cancellationToken:[OCMArg isNil]]).andReturn(taskCompletionSource.task).andDo(^(NSInvocation *invocation) {
+        requestsCount++;
+    });
+
+    BFTask *firstTask = [controller findObjectsAsyncForQueryState:state withCancellationToken:nil user:nil];
+    BFTask *secondTask = [controller findObjectsAsyncForQueryState:state withCancellationToken:nil user:nil];
+
+    NSDictionary *resultObject = [self sampleCommandResult].result;
+    [taskCompletionSource setResult:[PFCommandResult commandResultWithResult:resultObject
+                                                                resultString:[PFJSONSerialization stringFromJSONObject:resultObject]
+                                                                httpResponse:nil]];
+    [firstTask waitUntilFinished];
+    [secondTask waitUntilFinished];
+    [self assertFindObjectsResult:firstTask.result];
+    [self assertFindObjectsResult:secondTask.result];
+    XCTAssertEqual(requestsCount, 1);
+
+    // The shared request saved its result.
+    BFTask *cacheTask = [self findObjectsFromCacheWithController:controller];
+    [self assertFindObjectsResult:cacheTask.result];
+
+    [dataSource.keyValueCache waitForOutstandingOperations];
+}
+
+- (void)testFindObjectsStaleWhileRevalidateCacheMissCancel {
+    id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self dataSourceWithMemoryKeyValueCache];
+    PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
+    PFQueryState *state = [self sampleQueryStateWithCachePolicy:kPFCachePolicyStaleWhileRevalidate];
+
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    id runner = dataSource.commandRunner;
+    OCMStub([[runner ignoringNonObjectArgs] runCommandAsync:[OCMArg isNotNil]
+                                                withOptions:0
+                                          cancellationToken:[OCMArg isNil]]).andReturn(taskCompletionSource.task);
+
+    BFCancellationTokenSource *cancellationTokenSource = [BFCancellationTokenSource cancellationTokenSource];
+    BFTask *cancelledTask = [controller findObjectsAsyncForQueryState:state
+                                                withCancellationToken:cancellationTokenSource.token
+                                                                 user:nil];
+    BFTask *task = [controller findObjectsAsyncForQueryState:state withCancellationToken:nil user:nil];
+
+    // Only the query that was cancelled stops waiting, the shared request keeps running for the other one.
+    [cancellationTokenSource cancel];
+    [cancelledTask waitUntilFinished];
+    XCTAssertTrue(cancelledTask.cancelled);
+    XCTAssertFalse(task.completed);
+
+    NSDictionary *resultObject = [self sampleCommandResult].result;
+    [taskCompletionSource setResult:[PFCommandResult commandResultWithResult:resultObject
+                                                                resultString:[PFJSONSerialization stringFromJSONObject:resultObject]
+                                                                httpResponse:nil]];
+    [task waitUntilFinished];
+    [self assertFindObjectsResult:task.result];
+
+    [dataSource.keyValueCache waitForOutstandingOperations];
+}
+
 - (void)testCacheKey {
     id<PFCommandRunnerProvider, PFKeyValueCacheProvider> dataSource = [self mockedDataSource];
     id cache = dataSource.keyValueCache;
 
     NSString *jsonString = [PFJSONSerialization stringFromJSONObject:[self sampleCommandResult].result];
-    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0]).andReturn(jsonString);
+    OCMStub([[cache ignoringNonObjectArgs] objectForKey:[OCMArg isNotNil] maxAge:0 creationDate:NULL]).andReturn(jsonString);
 
     PFQueryState *state = [self sampleQueryStateWithCachePolicy:0];
     PFCachedQueryController *controller = [PFCachedQueryController controllerWithCommonDataSource:dataSource];
 
     NSString *cacheKey = [PFRESTQueryCommand findCommandForQueryState:state withSessionToken:@"a" error:nil].cacheKey;
     XCTAssertEqualObjects([controller cacheKeyForQueryState:state sessionToken:@"a"], cacheKey);
+    XCTAssertEqualObjects([state cacheKeyForSessionToken:@"a"], cacheKey);
+    XCTAssertNil([state cacheKeyForSessionToken:nil]);
+
+    NSString *otherCacheKey = [PFRESTQueryCommand findCommandForQueryState:state withSessionToken:nil error:nil].cacheKey;
+    XCTAssertNotEqualObjects(otherCacheKey, cacheKey);
+    XCTAssertEqualObjects([controller cacheKeyForQueryState:state sessionToken:nil], otherCacheKey);
 }
 
 - (void)testHasCachedResult {
@@ -17,6 +17,7 @@
 #import "PFMutableQueryState.h"
 #import "PFObject.h"
 #import "PFQueryController.h"
+#import "PFRESTCommand.h"
 #import "PFTestCase.h"
 
 @interface QueryControllerUnitTests : PFTestCase
@@ -98,6 +99,86 @@
     [self waitForTestExpectations];
 }
 
+- (void)testFindObjectsProgressiveResults {
+    id<PFCommandRunnerProvider> dataSource = PFStrictProtocolMock(@protocol(PFCommandRunnerProvider));
+    id runner = PFStrictProtocolMock(@protocol(PFCommandRunning));
+    OCMStub(dataSource.commandRunner).andReturn(runner);
+
+    NSArray *results = @[ @{ @"objectId" : @"a", @"name" : @"yarr" },
+                          @{ @"objectId" : @"b", @"name" : @"yarr" } ];
+    PFCommandResult *result = [PFCommandResult commandResultWithResult:@{ @"results" : results }
+                                                          resultString:nil
+                                                          httpResponse:nil];
+    OCMStub([[runner ignoringNonObjectArgs] runCommandAsync:OCMOCK_ANY
+                                                withOptions:0
+                                          cancellationToken:OCMOCK_ANY]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained PFRESTCommand *command = nil;
+        [invocation getArgument:&command atIndex:2];
+
+        command.partialResultsBlock(@[ results[0] ], 0);
+        // A retried command reports the same results again.
+        command.partialResultsBlock(results, 0);
+
+        __autoreleasing BFTask *task = [BFTask taskWithResult:result];
+        [invocation setReturnValue:&task];
+    });
+
+    PFQueryController *controller = [PFQueryController controllerWithCommonDataSource:dataSource];
+    NSMutableArray *progressiveObjects = [NSMutableArray array];
+    NSArray *objects = [[controller findObjectsAsyncForQueryState:[self sampleQueryState]
+                                            withCancellationToken:nil
+                                                             user:nil
+                                          progressiveResultsBlock:^(NSArray *objects) {
+                                              [progressiveObjects addObjectsFromArray:objects];
+                                          }] waitForResult:nil];
+    XCTAssertEqual(progressiveObjects.count, 2);
+    XCTAssertEqual(objects.count, 2);
+    XCTAssertEqual(objects[0], progressiveObjects[0]);
+    XCTAssertEqual(objects[1], progressiveObjects[1]);
+    XCTAssertEqualObjects([objects[1] objectId], @"b");
+}
+
+- (void)testFindObjectsProgressiveResultsOfAnotherAttempt {
+    id<PFCommandRunnerProvider> dataSource = PFStrictProtocolMock(@protocol(PFCommandRunnerProvider));
+    id runner = PFStrictProtocolMock(@protocol(PFCommandRunning));
+    OCMStub(dataSource.commandRunner).andReturn(runner);
+
+    NSDictionary *resultA = @{ @"objectId" : @"a", @"name" : @"yarr" };
+    NSDictionary *resultB = @{ @"objectId" : @"b", @"name" : @"yarr" };
+    NSDictionary *resultC = @{ @"objectId" : @"c", @"name" : @"yarr" };
+    NSDictionary *resultE = @{ @"objectId" : @"e", @"name" : @"yarr" };
+    // The response comes from another source than the streamed results, e.g. from the cache.
+    PFCommandResult *result = [PFCommandResult commandResultWithResult:@{ @"results" : @[ resultA, resultB, resultE ] }
+                                                          resultString:nil
+                                                          httpResponse:nil];
+    OCMStub([[runner ignoringNonObjectArgs] runCommandAsync:OCMOCK_ANY
+                                                withOptions:0
+                                          cancellationToken:OCMOCK_ANY]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained PFRESTCommand *command = nil;
+        [invocation getArgument:&command atIndex:2];
+
+        command.partialResultsBlock(@[ resultA, resultC ], 0);
+        // A retried command reports different results.
+        command.partialResultsBlock(@[ resultA, resultB ], 0);
+
+        __autoreleasing BFTask *task = [BFTask taskWithResult:result];
+        [invocation setReturnValue:&task];
+    });
+
+    PFQueryController *controller = [PFQueryController controllerWithCommonDataSource:dataSource];
+    NSMutableArray *progressiveObjects = [NSMutableArray array];
+    NSArray *objects = [[controller findObjectsAsyncForQueryState:[self sampleQueryState]
+                                            withCancellationToken:nil
+                                                             user:nil
+                                          progressiveResultsBlock:^(NSArray *objects) {
+                                              [progressiveObjects addObjectsFromArray:objects];
+                                          }] waitForResult:nil];
+    XCTAssertEqualObjects([progressiveObjects valueForKey:@"objectId"], (@[ @"a", @"c", @"b" ]));
+    XCTAssertEqualObjects([objects valueForKey:@"objectId"], (@[ @"a", @"b", @"e" ]));
+    XCTAssertEqual(objects[0], progressiveObjects[0]);
+    XCTAssertEqual(objects[1], progressiveObjects[2]);
+}
+
 - (void)testFindObjectsCancellation {
     PFQueryController *controller = [PFQueryController controllerWithCommonDataSource:[self mockedCommonDataSource]];
     PFQueryState *state = [self sampleQueryState];
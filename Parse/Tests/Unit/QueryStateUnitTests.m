@@ -9,6 +9,8 @@
 
 #import "PFMacros.h"
 #import "PFMutableQueryState.h"
+#import "PFQuery.h"
+#import "PFQueryState_Private.h"
 #import "PFTestCase.h"
 
 @interface QueryStateUnitTests : PFTestCase
@@ -134,6 +136,42 @@
     XCTAssertEqualObjects(state.conditions[@"yarr"][@"$yolo"], @"a");
 }
 
+- (void)testGenericConditionsArentSharedWithCopies {
+    PFMutableQueryState *state = [[PFMutableQueryState alloc] initWithParseClassName:@"Yarr"];
+    [state setConditionType:@"$gt" withObject:@1 forKey:@"yarr"];
+    PFQueryState *copiedState = [state copy];
+    [state setConditionType:@"$lt" withObject:@5 forKey:@"yarr"];
+
+    XCTAssertEqualObjects(copiedState.conditions[@"yarr"], @{ @"$gt" : @1 });
+    XCTAssertEqualObjects(state.conditions[@"yarr"], (@{ @"$gt" : @1, @"$lt" : @5 }));
+}
+
+- (void)testCacheKey {
+    PFMutableQueryState *mutableState = [[PFMutableQueryState alloc] initWithParseClassName:@"Yarr"];
+    [mutableState setCacheKey:@"a" forSessionToken:nil];
+    XCTAssertNil([mutableState cacheKeyForSessionToken:nil]);
+
+    PFQueryState *state = [mutableState copy];
+    [state setCacheKey:@"a" forSessionToken:nil];
+    XCTAssertEqualObjects([state cacheKeyForSessionToken:nil], @"a");
+    XCTAssertNil([state cacheKeyForSessionToken:@"b"]);
+
+    [state setCacheKey:@"c" forSessionToken:@"b"];
+    XCTAssertEqualObjects([state cacheKeyForSessionToken:@"b"], @"c");
+    XCTAssertNil([state cacheKeyForSessionToken:nil]);
+
+    XCTAssertNil([[state mutableCopy] cacheKeyForSessionToken:@"b"]);
+}
+
+- (void)testCacheKeyWithSubquery {
+    PFMutableQueryState *mutableState = [[PFMutableQueryState alloc] initWithParseClassName:@"Yarr"];
+    [mutableState setConditionType:@"$inQuery" withObject:[PFQuery queryWithClassName:@"Yolo"] forKey:@"yarr"];
+
+    PFQueryState *state = [mutableState copy];
+    [state setCacheKey:@"a" forSessionToken:nil];
+    XCTAssertNil([state cacheKeyForSessionToken:nil]);
+}
+
 - (void)testEqualityConditions {
     PFMutableQueryState *state = [[PFMutableQueryState alloc] initWithParseClassName:@"Yarr"];
     [state setEqualityConditionWithObject:@"a" forKey:@"yarr"];
@@ -475,6 +475,38 @@
     }] waitUntilFinished];
 }
 
+- (void)testCachedSQLWithArgumentsArrays {
+    PFSQLiteDatabase *database = self->database;
+    NSString *sql = @"INSERT INTO test (a, b, c, d) VALUES (?, ?, ?, ?)";
+    [[[[[[[self createDatabaseAsync] continueWithBlock:^id(BFTask *task) {
+        return [database executeCachedSQLAsync:sql withArgumentsArrays:@[ @[ @"one", @"two", @1, @1.1 ],
+                                                                          @[ @"three", @"four", @2, @2.2 ] ]];
+    }] continueWithBlock:^id(BFTask *task) {
+        XCTAssertNil(task.error);
+        // The statement is reused after being reset.
+        return [database executeCachedSQLAsync:sql withArgumentsInArray:@[ @"five", @"six", @3, @3.3 ]];
+    }] continueWithBlock:^id(BFTask *task) {
+        XCTAssertNil(task.error);
+        return [database executeCachedSQLAsync:sql withArgumentsArrays:@[ @[ @"seven", @"eight", @4, @4.4 ],
+                                                                          @[ @"nine" ] ]];
+    }] continueWithBlock:^id(BFTask *task) {
+        XCTAssertNotNil(task.error);
+        return [database executeQueryAsync:@"SELECT c FROM test ORDER BY c"
+                      withArgumentsInArray:nil
+                                     block:^id(PFSQLiteDatabaseResult *result) {
+            NSMutableArray *values = [NSMutableArray array];
+            while ([result next]) {
+                [values addObject:@([result intForColumnIndex:0])];
+            }
+            return values;
+        }];
+    }] continueWithBlock:^id(BFTask *task) {
+        // Rows before the failing one are inserted.
+        XCTAssertEqualObjects(task.result, (@[ @1, @2, @3, @4 ]));
+        return [database closeAsync];
+    }] waitUntilFinished];
+}
+
 - (void)testInvalidArgumentCount {
     PFSQLiteDatabase *database = self->database;
     [[[[self createDatabaseAsync] continueWithBlock:^id(BFTask *task) {
@@ -14,6 +14,7 @@
 #import "PFCommandResult.h"
 #import "PFCommandRunningConstants.h"
 #import "PFCommandURLRequestConstructor.h"
+#import "PFHTTPRequest.h"
 #import "PFRESTCommand.h"
 #import "PFTestCase.h"
 #import "PFObject.h"
@@ -66,6 +67,7 @@
 
     NSURLRequest *urlRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://foo.bar"]];
 
+    OCMStub([mockedCommand httpMethod]).andReturn(PFHTTPRequestMethodPOST);
     OCMStub([mockedCommand resolveLocalIds:(NSError * __autoreleasing *)[OCMArg anyPointer]]).andReturn(YES);
 
     OCMStub([mockedRequestConstructor getDataURLRequestAsyncForCommand:mockedCommand]).andReturn([BFTask taskWithResult:urlRequest]);
@@ -137,6 +139,7 @@
 
     __block int performDataURLRequestCount = 0;
 
+    OCMStub([mockedCommand httpMethod]).andReturn(PFHTTPRequestMethodPOST);
     OCMStub([mockedCommand resolveLocalIds:(NSError * __autoreleasing *)[OCMArg anyPointer]]).andReturn(YES);
     OCMStub([mockedRequestConstructor getDataURLRequestAsyncForCommand:mockedCommand]).andReturn([BFTask taskWithResult:urlRequest]);
 
@@ -182,6 +185,7 @@
                                                  code:kPFErrorInvalidSessionToken
                                              userInfo:nil];
 
+    OCMStub([mockedCommand httpMethod]).andReturn(PFHTTPRequestMethodPOST);
     OCMStub([mockedCommand resolveLocalIds:(NSError * __autoreleasing *)[OCMArg anyPointer]]);
     OCMStub([mockedRequestConstructor getDataURLRequestAsyncForCommand:mockedCommand]).andReturn([BFTask taskWithResult:urlRequest]);
 
@@ -277,6 +281,7 @@
 
     NSURLRequest *urlRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://foo.bar"]];
 
+    OCMStub([mockedCommand httpMethod]).andReturn(PFHTTPRequestMethodPOST);
     OCMExpect([mockedCommand resolveLocalIds:(NSError * __autoreleasing *)[OCMArg anyPointer]]).andReturn(YES);
 
     OCMStub([mockedRequestConstructor getDataURLRequestAsyncForCommand:mockedCommand]).andReturn([BFTask taskWithResult:urlRequest]);
@@ -376,4 +381,101 @@
     XCTAssertTrue([possibleErrors indexOfObject:error.localizedDescription] != NSNotFound);
 }
 
+- (void)testRunIdenticalReadOnlyCommandsOnce {
+    id mockedDataSource = PFStrictProtocolMock(@protocol(PFInstallationIdentifierStoreProvider));
+    id mockedSession = PFStrictClassMock([PFURLSession class]);
+    id mockedRequestConstructor = PFStrictClassMock([PFCommandURLRequestConstructor class]);
+    id mockedNotificationCenter = PFStrictClassMock([NSNotificationCenter class]);
+
+    id mockedCommandResult = PFStrictClassMock([PFCommandResult class]);
+    NSURLRequest *urlRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://foo.bar"]];
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+
+    __block int performDataURLRequestCount = 0;
+    OCMStub([mockedRequestConstructor getDataURLRequestAsyncForCommand:[OCMArg any]]).andReturn([BFTask taskWithResult:urlRequest]);
+    [OCMStub([mockedSession performDataURLRequestAsync:urlRequest
+                                            forCommand:[OCMArg any]
+                                     cancellationToken:[OCMArg any]]).andDo(^(NSInvocation *_) {
+        performDataURLRequestCount++;
+    }) andReturn:taskCompletionSource.task];
+    OCMStub([mockedSession invalidateAndCancel]);
+
+    PFURLSessionCommandRunner *commandRunner = [[PFURLSessionCommandRunner alloc] initWithDataSource:mockedDataSource
+                                                                                             session:mockedSession
+                                                                                  requestConstructor:mockedRequestConstructor
+                                                                                  notificationCenter:mockedNotificationCenter];
+
+    PFRESTCommand *(^queryCommand)(NSString *) = ^PFRESTCommand *(NSString *sessionToken) {
+        return [PFRESTCommand commandWithHTTPPath:@"classes/Yolo"
+                                       httpMethod:PFHTTPRequestMethodGET
+                                       parameters:@{ @"where" : @{ @"a" : @"b" } }
+                                     sessionToken:sessionToken
+                                            error:nil];
+    };
+    BFTask *taskA = [commandRunner runCommandAsync:queryCommand(@"yarr") withOptions:0];
+    BFTask *taskB = [commandRunner runCommandAsync:queryCommand(@"yarr") withOptions:0];
+    XCTAssertEqual(performDataURLRequestCount, 1);
+
+    // Different session token - different request.
+    BFTask *taskC = [commandRunner runCommandAsync:queryCommand(@"arrr") withOptions:0];
+    XCTAssertEqual(performDataURLRequestCount, 2);
+
+    [taskCompletionSource setResult:mockedCommandResult];
+    XCTAssertEqual([taskA waitForResult:nil], mockedCommandResult);
+    XCTAssertEqual([taskB waitForResult:nil], mockedCommandResult);
+    XCTAssertEqual([taskC waitForResult:nil], mockedCommandResult);
+
+    // Finished commands are not shared.
+    [[commandRunner runCommandAsync:queryCommand(@"yarr") withOptions:0] waitForResult:nil];
+    XCTAssertEqual(performDataURLRequestCount, 3);
+}
+
+- (void)testCancelSharedReadOnlyCommand {
+    id mockedDataSource = PFStrictProtocolMock(@protocol(PFInstallationIdentifierStoreProvider));
+    id mockedSession = PFStrictClassMock([PFURLSession class]);
+    id mockedRequestConstructor = PFStrictClassMock([PFCommandURLRequestConstructor class]);
+    id mockedNotificationCenter = PFStrictClassMock([NSNotificationCenter class]);
+
+    NSURLRequest *urlRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://foo.bar"]];
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+
+    __block BFCancellationToken *requestCancellationToken = nil;
+    OCMStub([mockedRequestConstructor getDataURLRequestAsyncForCommand:[OCMArg any]]).andReturn([BFTask taskWithResult:urlRequest]);
+    [OCMStub([mockedSession performDataURLRequestAsync:urlRequest
+                                            forCommand:[OCMArg any]
+                                     cancellationToken:[OCMArg any]]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained BFCancellationToken *token = nil;
+        [invocation getArgument:&token atIndex:4];
+        requestCancellationToken = token;
+    }) andReturn:taskCompletionSource.task];
+    OCMStub([mockedSession invalidateAndCancel]);
+
+    PFURLSessionCommandRunner *commandRunner = [[PFURLSessionCommandRunner alloc] initWithDataSource:mockedDataSource
+                                                                                             session:mockedSession
+                                                                                  requestConstructor:mockedRequestConstructor
+                                                                                  notificationCenter:mockedNotificationCenter];
+
+    PFRESTCommand *command = [PFRESTCommand commandWithHTTPPath:@"classes/Yolo/abc"
+                                                     httpMethod:PFHTTPRequestMethodGET
+                                                     parameters:nil
+                                                   sessionToken:nil
+                                                          error:nil];
+    BFCancellationTokenSource *cancellationTokenSourceA = [BFCancellationTokenSource cancellationTokenSource];
+    BFCancellationTokenSource *cancellationTokenSourceB = [BFCancellationTokenSource cancellationTokenSource];
+    BFTask *taskA = [commandRunner runCommandAsync:command withOptions:0 cancellationToken:cancellationTokenSourceA.token];
+    BFTask *taskB = [commandRunner runCommandAsync:command withOptions:0 cancellationToken:cancellationTokenSourceB.token];
+    XCTAssertNotNil(requestCancellationToken);
+
+    [cancellationTokenSourceA cancel];
+    XCTAssertTrue(taskA.cancelled);
+    XCTAssertFalse(taskB.completed);
+    XCTAssertFalse(requestCancellationToken.cancellationRequested);
+
+    [cancellationTokenSourceB cancel];
+    XCTAssertTrue(taskB.cancelled);
+    XCTAssertTrue(requestCancellationToken.cancellationRequested);
+
+    [taskCompletionSource cancel];
+}
+
 @end
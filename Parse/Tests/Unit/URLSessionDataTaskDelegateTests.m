@@ -94,6 +94,46 @@ totalBytesExpectedToSend:5];
     XCTAssertEqualObjects([commandResult result], (@{ @"foo" : @"bar" }));
 }
 
+- (void)testPartialResults {
+    NSURLSession *mockedSession = PFStrictClassMock([NSURLSession class]);
+    id mockedTask = PFStrictClassMock([NSURLSessionTask class]);
+
+    BFCancellationTokenSource *source = [BFCancellationTokenSource cancellationTokenSource];
+    PFURLSessionJSONDataTaskDelegate *delegate = [PFURLSessionJSONDataTaskDelegate taskDelegateForDataTask:mockedTask
+                                                                                     withCancellationToken:source.token];
+    NSMutableArray *partialResults = [NSMutableArray array];
+    NSMutableArray *indexes = [NSMutableArray array];
+    delegate.partialResultsBlock = ^(NSArray *results, NSUInteger index) {
+        [partialResults addObjectsFromArray:results];
+        [indexes addObject:@(index)];
+    };
+
+    NSString *body = (@"{ \"other\" : { \"results\" : [ { \"a\" : 0 } ] }, \"results\" : ["
+                      @" { \"a\" : \"}]\\\"{\" }, { \"b\" : [ 1, { \"c\" : 2 } ] } ], \"count\" : 2 }");
+    NSData *data = [body dataUsingEncoding:NSUTF8StringEncoding];
+    NSHTTPURLResponse *urlResponse = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"http://foo.bar"]
+                                                                 statusCode:200
+                                                                HTTPVersion:@"HTTP/1.1"
+                                                               headerFields:nil];
+    [delegate URLSession:mockedSession
+                dataTask:mockedTask
+      didReceiveResponse:urlResponse
+       completionHandler:^(NSURLSessionResponseDisposition disposition) {
+           XCTAssertEqual(disposition, NSURLSessionResponseAllow);
+       }];
+
+    for (NSUInteger i = 0; i < data.length; i += 3) {
+        NSData *chunk = [data subdataWithRange:NSMakeRange(i, MIN(3, data.length - i))];
+        [delegate URLSession:mockedSession dataTask:mockedTask didReceiveData:chunk];
+    }
+    [delegate URLSession:mockedSession task:mockedTask didCompleteWithError:nil];
+
+    PFCommandResult *commandResult = delegate.resultTask.result;
+    XCTAssertEqualObjects(partialResults, commandResult.result[@"results"]);
+    XCTAssertEqualObjects(partialResults[0], @{ @"a" : @"}]\"{" });
+    XCTAssertEqualObjects(indexes, (@[ @0, @1 ]));
+}
+
 - (void)testUnknownError {
     NSURLSession *mockedSession = PFStrictClassMock([NSURLSession class]);
     id mockedTask = PFStrictClassMock([NSURLSessionTask class]);
@@ -0,0 +1,308 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+@import Bolts;
+
+#import "PFTestCase.h"
+#import "PFURLSessionScheduler.h"
+
+@interface URLSessionSchedulerTests : PFTestCase
+
+@end
+
+@implementation URLSessionSchedulerTests
+
+///--------------------------------------
+#pragma mark - Helpers
+///--------------------------------------
+
+- (BFTask *)scheduleTaskInLane:(PFCommandRunningLane)lane
+                   ofScheduler:(PFURLSessionScheduler *)scheduler
+             cancellationToken:(BFCancellationToken *)cancellationToken
+      withTaskCompletionSource:(BFTaskCompletionSource *)taskCompletionSource
+                  startedCount:(NSUInteger *)startedCount {
+    return [scheduler scheduleTaskInLane:lane cancellationToken:cancellationToken withBlock:^BFTask *{
+        (*startedCount)++;
+        return taskCompletionSource.task;
+    }];
+}
+
+- (void)runQuickTasksCount:(NSUInteger)count inLane:(PFCommandRunningLane)lane ofScheduler:(PFURLSessionScheduler *)scheduler {
+    for (NSUInteger i = 0; i < count; i++) {
+        [scheduler scheduleTaskInLane:lane cancellationToken:nil withBlock:^BFTask *{
+            return [BFTask taskWithResult:nil];
+        }];
+    }
+}
+
+- (void)runSlowTaskInLane:(PFCommandRunningLane)lane ofScheduler:(PFURLSessionScheduler *)scheduler {
+    BFTaskCompletionSource *taskCompletionSource = [BFTaskCompletionSource taskCompletionSource];
+    [scheduler scheduleTaskInLane:lane cancellationToken:nil withBlock:^BFTask *{
+        return taskCompletionSource.task;
+    }];
+    [NSThread sleepForTimeInterval:0.3];
+    [taskCompletionSource setResult:nil];
+}
+
+///--------------------------------------
+#pragma mark - Tests
+///--------------------------------------
+
+- (void)testDefaultLimits {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+    XCTAssertEqual([scheduler maxConcurrentTasksCountForLane:PFCommandRunningLaneInteractive], 8);
+    XCTAssertEqual([scheduler maxConcurrentTasksCountForLane:PFCommandRunningLaneBackground], 2);
+    XCTAssertEqual([scheduler maxConcurrentTasksCountForLane:PFCommandRunningLaneFileTransfer], 3);
+    XCTAssertEqual([scheduler maxConcurrentTasksCountForLane:PFCommandRunningLaneEventuallyQueue], 4);
+
+    for (NSUInteger lane = 0; lane < PFCommandRunningLanesCount; lane++) {
+        XCTAssertEqual([scheduler concurrentTasksLimitForLane:lane], [scheduler maxConcurrentTasksCountForLane:lane]);
+        XCTAssertEqual([scheduler runningTasksCountForLane:lane], 0);
+        XCTAssertEqual([scheduler waitingTasksCountForLane:lane], 0);
+        XCTAssertEqual([scheduler averageWaitTimeForLane:lane], 0.0);
+    }
+}
+
+- (void)testLimitsRunningTasks {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    NSUInteger startedCount = 0;
+    NSArray *sources = @[ [BFTaskCompletionSource taskCompletionSource],
+                          [BFTaskCompletionSource taskCompletionSource],
+                          [BFTaskCompletionSource taskCompletionSource] ];
+    NSMutableArray *tasks = [NSMutableArray array];
+    for (BFTaskCompletionSource *source in sources) {
+        [tasks addObject:[self scheduleTaskInLane:PFCommandRunningLaneBackground
+                                      ofScheduler:scheduler
+                                cancellationToken:nil
+                         withTaskCompletionSource:source
+                                     startedCount:&startedCount]];
+    }
+    XCTAssertEqual(startedCount, 2);
+    XCTAssertEqual([scheduler runningTasksCountForLane:PFCommandRunningLaneBackground], 2);
+    XCTAssertEqual([scheduler waitingTasksCountForLane:PFCommandRunningLaneBackground], 1);
+
+    [sources[0] setResult:@"yarr"];
+    XCTAssertEqualObjects([tasks[0] waitForResult:nil], @"yarr");
+    XCTAssertEqual(startedCount, 3);
+    XCTAssertEqual([scheduler runningTasksCountForLane:PFCommandRunningLaneBackground], 2);
+    XCTAssertEqual([scheduler waitingTasksCountForLane:PFCommandRunningLaneBackground], 0);
+
+    [sources[1] setResult:nil];
+    [sources[2] setResult:nil];
+    XCTAssertEqual([scheduler runningTasksCountForLane:PFCommandRunningLaneBackground], 0);
+}
+
+- (void)testLanesAreIndependent {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+    [scheduler setMaxConcurrentTasksCount:1 forLane:PFCommandRunningLaneFileTransfer];
+    XCTAssertEqual([scheduler maxConcurrentTasksCountForLane:PFCommandRunningLaneFileTransfer], 1);
+
+    NSUInteger startedCount = 0;
+    BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+    [self scheduleTaskInLane:PFCommandRunningLaneFileTransfer
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    [self scheduleTaskInLane:PFCommandRunningLaneFileTransfer
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    XCTAssertEqual(startedCount, 1);
+
+    [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    XCTAssertEqual(startedCount, 2);
+
+    [source setResult:nil];
+    XCTAssertEqual(startedCount, 3);
+}
+
+- (void)testWaitTime {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+    [scheduler setMaxConcurrentTasksCount:1 forLane:PFCommandRunningLaneInteractive];
+
+    NSUInteger startedCount = 0;
+    BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+    [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    XCTAssertLessThan([scheduler averageWaitTimeForLane:PFCommandRunningLaneInteractive], 0.01);
+
+    [NSThread sleepForTimeInterval:0.1];
+    [source setResult:nil];
+    XCTAssertEqual(startedCount, 2);
+    XCTAssertGreaterThan([scheduler averageWaitTimeForLane:PFCommandRunningLaneInteractive], 0.01);
+}
+
+- (void)testCancelWaitingTask {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+    [scheduler setMaxConcurrentTasksCount:1 forLane:PFCommandRunningLaneInteractive];
+
+    NSUInteger startedCount = 0;
+    BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+    BFCancellationTokenSource *cancellationTokenSource = [BFCancellationTokenSource cancellationTokenSource];
+    [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    BFTask *task = [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                                ofScheduler:scheduler
+                          cancellationToken:cancellationTokenSource.token
+                   withTaskCompletionSource:source
+                               startedCount:&startedCount];
+    XCTAssertEqual([scheduler waitingTasksCountForLane:PFCommandRunningLaneInteractive], 1);
+
+    [cancellationTokenSource cancel];
+    XCTAssertTrue(task.cancelled);
+    XCTAssertEqual([scheduler waitingTasksCountForLane:PFCommandRunningLaneInteractive], 0);
+
+    [source setResult:nil];
+    XCTAssertEqual(startedCount, 1);
+    XCTAssertEqual([scheduler runningTasksCountForLane:PFCommandRunningLaneInteractive], 0);
+}
+
+- (void)testURLErrorDecreasesLimitOnce {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    NSUInteger startedCount = 0;
+    BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+    BFTask *taskA = [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                                 ofScheduler:scheduler
+                           cancellationToken:nil
+                    withTaskCompletionSource:source
+                                startedCount:&startedCount];
+    BFTask *taskB = [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                                 ofScheduler:scheduler
+                           cancellationToken:nil
+                    withTaskCompletionSource:source
+                                startedCount:&startedCount];
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    [source setError:error];
+    XCTAssertEqualObjects(taskA.error, error);
+    XCTAssertEqualObjects(taskB.error, error);
+
+    // Both requests were running when the limit was cut, so the second one doesn't cut it again.
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 4);
+    XCTAssertEqual([scheduler maxConcurrentTasksCountForLane:PFCommandRunningLaneInteractive], 8);
+}
+
+- (void)testTemporaryErrorDecreasesLimit {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    NSUInteger startedCount = 0;
+    BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+    [self scheduleTaskInLane:PFCommandRunningLaneEventuallyQueue
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    [source setError:[NSError errorWithDomain:@"ParseTestDomain" code:100500 userInfo:@{ @"temporary" : @YES }]];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneEventuallyQueue], 2);
+
+    // Errors that are not temporary say nothing about the network.
+    source = [BFTaskCompletionSource taskCompletionSource];
+    [self scheduleTaskInLane:PFCommandRunningLaneEventuallyQueue
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    [source setError:[NSError errorWithDomain:@"ParseTestDomain" code:100500 userInfo:nil]];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneEventuallyQueue], 2);
+}
+
+- (void)testConnectivityErrorsDoNotDecreaseLimit {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    NSError *notConnectedError = [NSError errorWithDomain:NSURLErrorDomain
+                                                     code:NSURLErrorNotConnectedToInternet
+                                                 userInfo:nil];
+    NSError *cannotFindHostError = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotFindHost userInfo:nil];
+    NSError *timedOutError = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    NSArray<NSError *> *errors = @[ notConnectedError,
+                                    [NSError errorWithDomain:@"ParseTestDomain"
+                                                        code:100
+                                                    userInfo:@{ @"temporary" : @YES,
+                                                                NSUnderlyingErrorKey : cannotFindHostError }],
+                                    [NSError errorWithDomain:@"ParseTestDomain"
+                                                        code:100
+                                                    userInfo:@{ @"temporary" : @YES,
+                                                                NSUnderlyingErrorKey : timedOutError }] ];
+    NSArray<NSNumber *> *limits = @[ @8, @8, @4 ];
+
+    [errors enumerateObjectsUsingBlock:^(NSError *error, NSUInteger index, BOOL *stop) {
+        NSUInteger startedCount = 0;
+        BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+        [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                     ofScheduler:scheduler
+               cancellationToken:nil
+        withTaskCompletionSource:source
+                    startedCount:&startedCount];
+        [source setError:error];
+        XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive],
+                       limits[index].unsignedIntegerValue);
+    }];
+}
+
+- (void)testSlowRequestDecreasesLimit {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    [self runQuickTasksCount:1 inLane:PFCommandRunningLaneInteractive ofScheduler:scheduler];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 8);
+
+    [self runSlowTaskInLane:PFCommandRunningLaneInteractive ofScheduler:scheduler];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 4);
+}
+
+- (void)testSlowFileTransferDoesNotDecreaseLimit {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    [self runQuickTasksCount:1 inLane:PFCommandRunningLaneFileTransfer ofScheduler:scheduler];
+    [self runSlowTaskInLane:PFCommandRunningLaneFileTransfer ofScheduler:scheduler];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneFileTransfer], 3);
+}
+
+- (void)testQuickRequestsIncreaseLimit {
+    PFURLSessionScheduler *scheduler = [[PFURLSessionScheduler alloc] init];
+
+    NSUInteger startedCount = 0;
+    BFTaskCompletionSource *source = [BFTaskCompletionSource taskCompletionSource];
+    [self scheduleTaskInLane:PFCommandRunningLaneInteractive
+                 ofScheduler:scheduler
+           cancellationToken:nil
+    withTaskCompletionSource:source
+                startedCount:&startedCount];
+    [source setError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 4);
+
+    // A limit's worth of quick requests grows it by one.
+    [self runQuickTasksCount:4 inLane:PFCommandRunningLaneInteractive ofScheduler:scheduler];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 4);
+    [self runQuickTasksCount:1 inLane:PFCommandRunningLaneInteractive ofScheduler:scheduler];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 5);
+
+    // But never above the maximum.
+    [self runQuickTasksCount:100 inLane:PFCommandRunningLaneInteractive ofScheduler:scheduler];
+    XCTAssertEqual([scheduler concurrentTasksLimitForLane:PFCommandRunningLaneInteractive], 8);
+}
+
+@end
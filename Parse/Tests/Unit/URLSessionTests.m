@@ -91,6 +91,8 @@
     NSURLSession *mockedURLSession = PFStrictClassMock([NSURLSession class]);
     NSURLRequest *mockedURLRequest = PFStrictClassMock([NSURLRequest class]);
     PFRESTCommand *mockedCommand = PFStrictClassMock([PFRESTCommand class]);
+    OCMStub([mockedCommand partialResultsBlock]);
+    OCMStub([mockedCommand lane]).andReturn(PFCommandRunningLaneInteractive);
     NSArray *mocks = @[ mockedURLSession, mockedURLRequest, mockedCommand ];
     
     MockedSessionTask *mockedDataTask = [[MockedSessionTask alloc] init];
@@ -131,7 +133,7 @@
     OCMExpect([delegate urlSession:session
               didPerformURLRequest:mockedURLRequest
                    withURLResponse:[OCMArg isNotNil]
-                    responseString:[OCMArg isNotNil]]);
+                      responseData:[OCMArg isNotNil]]);
     
     XCTestExpectation *expectation = [self currentSelectorTestExpectation];
     [[session performDataURLRequestAsync:mockedURLRequest forCommand:mockedCommand cancellationToken:nil] continueWithBlock:^id(BFTask *task) {
@@ -147,6 +149,73 @@
     [mocks makeObjectsPerformSelector:@selector(stopMocking)];
 }
 
+- (void)testPerformDataRequestInChunks {
+    NSURLSession *mockedURLSession = PFStrictClassMock([NSURLSession class]);
+    NSURLRequest *mockedURLRequest = PFStrictClassMock([NSURLRequest class]);
+    PFRESTCommand *mockedCommand = PFStrictClassMock([PFRESTCommand class]);
+    OCMStub([mockedCommand partialResultsBlock]);
+    OCMStub([mockedCommand lane]).andReturn(PFCommandRunningLaneInteractive);
+    NSArray *mocks = @[ mockedURLSession, mockedURLRequest, mockedCommand ];
+
+    MockedSessionTask *mockedDataTask = [[MockedSessionTask alloc] init];
+    mockedDataTask.originalRequest = mockedURLRequest;
+
+    __block id<NSURLSessionDelegate, NSURLSessionTaskDelegate, NSURLSessionDataDelegate> sessionDelegate = nil;
+
+    OCMExpect([mockedURLSession dataTaskWithRequest:mockedURLRequest]).andReturn(mockedDataTask);
+
+    mockedDataTask.taskIdentifier = 1337;
+
+    NSString *responseString = @"{ \"foo\": \"bar\" }";
+    @weakify(mockedDataTask);
+    mockedDataTask.resumeBlock = ^{
+        @strongify(mockedDataTask);
+
+        NSData *dataRecieved = [responseString dataUsingEncoding:NSUTF8StringEncoding];
+        NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"http://foo.bar"]
+                                                                  statusCode:200
+                                                                 HTTPVersion:@"HTTP/1.1"
+                                                                headerFields:@{ @"Content-Length" : @(dataRecieved.length).stringValue }];
+
+        [sessionDelegate URLSession:mockedURLSession
+                           dataTask:(id)mockedDataTask
+                 didReceiveResponse:response
+                  completionHandler:^(NSURLSessionResponseDisposition disposition) {
+                      XCTAssertEqual(disposition, NSURLSessionResponseAllow);
+                  }];
+        for (NSUInteger i = 0; i < dataRecieved.length; i += 4) {
+            NSData *chunk = [dataRecieved subdataWithRange:NSMakeRange(i, MIN(4, dataRecieved.length - i))];
+            [sessionDelegate URLSession:mockedURLSession dataTask:(id)mockedDataTask didReceiveData:chunk];
+        }
+
+        [sessionDelegate URLSession:mockedURLSession task:(id)mockedDataTask didCompleteWithError:nil];
+    };
+
+    id delegate = PFStrictProtocolMock(@protocol(PFURLSessionDelegate));
+    PFURLSession *session = [PFURLSession sessionWithURLSession:mockedURLSession delegate:delegate];
+    sessionDelegate = (id)session;
+
+    OCMExpect([delegate urlSession:session willPerformURLRequest:mockedURLRequest]);
+    OCMExpect([delegate urlSession:session
+              didPerformURLRequest:mockedURLRequest
+                   withURLResponse:[OCMArg isNotNil]
+                      responseData:[responseString dataUsingEncoding:NSUTF8StringEncoding]]);
+
+    XCTestExpectation *expectation = [self currentSelectorTestExpectation];
+    [[session performDataURLRequestAsync:mockedURLRequest forCommand:mockedCommand cancellationToken:nil] continueWithBlock:^id(BFTask *task) {
+        PFCommandResult *actualResult = task.result;
+        XCTAssertEqualObjects(actualResult.result, (@{ @"foo" : @"bar" }));
+        XCTAssertEqualObjects(actualResult.resultString, responseString);
+        [expectation fulfill];
+        return nil;
+    }];
+    [self waitForTestExpectations];
+
+    OCMVerifyAll((id)mockedURLSession);
+    OCMVerifyAll(delegate);
+    [mocks makeObjectsPerformSelector:@selector(stopMocking)];
+}
+
 - (void)testPerformDataRequesPreCancel {
     NSURLSession *mockedURLSession = PFStrictClassMock([NSURLSession class]);
     NSURLRequest *mockedURLRequest = PFStrictClassMock([NSURLRequest class]);
@@ -176,6 +245,8 @@
     NSURLSession *mockedURLSession = PFStrictClassMock([NSURLSession class]);
     NSURLRequest *mockedURLRequest = PFStrictClassMock([NSURLRequest class]);
     PFRESTCommand *mockedCommand = PFStrictClassMock([PFRESTCommand class]);
+    OCMStub([mockedCommand partialResultsBlock]);
+    OCMStub([mockedCommand lane]).andReturn(PFCommandRunningLaneInteractive);
     NSArray *mocks = @[ mockedURLSession, mockedURLRequest, mockedCommand ];
     
     MockedSessionTask *mockedDataTask = [[MockedSessionTask alloc] init];
@@ -225,7 +296,7 @@
     OCMExpect([delegate urlSession:session
               didPerformURLRequest:mockedURLRequest
                    withURLResponse:[OCMArg isNotNil]
-                    responseString:nil]);
+                      responseData:nil]);
     
     XCTestExpectation *expectation = [self currentSelectorTestExpectation];
     [[session performDataURLRequestAsync:mockedURLRequest
@@ -246,6 +317,8 @@
     NSURLSession *mockedURLSession = PFStrictClassMock([NSURLSession class]);
     NSURLRequest *mockedURLRequest = PFStrictClassMock([NSURLRequest class]);
     PFRESTCommand *mockedCommand = PFStrictClassMock([PFRESTCommand class]);
+    OCMStub([mockedCommand partialResultsBlock]);
+    OCMStub([mockedCommand lane]).andReturn(PFCommandRunningLaneInteractive);
     NSArray *mocks = @[ mockedURLSession, mockedURLRequest, mockedCommand ];
     
     MockedSessionTask *mockedDataTask = [[MockedSessionTask alloc] init];
@@ -272,7 +345,7 @@
     OCMExpect([delegate urlSession:session
               didPerformURLRequest:mockedURLRequest
                    withURLResponse:nil
-                    responseString:[OCMArg isNotNil]]);
+                      responseData:[OCMArg isNotNil]]);
     
     XCTestExpectation *expectation = [self currentSelectorTestExpectation];
     [[session performDataURLRequestAsync:mockedURLRequest forCommand:mockedCommand cancellationToken:nil]
@@ -376,7 +449,7 @@
     OCMExpect([delegate urlSession:session
               didPerformURLRequest:mockedURLRequest
                    withURLResponse:[OCMArg isNotNil]
-                    responseString:[OCMArg isNotNil]]);
+                      responseData:[OCMArg isNotNil]]);
     
     __block int lastProgress = 0;
     
@@ -469,7 +542,7 @@
     OCMExpect([delegate urlSession:session
               didPerformURLRequest:mockedURLRequest
                    withURLResponse:[OCMArg isNotNil]
-                    responseString:nil]);
+                      responseData:nil]);
     
     __block int lastProgress = 0;
     
@@ -498,6 +571,8 @@
     NSURLSession *mockedURLSession = PFStrictClassMock([NSURLSession class]);
     NSURLRequest *mockedURLRequest = PFStrictClassMock([NSURLRequest class]);
     PFRESTCommand *mockedCommand = PFStrictClassMock([PFRESTCommand class]);
+    OCMStub([mockedCommand partialResultsBlock]);
+    OCMStub([mockedCommand lane]).andReturn(PFCommandRunningLaneInteractive);
     NSArray *mocks = @[ mockedURLSession, mockedURLRequest, mockedCommand ];
     
     MockedSessionTask *mockedDataTask = [[MockedSessionTask alloc] init];
@@ -542,7 +617,7 @@
     OCMExpect([delegate urlSession:session
               didPerformURLRequest:mockedURLRequest
                    withURLResponse:[OCMArg isNotNil]
-                    responseString:[OCMArg isNotNil]]);
+                      responseData:[OCMArg isNotNil]]);
     
     XCTestExpectation *expectation = [self currentSelectorTestExpectation];
     [[session performDataURLRequestAsync:mockedURLRequest forCommand:mockedCommand cancellationToken:nil]